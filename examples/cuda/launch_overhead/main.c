@@ -0,0 +1,232 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_cuda.h>
+#include <bsg_manycore_regression.h>
+#include <bsg_manycore.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALLOC_NAME "default_allocator"
+
+/*!
+ * Measures the overheads of the host runtime, rather than of the
+ * kernel: program load time, empty-kernel launch latency, launch
+ * throughput for 1x1 and whole-pod tile groups, device malloc/free
+ * rate, and memcpy/DMA bandwidth across transfer sizes.
+ *
+ * Each measurement is printed as one line:
+ *
+ *   BSG BENCHMARK {"metric":..., <parameters>, "iters":N, "ns":T, "cycles":C}
+ *
+ * where T and C are the host nanoseconds and device cycles taken by
+ * all N iterations together. C is 0 on platforms without a cycle
+ * counter. The first line is a "config" record describing the
+ * machine. `make benchmark.jsonl` collects the records and `make
+ * sweep` collects them for every machine in machines/.
+ */
+
+// Iteration counts default low enough for RTL simulation
+#ifndef LAUNCH_ITERS
+#define LAUNCH_ITERS 4
+#endif
+#ifndef LAUNCH_GRID
+#define LAUNCH_GRID 8
+#endif
+#ifndef MALLOC_ITERS
+#define MALLOC_ITERS 64
+#endif
+#ifndef COPY_ITERS
+#define COPY_ITERS 2
+#endif
+#ifndef COPY_MAX_BYTES
+#define COPY_MAX_BYTES (64 * 1024)
+#endif
+
+static void report(const char *metric, const char *params, unsigned iters,
+                   const hb_mc_timeline_stamp_t *begin,
+                   const hb_mc_timeline_stamp_t *end)
+{
+        printf("BSG BENCHMARK {\"metric\":\"%s\"%s,\"iters\":%u,"
+               "\"ns\":%" PRIu64 ",\"cycles\":%" PRIu64 "}\n",
+               metric, params, iters, end->ns - begin->ns,
+               end->cycle - begin->cycle);
+        fflush(stdout);
+}
+
+/* launch #grid tile groups of #tg, #iters times, timing each round */
+static int bench_launch(hb_mc_device_t *device, const char *metric,
+                        hb_mc_dimension_t grid, hb_mc_dimension_t tg, unsigned iters)
+{
+        hb_mc_timeline_stamp_t begin, end;
+        uint32_t cuda_argv[1];
+        char params[64];
+
+        snprintf(params, sizeof(params), ",\"tile_group\":\"%dx%d\",\"tile_groups\":%d",
+                 tg.x, tg.y, grid.x * grid.y);
+
+        hb_mc_timeline_stamp(device->mc, &begin);
+        for (unsigned i = 0; i < iters; i++) {
+                BSG_CUDA_CALL(hb_mc_kernel_enqueue(device, grid, tg, "kernel_empty", 0, cuda_argv));
+                BSG_CUDA_CALL(hb_mc_device_tile_groups_execute(device));
+        }
+        hb_mc_timeline_stamp(device->mc, &end);
+
+        report(metric, params, iters, &begin, &end);
+        return HB_MC_SUCCESS;
+}
+
+static int bench_malloc(hb_mc_device_t *device)
+{
+        static hb_mc_eva_t evas[MALLOC_ITERS];
+        hb_mc_timeline_stamp_t begin, end;
+
+        hb_mc_timeline_stamp(device->mc, &begin);
+        for (unsigned i = 0; i < MALLOC_ITERS; i++)
+                BSG_CUDA_CALL(hb_mc_device_malloc(device, 64, &evas[i]));
+        hb_mc_timeline_stamp(device->mc, &end);
+        report("malloc", ",\"bytes\":64", MALLOC_ITERS, &begin, &end);
+
+        hb_mc_timeline_stamp(device->mc, &begin);
+        for (unsigned i = 0; i < MALLOC_ITERS; i++)
+                BSG_CUDA_CALL(hb_mc_device_free(device, evas[i]));
+        hb_mc_timeline_stamp(device->mc, &end);
+        report("free", ",\"bytes\":64", MALLOC_ITERS, &begin, &end);
+
+        return HB_MC_SUCCESS;
+}
+
+static int bench_copy(hb_mc_device_t *device, hb_mc_eva_t d_buf, void *h_buf, uint32_t bytes)
+{
+        hb_mc_timeline_stamp_t begin, end;
+        hb_mc_dma_htod_t htod = { .d_addr = d_buf, .h_addr = h_buf, .size = bytes };
+        hb_mc_dma_dtoh_t dtoh = { .d_addr = d_buf, .h_addr = h_buf, .size = bytes };
+        char params[32];
+        int err = HB_MC_SUCCESS;
+
+        snprintf(params, sizeof(params), ",\"bytes\":%" PRIu32, bytes);
+
+        hb_mc_timeline_stamp(device->mc, &begin);
+        for (unsigned i = 0; i < COPY_ITERS; i++)
+                BSG_CUDA_CALL(hb_mc_device_memcpy_to_device(device, d_buf, h_buf, bytes));
+        hb_mc_timeline_stamp(device->mc, &end);
+        report("memcpy_to_device", params, COPY_ITERS, &begin, &end);
+
+        hb_mc_timeline_stamp(device->mc, &begin);
+        for (unsigned i = 0; i < COPY_ITERS; i++)
+                BSG_CUDA_CALL(hb_mc_device_memcpy_to_host(device, h_buf, d_buf, bytes));
+        hb_mc_timeline_stamp(device->mc, &end);
+        report("memcpy_to_host", params, COPY_ITERS, &begin, &end);
+
+        // not every platform has DMA; leave those records out
+        hb_mc_timeline_stamp(device->mc, &begin);
+        for (unsigned i = 0; i < COPY_ITERS; i++) {
+                err = hb_mc_device_dma_to_device(device, &htod, 1);
+                if (err == HB_MC_NOIMPL)
+                        break;
+                BSG_CUDA_CALL(err);
+        }
+        hb_mc_timeline_stamp(device->mc, &end);
+        if (err != HB_MC_NOIMPL)
+                report("dma_to_device", params, COPY_ITERS, &begin, &end);
+
+        hb_mc_timeline_stamp(device->mc, &begin);
+        for (unsigned i = 0; i < COPY_ITERS; i++) {
+                err = hb_mc_device_dma_to_host(device, &dtoh, 1);
+                if (err == HB_MC_NOIMPL)
+                        break;
+                BSG_CUDA_CALL(err);
+        }
+        hb_mc_timeline_stamp(device->mc, &end);
+        if (err != HB_MC_NOIMPL)
+                report("dma_to_host", params, COPY_ITERS, &begin, &end);
+
+        return HB_MC_SUCCESS;
+}
+
+int launch_overhead(int argc, char **argv) {
+        char *bin_path, *test_name;
+        struct arguments_path args = {NULL, NULL};
+        hb_mc_timeline_stamp_t begin, end;
+
+        argp_parse (&argp_path, argc, argv, 0, 0, &args);
+        bin_path = args.path;
+        test_name = args.name;
+
+        bsg_pr_test_info("Running the host runtime overhead benchmarks\n");
+
+        hb_mc_device_t device;
+        BSG_CUDA_CALL(hb_mc_device_init(&device, test_name, HB_MC_DEVICE_ID));
+
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(device.mc);
+        hb_mc_dimension_t pods = cfg->pods;
+        hb_mc_dimension_t pod_shape = hb_mc_config_get_dimension_vcore(cfg);
+
+        printf("BSG BENCHMARK {\"metric\":\"config\",\"pods\":\"%dx%d\",\"pod_shape\":\"%dx%d\"}\n",
+               pods.x, pods.y, pod_shape.x, pod_shape.y);
+
+        // only the default pod is measured; the others behave the same
+        hb_mc_timeline_stamp(device.mc, &begin);
+        BSG_CUDA_CALL(hb_mc_device_program_init(&device, bin_path, ALLOC_NAME, 0));
+        hb_mc_timeline_stamp(device.mc, &end);
+        report("program_init", "", 1, &begin, &end);
+
+        hb_mc_dimension_t one = { .x = 1, .y = 1 };
+        hb_mc_dimension_t grid = { .x = LAUNCH_GRID, .y = 1 };
+
+        BSG_CUDA_CALL(bench_launch(&device, "launch_latency", one, one, LAUNCH_ITERS));
+        BSG_CUDA_CALL(bench_launch(&device, "launch_latency", one, pod_shape, LAUNCH_ITERS));
+        BSG_CUDA_CALL(bench_launch(&device, "launch_throughput", grid, one, 1));
+        BSG_CUDA_CALL(bench_launch(&device, "launch_throughput", grid, pod_shape, 1));
+
+        BSG_CUDA_CALL(bench_malloc(&device));
+
+        hb_mc_eva_t d_buf;
+        void *h_buf = calloc(1, COPY_MAX_BYTES);
+        if (h_buf == NULL) {
+                bsg_pr_test_err("Failed to allocate %d bytes of host memory\n", COPY_MAX_BYTES);
+                return HB_MC_NOMEM;
+        }
+        BSG_CUDA_CALL(hb_mc_device_malloc(&device, COPY_MAX_BYTES, &d_buf));
+
+        for (uint32_t bytes = 4; bytes <= COPY_MAX_BYTES; bytes *= 4)
+                BSG_CUDA_CALL(bench_copy(&device, d_buf, h_buf, bytes));
+
+        BSG_CUDA_CALL(hb_mc_device_free(&device, d_buf));
+        free(h_buf);
+
+        BSG_CUDA_CALL(hb_mc_device_program_finish(&device));
+        BSG_CUDA_CALL(hb_mc_device_finish(&device));
+
+        return HB_MC_SUCCESS;
+}
+
+declare_program_main("launch_overhead", launch_overhead);
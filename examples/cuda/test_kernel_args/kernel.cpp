@@ -0,0 +1,37 @@
+// This kernel takes a descriptor struct by reference, a 64-bit scalar
+// and a small struct by value, as packed by hb_mc_kernel_args_push_*().
+
+#include "bsg_manycore.h"
+#include "bsg_set_tile_x_y.h"
+
+#include <stdint.h>
+
+typedef struct {
+        const int *A;
+        int       *B;
+        uint32_t   N;
+        int32_t    bias;
+} vec_desc_t;
+
+typedef struct {
+        int16_t lo;
+        int16_t hi;
+        int32_t step;
+} clamp_t;
+
+extern "C" __attribute__ ((noinline))
+int kernel_args(const vec_desc_t *desc, uint64_t scale, clamp_t clamp) {
+
+        for (uint32_t i = __bsg_id; i < desc->N; i += bsg_tiles_X * bsg_tiles_Y) {
+                int64_t v = desc->A[i] * (int64_t) scale + desc->bias;
+                if (v < clamp.lo)
+                        v = clamp.lo;
+                if (v > clamp.hi)
+                        v = clamp.hi;
+                desc->B[i] = (int) v * clamp.step;
+        }
+
+        bsg_fence();
+
+        return 0;
+}
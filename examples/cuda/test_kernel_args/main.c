@@ -0,0 +1,154 @@
+// Copyright (c) 2019, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_tile.h>
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_loader.h>
+#include <bsg_manycore_cuda.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <bsg_manycore_regression.h>
+
+#define ALLOC_NAME "default_allocator"
+
+/*!
+ * Passes a descriptor by reference, a 64-bit scalar and a small struct by
+ * value to a kernel with the typed kernel argument API, and checks that the
+ * kernel saw all of them. B[i] = clamp(A[i] * scale + bias) * step
+*/
+
+/* device layout of the descriptor - pointers are 32-bit on the device */
+typedef struct {
+        hb_mc_eva_t A;
+        hb_mc_eva_t B;
+        uint32_t    N;
+        int32_t     bias;
+} vec_desc_t;
+
+typedef struct {
+        int16_t lo;
+        int16_t hi;
+        int32_t step;
+} clamp_t;
+
+static int32_t host_kernel_args(int32_t a, uint64_t scale, int32_t bias, clamp_t clamp)
+{
+        int64_t v = a * (int64_t) scale + bias;
+        if (v < clamp.lo)
+                v = clamp.lo;
+        if (v > clamp.hi)
+                v = clamp.hi;
+        return (int32_t) v * clamp.step;
+}
+
+int kernel_kernel_args (int argc, char **argv) {
+        char *bin_path, *test_name;
+        struct arguments_path args = {NULL, NULL};
+
+        argp_parse (&argp_path, argc, argv, 0, 0, &args);
+        bin_path = args.path;
+        test_name = args.name;
+
+        bsg_pr_test_info("Running the CUDA Kernel Argument Marshalling test on one 2x2 tile group.\n\n");
+
+        srand(time(NULL));
+
+        hb_mc_device_t device;
+        BSG_CUDA_CALL(hb_mc_device_init(&device, test_name, HB_MC_DEVICE_ID));
+
+        hb_mc_pod_id_t pod;
+        hb_mc_device_foreach_pod_id(&device, pod)
+        {
+                bsg_pr_info("Loading program for test %s onto pod %d\n", test_name, pod);
+                BSG_CUDA_CALL(hb_mc_device_set_default_pod(&device, pod));
+                BSG_CUDA_CALL(hb_mc_device_program_init(&device, bin_path, ALLOC_NAME, 0));
+
+                uint32_t N = 256;
+
+                eva_t A_device, B_device;
+                BSG_CUDA_CALL(hb_mc_device_malloc(&device, N * sizeof(int32_t), &A_device));
+                BSG_CUDA_CALL(hb_mc_device_malloc(&device, N * sizeof(int32_t), &B_device));
+
+                int32_t A_host[N];
+                for (uint32_t i = 0; i < N; i++)
+                        A_host[i] = (rand() & 0xFF) - 0x80;
+
+                void *dst = (void *) ((intptr_t) A_device);
+                void *src = (void *) &A_host[0];
+                BSG_CUDA_CALL(hb_mc_device_memcpy (&device, dst, src, N * sizeof(int32_t), HB_MC_MEMCPY_TO_DEVICE));
+
+                /*****************************************************************************************************************
+                 * Pack the arguments. The descriptor is uploaded with the argument words at launch.
+                 ******************************************************************************************************************/
+                vec_desc_t desc = { .A = A_device, .B = B_device, .N = N, .bias = -7 };
+                uint64_t scale = 3;
+                clamp_t clamp = { .lo = -200, .hi = 300, .step = 2 };
+
+                hb_mc_kernel_args_t kargs;
+                BSG_CUDA_CALL(hb_mc_kernel_args_init(&kargs));
+                BSG_CUDA_CALL(hb_mc_kernel_args_push_struct(&kargs, &desc, sizeof(desc), 4));
+                BSG_CUDA_CALL(hb_mc_kernel_args_push_u64(&kargs, scale));
+                BSG_CUDA_CALL(hb_mc_kernel_args_push_struct(&kargs, &clamp, sizeof(clamp), 4));
+
+                hb_mc_dimension_t tg_dim = { .x = 2, .y = 2};
+                hb_mc_dimension_t grid_dim = { .x = 1, .y = 1};
+
+                BSG_CUDA_CALL(hb_mc_kernel_enqueue_args (&device, grid_dim, tg_dim, "kernel_args", &kargs));
+                BSG_CUDA_CALL(hb_mc_kernel_args_exit(&kargs));
+
+                BSG_CUDA_CALL(hb_mc_device_tile_groups_execute(&device));
+
+                int32_t B_host[N];
+                src = (void *) ((intptr_t) B_device);
+                dst = (void *) &B_host[0];
+                BSG_CUDA_CALL(hb_mc_device_memcpy (&device, dst, src, N * sizeof(int32_t), HB_MC_MEMCPY_TO_HOST));
+
+                BSG_CUDA_CALL(hb_mc_device_program_finish(&device));
+
+                int mismatch = 0;
+                for (uint32_t i = 0; i < N; i++) {
+                        int32_t expected = host_kernel_args(A_host[i], scale, desc.bias, clamp);
+                        if (B_host[i] != expected) {
+                                bsg_pr_err(BSG_RED("Mismatch: ") "B[%" PRIu32 "] = %" PRId32 "\t Expected: %" PRId32 "\n",
+                                           i, B_host[i], expected);
+                                mismatch = 1;
+                        }
+                }
+
+                if (mismatch) {
+                        return HB_MC_FAIL;
+                }
+        }
+        BSG_CUDA_CALL(hb_mc_device_finish(&device));
+
+        return HB_MC_SUCCESS;
+}
+
+declare_program_main("test_kernel_args", kernel_kernel_args);
@@ -0,0 +1,64 @@
+// This kernel stays resident on its tiles and runs vector addition
+// chunks out of a work queue that the host fills while it runs.
+//
+// The queue layout mirrors the HB_MC_WORK_QUEUE_* definitions in
+// bsg_manycore_cuda.h.
+
+#include "bsg_manycore.h"
+#include "bsg_set_tile_x_y.h"
+
+#define QUEUE_HEAD_IDX          0
+#define QUEUE_TAIL_IDX          1
+#define QUEUE_DONE_IDX          2
+#define QUEUE_CAPACITY_IDX      3
+#define QUEUE_HEADER_WORDS      4
+
+#define SLOT_OP_IDX             0
+#define SLOT_ARG0_IDX           1
+#define SLOT_ARG1_IDX           2
+#define SLOT_FULL_IDX           3
+#define SLOT_WORDS              4
+
+#define OP_EXIT                 0xFFFFFFFF
+#define OP_VEC_ADD              0
+
+static inline unsigned amoadd(volatile unsigned *p, unsigned v)
+{
+        unsigned r;
+        asm volatile ("amoadd.w %0, %2, %1" : "=r" (r), "+A" (*p) : "r" (v) : "memory");
+        return r;
+}
+
+extern "C" __attribute__ ((noinline))
+int kernel_persistent_vec_add(unsigned *queue, int *A, int *B, int *C) {
+        volatile unsigned *q = queue;
+        unsigned capacity = q[QUEUE_CAPACITY_IDX];
+
+        while (1) {
+                // claim the next item
+                unsigned item = amoadd(&q[QUEUE_HEAD_IDX], 1);
+
+                // wait for the host to publish it
+                while (item >= q[QUEUE_TAIL_IDX]);
+
+                volatile unsigned *slot = &q[QUEUE_HEADER_WORDS + (item % capacity) * SLOT_WORDS];
+                unsigned op    = slot[SLOT_OP_IDX];
+                unsigned start = slot[SLOT_ARG0_IDX];
+                unsigned len   = slot[SLOT_ARG1_IDX];
+
+                // hand the slot back to the host
+                slot[SLOT_FULL_IDX] = 0;
+
+                if (op == OP_EXIT)
+                        break;
+
+                for (unsigned i = start; i < start + len; i++)
+                        C[i] = A[i] + B[i];
+
+                // results must land before the item is counted as done
+                bsg_fence();
+                amoadd(&q[QUEUE_DONE_IDX], 1);
+        }
+
+        return 0;
+}
@@ -0,0 +1,151 @@
+// Copyright (c) 2019, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_tile.h>
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_loader.h>
+#include <bsg_manycore_cuda.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <bsg_manycore_regression.h>
+
+#define ALLOC_NAME "default_allocator"
+
+#define N          1024
+#define CHUNK      16
+#define CAPACITY   16
+#define OP_VEC_ADD 0
+
+/*!
+ * Runs vector addition on one 2x2 tile group that stays resident and pulls
+ * work from a queue in DRAM. A[N] + B[N] --> C[N] is split into N/CHUNK
+ * items, more than fit in the queue at once, so the queue wraps.
+ */
+
+int kernel_persistent_kernel (int argc, char **argv) {
+        char *bin_path, *test_name;
+        struct arguments_path args = {NULL, NULL};
+
+        argp_parse (&argp_path, argc, argv, 0, 0, &args);
+        bin_path = args.path;
+        test_name = args.name;
+
+        bsg_pr_test_info("Running a persistent CUDA Vector Addition Kernel on one 2x2 tile group.\n\n");
+
+        srand(0);
+
+        hb_mc_device_t device;
+        BSG_CUDA_CALL(hb_mc_device_init(&device, test_name, HB_MC_DEVICE_ID));
+
+        hb_mc_pod_id_t pod;
+        hb_mc_device_foreach_pod_id(&device, pod)
+        {
+                bsg_pr_info("Loading program for test %s onto pod %d\n", test_name, pod);
+                BSG_CUDA_CALL(hb_mc_device_set_default_pod(&device, pod));
+                BSG_CUDA_CALL(hb_mc_device_program_init(&device, bin_path, ALLOC_NAME, 0));
+
+                /*****************************************************************************************************************
+                 * Allocate and initialize A, B and C.
+                 ******************************************************************************************************************/
+                eva_t A_device, B_device, C_device;
+                BSG_CUDA_CALL(hb_mc_device_malloc(&device, N * sizeof(uint32_t), &A_device));
+                BSG_CUDA_CALL(hb_mc_device_malloc(&device, N * sizeof(uint32_t), &B_device));
+                BSG_CUDA_CALL(hb_mc_device_malloc(&device, N * sizeof(uint32_t), &C_device));
+
+                uint32_t A_host[N], B_host[N], C_host[N];
+                for (int i = 0; i < N; i++) {
+                        A_host[i] = rand() & 0xFFFF;
+                        B_host[i] = rand() & 0xFFFF;
+                }
+
+                BSG_CUDA_CALL(hb_mc_device_memcpy(&device, (void*)((intptr_t)A_device), &A_host[0],
+                                                  N * sizeof(uint32_t), HB_MC_MEMCPY_TO_DEVICE));
+                BSG_CUDA_CALL(hb_mc_device_memcpy(&device, (void*)((intptr_t)B_device), &B_host[0],
+                                                  N * sizeof(uint32_t), HB_MC_MEMCPY_TO_DEVICE));
+
+                /*****************************************************************************************************************
+                 * Create the work queue and launch the kernel once. It will not return until the queue is closed.
+                 ******************************************************************************************************************/
+                hb_mc_work_queue_t queue;
+                BSG_CUDA_CALL(hb_mc_device_pod_work_queue_init(&device, pod, CAPACITY, &queue));
+
+                hb_mc_dimension_t tg_dim = { .x = 2, .y = 2};
+                hb_mc_dimension_t grid_dim = { .x = 1, .y = 1};
+                uint32_t workers = tg_dim.x * tg_dim.y * grid_dim.x * grid_dim.y;
+
+                uint32_t cuda_argv[4] = {queue.eva, A_device, B_device, C_device};
+                BSG_CUDA_CALL(hb_mc_kernel_enqueue (&device, grid_dim, tg_dim, "kernel_persistent_vec_add", 4, cuda_argv));
+                BSG_CUDA_CALL(hb_mc_device_pod_kernels_launch(&device, pod));
+
+                /*****************************************************************************************************************
+                 * Feed the queue, wait for the batch, then let the tiles exit.
+                 ******************************************************************************************************************/
+                hb_mc_work_item_t items[N / CHUNK];
+                for (int i = 0; i < N / CHUNK; i++) {
+                        items[i].op   = OP_VEC_ADD;
+                        items[i].arg0 = i * CHUNK;
+                        items[i].arg1 = CHUNK;
+                }
+
+                BSG_CUDA_CALL(hb_mc_device_pod_work_queue_push(&device, &queue, items, N / CHUNK));
+                BSG_CUDA_CALL(hb_mc_device_pod_work_queue_wait(&device, &queue, N / CHUNK, -1));
+                BSG_CUDA_CALL(hb_mc_device_pod_work_queue_close(&device, &queue, workers));
+
+                // wait for the tile group to return
+                BSG_CUDA_CALL(hb_mc_device_tile_groups_execute(&device));
+
+                BSG_CUDA_CALL(hb_mc_device_pod_work_queue_exit(&device, &queue));
+
+                BSG_CUDA_CALL(hb_mc_device_memcpy(&device, &C_host[0], (void*)((intptr_t)C_device),
+                                                  N * sizeof(uint32_t), HB_MC_MEMCPY_TO_HOST));
+
+                BSG_CUDA_CALL(hb_mc_device_program_finish(&device));
+
+                /*****************************************************************************************************************
+                 * Compare the results.
+                 ******************************************************************************************************************/
+                int mismatch = 0;
+                for (int i = 0; i < N; i++) {
+                        if (A_host[i] + B_host[i] != C_host[i]) {
+                                bsg_pr_err(BSG_RED("Mismatch: ") "C[%d]:  0x%08" PRIx32 " + 0x%08" PRIx32 " = 0x%08" PRIx32 "\n",
+                                           i , A_host[i], B_host[i], C_host[i]);
+                                mismatch = 1;
+                        }
+                }
+
+                if (mismatch) {
+                        return HB_MC_FAIL;
+                }
+        }
+        BSG_CUDA_CALL(hb_mc_device_finish(&device));
+
+        return HB_MC_SUCCESS;
+}
+
+declare_program_main("test_persistent_kernel", kernel_persistent_kernel);
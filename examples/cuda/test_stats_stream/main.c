@@ -0,0 +1,238 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_cuda.h>
+#include <bsg_manycore_stats_stream.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <bsg_manycore_regression.h>
+
+#define ALLOC_NAME "default_allocator"
+#define LAUNCHES 2
+#define STREAM   "stats_stream.bin"
+#define MAX_TGS  16
+
+/*
+ * Runs the vector addition kernel LAUNCHES times while recording a
+ * stats stream, then reads the stream back and checks that it holds
+ * one kernel record per launch and one tile group record per tile
+ * group, with sane cycle intervals.
+ *
+ * Each launch repeats the addition reps[] times. Where the platform
+ * counts instructions, every tile group must have executed at least
+ * MIN_INSTRS_PER_ADD instructions per element and repetition, and the
+ * extra repetitions of the later launch must show up in its count.
+ */
+
+static const uint32_t reps[LAUNCHES] = {1, 4};
+
+// two loads, an add and a store
+#define MIN_INSTRS_PER_ADD 4
+
+static int check_stream(const char *path, uint32_t tgs_per_launch,
+                        uint32_t block_size_x, int profiled)
+{
+        FILE *f = fopen(path, "rb");
+        if (f == NULL) {
+                bsg_pr_err("failed to open %s\n", path);
+                return HB_MC_FAIL;
+        }
+
+        hb_mc_stats_stream_header_t hdr;
+        hb_mc_stats_record_header_t rh;
+        uint32_t kernels = 0, tile_groups = 0, grid_x = 0;
+        uint64_t work[LAUNCHES][MAX_TGS] = {{0}};
+        int rc = HB_MC_SUCCESS;
+
+        if (fread(&hdr, sizeof(hdr), 1, f) != 1 ||
+            hdr.magic != HB_MC_STATS_STREAM_MAGIC ||
+            hdr.version != HB_MC_STATS_STREAM_VERSION) {
+                bsg_pr_err("bad stream header\n");
+                rc = HB_MC_FAIL;
+        }
+
+        while (rc == HB_MC_SUCCESS && fread(&rh, sizeof(rh), 1, f) == 1) {
+                if (rh.type == HB_MC_STATS_RECORD_KERNEL) {
+                        hb_mc_stats_kernel_record_t k;
+                        char name[64] = {0};
+                        if (rh.size < sizeof(k) ||
+                            fread(&k, sizeof(k), 1, f) != 1 ||
+                            k.name_len >= sizeof(name) ||
+                            rh.size != sizeof(k) + k.name_len ||
+                            fread(name, 1, k.name_len, f) != k.name_len) {
+                                bsg_pr_err("malformed kernel record\n");
+                                rc = HB_MC_FAIL;
+                                break;
+                        }
+
+                        bsg_pr_test_info("kernel '%s' launch %u: grid %ux%u, tile group %ux%u\n",
+                                         name, k.launch, k.grid_x, k.grid_y, k.tg_x, k.tg_y);
+
+                        if (k.launch != kernels ||
+                            strcmp(name, "kernel_vec_add_parallel") != 0 ||
+                            k.grid_x * k.grid_y != tgs_per_launch ||
+                            k.tg_x != 2 || k.tg_y != 2) {
+                                bsg_pr_err("unexpected kernel record\n");
+                                rc = HB_MC_FAIL;
+                        }
+                        grid_x = k.grid_x;
+                        kernels++;
+                } else if (rh.type == HB_MC_STATS_RECORD_TILE_GROUP) {
+                        hb_mc_stats_tile_group_record_t t;
+                        if (rh.size != sizeof(t) || fread(&t, sizeof(t), 1, f) != 1) {
+                                bsg_pr_err("malformed tile group record\n");
+                                rc = HB_MC_FAIL;
+                                break;
+                        }
+
+                        uint64_t cycles = t.end_cycle - t.start_cycle;
+                        uint64_t all = t.icount[e_instr_all];
+                        uint32_t tg = t.id_y * grid_x + t.id_x;
+
+                        bsg_pr_test_info("launch %u tile group (%u,%u): %" PRIu64 " cycles, "
+                                         "%" PRIu64 " instructions (%" PRIu64 " integer, "
+                                         "%" PRIu64 " float) on %u tiles\n",
+                                         t.launch, t.id_x, t.id_y, cycles, all,
+                                         t.icount[e_instr_int], t.icount[e_instr_float], t.tiles);
+
+                        // a tile group retires after its kernel record was written
+                        if (t.launch >= kernels || tg >= MAX_TGS ||
+                            t.dim_x != 2 || t.dim_y != 2 ||
+                            t.end_cycle < t.start_cycle) {
+                                bsg_pr_err("unexpected tile group record\n");
+                                rc = HB_MC_FAIL;
+                                break;
+                        }
+
+                        if (!profiled) {
+                                if (t.tiles != 0 || all != 0) {
+                                        bsg_pr_err("instruction counts without a profiler\n");
+                                        rc = HB_MC_FAIL;
+                                }
+                        } else if (t.tiles != 4 ||
+                                   all < (uint64_t)reps[t.launch] * block_size_x * MIN_INSTRS_PER_ADD ||
+                                   t.icount[e_instr_int] > all ||
+                                   t.icount[e_instr_float] != 0 ||
+                                   // a tile retires at most one instruction per cycle
+                                   cycles < all / t.tiles) {
+                                bsg_pr_err("unexpected instruction counts\n");
+                                rc = HB_MC_FAIL;
+                        }
+                        work[t.launch][tg] = all;
+                        tile_groups++;
+                } else if (fseek(f, rh.size, SEEK_CUR) != 0) {
+                        // readers skip record types they don't know
+                        rc = HB_MC_FAIL;
+                }
+        }
+
+        fclose(f);
+
+        if (rc == HB_MC_SUCCESS &&
+            (kernels != LAUNCHES || tile_groups != LAUNCHES * tgs_per_launch)) {
+                bsg_pr_err("expected %d kernels and %u tile groups, found %u and %u\n",
+                           LAUNCHES, LAUNCHES * tgs_per_launch, kernels, tile_groups);
+                rc = HB_MC_FAIL;
+        }
+
+        // The later launch does more repetitions on top of a similar
+        // overhead, so its count grows by at least the extra work. It
+        // grows by less than twice the ratio of reps, which leaves room
+        // for the overhead to differ between launches.
+        for (uint32_t tg = 0; profiled && rc == HB_MC_SUCCESS && tg < tgs_per_launch; tg++) {
+                uint64_t extra = (uint64_t)(reps[1] - reps[0]) * block_size_x * MIN_INSTRS_PER_ADD;
+                if (work[1][tg] < work[0][tg] + extra ||
+                    work[1][tg] * reps[0] > 2 * work[0][tg] * reps[1]) {
+                        bsg_pr_err("tile group %u: %" PRIu64 " then %" PRIu64 " instructions "
+                                   "is not in line with %u then %u repetitions\n",
+                                   tg, work[0][tg], work[1][tg], reps[0], reps[1]);
+                        rc = HB_MC_FAIL;
+                }
+        }
+
+        return rc;
+}
+
+int kernel_stats_stream (int argc, char **argv) {
+        char *bin_path, *test_name;
+        struct arguments_path args = {NULL, NULL};
+
+        argp_parse (&argp_path, argc, argv, 0, 0, &args);
+        bin_path = args.path;
+        test_name = args.name;
+
+        bsg_pr_test_info("Running the CUDA Vector Addition Kernel %d times with a stats stream.\n\n",
+                         LAUNCHES);
+
+        const char *path = getenv("HB_MC_STATS_STREAM");
+        if (path == NULL || *path == '\0')
+                path = STREAM;
+
+        hb_mc_device_t device;
+        BSG_CUDA_CALL(hb_mc_device_init(&device, test_name, HB_MC_DEVICE_ID));
+        BSG_CUDA_CALL(hb_mc_device_program_init(&device, bin_path, ALLOC_NAME, 0));
+        BSG_CUDA_CALL(hb_mc_device_stats_stream_open(&device, path));
+
+        // An empty snapshot reports how many tiles have a profiler
+        hb_mc_icount_snapshot_t snap = { .tiles = NULL, .cap = 0 };
+        int err = hb_mc_manycore_get_icount_snapshot(device.mc, &snap);
+        if (err != HB_MC_NOMEM && err != HB_MC_NOIMPL) {
+                bsg_pr_err("unexpected result from an empty snapshot: %s\n", hb_mc_strerror(err));
+                return err == HB_MC_SUCCESS ? HB_MC_FAIL : err;
+        }
+        int profiled = (err == HB_MC_NOMEM);
+        bsg_pr_test_info("%s\n", profiled ?
+                         "Checking instruction counts" :
+                         "No profiler on this platform, checking that counts are empty");
+
+        uint32_t N = 1024;
+        uint32_t block_size_x = 256;
+        eva_t A_device, B_device, C_device;
+        BSG_CUDA_CALL(hb_mc_device_malloc(&device, N * sizeof(uint32_t), &A_device));
+        BSG_CUDA_CALL(hb_mc_device_malloc(&device, N * sizeof(uint32_t), &B_device));
+        BSG_CUDA_CALL(hb_mc_device_malloc(&device, N * sizeof(uint32_t), &C_device));
+
+        hb_mc_dimension_t tg_dim = { .x = 2, .y = 2 };
+        hb_mc_dimension_t grid_dim = { .x = N / block_size_x, .y = 1 };
+
+        for (int i = 0; i < LAUNCHES; i++) {
+                uint32_t cuda_argv[6] = {A_device, B_device, C_device, N, block_size_x, reps[i]};
+                BSG_CUDA_CALL(hb_mc_kernel_enqueue (&device, grid_dim, tg_dim,
+                                                    "kernel_vec_add_parallel", 6, cuda_argv));
+                BSG_CUDA_CALL(hb_mc_device_tile_groups_execute(&device));
+        }
+
+        // closes the stream
+        BSG_CUDA_CALL(hb_mc_device_finish(&device));
+
+        return check_stream(path, grid_dim.x * grid_dim.y, block_size_x, profiled);
+}
+
+declare_program_main("test_stats_stream", kernel_stats_stream);
@@ -0,0 +1,134 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_cuda.h>
+#include <bsg_manycore_trace_regions.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <bsg_manycore_regression.h>
+
+#define ALLOC_NAME "default_allocator"
+#define LAUNCHES 3
+#define TRACED   1
+
+/*
+ * Runs the vector addition kernel LAUNCHES times with only launch
+ * TRACED selected for tracing, and checks that exactly one trace
+ * region was recorded for it.
+ */
+
+static int check_regions(const char *path)
+{
+        FILE *f = fopen(path, "r");
+        if (f == NULL) {
+                bsg_pr_err("failed to open %s\n", path);
+                return HB_MC_FAIL;
+        }
+
+        char line[256];
+        int regions = 0;
+        int rc = HB_MC_SUCCESS;
+
+        // skip the header
+        if (fgets(line, sizeof(line), f) == NULL)
+                rc = HB_MC_FAIL;
+
+        while (rc == HB_MC_SUCCESS && fgets(line, sizeof(line), f) != NULL) {
+                unsigned region, launch;
+                uint64_t start, end;
+                char kernel[128];
+                if (sscanf(line, "%u,%127[^,],%u,%" SCNu64 ",%" SCNu64,
+                           &region, kernel, &launch, &start, &end) != 5) {
+                        bsg_pr_err("malformed region: %s", line);
+                        rc = HB_MC_FAIL;
+                        break;
+                }
+
+                bsg_pr_test_info("region %u: '%s' launch %u, cycles %" PRIu64 "-%" PRIu64 "\n",
+                                 region, kernel, launch, start, end);
+
+                if (launch != TRACED || strcmp(kernel, "kernel_vec_add_parallel") != 0 || end < start) {
+                        bsg_pr_err("unexpected region\n");
+                        rc = HB_MC_FAIL;
+                }
+                regions++;
+        }
+
+        fclose(f);
+
+        if (rc == HB_MC_SUCCESS && regions != 1) {
+                bsg_pr_err("expected 1 region, found %d\n", regions);
+                rc = HB_MC_FAIL;
+        }
+
+        return rc;
+}
+
+int kernel_trace_regions (int argc, char **argv) {
+        char *bin_path, *test_name;
+        struct arguments_path args = {NULL, NULL};
+
+        argp_parse (&argp_path, argc, argv, 0, 0, &args);
+        bin_path = args.path;
+        test_name = args.name;
+
+        bsg_pr_test_info("Running the CUDA Vector Addition Kernel %d times, tracing launch %d.\n\n",
+                         LAUNCHES, TRACED);
+
+        hb_mc_device_t device;
+        BSG_CUDA_CALL(hb_mc_device_init(&device, test_name, HB_MC_DEVICE_ID));
+        BSG_CUDA_CALL(hb_mc_device_program_init(&device, bin_path, ALLOC_NAME, 0));
+
+        BSG_CUDA_CALL(hb_mc_device_trace_regions_set(&device, "#1", HB_MC_TRACE_REGION_TRACE));
+
+        uint32_t N = 1024;
+        uint32_t block_size_x = 256;
+        eva_t A_device, B_device, C_device;
+        BSG_CUDA_CALL(hb_mc_device_malloc(&device, N * sizeof(uint32_t), &A_device));
+        BSG_CUDA_CALL(hb_mc_device_malloc(&device, N * sizeof(uint32_t), &B_device));
+        BSG_CUDA_CALL(hb_mc_device_malloc(&device, N * sizeof(uint32_t), &C_device));
+
+        hb_mc_dimension_t tg_dim = { .x = 2, .y = 2 };
+        hb_mc_dimension_t grid_dim = { .x = N / block_size_x, .y = 1 };
+        uint32_t cuda_argv[5] = {A_device, B_device, C_device, N, block_size_x};
+
+        for (int i = 0; i < LAUNCHES; i++) {
+                BSG_CUDA_CALL(hb_mc_kernel_enqueue (&device, grid_dim, tg_dim,
+                                                    "kernel_vec_add_parallel", 5, cuda_argv));
+                BSG_CUDA_CALL(hb_mc_device_tile_groups_execute(&device));
+        }
+
+        BSG_CUDA_CALL(hb_mc_device_finish(&device));
+
+        const char *path = getenv("HB_MC_TRACE_REGIONS_FILE");
+        return check_regions(path != NULL ? path : HB_MC_TRACE_REGIONS_FILE);
+}
+
+declare_program_main("test_trace_regions", kernel_trace_regions);
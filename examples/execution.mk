@@ -47,6 +47,12 @@ stats: profile.log
 blood: profile.log
 	PYTHONPATH=$(BSG_MANYCORE_DIR)/software/py/ python3 -m vanilla_parser --stats $(VANILLA_STATS) --vcache-stats $(VCACHE_STATS)  --tile-group --tile --cache-line-words $(BSG_MACHINE_VCACHE_LINE_WORDS)
 
+# Summarize the stream recorded by running with
+# HB_MC_STATS_STREAM=$(STATS_STREAM), without the CSV round trip
+STATS_STREAM ?= stats_stream.bin
+stats_stream: $(BSG_PLATFORM_PATH)/hb_mc_stats_reader
+	$< -n $(STATS_STREAM)
+
 .PHONY: execution.clean
 execution.clean: 
 	rm -rf *.log
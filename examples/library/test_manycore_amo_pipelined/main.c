@@ -0,0 +1,158 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_regression.h>
+#include <bsg_manycore.h>
+#include <bsg_manycore_npa.h>
+#include <bsg_manycore_printing.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_NAME "test_manycore_amo_pipelined"
+
+#define test_pr_err(msg, ...)                           \
+        bsg_pr_err(TEST_NAME ": " msg , ##__VA_ARGS__)
+
+hb_mc_manycore_t manycore, *mc = &manycore;
+
+/* more than the remote load capacity, so that load ids are reused */
+#define WORDS 256
+
+hb_mc_npa_t target_npas [WORDS];
+uint32_t    vpi         [WORDS];
+uint32_t    vpo         [WORDS];
+uint32_t    in          [WORDS];
+
+/*
+ * Many AMOs to one word: they are applied in order, so each sees the
+ * sum of the ones before it.
+ */
+static int test_same_word(hb_mc_npa_t base)
+{
+        int i, err;
+
+        err = hb_mc_manycore_write32(mc, &base, 0);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        for (i = 0; i < WORDS; i++) {
+                target_npas[i] = base;
+                vpi[i] = 1;
+        }
+
+        err = hb_mc_manycore_amo32_n(mc, HB_MC_PACKET_OP_REMOTE_AMOADD,
+                                     target_npas, vpi, vpo, WORDS);
+        if (err != HB_MC_SUCCESS) {
+                test_pr_err("pipelined amoadd failed: %s\n", hb_mc_strerror(err));
+                return err;
+        }
+
+        for (i = 0; i < WORDS; i++) {
+                if (vpo[i] != i) {
+                        test_pr_err("amoadd %d returned %" PRIu32 ", expected %d\n",
+                                    i, vpo[i], i);
+                        return HB_MC_FAIL;
+                }
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/*
+ * One AMO to each of many words, discarding the previous values, then
+ * read them back.
+ */
+static int test_many_words(hb_mc_npa_t base)
+{
+        int i, err;
+
+        for (i = 0; i < WORDS; i++) {
+                target_npas[i] = hb_mc_npa_from_x_y(hb_mc_npa_get_x(&base),
+                                                    hb_mc_npa_get_y(&base),
+                                                    hb_mc_npa_get_epa(&base) + i * sizeof(uint32_t));
+                vpi[i] = (uint32_t)rand();
+        }
+
+        err = hb_mc_manycore_amo32_n(mc, HB_MC_PACKET_OP_REMOTE_AMOSWAP,
+                                     target_npas, vpi, NULL, WORDS);
+        if (err != HB_MC_SUCCESS) {
+                test_pr_err("pipelined amoswap failed: %s\n", hb_mc_strerror(err));
+                return err;
+        }
+
+        err = hb_mc_manycore_read_mem(mc, &base, in, sizeof(in));
+        if (err != HB_MC_SUCCESS) {
+                test_pr_err("failed to read back: %s\n", hb_mc_strerror(err));
+                return err;
+        }
+
+        for (i = 0; i < WORDS; i++) {
+                if (in[i] != vpi[i]) {
+                        test_pr_err("word %d is %08" PRIx32 ", expected %08" PRIx32 "\n",
+                                    i, in[i], vpi[i]);
+                        return HB_MC_FAIL;
+                }
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+static int run_tests(int argc, char *argv[])
+{
+        int err, rc = HB_MC_FAIL;
+
+        err = hb_mc_manycore_init(mc, TEST_NAME, HB_MC_DEVICE_ID);
+        if (err != HB_MC_SUCCESS) {
+                test_pr_err("failed to initialize manycore: %s\n",
+                            hb_mc_strerror(err));
+                goto done;
+        }
+
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        hb_mc_coordinate_t pod = {.x=0, .y=0};
+        hb_mc_idx_t y = hb_mc_config_pod_dram_y(cfg, pod, 0);
+        hb_mc_idx_t base_x = hb_mc_config_get_vcore_base_x(cfg);
+        hb_mc_npa_t base = hb_mc_npa_from_x_y(base_x, y, 0);
+
+        err = test_same_word(base);
+        if (err != HB_MC_SUCCESS)
+                goto cleanup;
+
+        err = test_many_words(base);
+        if (err != HB_MC_SUCCESS)
+                goto cleanup;
+
+        rc = HB_MC_SUCCESS;
+
+cleanup:
+        hb_mc_manycore_exit(mc);
+done:
+        return rc;
+}
+
+declare_program_main(TEST_NAME, run_tests);
@@ -0,0 +1,124 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_regression.h>
+#include <bsg_manycore.h>
+#include <bsg_manycore_api_stats.h>
+#include <bsg_manycore_npa.h>
+#include <bsg_manycore_printing.h>
+#include <inttypes.h>
+
+#define TEST_NAME "test_manycore_api_stats"
+
+#define test_pr_err(msg, ...)                           \
+        bsg_pr_err(TEST_NAME ": " msg , ##__VA_ARGS__)
+
+#define CALLS 16
+
+hb_mc_manycore_t manycore, *mc = &manycore;
+
+static int check_calls(hb_mc_api_t api, uint64_t expect)
+{
+        hb_mc_api_stats_t stats;
+        int err = hb_mc_manycore_api_stats_get(mc, api, &stats);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        if (stats.calls != expect) {
+                test_pr_err("%s: expected %" PRIu64 " calls, recorded %" PRIu64 "\n",
+                            hb_mc_api_to_string(api), expect, stats.calls);
+                return HB_MC_FAIL;
+        }
+
+        if (stats.ns_min > stats.ns_max || stats.ns_total < stats.ns_max) {
+                test_pr_err("%s: inconsistent latencies: min %" PRIu64 ", max %" PRIu64
+                            ", total %" PRIu64 "\n",
+                            hb_mc_api_to_string(api), stats.ns_min, stats.ns_max, stats.ns_total);
+                return HB_MC_FAIL;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+static int run_tests(int argc, char *argv[])
+{
+        int i, err, rc = HB_MC_FAIL;
+        uint32_t buf[32];
+
+        err = hb_mc_manycore_init(mc, TEST_NAME, HB_MC_DEVICE_ID);
+        if (err != HB_MC_SUCCESS) {
+                test_pr_err("failed to initialize manycore: %s\n",
+                            hb_mc_strerror(err));
+                return err;
+        }
+
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        hb_mc_coordinate_t pod = {.x=0, .y=0};
+        hb_mc_npa_t npa = hb_mc_npa_from_x_y(hb_mc_config_get_vcore_base_x(cfg),
+                                             hb_mc_config_pod_dram_y(cfg, pod, 0), 0);
+
+        // only count calls made by this test
+        hb_mc_manycore_api_stats_reset(mc);
+
+        for (i = 0; i < CALLS; i++) {
+                buf[0] = i;
+                err = hb_mc_manycore_write_mem(mc, &npa, buf, sizeof(buf));
+                if (err == HB_MC_SUCCESS)
+                        err = hb_mc_manycore_read_mem(mc, &npa, buf, sizeof(buf));
+                if (err != HB_MC_SUCCESS) {
+                        test_pr_err("memory access %d failed: %s\n", i, hb_mc_strerror(err));
+                        goto cleanup;
+                }
+        }
+
+        err = hb_mc_manycore_host_request_fence(mc, -1);
+        if (err != HB_MC_SUCCESS)
+                goto cleanup;
+
+        err = check_calls(HB_MC_API_WRITE_MEM, CALLS);
+        if (err == HB_MC_NOIMPL) {
+                bsg_pr_test_info("library built without API statistics (LIB_API_STATS=0)\n");
+                rc = HB_MC_SUCCESS;
+                goto cleanup;
+        }
+        if (err == HB_MC_SUCCESS)
+                err = check_calls(HB_MC_API_READ_MEM, CALLS);
+        if (err == HB_MC_SUCCESS)
+                err = check_calls(HB_MC_API_FENCE, 1);
+        if (err != HB_MC_SUCCESS)
+                goto cleanup;
+
+        hb_mc_manycore_api_stats_print(mc);
+        rc = HB_MC_SUCCESS;
+
+cleanup:
+        hb_mc_manycore_exit(mc);
+        return rc;
+}
+
+declare_program_main(TEST_NAME, run_tests);
@@ -0,0 +1,230 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_regression.h>
+#include <bsg_manycore.h>
+#include <bsg_manycore_cmdlist.h>
+#include <bsg_manycore_npa.h>
+#include <bsg_manycore_printing.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TEST_NAME "test_manycore_cmdlist"
+
+#define test_pr_err(msg, ...)                           \
+        bsg_pr_err(TEST_NAME ": " msg , ##__VA_ARGS__)
+
+hb_mc_manycore_t manycore, *mc = &manycore;
+
+/*
+ * Alternate writes to one region with reads from another, as a host
+ * tool walking device structures would, first with serial calls and
+ * then as one command list. Compare results and throughput.
+ */
+#define WORDS 512
+
+uint32_t src     [WORDS];
+uint32_t dst     [WORDS];
+uint32_t serial  [WORDS];
+uint32_t results [2 * WORDS + 4];
+
+static hb_mc_npa_t word_npa(const hb_mc_npa_t *base, int i)
+{
+        return hb_mc_npa_from_x_y(hb_mc_npa_get_x(base),
+                                  hb_mc_npa_get_y(base),
+                                  hb_mc_npa_get_epa(base) + i * sizeof(uint32_t));
+}
+
+static uint64_t host_ns(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int run_serial(const hb_mc_npa_t *rd, const hb_mc_npa_t *wr)
+{
+        int i, err;
+
+        for (i = 0; i < WORDS; i++) {
+                hb_mc_npa_t w = word_npa(wr, i), r = word_npa(rd, i);
+
+                err = hb_mc_manycore_write32(mc, &w, dst[i]);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+
+                err = hb_mc_manycore_read32(mc, &r, &serial[i]);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+static int run_cmdlist(hb_mc_cmdlist_t *cl, const hb_mc_npa_t *rd, const hb_mc_npa_t *wr)
+{
+        int i, err;
+
+        for (i = 0; i < WORDS; i++) {
+                hb_mc_npa_t w = word_npa(wr, i), r = word_npa(rd, i);
+
+                err = hb_mc_cmdlist_write32(cl, &w, dst[i], NULL);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+
+                err = hb_mc_cmdlist_read32(cl, &r, NULL);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+        }
+
+        return hb_mc_manycore_cmdlist_submit(mc, cl, results);
+}
+
+/*
+ * Declared ordering: bump a counter, read it back only after the bump
+ * completes, then fence and read back a word written before the fence.
+ */
+static int run_dependencies(hb_mc_cmdlist_t *cl, const hb_mc_npa_t *base)
+{
+        size_t amo, rd, after;
+        int err;
+        hb_mc_npa_t counter = word_npa(base, 0), other = word_npa(base, 1);
+
+        hb_mc_cmdlist_reset(cl);
+
+        err = hb_mc_cmdlist_write32(cl, &counter, 41, NULL);
+        if (err == HB_MC_SUCCESS)
+                err = hb_mc_cmdlist_fence(cl, NULL);
+        if (err == HB_MC_SUCCESS)
+                err = hb_mc_cmdlist_amo32(cl, HB_MC_PACKET_OP_REMOTE_AMOADD, &counter, 1, &amo);
+        if (err == HB_MC_SUCCESS)
+                err = hb_mc_cmdlist_write32(cl, &other, 0xcafef00d, NULL);
+        if (err == HB_MC_SUCCESS)
+                err = hb_mc_cmdlist_read32(cl, &counter, &rd);
+        if (err == HB_MC_SUCCESS)
+                err = hb_mc_cmdlist_depend(cl, rd, amo);
+        if (err == HB_MC_SUCCESS)
+                err = hb_mc_cmdlist_fence(cl, NULL);
+        if (err == HB_MC_SUCCESS)
+                err = hb_mc_cmdlist_read32(cl, &other, &after);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        err = hb_mc_manycore_cmdlist_submit(mc, cl, results);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        if (results[amo] != 41 || results[rd] != 42 || results[after] != 0xcafef00d) {
+                test_pr_err("dependencies not respected: amo = %" PRIu32 ", read = %" PRIu32
+                            ", after fence = %08" PRIx32 "\n",
+                            results[amo], results[rd], results[after]);
+                return HB_MC_FAIL;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+static int run_tests(int argc, char *argv[])
+{
+        int i, err, rc = HB_MC_FAIL;
+        hb_mc_cmdlist_t cl;
+        uint64_t t0, t1, t2, c0, c1, c2;
+
+        hb_mc_cmdlist_init(&cl);
+
+        err = hb_mc_manycore_init(mc, TEST_NAME, HB_MC_DEVICE_ID);
+        if (err != HB_MC_SUCCESS) {
+                test_pr_err("failed to initialize manycore: %s\n",
+                            hb_mc_strerror(err));
+                goto done;
+        }
+
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        hb_mc_coordinate_t pod = {.x=0, .y=0};
+        hb_mc_idx_t y = hb_mc_config_pod_dram_y(cfg, pod, 0);
+        hb_mc_idx_t base_x = hb_mc_config_get_vcore_base_x(cfg);
+        hb_mc_npa_t rd = hb_mc_npa_from_x_y(base_x, y, 0);
+        hb_mc_npa_t wr = word_npa(&rd, WORDS);
+        hb_mc_npa_t scratch = word_npa(&rd, 2 * WORDS);
+
+        for (i = 0; i < WORDS; i++) {
+                src[i] = (uint32_t)rand();
+                dst[i] = (uint32_t)rand();
+        }
+
+        err = hb_mc_manycore_write_mem(mc, &rd, src, sizeof(src));
+        if (err != HB_MC_SUCCESS)
+                goto cleanup;
+
+        hb_mc_manycore_get_cycle(mc, &c0);
+        t0 = host_ns();
+        err = run_serial(&rd, &wr);
+        if (err != HB_MC_SUCCESS) {
+                test_pr_err("serial calls failed: %s\n", hb_mc_strerror(err));
+                goto cleanup;
+        }
+
+        hb_mc_manycore_get_cycle(mc, &c1);
+        t1 = host_ns();
+        err = run_cmdlist(&cl, &rd, &wr);
+        if (err != HB_MC_SUCCESS) {
+                test_pr_err("command list failed: %s\n", hb_mc_strerror(err));
+                goto cleanup;
+        }
+        hb_mc_manycore_get_cycle(mc, &c2);
+        t2 = host_ns();
+
+        for (i = 0; i < WORDS; i++) {
+                if (serial[i] != src[i] || results[2 * i + 1] != src[i]) {
+                        test_pr_err("word %d: serial %08" PRIx32 ", command list %08" PRIx32
+                                    ", expected %08" PRIx32 "\n",
+                                    i, serial[i], results[2 * i + 1], src[i]);
+                        goto cleanup;
+                }
+        }
+
+        bsg_pr_test_info("%d writes + %d reads, serial:       %" PRIu64 " ns, %" PRIu64 " cycles\n",
+                         WORDS, WORDS, t1 - t0, c1 - c0);
+        bsg_pr_test_info("%d writes + %d reads, command list: %" PRIu64 " ns, %" PRIu64 " cycles\n",
+                         WORDS, WORDS, t2 - t1, c2 - c1);
+
+        err = run_dependencies(&cl, &scratch);
+        if (err != HB_MC_SUCCESS)
+                goto cleanup;
+
+        rc = HB_MC_SUCCESS;
+
+cleanup:
+        hb_mc_manycore_exit(mc);
+done:
+        hb_mc_cmdlist_cleanup(&cl);
+        return rc;
+}
+
+declare_program_main(TEST_NAME, run_tests);
@@ -0,0 +1,115 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_regression.h>
+#include <bsg_manycore_printing.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TEST_NAME "test_printing_perf"
+
+/*
+ * Measure the host cost of the bsg_pr_* family. Output goes to
+ * /dev/null so that the numbers reflect formatting and prefixing,
+ * not the terminal.
+ */
+#define CALLS 200000
+
+static uint64_t host_ns(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static const char *long_arg =
+        "the quick brown fox jumps over the lazy dog, "
+        "the quick brown fox jumps over the lazy dog, "
+        "the quick brown fox jumps over the lazy dog";
+
+static uint64_t bench_single_line(void)
+{
+        uint64_t t = host_ns();
+        for (int i = 0; i < CALLS; i++)
+                bsg_pr_info("%s: iteration %d of %d\n", TEST_NAME, i, CALLS);
+        return host_ns() - t;
+}
+
+static uint64_t bench_multi_line(void)
+{
+        uint64_t t = host_ns();
+        for (int i = 0; i < CALLS; i++)
+                bsg_pr_warn("iteration %d\nfirst line\nsecond line: %s\n", i, long_arg);
+        return host_ns() - t;
+}
+
+static uint64_t bench_partial_lines(void)
+{
+        uint64_t t = host_ns();
+        for (int i = 0; i < CALLS; i++) {
+                bsg_pr_err("value = ");
+                bsg_pr_err("%08x\n", i);
+        }
+        return host_ns() - t;
+}
+
+static int run_tests(int argc, char *argv[])
+{
+        uint64_t single, multi, partial;
+        int saved, null;
+
+        fflush(stderr);
+        saved = dup(STDERR_FILENO);
+        null = open("/dev/null", O_WRONLY);
+        if (saved < 0 || null < 0) {
+                bsg_pr_err(TEST_NAME ": failed to redirect stderr: %m\n");
+                return HB_MC_FAIL;
+        }
+        dup2(null, STDERR_FILENO);
+
+        single  = bench_single_line();
+        multi   = bench_multi_line();
+        partial = bench_partial_lines();
+
+        fflush(stderr);
+        dup2(saved, STDERR_FILENO);
+        close(saved);
+        close(null);
+
+        bsg_pr_test_info("single line:   %" PRIu64 " ns/call\n", single / CALLS);
+        bsg_pr_test_info("three lines:   %" PRIu64 " ns/call\n", multi / CALLS);
+        bsg_pr_test_info("partial lines: %" PRIu64 " ns/call\n", partial / (2 * CALLS));
+
+        return HB_MC_SUCCESS;
+}
+
+declare_program_main(TEST_NAME, run_tests);
@@ -0,0 +1,144 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_regression.h>
+#include <bsg_manycore.h>
+#include <bsg_manycore_npa.h>
+#include <bsg_manycore_printing.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define TEST_NAME "test_read_mem_perf"
+
+#define test_pr_err(msg, ...)                           \
+        bsg_pr_err(TEST_NAME ": " msg , ##__VA_ARGS__)
+
+hb_mc_manycore_t manycore, *mc = &manycore;
+
+/*
+ * Microbenchmark for hb_mc_manycore_read_mem(): host CPU time spent per
+ * word read, which is what the response reorder buffer is meant to keep
+ * small. On simulated platforms this includes simulator time.
+ */
+#define WORDS 4096
+#define ITERS 8
+
+uint32_t out [WORDS];
+uint32_t in  [WORDS];
+
+/* host timestamp counter, or 0 where there is none */
+static uint64_t host_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return 0;
+#endif
+}
+
+static uint64_t host_ns(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int run_tests(int argc, char *argv[])
+{
+        int i, err, rc = HB_MC_FAIL;
+        uint64_t best_cycles = UINT64_MAX, best_ns = UINT64_MAX;
+        uint64_t total_cycles = 0, total_ns = 0;
+
+        err = hb_mc_manycore_init(mc, TEST_NAME, HB_MC_DEVICE_ID);
+        if (err != HB_MC_SUCCESS) {
+                test_pr_err("failed to initialize manycore: %s\n",
+                            hb_mc_strerror(err));
+                goto done;
+        }
+
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        hb_mc_coordinate_t pod = {.x=0, .y=0};
+        hb_mc_idx_t y = hb_mc_config_pod_dram_y(cfg, pod, 0);
+        hb_mc_idx_t base_x = hb_mc_config_get_vcore_base_x(cfg);
+        hb_mc_npa_t npa = hb_mc_npa_from_x_y(base_x, y, 0);
+
+        for (i = 0; i < WORDS; i++)
+                out[i] = (uint32_t)rand();
+
+        err = hb_mc_manycore_write_mem(mc, &npa, out, sizeof(out));
+        if (err != HB_MC_SUCCESS) {
+                test_pr_err("failed to write: %s\n", hb_mc_strerror(err));
+                goto cleanup;
+        }
+
+        for (i = 0; i < ITERS; i++) {
+                memset(in, 0, sizeof(in));
+
+                uint64_t c0 = host_cycles(), t0 = host_ns();
+                err = hb_mc_manycore_read_mem(mc, &npa, in, sizeof(in));
+                uint64_t c1 = host_cycles(), t1 = host_ns();
+
+                if (err != HB_MC_SUCCESS) {
+                        test_pr_err("failed to read: %s\n", hb_mc_strerror(err));
+                        goto cleanup;
+                }
+
+                if (memcmp(out, in, sizeof(in)) != 0) {
+                        test_pr_err("read back data does not match on iteration %d\n", i);
+                        goto cleanup;
+                }
+
+                total_cycles += c1 - c0;
+                total_ns += t1 - t0;
+                if (c1 - c0 < best_cycles)
+                        best_cycles = c1 - c0;
+                if (t1 - t0 < best_ns)
+                        best_ns = t1 - t0;
+        }
+
+        bsg_pr_test_info("read_mem: %d words x %d iterations\n", WORDS, ITERS);
+        bsg_pr_test_info("host cycles/word: best %.2f, mean %.2f\n",
+                         (double)best_cycles / WORDS,
+                         (double)total_cycles / (WORDS * ITERS));
+        bsg_pr_test_info("host ns/word:     best %.2f, mean %.2f\n",
+                         (double)best_ns / WORDS,
+                         (double)total_ns / (WORDS * ITERS));
+
+        rc = HB_MC_SUCCESS;
+
+cleanup:
+        hb_mc_manycore_exit(mc);
+done:
+        return rc;
+}
+
+declare_program_main(TEST_NAME, run_tests);
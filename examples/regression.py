@@ -0,0 +1,416 @@
+# Copyright (c) 2021, University of Washington All rights reserved.
+# 
+# Redistribution and use in source and binary forms, with or without modification,
+# are permitted provided that the following conditions are met:
+# 
+# Redistributions of source code must retain the above copyright notice, this list
+# of conditions and the following disclaimer.
+# 
+# Redistributions in binary form must reproduce the above copyright notice, this
+# list of conditions and the following disclaimer in the documentation and/or
+# other materials provided with the distribution.
+# 
+# Neither the name of the copyright holder nor the names of its contributors may
+# be used to endorse or promote products derived from this software without
+# specific prior written permission.
+# 
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+# ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+# ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+# (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+# LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+# ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""Run regression tests in parallel, time them, and skip unchanged ones.
+
+Each test is run with `make -C <test> regression`, as the suite
+Makefiles do, so a test passes when that command succeeds. Tests are
+scheduled across host cores, limited by:
+
+  --jobs        tests running at once (default: number of cores)
+  --licenses    tests holding a simulator license at once
+  --mem-budget  GiB of memory the running tests may use together,
+                each charged --mem-per-test GiB unless --mem overrides it
+
+Every run writes a JSON summary with the outcome, wall time and
+device cycles of each test. Device cycles come from the
+"BSG REGRESSION CYCLES" line the regression harness prints after the
+test when HB_MC_REPORT_CYCLES is set.
+
+A test is skipped when the hash of its inputs matches a passing run
+in the cache. The inputs are the tracked files in the test directory
+and in any directory its Makefile reaches with a relative "../" path
+(or lists in EXTRA_INPUTS below), the tracked files of the runtime
+(libraries/, hardware/, the example Makefile fragments and the suite
+Makefiles), the platform and machine selected in the environment, and
+the BSG Manycore commit together with its uncommitted and untracked
+changes, which cover the SPMD sources.
+
+Pass a summary from an earlier run as --baseline to flag tests whose
+cycles or wall time grew by more than a threshold.
+
+The runtime and simulator must already be built, e.g. with
+`make parallel-regression` in this directory.
+"""
+
+import argparse
+import fnmatch
+import glob
+import hashlib
+import json
+import os
+import re
+import signal
+import subprocess
+import sys
+import threading
+import time
+
+EXAMPLES_PATH = os.path.dirname(os.path.abspath(__file__))
+REPLICANT_PATH = os.path.dirname(EXAMPLES_PATH)
+SUITES = ["library", "spmd", "cuda", "python"]
+CYCLES_RE = re.compile(rb"BSG REGRESSION CYCLES (\d+)")
+RUN_LOG = "regression_run.log"
+# a relative path out of the test directory in its Makefile, e.g. -I../other_test
+RELATIVE_RE = re.compile(r"(?:^|[\s=])(?:-I)?(\.\./[^\s:;)]*)", re.M)
+
+# Inputs of a test that its Makefile does not name with a "../" path,
+# as globs relative to the repository root
+EXTRA_INPUTS = {
+    # "cuda/some_test": ["examples/cuda/shared_inputs/*"],
+}
+
+
+def list_tests(suite):
+    """Ask make for the TESTS of a suite, so computed lists are included"""
+    out = subprocess.run(["make", "-s", "--no-print-directory", "-C", suite,
+                          "--eval=regression.list-tests: ; @echo $(TESTS)",
+                          "regression.list-tests"],
+                         cwd=EXAMPLES_PATH, stdout=subprocess.PIPE, check=True)
+    return [os.path.join(suite, t) for t in out.stdout.decode().split()]
+
+
+def hash_tracked(h, paths, cwd=REPLICANT_PATH, ls_args=()):
+    """Add the names and contents of the git-tracked files under paths"""
+    out = subprocess.run(["git", "ls-files", "-z"] + list(ls_args) + ["--"] + paths,
+                         cwd=cwd, stdout=subprocess.PIPE, check=True)
+    for f in sorted(out.stdout.split(b"\0")):
+        if not f:
+            continue
+        h.update(f + b"\0")
+        try:
+            with open(os.path.join(cwd, f.decode()), "rb") as fd:
+                h.update(hashlib.sha256(fd.read()).digest())
+        except FileNotFoundError:
+            h.update(b"deleted")
+
+
+def runtime_hash():
+    """Hash the inputs that every test shares"""
+    h = hashlib.sha256()
+    hash_tracked(h, ["libraries", "hardware", "environment.mk",
+                     "examples/*.mk", "examples/*/Makefile"])
+    for var in ["BSG_PLATFORM", "BSG_MACHINE_PATH", "BSG_MACHINE"]:
+        h.update(("%s=%s\0" % (var, os.environ.get(var, ""))).encode())
+    manycore = os.environ.get("BSG_MANYCORE_DIR")
+    if manycore:
+        # SPMD tests build their sources from here, edited or not
+        for cmd in (["rev-parse", "HEAD"], ["diff", "HEAD", "--binary"]):
+            out = subprocess.run(["git", "-C", manycore] + cmd,
+                                 stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+            h.update(out.stdout)
+        hash_tracked(h, [], cwd=manycore, ls_args=["--others", "--exclude-standard"])
+    return h.hexdigest()
+
+
+def test_inputs(test):
+    """The directories and files, relative to the repository, a test reads"""
+    test_dir = os.path.join("examples", test)
+    inputs = {test_dir}
+    try:
+        with open(os.path.join(REPLICANT_PATH, test_dir, "Makefile")) as f:
+            makefile = f.read()
+    except IOError:
+        makefile = ""
+    for rel in RELATIVE_RE.findall(makefile):
+        path = os.path.normpath(os.path.join(test_dir, rel))
+        if not path.startswith(".."):
+            inputs.add(path)
+    for pattern, globs in EXTRA_INPUTS.items():
+        if fnmatch.fnmatch(test, pattern):
+            for g in globs:
+                inputs.update(os.path.relpath(p, REPLICANT_PATH)
+                              for p in glob.glob(os.path.join(REPLICANT_PATH, g)))
+    return sorted(inputs)
+
+
+def test_hash(test, shared):
+    h = hashlib.sha256(shared.encode())
+    h.update(test.encode() + b"\0")
+    hash_tracked(h, test_inputs(test))
+    return h.hexdigest()
+
+
+def load_json(path, default):
+    try:
+        with open(path) as f:
+            return json.load(f)
+    except (IOError, ValueError):
+        return default
+
+
+class Scheduler(object):
+    """Admit tests while jobs, licenses and memory allow
+
+    Only the dispatch loop in main() calls acquire(), one test at a
+    time in the order given, so a test that has to wait for room also
+    holds back the tests after it: the longest-first order holds.
+    """
+
+    def __init__(self, args):
+        self.args = args
+        self.lock = threading.Condition()
+        self.jobs = 0
+        self.licenses = 0
+        self.mem = 0.0
+
+    def mem_for(self, test):
+        for pattern, gib in self.args.mem:
+            if fnmatch.fnmatch(test, pattern):
+                return gib
+        return self.args.mem_per_test
+
+    def fits(self, mem):
+        a = self.args
+        if self.jobs >= a.jobs:
+            return False
+        if a.licenses and self.licenses >= a.licenses:
+            return False
+        # a test bigger than the whole budget still runs, alone
+        if a.mem_budget and self.mem + mem > a.mem_budget and self.jobs > 0:
+            return False
+        return True
+
+    def acquire(self, test):
+        mem = self.mem_for(test)
+        with self.lock:
+            while not self.fits(mem):
+                self.lock.wait()
+            self.jobs += 1
+            self.licenses += 1
+            self.mem += mem
+        return mem
+
+    def release(self, mem):
+        with self.lock:
+            self.jobs -= 1
+            self.licenses -= 1
+            self.mem -= mem
+            self.lock.notify_all()
+
+
+def kill_group(p):
+    """Kill a test's make and everything it started, and wait for them to exit"""
+    try:
+        os.killpg(p.pid, signal.SIGKILL)
+    except ProcessLookupError:
+        pass
+    p.wait()
+    # the simulator holds its license and memory until it is gone, not just make
+    while True:
+        try:
+            os.killpg(p.pid, 0)
+        except ProcessLookupError:
+            break
+        time.sleep(0.1)
+
+
+def run_test(test, args):
+    """Run one test and return its result"""
+    env = dict(os.environ, HB_MC_REPORT_CYCLES="1")
+    # each test gets its own make, not a share of ours
+    env.pop("MAKEFLAGS", None)
+    env.pop("MFLAGS", None)
+
+    log = os.path.join(EXAMPLES_PATH, test, RUN_LOG)
+    start = time.time()
+    status = "fail"
+    with open(log, "wb") as f:
+        # in its own session, so that a timeout can kill the simulator make started
+        p = subprocess.Popen(["make", "-C", test, "regression"], cwd=EXAMPLES_PATH,
+                             env=env, stdout=f, stderr=subprocess.STDOUT,
+                             start_new_session=True)
+        try:
+            status = "pass" if p.wait(timeout=args.timeout or None) == 0 else "fail"
+        except subprocess.TimeoutExpired:
+            kill_group(p)
+            status = "timeout"
+        except BaseException:
+            kill_group(p)
+            raise
+    wall = time.time() - start
+
+    cycles = None
+    with open(log, "rb") as f:
+        found = CYCLES_RE.findall(f.read())
+        if found:
+            cycles = int(found[-1])
+
+    return {"test": test, "status": status, "wall_s": round(wall, 3),
+            "cycles": cycles, "log": os.path.relpath(log, EXAMPLES_PATH)}
+
+
+def compare(result, base, args):
+    """Describe how a result regressed against its baseline, if it did"""
+    why = []
+    if result.get("cycles") and base.get("cycles"):
+        grew = (result["cycles"] - base["cycles"]) * 100.0 / base["cycles"]
+        if grew > args.cycle_threshold:
+            why.append("cycles %d -> %d (+%.1f%%)" % (base["cycles"], result["cycles"], grew))
+    if base.get("wall_s") and args.time_threshold:
+        grew = (result["wall_s"] - base["wall_s"]) * 100.0 / base["wall_s"]
+        if grew > args.time_threshold:
+            why.append("wall %.1fs -> %.1fs (+%.1f%%)" % (base["wall_s"], result["wall_s"], grew))
+    return why
+
+
+def parse_args():
+    p = argparse.ArgumentParser(description=__doc__,
+                                formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("targets", nargs="*",
+                   help="suites (%s) or test directories; default: all suites" % ", ".join(SUITES))
+    p.add_argument("-j", "--jobs", type=int, default=os.cpu_count() or 1)
+    p.add_argument("--licenses", type=int, default=0,
+                   help="simulator licenses available (default: unlimited)")
+    p.add_argument("--mem-budget", type=float, default=0,
+                   help="GiB available to running tests (default: unlimited)")
+    p.add_argument("--mem-per-test", type=float, default=1.0,
+                   help="GiB charged to each test against --mem-budget")
+    p.add_argument("--mem", action="append", default=[], metavar="GLOB=GIB",
+                   help="charge tests matching GLOB this many GiB instead")
+    p.add_argument("--timeout", type=float, default=0,
+                   help="seconds before a test is stopped (default: none)")
+    p.add_argument("--summary", default="regression_summary.json")
+    p.add_argument("--baseline", help="a summary from an earlier run")
+    p.add_argument("--cycle-threshold", type=float, default=2.0,
+                   help="percent growth in cycles flagged against the baseline")
+    p.add_argument("--time-threshold", type=float, default=0,
+                   help="percent growth in wall time flagged against the baseline (default: off)")
+    p.add_argument("--fail-on-regression", action="store_true",
+                   help="exit with an error if a test regressed against the baseline")
+    p.add_argument("--cache", default="regression_cache.json")
+    p.add_argument("--no-cache", action="store_true", help="run every test")
+    args = p.parse_args()
+
+    mem = []
+    for m in args.mem:
+        pattern, _, gib = m.rpartition("=")
+        if not pattern:
+            p.error("--mem expects GLOB=GIB, got '%s'" % m)
+        mem.append((pattern, float(gib)))
+    args.mem = mem
+    return args
+
+
+def main():
+    args = parse_args()
+    os.chdir(EXAMPLES_PATH)
+
+    tests = []
+    for t in args.targets or SUITES:
+        t = os.path.normpath(t)
+        tests.extend(list_tests(t) if t in SUITES else [t])
+
+    cache = {} if args.no_cache else load_json(args.cache, {})
+    baseline = {r["test"]: r for r in load_json(args.baseline, {}).get("tests", [])} \
+        if args.baseline else {}
+    shared = runtime_hash()
+
+    results = []
+    pending = []
+    for t in tests:
+        h = test_hash(t, shared)
+        hit = cache.get(t)
+        if hit and hit.get("hash") == h:
+            results.append(dict(hit, test=t, status="cached"))
+            print("CACHED: %s" % t)
+        else:
+            pending.append((t, h))
+
+    # start the longest tests first, so the slowest one does not run alone at the end
+    pending.sort(key=lambda th: -baseline.get(th[0], cache.get(th[0], {})).get("wall_s", 0))
+
+    sched = Scheduler(args)
+    lock = threading.Lock()
+    threads = []
+    start = time.time()
+
+    def worker(test, h, mem):
+        try:
+            r = run_test(test, args)
+        finally:
+            sched.release(mem)
+        r["hash"] = h
+        with lock:
+            results.append(r)
+            if r["status"] == "pass":
+                cache[test] = {"hash": h, "wall_s": r["wall_s"], "cycles": r["cycles"]}
+            else:
+                cache.pop(test, None)
+            cycles = "" if r["cycles"] is None else ", %d cycles" % r["cycles"]
+            print("%s: %s (%.1fs%s)" % (r["status"].upper(), test, r["wall_s"], cycles))
+            sys.stdout.flush()
+
+    # dispatch in order: each test starts only once there is room for it
+    for t, h in pending:
+        mem = sched.acquire(t)
+        th = threading.Thread(target=worker, args=(t, h, mem))
+        th.start()
+        threads.append(th)
+    for th in threads:
+        th.join()
+
+    regressions = 0
+    for r in results:
+        base = baseline.get(r["test"])
+        why = compare(r, base, args) if base and r["status"] == "pass" else []
+        if why:
+            r["regression"] = why
+            regressions += 1
+            print("REGRESSION: %s: %s" % (r["test"], "; ".join(why)))
+
+    results.sort(key=lambda r: tests.index(r["test"]))
+    failed = [r["test"] for r in results if r["status"] in ("fail", "timeout")]
+    summary = {
+        "wall_s": round(time.time() - start, 3),
+        "passed": len(results) - len(failed),
+        "failed": len(failed),
+        "cached": sum(1 for r in results if r["status"] == "cached"),
+        "regressions": regressions,
+        "tests": results,
+    }
+    with open(args.summary, "w") as f:
+        json.dump(summary, f, indent=2)
+    if not args.no_cache:
+        with open(args.cache, "w") as f:
+            json.dump(cache, f, indent=2)
+
+    print("")
+    print("%d of %d tests passed (%d cached), %d regressed; summary in %s" %
+          (summary["passed"], len(results), summary["cached"], regressions, args.summary))
+    for t in failed:
+        print("FAIL: %s (see %s)" % (t, os.path.join(t, RUN_LOG)))
+
+    if failed:
+        return 1
+    if regressions and args.fail_on_regression:
+        return 2
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -25,6 +25,7 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#define BSG_LOG_SUBSYSTEM BSG_LOG_PACKET
 #include <bsg_manycore.h>
 #include <bsg_manycore_platform.h>
 #include <bsg_manycore_dma.h>
@@ -34,6 +35,9 @@
 #include <bsg_manycore_responder.h>
 #include <bsg_manycore_epa.h>
 #include <bsg_manycore_vcache.h>
+#include <bsg_manycore_cmdlist.h>
+#include <bsg_manycore_api_stats.h>
+#include <bsg_manycore_timeline.h>
 
 #include <cinttypes>
 #include <cstdint>
@@ -45,8 +49,6 @@
 #include <cassert>
 
 #include <type_traits>
-#include <stack>
-#include <map>
 #include <queue>
 #include <vector>
 
@@ -69,6 +71,9 @@
 #define manycore_pr_info(mc, fmt, ...)                  \
         bsg_pr_info("%s: " fmt, mc->name, ##__VA_ARGS__)
 
+/* the number of packets formatted at once and handed to the platform */
+static const size_t HB_MC_MANYCORE_PACKET_BATCH = 256;
+
 
 /////////////////////////////////
 /* Flow Control Help Functions */
@@ -84,11 +89,15 @@ static int hb_mc_manycore_get_remote_load_cap(hb_mc_manycore_t *mc, unsigned *ca
 /**
  * Stall until the all requests (and responses to the host) have reached their destination.
  * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
- * @param[in] timeout A timeout counter. Unused - set to -1 to wait forever.
- * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ * @param[in] timeout How long to wait, 0 to poll, or -1 to wait forever.
+ * @return HB_MC_SUCCESS on success. HB_MC_TIMEOUT if requests are still in flight.
+ * Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_manycore_host_request_fence(hb_mc_manycore_t *mc, long timeout)
 {
+        HB_MC_API_PROBE(mc, HB_MC_API_FENCE);
+        HB_MC_TIMELINE_PROBE(mc, "fence", "fence",
+                             HB_MC_TIMELINE_MANYCORE_PID, HB_MC_TIMELINE_THREAD_TID);
         return hb_mc_platform_fence(mc, timeout);
 }
 
@@ -146,6 +155,9 @@ int  hb_mc_manycore_init(hb_mc_manycore_t *mc, const char *name, hb_mc_manycore_
         if (mc->name)
                 return HB_MC_INITIALIZED_TWICE;
 
+        // statistics are enabled once initialization completes
+        mc->stats = nullptr;
+
         // copy name
         mc->name = strdup(name);
         if (!mc->name) {
@@ -208,6 +220,32 @@ int  hb_mc_manycore_init(hb_mc_manycore_t *mc, const char *name, hb_mc_manycore_
                 return err;
         }
 
+        // initialize API call statistics
+        if ((err = hb_mc_manycore_api_stats_init(mc)) != HB_MC_SUCCESS) {
+                hb_mc_platform_cleanup(mc);
+                free((void*)mc->name);
+                return err;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+// device cycle counter when the last manycore exited
+static uint64_t exit_cycle = 0;
+static bool exit_cycle_valid = false;
+
+/**
+ * Get the device cycle counter as read by the last hb_mc_manycore_exit()
+ * @param[out] cycle  The cycle counter
+ * @return HB_MC_SUCCESS on success. HB_MC_NOTFOUND if no manycore has exited,
+ * or the platform has no cycle counter.
+ */
+int hb_mc_manycore_get_exit_cycle(uint64_t *cycle)
+{
+        if (!exit_cycle_valid)
+                return HB_MC_NOTFOUND;
+
+        *cycle = exit_cycle;
         return HB_MC_SUCCESS;
 }
 
@@ -218,12 +256,21 @@ int  hb_mc_manycore_init(hb_mc_manycore_t *mc, const char *name, hb_mc_manycore_
 int hb_mc_manycore_exit(hb_mc_manycore_t *mc)
 {
         int err;
+        uint64_t cycle;
+
+        // kept for the regression harness, which reports it once the device is gone
+        if (hb_mc_manycore_get_cycle(mc, &cycle) == HB_MC_SUCCESS) {
+                exit_cycle = cycle;
+                exit_cycle_valid = true;
+        }
+
         err = hb_mc_responders_quit(mc);
         if (err != HB_MC_SUCCESS) {
                 bsg_pr_err("%s: failed to cleanup responders: %s\n",
                            __func__, hb_mc_strerror(err));
                 return err;
         }
+        hb_mc_manycore_api_stats_cleanup(mc);
         hb_mc_platform_cleanup(mc);
         free((void*)mc->name);
         return HB_MC_SUCCESS;
@@ -255,8 +302,9 @@ int hb_mc_manycore_get_cycle(hb_mc_manycore_t *mc, uint64_t *time)
  * Transmit a request packet to manycore hardware
  * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init()
  * @param[in] request A request packet to transmit to manycore hardware
- * @param[in] timeout A timeout counter. Unused - set to -1 to wait forever.
- * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ * @param[in] timeout How long to wait for room in the transmit fifo, 0 to poll, or -1 to wait forever.
+ * @return HB_MC_SUCCESS on success. HB_MC_TIMEOUT if the packet was not accepted in time.
+ * Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_manycore_request_tx(hb_mc_manycore_t *mc,
                               hb_mc_request_packet_t *request,
@@ -270,8 +318,9 @@ int hb_mc_manycore_request_tx(hb_mc_manycore_t *mc,
  * Receive a response packet from manycore hardware
  * @param[in] mc       A manycore instance initialized with hb_mc_manycore_init()
  * @param[in] response A packet into which data should be read
- * @param[in] timeout  A timeout counter. Unused - set to -1 to wait forever.
- * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ * @param[in] timeout  How long to wait for a response, 0 to poll, or -1 to wait forever.
+ * @return HB_MC_SUCCESS on success. HB_MC_TIMEOUT if no response arrived in time.
+ * Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_manycore_response_rx(hb_mc_manycore_t *mc,
                                hb_mc_response_packet_t *response,
@@ -281,6 +330,110 @@ int hb_mc_manycore_response_rx(hb_mc_manycore_t *mc,
         return hb_mc_platform_receive(mc, (hb_mc_packet_t*)response, HB_MC_FIFO_RX_RSP, timeout);
 }
 
+/**
+ * Transmit an array of request packets to manycore hardware, in order
+ * @param[in]  mc       A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  requests An array of request packets to transmit to manycore hardware
+ * @param[in]  n        The number of packets in #requests
+ * @param[in]  timeout  How long to wait for room in the transmit fifo: microseconds on hardware,
+ *                      simulated cycles in simulation, 0 to poll, or -1 to wait forever.
+ *                      Passed to hb_mc_platform_transmit_n().
+ * @param[out] sent     The number of packets accepted, always a prefix of #requests
+ * @return HB_MC_SUCCESS if all #n packets were sent. HB_MC_BUSY if responses must be
+ * read before more requests are accepted. HB_MC_TIMEOUT if the rest were not accepted in time.
+ * Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_request_tx_n(hb_mc_manycore_t *mc,
+                                hb_mc_request_packet_t *requests,
+                                size_t n,
+                                long timeout,
+                                size_t *sent)
+{
+        static_assert(sizeof(hb_mc_request_packet_t) == sizeof(hb_mc_packet_t),
+                      "request packets must be packet-sized to be sent as an array");
+        return hb_mc_platform_transmit_n(mc, (hb_mc_packet_t*)requests, n,
+                                         HB_MC_FIFO_TX_REQ, timeout, sent);
+}
+
+/**
+ * Receive up to #n response packets from manycore hardware
+ * @param[in]  mc        A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] responses An array of at least #n packets into which data should be read
+ * @param[in]  n         The maximum number of packets to read - at most the number outstanding
+ * @param[in]  timeout   Set to -1 to wait forever, or 0 to return HB_MC_TIMEOUT if no packet is ready.
+ * @param[out] received  The number of packets read into #responses
+ * @return HB_MC_SUCCESS if at least one packet was read. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_response_rx_n(hb_mc_manycore_t *mc,
+                                 hb_mc_response_packet_t *responses,
+                                 size_t n,
+                                 long timeout,
+                                 size_t *received)
+{
+        static_assert(sizeof(hb_mc_response_packet_t) == sizeof(hb_mc_packet_t),
+                      "response packets must be packet-sized to be read as an array");
+        return hb_mc_platform_receive_n(mc, (hb_mc_packet_t*)responses, n,
+                                        HB_MC_FIFO_RX_RSP, timeout, received);
+}
+
+/**
+ * Transmit an array of packets one at a time with hb_mc_platform_transmit().
+ *
+ * NOTE: This method is declared with __attribute__((weak)) so that a
+ * platform can replace it with a native implementation in its own
+ * bsg_manycore_platform.cpp.
+ */
+int __attribute__((weak)) hb_mc_platform_transmit_n(hb_mc_manycore_t *mc,
+                                                    hb_mc_packet_t *packets,
+                                                    size_t n,
+                                                    hb_mc_fifo_tx_t type,
+                                                    long timeout,
+                                                    size_t *sent)
+{
+        int err = HB_MC_SUCCESS;
+        size_t i;
+
+        for (i = 0; i < n; i++) {
+                err = hb_mc_platform_transmit(mc, &packets[i], type, timeout);
+                if (err != HB_MC_SUCCESS)
+                        break;
+        }
+
+        *sent = i;
+        return err;
+}
+
+/**
+ * Receive up to #n packets one at a time with hb_mc_platform_receive().
+ *
+ * NOTE: This method is declared with __attribute__((weak)) so that a
+ * platform can replace it with a native implementation in its own
+ * bsg_manycore_platform.cpp.
+ */
+int __attribute__((weak)) hb_mc_platform_receive_n(hb_mc_manycore_t *mc,
+                                                   hb_mc_packet_t *packets,
+                                                   size_t n,
+                                                   hb_mc_fifo_rx_t type,
+                                                   long timeout,
+                                                   size_t *received)
+{
+        int err = HB_MC_SUCCESS;
+        size_t i;
+
+        // wait as requested for the first packet, then poll for the rest
+        for (i = 0; i < n; i++) {
+                err = hb_mc_platform_receive(mc, &packets[i], type, i == 0 ? timeout : 0);
+                if (err != HB_MC_SUCCESS)
+                        break;
+        }
+
+        *received = i;
+        if (i > 0 && err == HB_MC_TIMEOUT)
+                return HB_MC_SUCCESS;
+
+        return err;
+}
+
 /**
  * Transmit a response packet to manycore hardware
  * @param[in] mc        A manycore instance initialized with hb_mc_manycore_init()
@@ -299,8 +452,9 @@ int hb_mc_manycore_response_tx(hb_mc_manycore_t *mc,
  * Receive a request packet from manycore hardware
  * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init()
  * @param[in] request A packet into which data should be read
- * @param[in] timeout A timeout counter. Unused - set to -1 to wait forever.
- * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ * @param[in] timeout How long to wait for a request, 0 to poll, or -1 to wait forever.
+ * @return HB_MC_SUCCESS on success. HB_MC_TIMEOUT if no request arrived in time.
+ * Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_manycore_request_rx(hb_mc_manycore_t *mc,
                               hb_mc_request_packet_t *request,
@@ -533,7 +687,7 @@ static int hb_mc_manycore_vcache_apply_to_npa_range(hb_mc_manycore_t *mc,
                 hb_mc_npa_t line_npa = *npa;
                 hb_mc_npa_set_epa(&line_npa, epa);
 
-                err = hb_mc_manycore_vcache_apply_to_npa(mc, npa, cache_op);
+                err = hb_mc_manycore_vcache_apply_to_npa(mc, &line_npa, cache_op);
                 if (err != HB_MC_SUCCESS)
                         return err;
 
@@ -638,6 +792,8 @@ static int hb_mc_manycore_pod_apply_to_vcache(hb_mc_manycore_t *mc, hb_mc_coordi
  */
 int hb_mc_manycore_pod_invalidate_vcache(hb_mc_manycore_t *mc, hb_mc_coordinate_t pod)
 {
+        HB_MC_TIMELINE_PROBE(mc, "invalidate_vcache", "vcache",
+                             HB_MC_TIMELINE_MANYCORE_PID, HB_MC_TIMELINE_THREAD_TID);
         return hb_mc_manycore_pod_apply_to_vcache(mc, pod, [](hb_mc_manycore_t *mc, const hb_mc_npa_t *way_addr) {
                         // write way_id (no valid bit)
                         char npa_str [256];
@@ -671,6 +827,8 @@ int hb_mc_manycore_pod_validate_vcache(hb_mc_manycore_t *mc, hb_mc_coordinate_t
  */
 int hb_mc_manycore_pod_flush_vcache(hb_mc_manycore_t *mc, hb_mc_coordinate_t pod)
 {
+        HB_MC_TIMELINE_PROBE(mc, "flush_vcache", "vcache",
+                             HB_MC_TIMELINE_MANYCORE_PID, HB_MC_TIMELINE_THREAD_TID);
         if (!hb_mc_manycore_has_cache(mc))
                 return HB_MC_SUCCESS;
 
@@ -756,16 +914,16 @@ int hb_mc_manycore_flush_vcache(hb_mc_manycore_t *mc)
 // Memory API //
 ////////////////
 
-/* send a read request and don't wait for the return packet */
-static int hb_mc_manycore_send_read_rqst(hb_mc_manycore_t *mc,
-                                         const hb_mc_npa_t *npa, size_t sz,
-                                         uint32_t id = 0)
+/* format a read request without sending it */
+static int hb_mc_manycore_format_read_rqst(hb_mc_manycore_t *mc,
+                                           hb_mc_request_packet_t *rqst,
+                                           const hb_mc_npa_t *npa, size_t sz,
+                                           uint32_t id)
 {
-        hb_mc_packet_t rqst;
         int err;
 
         /* format the request packet */
-        err = hb_mc_manycore_format_load_request_packet(mc, &rqst.request, npa);
+        err = hb_mc_manycore_format_load_request_packet(mc, rqst, npa);
         if (err != HB_MC_SUCCESS) {
                 manycore_pr_err(mc, "%s: Failed to format load request packet: %s\n",
                                 __func__, hb_mc_strerror(err));
@@ -780,7 +938,7 @@ static int hb_mc_manycore_send_read_rqst(hb_mc_manycore_t *mc,
                 return err;
 
         // mark request with id
-        hb_mc_request_packet_set_load_id(&rqst.request, id);
+        hb_mc_request_packet_set_load_id(rqst, id);
 
         // set load info
         hb_mc_request_packet_load_info_t info = {};
@@ -789,16 +947,31 @@ static int hb_mc_manycore_send_read_rqst(hb_mc_manycore_t *mc,
         info.is_hex_op      = sz == 2;
         info.is_byte_op     = sz == 1;
 
-        hb_mc_request_packet_set_load_info(&rqst.request, info);
+        hb_mc_request_packet_set_load_info(rqst, info);
 
-        /* transmit the request to the hardware */
-        manycore_pr_dbg(mc, "Sending %d-byte read request to NPA "
+        manycore_pr_dbg(mc, "Formatted %d-byte read request to NPA "
                         "(x: %d, y: %d, 0x%08" PRIx32 ")\n",
                         sz,
                         hb_mc_npa_get_x(npa),
                         hb_mc_npa_get_y(npa),
                         hb_mc_npa_get_epa(npa));
 
+        return HB_MC_SUCCESS;
+}
+
+/* send a read request and don't wait for the return packet */
+static int hb_mc_manycore_send_read_rqst(hb_mc_manycore_t *mc,
+                                         const hb_mc_npa_t *npa, size_t sz,
+                                         uint32_t id = 0)
+{
+        hb_mc_packet_t rqst;
+        int err;
+
+        err = hb_mc_manycore_format_read_rqst(mc, &rqst.request, npa, sz, id);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        /* transmit the request to the hardware */
         err = hb_mc_manycore_request_tx(mc, &rqst.request, -1);
         if (err == HB_MC_BUSY)
                 return err; // omit the error message if just busy
@@ -859,14 +1032,16 @@ static int hb_mc_manycore_read(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, UIN
         return HB_MC_SUCCESS;
 }
 
-/* write to a memory address on the manycore */
-static int hb_mc_manycore_write(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, const void *vp, size_t sz)
+/* format a write request without sending it */
+static int hb_mc_manycore_format_write_rqst(hb_mc_manycore_t *mc,
+                                            hb_mc_request_packet_t *rqst,
+                                            const hb_mc_npa_t *npa,
+                                            const void *vp, size_t sz)
 {
         int err;
-        hb_mc_packet_t rqst;
 
         /* format the request packet */
-        err = hb_mc_manycore_format_request_packet(mc, &rqst.request, npa);
+        err = hb_mc_manycore_format_request_packet(mc, rqst, npa);
         if (err != HB_MC_SUCCESS)
                 return err;
 
@@ -882,37 +1057,66 @@ static int hb_mc_manycore_write(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, co
         /* set data and size */
         switch (sz) {
         case 4:
-                hb_mc_request_packet_set_op(&rqst.request, HB_MC_PACKET_OP_REMOTE_SW);
-                hb_mc_request_packet_set_data(&rqst.request, *(const uint32_t*)vp);
+                hb_mc_request_packet_set_op(rqst, HB_MC_PACKET_OP_REMOTE_SW);
+                hb_mc_request_packet_set_data(rqst, *(const uint32_t*)vp);
                 break;
         case 2:
-                hb_mc_request_packet_set_op(&rqst.request, HB_MC_PACKET_OP_REMOTE_STORE);
-                hb_mc_request_packet_set_data(&rqst.request, static_cast<uint32_t>(*(const uint16_t*)vp) << data_shift);
-                hb_mc_request_packet_set_mask(&rqst.request, static_cast<hb_mc_packet_mask_t>(
+                hb_mc_request_packet_set_op(rqst, HB_MC_PACKET_OP_REMOTE_STORE);
+                hb_mc_request_packet_set_data(rqst, static_cast<uint32_t>(*(const uint16_t*)vp) << data_shift);
+                hb_mc_request_packet_set_mask(rqst, static_cast<hb_mc_packet_mask_t>(
                                                       HB_MC_PACKET_REQUEST_MASK_SHORT << mask_shift));
                 break;
         case 1:
-                hb_mc_request_packet_set_op(&rqst.request, HB_MC_PACKET_OP_REMOTE_STORE);
-                hb_mc_request_packet_set_data(&rqst.request, static_cast<uint32_t>(*(const  uint8_t*)vp) << data_shift);
-                hb_mc_request_packet_set_mask(&rqst.request, static_cast<hb_mc_packet_mask_t>(
+                hb_mc_request_packet_set_op(rqst, HB_MC_PACKET_OP_REMOTE_STORE);
+                hb_mc_request_packet_set_data(rqst, static_cast<uint32_t>(*(const  uint8_t*)vp) << data_shift);
+                hb_mc_request_packet_set_mask(rqst, static_cast<hb_mc_packet_mask_t>(
                                                       HB_MC_PACKET_REQUEST_MASK_BYTE << mask_shift));
                 break;
         default:
                 return HB_MC_INVALID;
         }
 
-        /* transmit the request */
-        manycore_pr_dbg(mc, "Sending %d-byte write request to NPA "
+        manycore_pr_dbg(mc, "Formatted %d-byte write request to NPA "
                         "(x: %d, y: %d, 0x%08x) (data = 0x%08" PRIx32 ")\n",
                         sz,
                         hb_mc_npa_get_x(npa),
                         hb_mc_npa_get_y(npa),
                         hb_mc_npa_get_epa(npa),
-                        hb_mc_request_packet_get_data(&rqst.request));
+                        hb_mc_request_packet_get_data(rqst));
+
+        return HB_MC_SUCCESS;
+}
+
+/* write to a memory address on the manycore */
+static int hb_mc_manycore_write(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, const void *vp, size_t sz)
+{
+        int err;
+        hb_mc_packet_t rqst;
+
+        err = hb_mc_manycore_format_write_rqst(mc, &rqst.request, npa, vp, sz);
+        if (err != HB_MC_SUCCESS)
+                return err;
 
+        /* transmit the request */
         return hb_mc_manycore_request_tx(mc, &rqst.request, -1);
 }
 
+/* transmit every packet in #rqsts, retrying while the hardware is busy */
+static int hb_mc_manycore_request_tx_all(hb_mc_manycore_t *mc,
+                                         hb_mc_request_packet_t *rqsts, size_t n)
+{
+        while (n > 0) {
+                size_t sent = 0;
+                int err = hb_mc_manycore_request_tx_n(mc, rqsts, n, -1, &sent);
+                if (err != HB_MC_SUCCESS && err != HB_MC_BUSY)
+                        return err;
+
+                rqsts += sent;
+                n     -= sent;
+        }
+        return HB_MC_SUCCESS;
+}
+
 /* checks that the arguments of read/write_mem are supported */
 static int hb_mc_manycore_read_write_mem_check_args(hb_mc_manycore_t *mc,
                                                     const char *caller_name,
@@ -948,6 +1152,9 @@ int hb_mc_manycore_write_mem(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
                              const void *data, size_t sz)
 {
         int err;
+        HB_MC_API_PROBE(mc, HB_MC_API_WRITE_MEM);
+        HB_MC_TIMELINE_PROBE(mc, "write_mem", "memory",
+                             HB_MC_TIMELINE_MANYCORE_PID, HB_MC_TIMELINE_THREAD_TID);
 
         err = hb_mc_manycore_read_write_mem_check_args(mc, __func__, data, sz);
         if (err != HB_MC_SUCCESS)
@@ -958,27 +1165,40 @@ int hb_mc_manycore_write_mem(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
         const uint32_t *words = (const uint32_t*)data;
         size_t n_words = sz >> 2;
         hb_mc_npa_t addr = *npa;
+        hb_mc_request_packet_t rqsts[HB_MC_MANYCORE_PACKET_BATCH];
+
+        /* send store requests a batch of words at a time */
+        for (size_t i = 0; i < n_words; i += HB_MC_MANYCORE_PACKET_BATCH) {
+                size_t batch = std::min(n_words - i, HB_MC_MANYCORE_PACKET_BATCH);
+
+                for (size_t j = 0; j < batch; j++) {
+                        err = hb_mc_manycore_format_write_rqst(mc, &rqsts[j], &addr, &words[i + j], 4);
+                        if (err != HB_MC_SUCCESS)
+                                break;
+
+                        // Increment EPA by 4:
+                        hb_mc_npa_set_epa(&addr, hb_mc_npa_get_epa(&addr) + 4);
+                }
 
-        /* send store requests one word at a time */
-        for (size_t i = 0; i < n_words; i++) {
+                if (err == HB_MC_SUCCESS)
+                        err = hb_mc_manycore_request_tx_all(mc, rqsts, batch);
 
-                err = hb_mc_manycore_write(mc, &addr, &words[i], 4);
                 if (err != HB_MC_SUCCESS) {
                         manycore_pr_err(mc, "%s: Failed to send write request: %s\n",
                                         __func__, hb_mc_strerror(err));
-                        return err;
+                        goto done;
                 }
-
-                // Increment EPA by 4:
-                hb_mc_npa_set_epa(&addr, hb_mc_npa_get_epa(&addr) + 4);
         }
 
         err = hb_mc_manycore_host_request_fence(mc, -1);
-        if (err != HB_MC_SUCCESS)
-                return err;
 
-        hb_mc_platform_finish_bulk_transfer(mc);
-        return HB_MC_SUCCESS;
+done:
+        // close the transfer even on error, or later requests stay queued
+        if (err == HB_MC_SUCCESS)
+                err = hb_mc_platform_finish_bulk_transfer(mc);
+        else
+                hb_mc_platform_finish_bulk_transfer(mc);
+        return err;
 }
 
 /**
@@ -1001,51 +1221,67 @@ int hb_mc_manycore_memset(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
         const uint32_t word = (val << 24) | (val << 16) | (val << 8) | val;
         size_t n_words = sz >> 2;
         hb_mc_npa_t addr = *npa;
+        hb_mc_request_packet_t rqsts[HB_MC_MANYCORE_PACKET_BATCH];
 
         hb_mc_platform_start_bulk_transfer(mc);
 
-        /* send store requests one word at a time */
-        for (size_t i = 0; i < n_words; i++) {
+        /* send store requests a batch of words at a time */
+        for (size_t i = 0; i < n_words; i += HB_MC_MANYCORE_PACKET_BATCH) {
+                size_t batch = std::min(n_words - i, HB_MC_MANYCORE_PACKET_BATCH);
+
+                for (size_t j = 0; j < batch; j++) {
+                        err = hb_mc_manycore_format_write_rqst(mc, &rqsts[j], &addr, &word, 4);
+                        if (err != HB_MC_SUCCESS)
+                                break;
+
+                        // increment EPA by 1: (EPA's address words)
+                        hb_mc_npa_set_epa(&addr, hb_mc_npa_get_epa(&addr) + sizeof(uint32_t));
+                }
+
+                if (err == HB_MC_SUCCESS)
+                        err = hb_mc_manycore_request_tx_all(mc, rqsts, batch);
 
-                err = hb_mc_manycore_write(mc, &addr, &word, 4);
                 if (err != HB_MC_SUCCESS) {
                         manycore_pr_err(mc, "%s: Failed to send write request: %s\n",
                                         __func__, hb_mc_strerror(err));
-                        return err;
+                        goto done;
                 }
-
-                // increment EPA by 1: (EPA's address words)
-                hb_mc_npa_set_epa(&addr, hb_mc_npa_get_epa(&addr) + sizeof(uint32_t));
         }
 
         err = hb_mc_manycore_host_request_fence(mc, -1);
-        if (err != HB_MC_SUCCESS)
-                return err;
 
-        hb_mc_platform_finish_bulk_transfer(mc);
-
-        return HB_MC_SUCCESS;
+done:
+        // close the transfer even on error, or later requests stay queued
+        if (err == HB_MC_SUCCESS)
+                err = hb_mc_platform_finish_bulk_transfer(mc);
+        else
+                hb_mc_platform_finish_bulk_transfer(mc);
+        return err;
 }
 
 /**
- * Perform #cnt loads from a series of NPAs and return results in an associative container #data.
- * After returning success, #data[i] shall be the data read from the NPA given by #npa(i)
+ * Perform #cnt requests that each produce a response and return the
+ * response data in an associative container #data. Requests are
+ * pipelined, with up to io_remote_load_cap in flight, and matched to
+ * responses by load id. After returning success, #data[i] shall be the
+ * data returned for the request formatted by #rqst(i)
  * for i >= 0 and i < cnt.
  *
- * @tparam UINT               The unsigned integer type for data loads.
- * @tparam UINTV              An associative container of UNT words (indexed by i).
- * @tparam NPA_OF_I_FUNCTION  Returns an NPA given an index i.
+ * @tparam UINT                The unsigned integer type for response data.
+ * @tparam UINTV               An associative container of UINT words (indexed by i).
+ * @tparam RQST_OF_I_FUNCTION  Formats the request for an index i with a load id.
  *
  * @param[in]  mc    A manycore instance.
- * @param[in]  npa   A function that takes an index i and returns an NPA.
- * @param[out] data  A mutable associative container by which load data is returned.
- * @param[in]  cnt   The number of loads to perform.
+ * @param[in]  rqst  A function int(hb_mc_request_packet_t *, size_t i, uint32_t id)
+ *                   that formats the ith request.
+ * @param[out] data  A mutable associative container by which response data is returned.
+ * @param[in]  cnt   The number of requests to perform.
  *
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
-template <typename UINT, typename UINTV, typename NPA_OF_I_FUNCTION>
-static int hb_mc_manycore_read_mem_internal(hb_mc_manycore_t *mc,
-                                            NPA_OF_I_FUNCTION npa,
+template <typename UINT, typename UINTV, typename RQST_OF_I_FUNCTION>
+static int hb_mc_manycore_rqst_rsp_internal(hb_mc_manycore_t *mc,
+                                            RQST_OF_I_FUNCTION rqst,
                                             UINTV & data, size_t cnt)
 {
         const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
@@ -1059,101 +1295,158 @@ static int hb_mc_manycore_read_mem_internal(hb_mc_manycore_t *mc,
 
         hb_mc_platform_start_bulk_transfer(mc);
 
-        /* track requests and responses with ids and id_to_rsp_i */
-        std::stack <uint32_t, std::vector<uint32_t> > ids;
-        for (int i = n_ids - 1; i >= 0; i--)
-                ids.push(static_cast<uint32_t>(i));
+        /*
+         * Track requests and responses with a reorder buffer indexed
+         * by load id: free_ids is a stack of unused ids, and
+         * id_to_rsp_i[id] is the index of the request that holds id,
+         * or cnt when id is free. Both live on the stack, so a read
+         * makes no heap allocations.
+         */
+        uint32_t free_ids[n_ids];
+        size_t n_free_ids = 0;
+        size_t id_to_rsp_i[n_ids];
+        for (int i = n_ids - 1; i >= 0; i--) {
+                free_ids[n_free_ids++] = static_cast<uint32_t>(i);
+                id_to_rsp_i[i] = cnt;
+        }
 
-        std::map<uint32_t, uint32_t> id_to_rsp_i;
-        hb_mc_npa_t id_to_npa[n_ids];
+        hb_mc_request_packet_t rqsts[HB_MC_MANYCORE_PACKET_BATCH];
+        hb_mc_response_packet_t rsps[HB_MC_MANYCORE_PACKET_BATCH];
+        uint32_t rqst_ids[HB_MC_MANYCORE_PACKET_BATCH];
 
         /* until we've received all responses... */
         while (rsp_i < cnt) {
 
-                /* try to request as many words as we have left */
-                while (rqst_i < cnt) {
-                        // get the NPA of the next load address
-                        hb_mc_npa_t rqst_addr = npa(rqst_i);
+                /* format requests for as many words as we have load ids for */
+                size_t n_rqsts = std::min(std::min(cnt - rqst_i, n_free_ids),
+                                          HB_MC_MANYCORE_PACKET_BATCH);
+                for (size_t k = 0; k < n_rqsts; k++) {
+                        // get an available load id for this request
+                        uint32_t rqst_load_id = free_ids[--n_free_ids];
 
-                        // if we're out of load ids, break to start reading requests
-                        if (ids.empty())
-                                break;
+                        // save which request this is
+                        rqst_ids[k] = rqst_load_id;
+                        id_to_rsp_i[rqst_load_id] = rqst_i + k;
 
-                        // get an available load id for this load request
-                        uint32_t rqst_load_id = ids.top();
+                        err = rqst(&rqsts[k], rqst_i + k, rqst_load_id);
+                        if (err != HB_MC_SUCCESS)
+                                goto done;
+                }
 
-                        // save which request this is
-                        id_to_rsp_i[rqst_load_id] = rqst_i;
-                        id_to_npa[rqst_load_id] = rqst_addr;
-
-                        // send a load request
-                        err = hb_mc_manycore_send_read_rqst(mc, &rqst_addr, sizeof(UINT),
-                                                            rqst_load_id);
-                        if (err == HB_MC_SUCCESS) {
-                                // success; increment succesful requests and pop the load id
-                                rqst_i++;
-                                ids.pop();
-                        } else if (err == HB_MC_BUSY) {
-                                // if we're busy, break to start reading requests
-                                break;
-                        } else {
+                /* send as many as the hardware will take */
+                if (n_rqsts > 0) {
+                        size_t sent = 0;
+                        err = hb_mc_manycore_request_tx_n(mc, rqsts, n_rqsts, -1, &sent);
+                        if (err != HB_MC_SUCCESS && err != HB_MC_BUSY) {
                                 // we've hit some other error: abort with an error message
-                                manycore_pr_err(mc, "%s: Failed to send read request: %s\n",
+                                manycore_pr_err(mc, "%s: Failed to send request: %s\n",
                                                 __func__, hb_mc_strerror(err));
-                                return err;
+                                goto done;
+                        }
+
+                        manycore_pr_dbg(mc, "%s: Sent %zu requests\n", __func__, sent);
+
+                        // if we're busy, return the unsent load ids and start reading responses
+                        for (size_t k = n_rqsts; k > sent; k--) {
+                                id_to_rsp_i[rqst_ids[k - 1]] = cnt;
+                                free_ids[n_free_ids++] = rqst_ids[k - 1];
                         }
-                        manycore_pr_dbg(mc, "%s: Sent read request with load_id = %" PRIu32 "\n",
-                                        __func__, rqst_load_id);
+
+                        rqst_i += sent;
                 }
 
-                /* read all available response packets */
-                while (rsp_i < rqst_i) {
-                        /* read a response and write it back to the location marked by load_id */
-                        uint32_t read_data, load_id;
-                        err = hb_mc_manycore_recv_read_rsp(mc, &read_data, &load_id);
+                /* read the available response packets */
+                if (rsp_i < rqst_i) {
+                        size_t received = 0;
+                        size_t n_rsps = std::min(rqst_i - rsp_i, HB_MC_MANYCORE_PACKET_BATCH);
+                        err = hb_mc_manycore_response_rx_n(mc, rsps, n_rsps, -1, &received);
                         if (err != HB_MC_SUCCESS) {
-                                manycore_pr_err(mc, "%s: Failed to receive read response: %s\n",
+                                manycore_pr_err(mc, "%s: Failed to receive response: %s\n",
                                                 __func__, hb_mc_strerror(err));
-                                return err;
+                                goto done;
                         }
 
-                        manycore_pr_dbg(mc, "%s: Received response for load_id = %" PRIu32 "\n",
-                                        __func__, load_id);
+                        for (size_t k = 0; k < received; k++) {
+                                /* write the response back to the location marked by load_id */
+                                uint32_t read_data = hb_mc_response_packet_get_data(&rsps[k]);
+                                uint32_t load_id = hb_mc_response_packet_get_load_id(&rsps[k]);
 
-                        // this should never happen unless something is messed up in hardware
-                        if (load_id >= n_ids) {
-                                manycore_pr_err(mc, "%s: Bad load id = %" PRIu32 "\n",
+                                manycore_pr_dbg(mc, "%s: Received response for load_id = %" PRIu32 "\n",
                                                 __func__, load_id);
-                                return HB_MC_FAIL;
-                        }
 
-                        // This would be an unexpected response
-                        if (id_to_rsp_i.count(load_id) == 0) {
-                                manycore_pr_err(mc, "%s: Unexpected load id = %" PRIu32 "\n",
-                                                __func__, load_id);
-                                return HB_MC_FAIL;
-                        }
-                        uint32_t idx = id_to_rsp_i[load_id];
-                        
-                        // This would be a runtime writer error... or worse.
-                        if (idx > cnt) {
-                                manycore_pr_err(mc, "%s: Return index outside of array. Idx = %" PRIu32 "\n",
-                                                __func__, idx);
-                                return HB_MC_FAIL;
+                                // this should never happen unless something is messed up in hardware
+                                if (load_id >= n_ids) {
+                                        manycore_pr_err(mc, "%s: Bad load id = %" PRIu32 "\n",
+                                                        __func__, load_id);
+                                        err = HB_MC_FAIL;
+                                        goto done;
+                                }
+
+                                // This would be an unexpected response
+                                size_t idx = id_to_rsp_i[load_id];
+                                if (idx >= cnt) {
+                                        manycore_pr_err(mc, "%s: Unexpected load id = %" PRIu32 "\n",
+                                                        __func__, load_id);
+                                        err = HB_MC_FAIL;
+                                        goto done;
+                                }
+
+                                // write 'read_data' back to the correct location
+                                data[idx] = static_cast<UINT>(read_data);
+
+                                // increment succesful responses
+                                rsp_i++;
+
+                                // free the load id so we can use it again
+                                id_to_rsp_i[load_id] = cnt;
+                                free_ids[n_free_ids++] = load_id;
                         }
-                        // write 'read_data' back to the correct location
-                        data[idx] = static_cast<UINT>(read_data);
-
-                        // increment succesful responses
-                        rsp_i++;
-
-                        // push the load id onto the stack so we can use it again
-                        ids.push(load_id);
                 }
         }
-        hb_mc_platform_finish_bulk_transfer(mc);
+        err = HB_MC_SUCCESS;
+
+done:
+        // close the transfer even on error, or later requests stay queued
+        if (err == HB_MC_SUCCESS)
+                err = hb_mc_platform_finish_bulk_transfer(mc);
+        else
+                hb_mc_platform_finish_bulk_transfer(mc);
+        return err;
+}
 
-        return HB_MC_SUCCESS;
+/**
+ * Perform #cnt loads from a series of NPAs and return results in an associative container #data.
+ * After returning success, #data[i] shall be the data read from the NPA given by #npa(i)
+ * for i >= 0 and i < cnt.
+ *
+ * @tparam UINT               The unsigned integer type for data loads.
+ * @tparam UINTV              An associative container of UNT words (indexed by i).
+ * @tparam NPA_OF_I_FUNCTION  Returns an NPA given an index i.
+ *
+ * @param[in]  mc    A manycore instance.
+ * @param[in]  npa   A function that takes an index i and returns an NPA.
+ * @param[out] data  A mutable associative container by which load data is returned.
+ * @param[in]  cnt   The number of loads to perform.
+ *
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+template <typename UINT, typename UINTV, typename NPA_OF_I_FUNCTION>
+static int hb_mc_manycore_read_mem_internal(hb_mc_manycore_t *mc,
+                                            NPA_OF_I_FUNCTION npa,
+                                            UINTV & data, size_t cnt)
+{
+        /* ith request => load sizeof(UINT) bytes from npa(i) */
+        struct rqst_function {
+                hb_mc_manycore_t *mc;
+                NPA_OF_I_FUNCTION npa;
+                rqst_function(hb_mc_manycore_t *mc, NPA_OF_I_FUNCTION npa) : mc(mc), npa(npa) {}
+                int operator()(hb_mc_request_packet_t *rqst, size_t i, uint32_t id) {
+                        hb_mc_npa_t addr = npa(i);
+                        return hb_mc_manycore_format_read_rqst(mc, rqst, &addr, sizeof(UINT), id);
+                }
+        };
+
+        return hb_mc_manycore_rqst_rsp_internal<UINT>(mc, rqst_function(mc, npa), data, cnt);
 }
 
 /**
@@ -1189,6 +1482,9 @@ int hb_mc_manycore_read_mem(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
                             void *data, size_t sz)
 {
         int err;
+        HB_MC_API_PROBE(mc, HB_MC_API_READ_MEM);
+        HB_MC_TIMELINE_PROBE(mc, "read_mem", "memory",
+                             HB_MC_TIMELINE_MANYCORE_PID, HB_MC_TIMELINE_THREAD_TID);
 
         err = hb_mc_manycore_read_write_mem_check_args(mc, __func__, data, sz);
         if (err != HB_MC_SUCCESS)
@@ -1284,21 +1580,22 @@ int hb_mc_manycore_write32(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, uint32_
         return hb_mc_manycore_write(mc, npa, &v, 4);
 }
 
-/**
- * Do a 32-bit amoadd to manycore hardware at a given NPA (must be a DRAM address)
- * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
- * @param[in]  npa    A valid hb_mc_npa_t aligned to a four byte boundary
- * @param[in]  v      A word value to be added to the NPA
- * @param[out] vpo    The previous value at the NPA
- * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
- */
-int hb_mc_manycore_amoadd32(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, const uint32_t v, uint32_t *vpo)
+/* format an atomic request without sending it */
+static int hb_mc_manycore_format_amo_rqst(hb_mc_manycore_t *mc,
+                                          hb_mc_request_packet_t *rqst,
+                                          const hb_mc_npa_t *npa,
+                                          hb_mc_packet_op_t op,
+                                          uint32_t v, uint32_t id)
 {
         int err;
-        hb_mc_packet_t rqst;
+
+        if (op < HB_MC_PACKET_OP_REMOTE_AMOSWAP || op > HB_MC_PACKET_OP_REMOTE_AMOMAXU) {
+                manycore_pr_err(mc, "%s: Not an atomic operation: %d\n", __func__, op);
+                return HB_MC_INVALID;
+        }
 
         /* format the request packet */
-        err = hb_mc_manycore_format_request_packet(mc, &rqst.request, npa);
+        err = hb_mc_manycore_format_request_packet(mc, rqst, npa);
         if (err != HB_MC_SUCCESS)
                 return err;
 
@@ -1314,21 +1611,45 @@ int hb_mc_manycore_amoadd32(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, const
         if (hb_mc_config_is_dram(hb_mc_manycore_get_config(mc), hb_mc_npa_get_xy(npa)) == 0)
             return HB_MC_INVALID;
 
-        hb_mc_request_packet_set_op(&rqst.request, HB_MC_PACKET_OP_REMOTE_AMOADD);
-        hb_mc_request_packet_set_data(&rqst.request, v);
+        hb_mc_request_packet_set_op(rqst, op);
+        hb_mc_request_packet_set_data(rqst, v);
 
-        err = hb_mc_manycore_request_tx(mc, &rqst.request, -1);
-        if (err != HB_MC_SUCCESS)
-                return err;
+        // the previous value comes back tagged with this id
+        hb_mc_request_packet_set_load_id(rqst, id);
 
-        /* transmit the request */
-        manycore_pr_dbg(mc, "Sending %d-byte amo request to NPA "
+        manycore_pr_dbg(mc, "Formatted %d-byte amo request to NPA "
                         "(x: %d, y: %d, 0x%08x) (data = 0x%08" PRIx32 ")\n",
                         sz,
                         hb_mc_npa_get_x(npa),
                         hb_mc_npa_get_y(npa),
                         hb_mc_npa_get_epa(npa),
-                        hb_mc_request_packet_get_data(&rqst.request));
+                        hb_mc_request_packet_get_data(rqst));
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Do a 32-bit amoadd to manycore hardware at a given NPA (must be a DRAM address)
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  npa    A valid hb_mc_npa_t aligned to a four byte boundary
+ * @param[in]  v      A word value to be added to the NPA
+ * @param[out] vpo    The previous value at the NPA
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_amoadd32(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, const uint32_t v, uint32_t *vpo)
+{
+        int err;
+        hb_mc_packet_t rqst = {};
+
+        err = hb_mc_manycore_format_amo_rqst(mc, &rqst.request, npa,
+                                             HB_MC_PACKET_OP_REMOTE_AMOADD, v, 0);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        /* transmit the request */
+        err = hb_mc_manycore_request_tx(mc, &rqst.request, -1);
+        if (err != HB_MC_SUCCESS)
+                return err;
 
         /* read back response */
         uint32_t load_data;
@@ -1341,6 +1662,240 @@ int hb_mc_manycore_amoadd32(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, const
         return HB_MC_SUCCESS;
 }
 
+/**
+ * Do #n 32-bit atomic operations to manycore hardware, pipelined (must be DRAM addresses)
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  op     An atomic operation, HB_MC_PACKET_OP_REMOTE_AMOSWAP through HB_MC_PACKET_OP_REMOTE_AMOMAXU
+ * @param[in]  npa    An array of #n valid hb_mc_npa_t aligned to four byte boundaries
+ * @param[in]  vpi    An array of #n operands; vpi[i] is applied at npa[i]
+ * @param[out] vpo    An array of #n words set to the previous values, or NULL to discard them
+ * @param[in]  n      The number of atomic operations
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_amo32_n(hb_mc_manycore_t *mc, hb_mc_packet_op_t op,
+                           const hb_mc_npa_t *npa, const uint32_t *vpi,
+                           uint32_t *vpo, size_t n)
+{
+        /* ith request => op vpi[i] at npa[i] */
+        struct rqst_function {
+                hb_mc_manycore_t *mc;
+                hb_mc_packet_op_t op;
+                const hb_mc_npa_t *npa;
+                const uint32_t *vpi;
+                rqst_function(hb_mc_manycore_t *mc, hb_mc_packet_op_t op,
+                              const hb_mc_npa_t *npa, const uint32_t *vpi) :
+                        mc(mc), op(op), npa(npa), vpi(vpi) {}
+                int operator()(hb_mc_request_packet_t *rqst, size_t i, uint32_t id) {
+                        return hb_mc_manycore_format_amo_rqst(mc, rqst, &npa[i], op, vpi[i], id);
+                }
+        };
+
+        /* previous values are dropped when the caller doesn't want them */
+        struct discard {
+                uint32_t sink;
+                uint32_t & operator[](size_t i) { return sink; }
+        };
+
+        if (vpo != NULL)
+                return hb_mc_manycore_rqst_rsp_internal<uint32_t>(mc, rqst_function(mc, op, npa, vpi),
+                                                                  vpo, n);
+
+        discard d;
+        return hb_mc_manycore_rqst_rsp_internal<uint32_t>(mc, rqst_function(mc, op, npa, vpi),
+                                                          d, n);
+}
+
+/* have all commands that #cmd depends on completed? */
+static bool hb_mc_manycore_cmd_deps_done(const hb_mc_cmdlist_t *cl, size_t cmd,
+                                         const std::vector<bool> &done, size_t fenced)
+{
+        for (size_t d = cl->cmds[cmd].deps; d != HB_MC_CMD_NONE; d = cl->deps[d].next) {
+                size_t on = cl->deps[d].on;
+                if (on >= fenced && !done[on])
+                        return false;
+        }
+        return true;
+}
+
+/**
+ * Submit a command list as one pipelined stream and wait for it to complete
+ * @param[in]  mc       A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  cl       A command list initialized with hb_mc_cmdlist_init()
+ * @param[out] results  An array of hb_mc_cmdlist_size() words, or NULL. results[i] is
+ *                      set to the data read by command i, or the previous value for
+ *                      an atomic. Entries for writes and fences are left untouched.
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_cmdlist_submit(hb_mc_manycore_t *mc, const hb_mc_cmdlist_t *cl,
+                                  uint32_t *results)
+{
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        size_t n = hb_mc_cmdlist_size(cl);
+        size_t next = 0, outstanding = 0;
+        unsigned n_ids;
+        int err;
+
+        if (n == 0)
+                return HB_MC_SUCCESS;
+
+        /*
+         * Commands are issued in order. A read or atomic is done when
+         * its response arrives; every command before #fenced is done
+         * because a fence has been performed since it was issued.
+         */
+        std::vector<bool> done(n, false);
+        size_t fenced = 0;
+
+        /* load ids are tracked as in hb_mc_manycore_rqst_rsp_internal() */
+        n_ids = hb_mc_config_get_io_remote_load_cap(cfg);
+        uint32_t free_ids[n_ids];
+        size_t n_free_ids = 0;
+        size_t id_to_cmd[n_ids];
+        for (int i = n_ids - 1; i >= 0; i--) {
+                free_ids[n_free_ids++] = static_cast<uint32_t>(i);
+                id_to_cmd[i] = n;
+        }
+
+        hb_mc_request_packet_t rqsts[HB_MC_MANYCORE_PACKET_BATCH];
+        hb_mc_response_packet_t rsps[HB_MC_MANYCORE_PACKET_BATCH];
+        size_t rqst_cmds[HB_MC_MANYCORE_PACKET_BATCH];
+        uint32_t rqst_ids[HB_MC_MANYCORE_PACKET_BATCH];
+
+        hb_mc_platform_start_bulk_transfer(mc);
+
+        while (next < n || outstanding > 0) {
+
+                /* format commands in order until one has to wait */
+                size_t n_rqsts = 0;
+                while (next + n_rqsts < n && n_rqsts < HB_MC_MANYCORE_PACKET_BATCH) {
+                        size_t i = next + n_rqsts;
+                        const hb_mc_cmd_t *c = &cl->cmds[i];
+                        bool expect_response = c->type != HB_MC_CMD_WRITE32;
+
+                        if (c->type == HB_MC_CMD_FENCE ||
+                            !hb_mc_manycore_cmd_deps_done(cl, i, done, fenced) ||
+                            (expect_response && n_free_ids == 0))
+                                break;
+
+                        uint32_t id = expect_response ? free_ids[--n_free_ids] : 0;
+
+                        switch (c->type) {
+                        case HB_MC_CMD_READ32:
+                                err = hb_mc_manycore_format_read_rqst(mc, &rqsts[n_rqsts], &c->npa, 4, id);
+                                break;
+                        case HB_MC_CMD_WRITE32:
+                                err = hb_mc_manycore_format_write_rqst(mc, &rqsts[n_rqsts], &c->npa, &c->data, 4);
+                                break;
+                        case HB_MC_CMD_AMO32:
+                                err = hb_mc_manycore_format_amo_rqst(mc, &rqsts[n_rqsts], &c->npa, c->op, c->data, id);
+                                break;
+                        default:
+                                manycore_pr_err(mc, "%s: Unknown command type %d at %zu\n",
+                                                __func__, c->type, i);
+                                err = HB_MC_INVALID;
+                                break;
+                        }
+
+                        if (err != HB_MC_SUCCESS)
+                                goto done;
+
+                        if (expect_response)
+                                id_to_cmd[id] = i;
+
+                        rqst_cmds[n_rqsts] = i;
+                        rqst_ids[n_rqsts] = id;
+                        n_rqsts++;
+                }
+
+                /* send as many as the hardware will take */
+                if (n_rqsts > 0) {
+                        size_t sent = 0;
+                        err = hb_mc_manycore_request_tx_n(mc, rqsts, n_rqsts, -1, &sent);
+                        if (err != HB_MC_SUCCESS && err != HB_MC_BUSY) {
+                                manycore_pr_err(mc, "%s: Failed to send request: %s\n",
+                                                __func__, hb_mc_strerror(err));
+                                goto done;
+                        }
+
+                        // return the load ids of unsent requests
+                        for (size_t k = n_rqsts; k > sent; k--) {
+                                if (cl->cmds[rqst_cmds[k - 1]].type == HB_MC_CMD_WRITE32)
+                                        continue;
+                                id_to_cmd[rqst_ids[k - 1]] = n;
+                                free_ids[n_free_ids++] = rqst_ids[k - 1];
+                        }
+
+                        for (size_t k = 0; k < sent; k++)
+                                if (cl->cmds[rqst_cmds[k]].type != HB_MC_CMD_WRITE32)
+                                        outstanding++;
+
+                        next += sent;
+
+                        // the batch filled up: keep issuing
+                        if (sent == HB_MC_MANYCORE_PACKET_BATCH)
+                                continue;
+                }
+
+                /* read responses to unblock the next command */
+                if (outstanding > 0) {
+                        size_t received = 0;
+                        size_t n_rsps = std::min(outstanding, HB_MC_MANYCORE_PACKET_BATCH);
+                        err = hb_mc_manycore_response_rx_n(mc, rsps, n_rsps, -1, &received);
+                        if (err != HB_MC_SUCCESS) {
+                                manycore_pr_err(mc, "%s: Failed to receive response: %s\n",
+                                                __func__, hb_mc_strerror(err));
+                                goto done;
+                        }
+
+                        for (size_t k = 0; k < received; k++) {
+                                uint32_t load_id = hb_mc_response_packet_get_load_id(&rsps[k]);
+                                if (load_id >= n_ids || id_to_cmd[load_id] >= n) {
+                                        manycore_pr_err(mc, "%s: Unexpected load id = %" PRIu32 "\n",
+                                                        __func__, load_id);
+                                        err = HB_MC_FAIL;
+                                        goto done;
+                                }
+
+                                size_t i = id_to_cmd[load_id];
+                                if (results != NULL)
+                                        results[i] = hb_mc_response_packet_get_data(&rsps[k]);
+                                done[i] = true;
+                                outstanding--;
+
+                                id_to_cmd[load_id] = n;
+                                free_ids[n_free_ids++] = load_id;
+                        }
+                        continue;
+                }
+
+                /* only writes are in flight and the next command is waiting on them */
+                if (next < n) {
+                        err = hb_mc_manycore_host_request_fence(mc, -1);
+                        if (err != HB_MC_SUCCESS)
+                                goto done;
+
+                        fenced = next;
+                        if (cl->cmds[next].type == HB_MC_CMD_FENCE)
+                                fenced = ++next;
+                }
+        }
+
+        /* the list is complete once its trailing writes have landed */
+        err = hb_mc_manycore_host_request_fence(mc, -1);
+
+done:
+        // close the transfer even on error, or later requests stay queued
+        if (err == HB_MC_SUCCESS)
+                err = hb_mc_platform_finish_bulk_transfer(mc);
+        else
+                hb_mc_platform_finish_bulk_transfer(mc);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        manycore_pr_dbg(mc, "%s: Completed %zu commands\n", __func__, n);
+        return HB_MC_SUCCESS;
+}
+
 
 /**
  * Enable DRAM mode on the manycore instance.
@@ -1455,6 +2010,9 @@ int hb_mc_manycore_dma_write_no_cache_ainv(hb_mc_manycore_t *mc, const hb_mc_npa
                                            const void *data, size_t sz)
 {
         int err;
+        HB_MC_API_PROBE(mc, HB_MC_API_DMA_WRITE);
+        HB_MC_TIMELINE_PROBE(mc, "dma_write", "dma",
+                             HB_MC_TIMELINE_MANYCORE_PID, HB_MC_TIMELINE_THREAD_TID);
         if (!hb_mc_manycore_supports_dma_write(mc))
                 return HB_MC_NOIMPL;
 
@@ -1491,6 +2049,9 @@ int hb_mc_manycore_dma_read_no_cache_afl(hb_mc_manycore_t *mc, const hb_mc_npa_t
                                          void *data, size_t sz)
 {
         int err;
+        HB_MC_API_PROBE(mc, HB_MC_API_DMA_READ);
+        HB_MC_TIMELINE_PROBE(mc, "dma_read", "dma",
+                             HB_MC_TIMELINE_MANYCORE_PID, HB_MC_TIMELINE_THREAD_TID);
         if (!hb_mc_manycore_supports_dma_read(mc))
                 return HB_MC_NOIMPL;
 
@@ -1553,6 +2114,182 @@ int hb_mc_manycore_get_icount(hb_mc_manycore_t *mc, bsg_instr_type_e itype, int
         return hb_mc_platform_get_icount(mc, itype, count);
 }
 
+/**
+ * Report that per-tile instruction counts are not available.
+ *
+ * NOTE: This method is declared with __attribute__((weak)) so that a
+ * platform with a profiler can replace it in its own
+ * bsg_manycore_platform.cpp.
+ */
+int __attribute__((weak)) hb_mc_platform_get_icount_snapshot(hb_mc_manycore_t *mc,
+                                                             hb_mc_icount_snapshot_t *snap)
+{
+        return HB_MC_NOIMPL;
+}
+
+/**
+ * Capture every class of instruction count for every tile in one pass
+ * @param[in]  mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] snap  A snapshot whose #tiles and #cap are set by the caller
+ * @return HB_MC_SUCCESS on success. HB_MC_NOMEM if #cap is too small, in which
+ * case #n_tiles is set to the number of entries required. HB_MC_NOIMPL if the
+ * platform has no per-tile profiler, as on FPGAs, or the simulated machine
+ * was built without vcore profiling. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_get_icount_snapshot(hb_mc_manycore_t *mc, hb_mc_icount_snapshot_t *snap)
+{
+        int err;
+
+        snap->n_tiles = 0;
+        err = hb_mc_platform_get_icount_snapshot(mc, snap);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        // not every platform keeps a cycle counter; the counts are still useful
+        err = hb_mc_platform_get_cycle(mc, &snap->cycle);
+        if (err != HB_MC_SUCCESS)
+                snap->cycle = 0;
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Compute the instructions and cycles elapsed between two snapshots
+ * @param[in]  before  A snapshot taken with hb_mc_manycore_get_icount_snapshot()
+ * @param[in]  after   A later snapshot of the same manycore
+ * @param[out] delta   A snapshot whose #tiles and #cap are set by the caller.
+ *                     May be the same as #after.
+ * @return HB_MC_SUCCESS on success. HB_MC_INVALID if the snapshots cover different
+ * tiles. HB_MC_NOMEM if #delta is too small.
+ */
+int hb_mc_icount_snapshot_delta(const hb_mc_icount_snapshot_t *before,
+                                const hb_mc_icount_snapshot_t *after,
+                                hb_mc_icount_snapshot_t *delta)
+{
+        if (before->n_tiles != after->n_tiles) {
+                bsg_pr_err("%s: Snapshots have different tile counts (%zu and %zu)\n",
+                           __func__, before->n_tiles, after->n_tiles);
+                return HB_MC_INVALID;
+        }
+
+        if (delta->cap < after->n_tiles) {
+                delta->n_tiles = after->n_tiles;
+                return HB_MC_NOMEM;
+        }
+
+        for (size_t i = 0; i < after->n_tiles; i++) {
+                const hb_mc_tile_icount_t *b = &before->tiles[i];
+                const hb_mc_tile_icount_t *a = &after->tiles[i];
+                hb_mc_tile_icount_t *d = &delta->tiles[i];
+
+                if (!hb_mc_coordinate_eq(b->coord, a->coord)) {
+                        bsg_pr_err("%s: Snapshots differ at entry %zu\n", __func__, i);
+                        return HB_MC_INVALID;
+                }
+
+                d->coord = a->coord;
+                for (int t = 0; t < HB_MC_INSTR_TYPES; t++)
+                        d->icount[t] = a->icount[t] - b->icount[t];
+        }
+
+        delta->cycle = after->cycle - before->cycle;
+        delta->n_tiles = after->n_tiles;
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Sum one class of instruction count over every tile in a snapshot
+ * @param[in] snap   A snapshot, or a delta between two snapshots
+ * @param[in] itype  The class of instructions to sum
+ * @return The total count for #itype.
+ */
+uint64_t hb_mc_icount_snapshot_total(const hb_mc_icount_snapshot_t *snap, bsg_instr_type_e itype)
+{
+        uint64_t sum = 0;
+
+        for (size_t i = 0; i < snap->n_tiles; i++)
+                sum += snap->tiles[i].icount[itype];
+
+        return sum;
+}
+
+/**
+ * Report that PC histograms are not available.
+ *
+ * NOTE: The hb_mc_platform_pc_histogram_* methods are declared with
+ * __attribute__((weak)) so that a platform with a PC histogram can
+ * replace them in its own bsg_manycore_platform.cpp.
+ */
+int __attribute__((weak)) hb_mc_platform_pc_histogram_enable(hb_mc_manycore_t *mc)
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_pc_histogram_disable(hb_mc_manycore_t *mc)
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_pc_histogram_reset(hb_mc_manycore_t *mc,
+                                                            hb_mc_coordinate_t tile)
+{
+        return HB_MC_NOIMPL;
+}
+
+int __attribute__((weak)) hb_mc_platform_pc_histogram_read(hb_mc_manycore_t *mc,
+                                                           hb_mc_coordinate_t tile,
+                                                           hb_mc_pc_count_t *counts,
+                                                           size_t cap, size_t *n)
+{
+        *n = 0;
+        return HB_MC_NOIMPL;
+}
+
+/**
+ * Start accumulating per-tile PC histograms
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @return HB_MC_SUCCESS on success. HB_MC_NOIMPL if the platform has no
+ * PC histogram. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_pc_histogram_enable(hb_mc_manycore_t *mc){
+        return hb_mc_platform_pc_histogram_enable(mc);
+}
+
+/**
+ * Stop accumulating per-tile PC histograms. Counts already taken are kept.
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_pc_histogram_disable(hb_mc_manycore_t *mc){
+        return hb_mc_platform_pc_histogram_disable(mc);
+}
+
+/**
+ * Discard the PC histogram of one tile
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in] tile  A tile coordinate
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_pc_histogram_reset(hb_mc_manycore_t *mc, hb_mc_coordinate_t tile){
+        return hb_mc_platform_pc_histogram_reset(mc, tile);
+}
+
+/**
+ * Read the PC histogram of one tile, in ascending PC order
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  tile   A tile coordinate
+ * @param[out] counts An array of #cap entries
+ * @param[in]  cap    Length of #counts
+ * @param[out] n      Number of entries filled in #counts
+ * @return HB_MC_SUCCESS on success. HB_MC_NOMEM if #cap is too small, in which
+ * case #n is set to the number of entries required. Otherwise an error code
+ * defined in bsg_manycore_errno.h.
+ */
+int hb_mc_manycore_pc_histogram_read(hb_mc_manycore_t *mc, hb_mc_coordinate_t tile,
+                                     hb_mc_pc_count_t *counts, size_t cap, size_t *n){
+        return hb_mc_platform_pc_histogram_read(mc, tile, counts, cap, n);
+}
+
 /**
  * Enable trace file generation (vanilla_operation_trace.csv)
  * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
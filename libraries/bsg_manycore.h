@@ -56,6 +56,7 @@ extern "C" {
                 hb_mc_config_t config; //!< configuration of the manycore
                 void *platform;        //!< machine-specific data pointer
                 int dram_enabled;      //!< operating in no-dram mode?
+                void *stats;           //!< API call statistics (see bsg_manycore_api_stats.h)
         } hb_mc_manycore_t;
 
 #define HB_MC_MANYCORE_INIT {0}
@@ -98,6 +99,14 @@ extern "C" {
         __attribute__((warn_unused_result))
         int hb_mc_manycore_exit(hb_mc_manycore_t *mc);
 
+        /**
+         * Get the device cycle counter as read by the last hb_mc_manycore_exit()
+         * @param[out] cycle  The cycle counter
+         * @return HB_MC_SUCCESS on success. HB_MC_NOTFOUND if no manycore has exited,
+         * or the platform has no cycle counter.
+         */
+        int hb_mc_manycore_get_exit_cycle(uint64_t *cycle);
+
         ////////////////
         // Packet API //
         ////////////////
@@ -106,8 +115,9 @@ extern "C" {
          * Transmit a request packet to manycore hardware
          * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init()
          * @param[in] request A request packet to transmit to manycore hardware
-         * @param[in] timeout A timeout counter. Unused - set to -1 to wait forever.
-         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         * @param[in] timeout How long to wait for room in the transmit fifo, 0 to poll, or -1 to wait forever.
+         * @return HB_MC_SUCCESS on success. HB_MC_TIMEOUT if the packet was not accepted in time.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
          */
         __attribute__((warn_unused_result))
         int hb_mc_manycore_request_tx(hb_mc_manycore_t *mc,
@@ -118,14 +128,51 @@ extern "C" {
          * Receive a response packet from manycore hardware
          * @param[in] mc       A manycore instance initialized with hb_mc_manycore_init()
          * @param[in] response A packet into which data should be read
-         * @param[in] timeout  A timeout counter. Unused - set to -1 to wait forever.
-         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         * @param[in] timeout  How long to wait for a response, 0 to poll, or -1 to wait forever.
+         * @return HB_MC_SUCCESS on success. HB_MC_TIMEOUT if no response arrived in time.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
          */
         __attribute__((warn_unused_result))
         int hb_mc_manycore_response_rx(hb_mc_manycore_t *mc,
                                        hb_mc_response_packet_t *response,
                                        long timeout);
 
+        /**
+         * Transmit an array of request packets to manycore hardware, in order
+         * @param[in]  mc       A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  requests An array of request packets to transmit to manycore hardware
+         * @param[in]  n        The number of packets in #requests
+         * @param[in]  timeout  How long to wait for room in the transmit fifo: microseconds on hardware,
+         *                      simulated cycles in simulation, 0 to poll, or -1 to wait forever.
+         *                      Passed to hb_mc_platform_transmit_n().
+         * @param[out] sent     The number of packets accepted, always a prefix of #requests
+         * @return HB_MC_SUCCESS if all #n packets were sent. HB_MC_BUSY if responses must be
+         * read before more requests are accepted. HB_MC_TIMEOUT if the rest were not accepted in time.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_request_tx_n(hb_mc_manycore_t *mc,
+                                        hb_mc_request_packet_t *requests,
+                                        size_t n,
+                                        long timeout,
+                                        size_t *sent);
+
+        /**
+         * Receive up to #n response packets from manycore hardware
+         * @param[in]  mc        A manycore instance initialized with hb_mc_manycore_init()
+         * @param[out] responses An array of at least #n packets into which data should be read
+         * @param[in]  n         The maximum number of packets to read - at most the number outstanding
+         * @param[in]  timeout   Set to -1 to wait forever, or 0 to return HB_MC_TIMEOUT if no packet is ready.
+         * @param[out] received  The number of packets read into #responses
+         * @return HB_MC_SUCCESS if at least one packet was read. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_response_rx_n(hb_mc_manycore_t *mc,
+                                         hb_mc_response_packet_t *responses,
+                                         size_t n,
+                                         long timeout,
+                                         size_t *received);
+
         /**
          * Transmit a response packet to manycore hardware
          * @param[in] mc        A manycore instance initialized with hb_mc_manycore_init()
@@ -142,8 +189,9 @@ extern "C" {
          * Receive a request packet from manycore hardware
          * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init()
          * @param[in] request A packet into which data should be read
-         * @param[in] timeout A timeout counter. Unused - set to -1 to wait forever.
-         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         * @param[in] timeout How long to wait for a request, 0 to poll, or -1 to wait forever.
+         * @return HB_MC_SUCCESS on success. HB_MC_TIMEOUT if no request arrived in time.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
          */
         __attribute__((warn_unused_result))
         int hb_mc_manycore_request_rx(hb_mc_manycore_t *mc,
@@ -264,6 +312,26 @@ extern "C" {
         __attribute__((warn_unused_result))
         int hb_mc_manycore_amoadd32(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa, uint32_t vpi, uint32_t *vpo);
 
+        /**
+         * Do #n 32-bit atomic operations to manycore hardware, pipelined (must be DRAM addresses)
+         *
+         * Requests are issued back-to-back, up to the remote load
+         * capacity at a time, rather than one round trip each.
+         * Operations on the same address are applied in order.
+         *
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  op     An atomic operation, HB_MC_PACKET_OP_REMOTE_AMOSWAP through HB_MC_PACKET_OP_REMOTE_AMOMAXU
+         * @param[in]  npa    An array of #n valid hb_mc_npa_t aligned to four byte boundaries
+         * @param[in]  vpi    An array of #n operands; vpi[i] is applied at npa[i]
+         * @param[out] vpo    An array of #n words set to the previous values, or NULL to discard them
+         * @param[in]  n      The number of atomic operations
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_amo32_n(hb_mc_manycore_t *mc, hb_mc_packet_op_t op,
+                                   const hb_mc_npa_t *npa, const uint32_t *vpi,
+                                   uint32_t *vpo, size_t n);
+
         /**
          * Set memory to a given value starting at a given NPA
          * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
@@ -544,8 +612,9 @@ extern "C" {
         /**
          * Stall until the all requests (and responses to the host) have reached their destination.
          * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
-         * @param[in] timeout A timeout counter. Unused - set to -1 to wait forever.
-         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         * @param[in] timeout How long to wait, 0 to poll, or -1 to wait forever.
+         * @return HB_MC_SUCCESS on success. HB_MC_TIMEOUT if requests are still in flight.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
          */
         int hb_mc_manycore_host_request_fence(hb_mc_manycore_t *mc, long timeout);
 
@@ -573,6 +642,102 @@ extern "C" {
          */
         int hb_mc_manycore_get_icount(hb_mc_manycore_t *mc, bsg_instr_type_e itype, int *count);
 
+#define HB_MC_INSTR_TYPES (e_instr_all + 1)
+
+        typedef struct {
+                hb_mc_coordinate_t coord;                     //!< Tile coordinate
+                uint64_t           icount[HB_MC_INSTR_TYPES]; //!< Instructions executed, indexed by bsg_instr_type_e
+        } hb_mc_tile_icount_t;
+
+        /**
+         * Per-tile instruction counts for every tile with a profiler.
+         *
+         * The caller owns #tiles and sets #cap to its length. A
+         * snapshot fills #n_tiles entries, always in the same order
+         * for the same manycore, so two snapshots can be compared
+         * entry by entry.
+         */
+        typedef struct {
+                uint64_t             cycle;   //!< Device cycle counter when the snapshot was taken
+                hb_mc_tile_icount_t *tiles;   //!< Caller-provided array of #cap entries
+                size_t               cap;     //!< Length of #tiles
+                size_t               n_tiles; //!< Number of entries filled in #tiles
+        } hb_mc_icount_snapshot_t;
+
+        /**
+         * Capture every class of instruction count for every tile in one pass
+         * @param[in]  mc    A manycore instance initialized with hb_mc_manycore_init()
+         * @param[out] snap  A snapshot whose #tiles and #cap are set by the caller
+         * @return HB_MC_SUCCESS on success. HB_MC_NOMEM if #cap is too small, in which
+         * case #n_tiles is set to the number of entries required. HB_MC_NOIMPL if the
+         * platform has no per-tile profiler, as on FPGAs, or the simulated machine
+         * was built without vcore profiling. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_manycore_get_icount_snapshot(hb_mc_manycore_t *mc, hb_mc_icount_snapshot_t *snap);
+
+        /**
+         * Compute the instructions and cycles elapsed between two snapshots
+         * @param[in]  before  A snapshot taken with hb_mc_manycore_get_icount_snapshot()
+         * @param[in]  after   A later snapshot of the same manycore
+         * @param[out] delta   A snapshot whose #tiles and #cap are set by the caller.
+         *                     May be the same as #after.
+         * @return HB_MC_SUCCESS on success. HB_MC_INVALID if the snapshots cover different
+         * tiles. HB_MC_NOMEM if #delta is too small.
+         */
+        int hb_mc_icount_snapshot_delta(const hb_mc_icount_snapshot_t *before,
+                                        const hb_mc_icount_snapshot_t *after,
+                                        hb_mc_icount_snapshot_t *delta);
+
+        /**
+         * Sum one class of instruction count over every tile in a snapshot
+         * @param[in] snap   A snapshot, or a delta between two snapshots
+         * @param[in] itype  The class of instructions to sum
+         * @return The total count for #itype.
+         */
+        uint64_t hb_mc_icount_snapshot_total(const hb_mc_icount_snapshot_t *snap, bsg_instr_type_e itype);
+
+        typedef struct {
+                uint32_t pc;    //!< Program counter (EVA) that was sampled
+                uint64_t count; //!< Number of samples at #pc
+        } hb_mc_pc_count_t;
+
+        /**
+         * Start accumulating per-tile PC histograms
+         * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+         * @return HB_MC_SUCCESS on success. HB_MC_NOIMPL if the platform has no
+         * PC histogram. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_manycore_pc_histogram_enable(hb_mc_manycore_t *mc);
+
+        /**
+         * Stop accumulating per-tile PC histograms. Counts already taken are kept.
+         * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_manycore_pc_histogram_disable(hb_mc_manycore_t *mc);
+
+        /**
+         * Discard the PC histogram of one tile
+         * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in] tile  A tile coordinate
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_manycore_pc_histogram_reset(hb_mc_manycore_t *mc, hb_mc_coordinate_t tile);
+
+        /**
+         * Read the PC histogram of one tile, in ascending PC order
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  tile   A tile coordinate
+         * @param[out] counts An array of #cap entries
+         * @param[in]  cap    Length of #counts
+         * @param[out] n      Number of entries filled in #counts
+         * @return HB_MC_SUCCESS on success. HB_MC_NOMEM if #cap is too small, in which
+         * case #n is set to the number of entries required. Otherwise an error code
+         * defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_manycore_pc_histogram_read(hb_mc_manycore_t *mc, hb_mc_coordinate_t tile,
+                                             hb_mc_pc_count_t *counts, size_t cap, size_t *n);
+
         /**
          * Enable trace file generation (vanilla_operation_trace.csv)
          * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
@@ -0,0 +1,196 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_api_stats.h>
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_printing.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
+typedef struct hb_mc_api_stats_table {
+        hb_mc_api_stats_t api[HB_MC_API_N];
+} hb_mc_api_stats_table_t;
+
+static const char *hb_mc_api_names[HB_MC_API_N] = {
+        "write_mem",
+        "read_mem",
+        "fence",
+        "eva_write",
+        "eva_read",
+        "dma_write",
+        "dma_read",
+        "program_init",
+        "kernel_enqueue",
+        "tile_group_launch",
+        "tile_group_finish",
+};
+
+const char *hb_mc_api_to_string(hb_mc_api_t api)
+{
+        if (api < 0 || api >= HB_MC_API_N)
+                return "unknown";
+
+        return hb_mc_api_names[api];
+}
+
+/* the histogram bucket for #v: the number of significant bits */
+static inline unsigned hb_mc_api_stats_bucket(uint64_t v)
+{
+        return v == 0 ? 0 : std::min(64 - __builtin_clzll(v), HB_MC_API_STATS_BUCKETS - 1);
+}
+
+static void hb_mc_api_stats_clear(hb_mc_api_stats_table_t *table)
+{
+        memset(table, 0, sizeof(*table));
+        for (int api = 0; api < HB_MC_API_N; api++)
+                table->api[api].ns_min = UINT64_MAX;
+}
+
+int hb_mc_manycore_api_stats_init(hb_mc_manycore_t *mc)
+{
+        mc->stats = nullptr;
+#if HB_MC_API_STATS
+        hb_mc_api_stats_table_t *table =
+                reinterpret_cast<hb_mc_api_stats_table_t*>(malloc(sizeof(*table)));
+        if (table == nullptr) {
+                bsg_pr_err("%s: failed to allocate API statistics: %m\n", __func__);
+                return HB_MC_NOMEM;
+        }
+
+        hb_mc_api_stats_clear(table);
+        mc->stats = table;
+#endif
+        return HB_MC_SUCCESS;
+}
+
+void hb_mc_manycore_api_stats_cleanup(hb_mc_manycore_t *mc)
+{
+        free(mc->stats);
+        mc->stats = nullptr;
+}
+
+void hb_mc_manycore_api_stats_record(hb_mc_manycore_t *mc, hb_mc_api_t api,
+                                     uint64_t ns, uint64_t cycles)
+{
+        hb_mc_api_stats_table_t *table = reinterpret_cast<hb_mc_api_stats_table_t*>(mc->stats);
+        hb_mc_api_stats_t *s = &table->api[api];
+
+        s->calls++;
+        s->ns_total += ns;
+        s->cycles_total += cycles;
+        if (ns < s->ns_min)
+                s->ns_min = ns;
+        if (ns > s->ns_max)
+                s->ns_max = ns;
+
+        s->ns_hist[hb_mc_api_stats_bucket(ns)]++;
+        s->cycles_hist[hb_mc_api_stats_bucket(cycles)]++;
+}
+
+int hb_mc_manycore_api_stats_get(const hb_mc_manycore_t *mc, hb_mc_api_t api,
+                                 hb_mc_api_stats_t *stats)
+{
+        if (mc->stats == nullptr)
+                return HB_MC_NOIMPL;
+
+        if (api < 0 || api >= HB_MC_API_N || stats == nullptr)
+                return HB_MC_INVALID;
+
+        *stats = reinterpret_cast<const hb_mc_api_stats_table_t*>(mc->stats)->api[api];
+        return HB_MC_SUCCESS;
+}
+
+void hb_mc_manycore_api_stats_reset(hb_mc_manycore_t *mc)
+{
+        if (mc->stats != nullptr)
+                hb_mc_api_stats_clear(reinterpret_cast<hb_mc_api_stats_table_t*>(mc->stats));
+}
+
+/* an upper bound on the #pct percentile of a histogram with #n entries */
+static uint64_t hb_mc_api_stats_percentile(const uint64_t *hist, uint64_t n, unsigned pct)
+{
+        uint64_t rank = (n * pct + 99) / 100, seen = 0;
+        for (unsigned b = 0; b < HB_MC_API_STATS_BUCKETS; b++) {
+                seen += hist[b];
+                if (seen >= rank)
+                        return b == 0 ? 0 : (UINT64_C(1) << b) - 1;
+        }
+        return UINT64_MAX;
+}
+
+void hb_mc_manycore_api_stats_print(const hb_mc_manycore_t *mc)
+{
+        const hb_mc_api_stats_table_t *table =
+                reinterpret_cast<const hb_mc_api_stats_table_t*>(mc->stats);
+        if (table == nullptr)
+                return;
+
+        bsg_pr_info("%s: API call statistics (p50/p99 are upper bounds)\n", mc->name);
+        bsg_pr_info("%-18s %10s %14s %10s %10s %10s %10s %10s %12s\n",
+                    "call", "calls", "total (us)", "mean (ns)", "min (ns)",
+                    "p50 (ns)", "p99 (ns)", "max (ns)", "mean (cyc)");
+
+        for (int api = 0; api < HB_MC_API_N; api++) {
+                const hb_mc_api_stats_t *s = &table->api[api];
+                if (s->calls == 0)
+                        continue;
+
+                bsg_pr_info("%-18s %10" PRIu64 " %14" PRIu64 " %10" PRIu64 " %10" PRIu64
+                            " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %12" PRIu64 "\n",
+                            hb_mc_api_to_string(static_cast<hb_mc_api_t>(api)),
+                            s->calls,
+                            s->ns_total / 1000,
+                            s->ns_total / s->calls,
+                            s->ns_min,
+                            hb_mc_api_stats_percentile(s->ns_hist, s->calls, 50),
+                            hb_mc_api_stats_percentile(s->ns_hist, s->calls, 99),
+                            s->ns_max,
+                            s->cycles_total / s->calls);
+        }
+
+        /* one line per call: the count in each power-of-two latency bucket */
+        for (int api = 0; api < HB_MC_API_N; api++) {
+                const hb_mc_api_stats_t *s = &table->api[api];
+                if (s->calls == 0)
+                        continue;
+
+                char line[1024] = "";
+                size_t len = 0;
+                for (unsigned b = 0; b < HB_MC_API_STATS_BUCKETS && len < sizeof(line); b++) {
+                        if (s->ns_hist[b] == 0)
+                                continue;
+                        len += snprintf(&line[len], sizeof(line) - len, " <2^%u:%" PRIu64,
+                                        b, s->ns_hist[b]);
+                }
+
+                bsg_pr_info("%-18s ns histogram:%s\n",
+                            hb_mc_api_to_string(static_cast<hb_mc_api_t>(api)), line);
+        }
+}
@@ -0,0 +1,183 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/* Call counts and latency histograms for host API calls */
+#ifndef BSG_MANYCORE_API_STATS_H
+#define BSG_MANYCORE_API_STATS_H
+#include <bsg_manycore_features.h>
+#include <bsg_manycore.h>
+#include <bsg_manycore_errno.h>
+#ifdef __cplusplus
+#include <cstdint>
+#include <cstddef>
+#include <ctime>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#endif
+
+/*
+ * Statistics are compiled into the runtime library with HB_MC_API_STATS
+ * (see LIB_API_STATS in libraries.mk):
+ *   0 - off, instrumented calls compile to nothing
+ *   1 - call counts and wall-clock latency
+ *   2 - also device-cycle latency, which costs two extra cycle-counter
+ *       reads per call (MMIO reads on FPGA platforms)
+ */
+#ifndef HB_MC_API_STATS
+#define HB_MC_API_STATS 0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+        typedef enum __hb_mc_api_t {
+                HB_MC_API_WRITE_MEM         = 0,
+                HB_MC_API_READ_MEM          = 1,
+                HB_MC_API_FENCE             = 2,
+                HB_MC_API_EVA_WRITE         = 3,
+                HB_MC_API_EVA_READ          = 4,
+                HB_MC_API_DMA_WRITE         = 5,
+                HB_MC_API_DMA_READ          = 6,
+                HB_MC_API_PROGRAM_INIT      = 7,
+                HB_MC_API_KERNEL_ENQUEUE    = 8,
+                HB_MC_API_TILE_GROUP_LAUNCH = 9,
+                HB_MC_API_TILE_GROUP_FINISH = 10,
+                HB_MC_API_N                 = 11,
+        } hb_mc_api_t;
+
+/* bucket b counts latencies in [2^(b-1), 2^b); bucket 0 counts zero */
+#define HB_MC_API_STATS_BUCKETS 64
+
+        typedef struct __hb_mc_api_stats_t {
+                uint64_t calls;
+                uint64_t ns_total;
+                uint64_t ns_min;
+                uint64_t ns_max;
+                uint64_t cycles_total; //!< Zero unless HB_MC_API_STATS >= 2
+                uint64_t ns_hist[HB_MC_API_STATS_BUCKETS];
+                uint64_t cycles_hist[HB_MC_API_STATS_BUCKETS];
+        } hb_mc_api_stats_t;
+
+        /**
+         * Get a printable name for an instrumented API call
+         * @param[in]  api   An instrumented call
+         * @return A string naming #api.
+         */
+        const char *hb_mc_api_to_string(hb_mc_api_t api);
+
+        /**
+         * Get the statistics recorded for an API call since hb_mc_manycore_init()
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  api    An instrumented call
+         * @param[out] stats  Set to the statistics recorded for #api
+         * @return HB_MC_NOIMPL if the library was built without HB_MC_API_STATS.
+         * HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_manycore_api_stats_get(const hb_mc_manycore_t *mc, hb_mc_api_t api,
+                                         hb_mc_api_stats_t *stats);
+
+        /**
+         * Clear the statistics recorded for all API calls
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         */
+        void hb_mc_manycore_api_stats_reset(hb_mc_manycore_t *mc);
+
+        /**
+         * Print a summary of the statistics recorded for each API call that was made.
+         * Does nothing if the library was built without HB_MC_API_STATS.
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         */
+        void hb_mc_manycore_api_stats_print(const hb_mc_manycore_t *mc);
+
+        /* used by hb_mc_manycore_init() and hb_mc_manycore_exit() */
+        int hb_mc_manycore_api_stats_init(hb_mc_manycore_t *mc);
+        void hb_mc_manycore_api_stats_cleanup(hb_mc_manycore_t *mc);
+
+        /* add one call of #api to the statistics of #mc */
+        void hb_mc_manycore_api_stats_record(hb_mc_manycore_t *mc, hb_mc_api_t api,
+                                             uint64_t ns, uint64_t cycles);
+
+        static inline uint64_t hb_mc_api_stats_now_ns(void)
+        {
+                struct timespec ts;
+                clock_gettime(CLOCK_MONOTONIC, &ts);
+                return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+        }
+
+#ifdef __cplusplus
+}
+
+/*
+ * Times the enclosing scope and records it against an API call, so that
+ * every return path of an instrumented function is counted.
+ */
+class hb_mc_api_probe {
+public:
+        hb_mc_api_probe(hb_mc_manycore_t *mc, hb_mc_api_t api) :
+                mc(mc), api(api), on(mc != nullptr && mc->stats != nullptr), ns(0), cycles(0) {
+                if (!on)
+                        return;
+#if HB_MC_API_STATS >= 2
+                hb_mc_manycore_get_cycle(mc, &cycles);
+#endif
+                ns = hb_mc_api_stats_now_ns();
+        }
+
+        ~hb_mc_api_probe() {
+                if (!on || mc->stats == nullptr)
+                        return;
+                uint64_t elapsed_ns = hb_mc_api_stats_now_ns() - ns;
+                uint64_t elapsed_cycles = 0;
+#if HB_MC_API_STATS >= 2
+                uint64_t now;
+                if (hb_mc_manycore_get_cycle(mc, &now) == HB_MC_SUCCESS)
+                        elapsed_cycles = now - cycles;
+#endif
+                hb_mc_manycore_api_stats_record(mc, api, elapsed_ns, elapsed_cycles);
+        }
+
+private:
+        hb_mc_manycore_t *mc;
+        hb_mc_api_t api;
+        bool on;
+        uint64_t ns;
+        uint64_t cycles;
+};
+
+#if HB_MC_API_STATS
+#define HB_MC_API_PROBE(mc, api)                        \
+        hb_mc_api_probe __hb_mc_api_probe((mc), (api))
+#else
+#define HB_MC_API_PROBE(mc, api)
+#endif
+
+#endif // #ifdef __cplusplus
+
+#endif
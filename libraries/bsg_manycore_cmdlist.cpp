@@ -0,0 +1,158 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_cmdlist.h>
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_printing.h>
+
+#include <cstdlib>
+#include <cstring>
+
+/* grow an array of elements of size #sz to hold at least #n */
+static int hb_mc_cmdlist_reserve(void **array, size_t *cap, size_t n, size_t sz)
+{
+        if (n <= *cap)
+                return HB_MC_SUCCESS;
+
+        size_t new_cap = *cap ? *cap : 64;
+        while (new_cap < n)
+                new_cap *= 2;
+
+        void *new_array = realloc(*array, new_cap * sz);
+        if (new_array == NULL) {
+                bsg_pr_err("%s: failed to grow command list to %zu entries\n",
+                           __func__, new_cap);
+                return HB_MC_NOMEM;
+        }
+
+        *array = new_array;
+        *cap = new_cap;
+        return HB_MC_SUCCESS;
+}
+
+/* append a command, returning its index through #cmd */
+static int hb_mc_cmdlist_push(hb_mc_cmdlist_t *cl, const hb_mc_cmd_t *c, size_t *cmd)
+{
+        int err;
+
+        err = hb_mc_cmdlist_reserve(reinterpret_cast<void**>(&cl->cmds), &cl->cap_cmds,
+                                    cl->n_cmds + 1, sizeof(hb_mc_cmd_t));
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        if (cmd != NULL)
+                *cmd = cl->n_cmds;
+
+        cl->cmds[cl->n_cmds++] = *c;
+        return HB_MC_SUCCESS;
+}
+
+int hb_mc_cmdlist_init(hb_mc_cmdlist_t *cl)
+{
+        memset(cl, 0, sizeof(*cl));
+        return HB_MC_SUCCESS;
+}
+
+void hb_mc_cmdlist_cleanup(hb_mc_cmdlist_t *cl)
+{
+        free(cl->cmds);
+        free(cl->deps);
+        memset(cl, 0, sizeof(*cl));
+}
+
+void hb_mc_cmdlist_reset(hb_mc_cmdlist_t *cl)
+{
+        cl->n_cmds = 0;
+        cl->n_deps = 0;
+}
+
+int hb_mc_cmdlist_read32(hb_mc_cmdlist_t *cl, const hb_mc_npa_t *npa, size_t *cmd)
+{
+        hb_mc_cmd_t c = {};
+        c.type = HB_MC_CMD_READ32;
+        c.npa  = *npa;
+        c.deps = HB_MC_CMD_NONE;
+        return hb_mc_cmdlist_push(cl, &c, cmd);
+}
+
+int hb_mc_cmdlist_write32(hb_mc_cmdlist_t *cl, const hb_mc_npa_t *npa, uint32_t v, size_t *cmd)
+{
+        hb_mc_cmd_t c = {};
+        c.type = HB_MC_CMD_WRITE32;
+        c.npa  = *npa;
+        c.data = v;
+        c.deps = HB_MC_CMD_NONE;
+        return hb_mc_cmdlist_push(cl, &c, cmd);
+}
+
+int hb_mc_cmdlist_amo32(hb_mc_cmdlist_t *cl, hb_mc_packet_op_t op,
+                        const hb_mc_npa_t *npa, uint32_t v, size_t *cmd)
+{
+        if (op < HB_MC_PACKET_OP_REMOTE_AMOSWAP || op > HB_MC_PACKET_OP_REMOTE_AMOMAXU) {
+                bsg_pr_err("%s: Not an atomic operation: %d\n", __func__, op);
+                return HB_MC_INVALID;
+        }
+
+        hb_mc_cmd_t c = {};
+        c.type = HB_MC_CMD_AMO32;
+        c.npa  = *npa;
+        c.op   = op;
+        c.data = v;
+        c.deps = HB_MC_CMD_NONE;
+        return hb_mc_cmdlist_push(cl, &c, cmd);
+}
+
+int hb_mc_cmdlist_fence(hb_mc_cmdlist_t *cl, size_t *cmd)
+{
+        hb_mc_cmd_t c = {};
+        c.type = HB_MC_CMD_FENCE;
+        c.deps = HB_MC_CMD_NONE;
+        return hb_mc_cmdlist_push(cl, &c, cmd);
+}
+
+int hb_mc_cmdlist_depend(hb_mc_cmdlist_t *cl, size_t cmd, size_t on)
+{
+        int err;
+
+        // dependencies only point backwards, so a list can't deadlock
+        if (cmd >= cl->n_cmds || on >= cmd) {
+                bsg_pr_err("%s: command %zu cannot depend on command %zu\n",
+                           __func__, cmd, on);
+                return HB_MC_INVALID;
+        }
+
+        err = hb_mc_cmdlist_reserve(reinterpret_cast<void**>(&cl->deps), &cl->cap_deps,
+                                    cl->n_deps + 1, sizeof(hb_mc_cmd_dep_t));
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        cl->deps[cl->n_deps].on = on;
+        cl->deps[cl->n_deps].next = cl->cmds[cmd].deps;
+        cl->cmds[cmd].deps = cl->n_deps++;
+
+        return HB_MC_SUCCESS;
+}
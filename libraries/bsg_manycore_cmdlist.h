@@ -0,0 +1,186 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/* Record ordered streams of reads, writes, atomics and fences for pipelined submission */
+#ifndef BSG_MANYCORE_CMDLIST_H
+#define BSG_MANYCORE_CMDLIST_H
+#include <bsg_manycore_features.h>
+#include <bsg_manycore.h>
+#include <bsg_manycore_npa.h>
+#include <bsg_manycore_request_packet.h>
+#ifdef __cplusplus
+#include <cstdint>
+#include <cstddef>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HB_MC_CMD_NONE ((size_t)-1)
+
+        typedef enum __hb_mc_cmd_type_t {
+                HB_MC_CMD_READ32  = 0, //!< Load a word
+                HB_MC_CMD_WRITE32 = 1, //!< Store a word
+                HB_MC_CMD_AMO32   = 2, //!< Atomic operation on a word in DRAM
+                HB_MC_CMD_FENCE   = 3, //!< Wait for every earlier command to complete
+        } hb_mc_cmd_type_t;
+
+        typedef struct __hb_mc_cmd_t {
+                hb_mc_cmd_type_t  type;
+                hb_mc_npa_t       npa;
+                hb_mc_packet_op_t op;   //!< Atomic operation (HB_MC_CMD_AMO32 only)
+                uint32_t          data; //!< Store data or atomic operand
+                size_t            deps; //!< First entry in the dependency list, or HB_MC_CMD_NONE
+        } hb_mc_cmd_t;
+
+        typedef struct __hb_mc_cmd_dep_t {
+                size_t on;   //!< The command that must complete first
+                size_t next; //!< Next entry for the same command, or HB_MC_CMD_NONE
+        } hb_mc_cmd_dep_t;
+
+        /**
+         * A command list is an ordered sequence of commands to NPAs.
+         *
+         * Commands are issued in the order they were recorded, and
+         * as many are kept in flight at once as the hardware allows.
+         * The only ordering between commands to different NPAs is
+         * what the caller declares with hb_mc_cmdlist_depend() or
+         * hb_mc_cmdlist_fence(). Commands to the same NPA travel the
+         * same network path and complete in order.
+         */
+        typedef struct __hb_mc_cmdlist_t {
+                hb_mc_cmd_t     *cmds;
+                size_t           n_cmds;
+                size_t           cap_cmds;
+                hb_mc_cmd_dep_t *deps;
+                size_t           n_deps;
+                size_t           cap_deps;
+        } hb_mc_cmdlist_t;
+
+        /**
+         * Initialize an empty command list
+         * @param[in] cl  A command list
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_cmdlist_init(hb_mc_cmdlist_t *cl);
+
+        /**
+         * Free the memory held by a command list
+         * @param[in] cl  A command list initialized with hb_mc_cmdlist_init()
+         */
+        void hb_mc_cmdlist_cleanup(hb_mc_cmdlist_t *cl);
+
+        /**
+         * Remove every command from a command list, keeping its memory for reuse
+         * @param[in] cl  A command list initialized with hb_mc_cmdlist_init()
+         */
+        void hb_mc_cmdlist_reset(hb_mc_cmdlist_t *cl);
+
+        /**
+         * Get the number of commands in a command list
+         * @param[in] cl  A command list initialized with hb_mc_cmdlist_init()
+         * @return The number of commands recorded.
+         */
+        static inline size_t hb_mc_cmdlist_size(const hb_mc_cmdlist_t *cl)
+        {
+                return cl->n_cmds;
+        }
+
+        /**
+         * Record a 32-bit read
+         * @param[in]  cl   A command list initialized with hb_mc_cmdlist_init()
+         * @param[in]  npa  A valid hb_mc_npa_t aligned to a four byte boundary
+         * @param[out] cmd  Set to the index of the new command, if not NULL
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_cmdlist_read32(hb_mc_cmdlist_t *cl, const hb_mc_npa_t *npa, size_t *cmd);
+
+        /**
+         * Record a 32-bit write
+         * @param[in]  cl   A command list initialized with hb_mc_cmdlist_init()
+         * @param[in]  npa  A valid hb_mc_npa_t aligned to a four byte boundary
+         * @param[in]  v    The word to write
+         * @param[out] cmd  Set to the index of the new command, if not NULL
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_cmdlist_write32(hb_mc_cmdlist_t *cl, const hb_mc_npa_t *npa, uint32_t v, size_t *cmd);
+
+        /**
+         * Record a 32-bit atomic operation (must be a DRAM address)
+         * @param[in]  cl   A command list initialized with hb_mc_cmdlist_init()
+         * @param[in]  op   An atomic operation, HB_MC_PACKET_OP_REMOTE_AMOSWAP through HB_MC_PACKET_OP_REMOTE_AMOMAXU
+         * @param[in]  npa  A valid hb_mc_npa_t aligned to a four byte boundary
+         * @param[in]  v    The operand
+         * @param[out] cmd  Set to the index of the new command, if not NULL
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_cmdlist_amo32(hb_mc_cmdlist_t *cl, hb_mc_packet_op_t op,
+                                const hb_mc_npa_t *npa, uint32_t v, size_t *cmd);
+
+        /**
+         * Record a fence: no later command is issued until every earlier command has completed
+         * @param[in]  cl   A command list initialized with hb_mc_cmdlist_init()
+         * @param[out] cmd  Set to the index of the new command, if not NULL
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_cmdlist_fence(hb_mc_cmdlist_t *cl, size_t *cmd);
+
+        /**
+         * Declare that command #cmd may not be issued until command #on has completed
+         *
+         * A read or atomic completes when its response arrives. A
+         * write completes at the next fence, so depending on one
+         * stalls the stream until outstanding writes have landed.
+         *
+         * @param[in] cl   A command list initialized with hb_mc_cmdlist_init()
+         * @param[in] cmd  The index of the dependent command
+         * @param[in] on   The index of an earlier command
+         * @return HB_MC_SUCCESS on success. HB_MC_INVALID if #on is not earlier than #cmd.
+         */
+        int hb_mc_cmdlist_depend(hb_mc_cmdlist_t *cl, size_t cmd, size_t on);
+
+        /**
+         * Submit a command list as one pipelined stream and wait for it to complete
+         * @param[in]  mc       A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  cl       A command list initialized with hb_mc_cmdlist_init()
+         * @param[out] results  An array of hb_mc_cmdlist_size() words, or NULL. results[i] is
+         *                      set to the data read by command i, or the previous value for
+         *                      an atomic. Entries for writes and fences are left untouched.
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_manycore_cmdlist_submit(hb_mc_manycore_t *mc, const hb_mc_cmdlist_t *cl,
+                                          uint32_t *results);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -24,6 +24,7 @@
 // ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#define BSG_LOG_SUBSYSTEM BSG_LOG_CUDA
 #include <bsg_manycore_cuda.h>
 #include <bsg_manycore_cuda_barrier.h>
 #include <bsg_manycore_tile.h>
@@ -35,9 +36,17 @@
 #include <bsg_manycore_eva.h>
 #include <bsg_manycore_origin_eva_map.h>
 #include <bsg_manycore_config_pod.h>
+#include <bsg_manycore_api_stats.h>
+#include <bsg_manycore_trace_regions.h>
+#include <bsg_manycore_stats_stream.h>
+#include <bsg_manycore_hotspots.h>
+#include <bsg_manycore_watchdog.h>
+#include <bsg_manycore_timeline.h>
 
 #ifdef __cplusplus
 #include <cstring>
+#include <algorithm>
+#include <chrono>
 #else
 #include <string.h>
 #endif
@@ -95,6 +104,8 @@
 // Constants //
 ///////////////
 static const hb_mc_dimension_t HB_MC_MESH_FULL_CORE = HB_MC_DIMENSION(0,0);
+// largest alignment of an argument passed by reference (a double word on RV32)
+static const size_t HB_MC_KERNEL_ARGS_DATA_ALIGN = 8;
 
 ////////////////////
 // Kernel helpers //
@@ -110,6 +121,37 @@ static int kernel_init(hb_mc_kernel_t *kernel, const char *name, uint32_t argc,
         memcpy(const_cast<uint32_t*>(kernel->argv), argv, argc * sizeof(*argv));
         kernel->argc = argc;
         kernel->refcount = 0;
+        kernel->argv_eva = 0;
+        kernel->data = NULL;
+        kernel->data_size = 0;
+        kernel->relocs = NULL;
+        kernel->num_relocs = 0;
+        kernel->launch = 0;
+        kernel->traced = 0;
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Initialize a kernel from a typed argument list
+ */
+__attribute__((warn_unused_result))
+static int kernel_init_args(hb_mc_kernel_t *kernel, const char *name, const hb_mc_kernel_args_t *args)
+{
+        BSG_CUDA_CALL(kernel_init(kernel, name, args->argc, args->argv));
+
+        if (args->data_size > 0) {
+                XMALLOC_N(kernel->data, args->data_size);
+                memcpy(const_cast<unsigned char*>(kernel->data), args->data, args->data_size);
+                kernel->data_size = args->data_size;
+        }
+
+        if (args->num_relocs > 0) {
+                XMALLOC_N(kernel->relocs, args->num_relocs);
+                memcpy(const_cast<uint32_t*>(kernel->relocs), args->relocs,
+                       args->num_relocs * sizeof(*args->relocs));
+                kernel->num_relocs = args->num_relocs;
+        }
 
         return HB_MC_SUCCESS;
 }
@@ -133,6 +175,14 @@ static int kernel_exit(hb_mc_kernel_t *kernel)
         free(const_cast<uint32_t*>(kernel->argv));
         kernel->argv = NULL;
 
+        free(const_cast<unsigned char*>(kernel->data));
+        kernel->data = NULL;
+        kernel->data_size = 0;
+
+        free(const_cast<uint32_t*>(kernel->relocs));
+        kernel->relocs = NULL;
+        kernel->num_relocs = 0;
+
         kernel->refcount = 0;
         kernel->argc = 0;
 
@@ -154,6 +204,9 @@ static int hb_mc_device_pod_tile_group_init(hb_mc_device_t* device,
 __attribute__((warn_unused_result))
 static int hb_mc_device_pod_tile_group_exit(hb_mc_device_t *device, hb_mc_pod_t *pod, hb_mc_tile_group_t *tg);
 
+__attribute__((warn_unused_result))
+static int hb_mc_device_pod_barcfgs_exit(hb_mc_device_t *device, hb_mc_pod_t *pod);
+
 /////////////////////
 // Program helpers //
 /////////////////////
@@ -510,6 +563,9 @@ static int hb_mc_device_pod_init(hb_mc_device_t *device,
         pod->tile_group_capacity = 0;
         pod->num_grids           = 0;
         pod->program_loaded      = 0;
+        pod->barcfgs             = NULL;
+        pod->num_barcfgs         = 0;
+        pod->barcfg_capacity     = 0;
         return HB_MC_SUCCESS;
 }
 
@@ -534,6 +590,14 @@ int hb_mc_device_init (hb_mc_device_t *device,
                        const char *name,
                        hb_mc_manycore_id_t id)
 {
+        int err;
+
+        // nothing to clean up until each feature is initialized
+        device->trace_regions = NULL;
+        device->stats_stream = NULL;
+        device->hotspots = NULL;
+        device->watchdog = NULL;
+
         // initialize manycore
         XMALLOC(device->mc);
         *(device->mc) = {0};
@@ -565,7 +629,50 @@ int hb_mc_device_init (hb_mc_device_t *device,
         // set name
         XSTRDUP(device->name, name);
 
+        // trace the kernels selected by HB_MC_TRACE_KERNELS, if any
+        err = hb_mc_device_trace_regions_init(device);
+        if (err != HB_MC_SUCCESS)
+                goto cleanup;
+
+        // record per-tile-group stats to HB_MC_STATS_STREAM, if set
+        err = hb_mc_device_stats_stream_init(device);
+        if (err != HB_MC_SUCCESS)
+                goto cleanup;
+
+        // report the hottest functions of each launch if HB_MC_HOTSPOTS is set
+        err = hb_mc_device_hotspots_init(device);
+        if (err != HB_MC_SUCCESS)
+                goto cleanup;
+
+        // bound tile group run time if HB_MC_WATCHDOG_{SECONDS,CYCLES} are set
+        err = hb_mc_device_watchdog_init(device);
+        if (err != HB_MC_SUCCESS)
+                goto cleanup;
+
+        // record a timeline to HB_MC_TIMELINE, if set
+        err = hb_mc_timeline_init();
+        if (err != HB_MC_SUCCESS)
+                goto cleanup;
+
         return HB_MC_SUCCESS;
+
+cleanup:
+        // a bad environment variable should not leak the device
+        hb_mc_device_watchdog_disable(device);
+        hb_mc_device_hotspots_disable(device);
+        hb_mc_device_stats_stream_close(device);
+        hb_mc_device_trace_regions_cleanup(device);
+        hb_mc_timeline_close();
+        if (hb_mc_manycore_exit(device->mc) != HB_MC_SUCCESS)
+                bsg_pr_err("%s: failed to exit manycore after init error\n",
+                           __func__);
+        free(device->mc);
+        free(device->pods);
+        free(const_cast<char*>(device->name));
+        device->mc = NULL;
+        device->pods = NULL;
+        device->name = NULL;
+        return err;
 }
 
 
@@ -629,6 +736,17 @@ int hb_mc_device_finish (hb_mc_device_t *device)
         // fence on all requests
         BSG_CUDA_CALL(hb_mc_manycore_host_request_fence(device->mc, -1));
 
+        // summarize host API costs (if built with HB_MC_API_STATS)
+        hb_mc_manycore_api_stats_print(device->mc);
+
+        hb_mc_device_trace_regions_cleanup(device);
+        hb_mc_device_stats_stream_close(device);
+        hb_mc_device_hotspots_disable(device);
+        hb_mc_device_watchdog_disable(device);
+
+        // errors are reported, but should not stop the cleanup
+        hb_mc_timeline_close();
+
         // cleanup manycore
         BSG_CUDA_CALL(hb_mc_manycore_exit (device->mc));
 
@@ -918,6 +1036,9 @@ int hb_mc_device_pod_program_init_binary_opts(hb_mc_device_t       *device,
                                               size_t                bin_size,
                                               const hb_mc_program_options_t *popts)
 {
+        HB_MC_API_PROBE(device->mc, HB_MC_API_PROGRAM_INIT);
+        HB_MC_TIMELINE_PROBE(device->mc, "program_init", "program",
+                             HB_MC_TIMELINE_POD_PID(pod_id), HB_MC_TIMELINE_HOST_TID);
         bsg_pr_dbg("%s: device<%s>: program<%s>\n", __func__, device->name, popts->program_name);
         CHECK_POD_ID(device, pod_id);
 
@@ -1006,6 +1127,9 @@ int hb_mc_device_pod_tile_groups_exit(hb_mc_device_t *device,
                         BSG_CUDA_CALL(hb_mc_device_pod_tile_group_exit(device, pod, tg));
         }
 
+        // free barrier configs
+        BSG_CUDA_CALL(hb_mc_device_pod_barcfgs_exit(device, pod));
+
         // free tile groups
         free(pod->tile_groups);
         pod->tile_groups = NULL;
@@ -1205,6 +1329,8 @@ int hb_mc_device_pod_memcpy_to_device(hb_mc_device_t *device,
                                       const void *haddr,
                                       uint32_t bytes)
 {
+        HB_MC_TIMELINE_PROBE(device->mc, "memcpy_to_device", "memcpy",
+                             HB_MC_TIMELINE_POD_PID(pod_id), HB_MC_TIMELINE_HOST_TID);
         CHECK_POD_ID(device, pod_id);
 
         hb_mc_pod_t *pod = &device->pods[pod_id];
@@ -1233,6 +1359,8 @@ int hb_mc_device_pod_memcpy_to_host(hb_mc_device_t *device,
                                     hb_mc_eva_t daddr,
                                     uint32_t bytes)
 {
+        HB_MC_TIMELINE_PROBE(device->mc, "memcpy_to_host", "memcpy",
+                             HB_MC_TIMELINE_POD_PID(pod_id), HB_MC_TIMELINE_HOST_TID);
         CHECK_POD_ID(device, pod_id);
 
         hb_mc_pod_t *pod = &device->pods[pod_id];
@@ -1260,6 +1388,8 @@ int hb_mc_device_pod_memset (hb_mc_device_t *device,
                              uint8_t data,
                              size_t sz)
 {
+        HB_MC_TIMELINE_PROBE(device->mc, "memset", "memcpy",
+                             HB_MC_TIMELINE_POD_PID(pod_id), HB_MC_TIMELINE_HOST_TID);
         CHECK_POD_ID(device, pod_id);
 
         hb_mc_pod_t *pod = &device->pods[pod_id];
@@ -1294,6 +1424,12 @@ static int hb_mc_device_pod_tile_group_init(hb_mc_device_t* device,
         tg->grid_id = grid_id;
         tg->grid_dim = grid_dim;
         tg->status = HB_MC_TILE_GROUP_STATUS_INITIALIZED;
+        // set at allocation; exit checks them even if that never happens
+        tg->barcfg_eva = 0;
+        tg->argv_eva = 0;
+        // stamped at launch only if the timeline or watchdog wants it
+        tg->launched.ns = 0;
+        tg->launched.cycle = 0;
 
         hb_mc_coordinate_t host = hb_mc_manycore_get_host_coordinate(device->mc);
         tg->finish_signal_npa = hb_mc_npa(host, hb_mc_tile_group_get_finish_signal_addr(tg));
@@ -1313,11 +1449,15 @@ static int hb_mc_device_pod_tile_group_init(hb_mc_device_t* device,
 static int hb_mc_device_pod_tile_group_exit(hb_mc_device_t *device, hb_mc_pod_t *pod, hb_mc_tile_group_t *tg)
 {
 
-        // Free the memory location in the device that holds the list of
-        // arguments of tile group's kernel
         hb_mc_pod_id_t pod_id = hb_mc_device_pod_to_pod_id(device, pod);
-        BSG_CUDA_CALL(hb_mc_device_pod_free(device, pod_id, tg->argv_eva));
-        BSG_CUDA_CALL(hb_mc_device_pod_free(device, pod_id, tg->barcfg_eva));
+
+        // release the barrier config for reuse by another tile group of this shape
+        for (uint32_t i = 0; i < pod->num_barcfgs; i++) {
+                if (tg->barcfg_eva != 0 && pod->barcfgs[i].eva == tg->barcfg_eva)
+                        pod->barcfgs[i].in_use = 0;
+        }
+        tg->barcfg_eva = 0;
+        tg->argv_eva = 0;
 
         // release tile gorup resources
         tg->dim = HB_MC_DIMENSION(0,0);
@@ -1331,9 +1471,15 @@ static int hb_mc_device_pod_tile_group_exit(hb_mc_device_t *device, hb_mc_pod_t
         free(tg->map);
 
         // decrement the kernel reference count and free if needed
+        // the last tile group of the grid frees the shared argv
         tg->kernel->refcount -= 1;
-        if (tg->kernel->refcount == 0)
+        if (tg->kernel->refcount == 0) {
+                BSG_CUDA_CALL(hb_mc_device_hotspots_kernel_finish(device, pod, tg->kernel));
+                if (tg->kernel->argv_eva != 0)
+                        BSG_CUDA_CALL(hb_mc_device_pod_free(device, pod_id, tg->kernel->argv_eva));
                 BSG_CUDA_CALL(kernel_exit(tg->kernel));
+                free(tg->kernel);
+        }
 
         tg->kernel = NULL;
         return HB_MC_SUCCESS;
@@ -1376,6 +1522,36 @@ static int hb_mc_device_pod_tile_group_kernel_enqueue (hb_mc_device_t* device,
         return HB_MC_SUCCESS;
 }
 
+/**
+ * Enqueue a tile group for every point of a grid running kernel on a pod.
+ */
+__attribute__((warn_unused_result))
+static
+int hb_mc_device_pod_grid_enqueue(hb_mc_device_t    *device,
+                                  hb_mc_pod_t       *pod,
+                                  hb_mc_dimension_t  grid_dim,
+                                  hb_mc_dimension_t  tg_dim,
+                                  hb_mc_kernel_t    *kernel)
+{
+        HB_MC_API_PROBE(device->mc, HB_MC_API_KERNEL_ENQUEUE);
+        HB_MC_TIMELINE_PROBE(device->mc, kernel->name, "kernel_enqueue",
+                             HB_MC_TIMELINE_POD_PID(hb_mc_device_pod_to_pod_id(device, pod)),
+                             HB_MC_TIMELINE_HOST_TID);
+        hb_mc_device_trace_regions_kernel_enqueue(device, kernel);
+        BSG_CUDA_CALL(hb_mc_device_stats_stream_kernel(device, hb_mc_device_pod_to_pod_id(device, pod),
+                                                       kernel, grid_dim, tg_dim));
+
+        // add all tile groups
+        hb_mc_coordinate_t tg_id;
+        foreach_coordinate(tg_id, HB_MC_COORDINATE(0,0), grid_dim)
+        {
+                BSG_CUDA_CALL(hb_mc_device_pod_tile_group_kernel_enqueue(device, pod, pod->num_grids, tg_id, grid_dim, tg_dim, kernel));
+        }
+
+        pod->num_grids++;
+        return HB_MC_SUCCESS;
+}
+
 /**
  * Enqueues and schedules a kernel to be run on a pod
  * Takes the grid size, tile group dimensions, kernel name, argc,
@@ -1417,15 +1593,41 @@ int hb_mc_device_pod_kernel_enqueue(hb_mc_device_t    *device,
         XMALLOC(kernel);
         BSG_CUDA_CALL(kernel_init(kernel, name, argc, argv));
 
-        // add all tile groups
-        hb_mc_coordinate_t tg_id;
-        foreach_coordinate(tg_id, HB_MC_COORDINATE(0,0), grid_dim)
-        {
-                BSG_CUDA_CALL(hb_mc_device_pod_tile_group_kernel_enqueue(device, pod, pod->num_grids, tg_id, grid_dim, tg_dim, kernel));
-        }
+        return hb_mc_device_pod_grid_enqueue(device, pod, grid_dim, tg_dim, kernel);
+}
 
-        pod->num_grids++;
-        return HB_MC_SUCCESS;
+/**
+ * Enqueues and schedules a kernel to be run on a pod with a typed argument list.
+ * @param[in]  device        Pointer to device
+ * @param[in]  pod           Pod ID
+ * @param[in]  grid_dim      X/Y dimensions of the grid to be initialized
+ * @param[in]  tg_dim        X/Y dimensions of tile groups in grid
+ * @param[in]  name          Kernel name to be executed on tile groups in grid
+ * @param[in]  args          Arguments initialized with hb_mc_kernel_args_init()
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_device_pod_kernel_enqueue_args(hb_mc_device_t    *device,
+                                         hb_mc_pod_id_t     pod_id,
+                                         hb_mc_dimension_t  grid_dim,
+                                         hb_mc_dimension_t  tg_dim,
+                                         const char* name,
+                                         const hb_mc_kernel_args_t *args)
+{
+        CHECK_POD_ID(device, pod_id);
+        CHECK_PTR(device->pods);
+        CHECK_PTR(args);
+
+        hb_mc_pod_t *pod = &device->pods[pod_id];
+
+        bsg_pr_dbg("%s: device<%s>: program<%s>: calling\n",
+                   __func__, device->name, pod->program->bin_name);
+
+        // create a kernel
+        hb_mc_kernel_t *kernel;
+        XMALLOC(kernel);
+        BSG_CUDA_CALL(kernel_init_args(kernel, name, args));
+
+        return hb_mc_device_pod_grid_enqueue(device, pod, grid_dim, tg_dim, kernel);
 }
 
 /**
@@ -1567,16 +1769,64 @@ int hb_mc_device_pod_tile_group_deallocate_tiles(hb_mc_device_t *device, hb_mc_p
         return HB_MC_SUCCESS;
 }
 
+/**
+ * Free the barrier config arrays of a pod.
+ * Called when all tile groups on the pod have drained.
+ */
+static int hb_mc_device_pod_barcfgs_exit(hb_mc_device_t *device, hb_mc_pod_t *pod)
+{
+        hb_mc_pod_id_t pod_id = hb_mc_device_pod_to_pod_id(device, pod);
+        for (uint32_t i = 0; i < pod->num_barcfgs; i++) {
+                if (pod->barcfgs[i].in_use) {
+                        bsg_pr_err("%s: barrier config for %dx%d tile group still in use\n",
+                                   __func__,
+                                   hb_mc_dimension_get_x(pod->barcfgs[i].dim),
+                                   hb_mc_dimension_get_y(pod->barcfgs[i].dim));
+                        return HB_MC_BUSY;
+                }
+                BSG_CUDA_CALL(hb_mc_device_pod_free(device, pod_id, pod->barcfgs[i].eva));
+        }
+
+        free(pod->barcfgs);
+        pod->barcfgs = NULL;
+        pod->num_barcfgs = 0;
+        pod->barcfg_capacity = 0;
+
+        return HB_MC_SUCCESS;
+}
+
 /**
  * Initialize the array of CSR values for the hw barrier.
  * This function checks if the barrier is used in the kernel, and if so an array is allocated
  * and initialized.
+ *
+ * The CSR values depend only on the tile group shape, so arrays are kept on the pod and
+ * handed to the next tile group of the same shape once their current owner finishes.
+ * Only the barrier lock word is reset on reuse - it cannot be shared between running
+ * tile groups.
  */
 static int hb_mc_device_pod_tile_group_barrier_init(hb_mc_device_t *device
                                                     , hb_mc_pod_t *pod
                                                     , hb_mc_tile_group_t *tg)
 {
         hb_mc_kernel_t *kernel = tg->kernel;
+        hb_mc_pod_id_t pod_id = hb_mc_device_pod_to_pod_id(device, pod);
+
+        // reuse a released array for this shape if there is one
+        for (uint32_t i = 0; i < pod->num_barcfgs; i++) {
+                hb_mc_barcfg_t *cfg = &pod->barcfgs[i];
+                if (cfg->in_use || cfg->dim.x != tg->dim.x || cfg->dim.y != tg->dim.y)
+                        continue;
+
+                // word zero holds the amoadd barrier lock
+                int lock = 0;
+                BSG_CUDA_CALL(hb_mc_device_pod_memcpy_to_device(device, pod_id, cfg->eva, &lock, sizeof(lock)));
+
+                cfg->in_use = 1;
+                tg->barcfg_eva = cfg->eva;
+                return HB_MC_SUCCESS;
+        }
+
         bsg_pr_dbg("%s: device<%s>: program<%s>: Initializing hardware barrier array for kernel '%s'\n"
                    , __func__
                    , device->name
@@ -1601,7 +1851,6 @@ static int hb_mc_device_pod_tile_group_barrier_init(hb_mc_device_t *device
         // found the barrier pointer
         // allocate an array for csr values
         hb_mc_eva_t barcfg_eva;
-        hb_mc_pod_id_t pod_id = hb_mc_device_pod_to_pod_id(device, pod);
         BSG_CUDA_CALL(hb_mc_device_pod_malloc(device
                                               , pod_id
                                               , (1 + tg->dim.x * tg->dim.y) * sizeof(int)
@@ -1622,7 +1871,18 @@ static int hb_mc_device_pod_tile_group_barrier_init(hb_mc_device_t *device
         // copy csr val vector to device
         BSG_CUDA_CALL(hb_mc_device_pod_memcpy_to_device(device, pod_id, barcfg_eva, barcfg, sizeof(barcfg)));
 
-        // save so we can free later
+        // save so we can reuse and free later
+        if (pod->num_barcfgs == pod->barcfg_capacity) {
+                uint32_t cap = pod->barcfg_capacity == 0 ? 1 : 2 * pod->barcfg_capacity;
+                XREALLOC(pod->barcfgs, cap);
+                pod->barcfg_capacity = cap;
+        }
+
+        hb_mc_barcfg_t *cfg = &pod->barcfgs[pod->num_barcfgs++];
+        cfg->dim = tg->dim;
+        cfg->eva = barcfg_eva;
+        cfg->in_use = 1;
+
         tg->barcfg_eva = barcfg_eva;
 
         return HB_MC_SUCCESS;       
@@ -1632,22 +1892,56 @@ __attribute__((warn_unused_result))
 static
 int hb_mc_device_pod_tile_group_launch(hb_mc_device_t *device, hb_mc_pod_t *pod, hb_mc_tile_group_t *tile_group)
 {
+        HB_MC_API_PROBE(device->mc, HB_MC_API_TILE_GROUP_LAUNCH);
+        HB_MC_TIMELINE_PROBE(device->mc, "tile_group_launch", "tile_group",
+                             HB_MC_TIMELINE_POD_PID(hb_mc_device_pod_to_pod_id(device, pod)),
+                             HB_MC_TIMELINE_HOST_TID);
         hb_mc_kernel_t *kernel = tile_group->kernel;
         bsg_pr_dbg("%s: device<%s>: program<%s>: Launching tile group running kernel = '%s'\n",
                    __func__, device->name, pod->program->bin_name, kernel->name);
 
         // initialize argv
-        // allocate argv
-        hb_mc_eva_t argv_addr;
-        hb_mc_pod_id_t pod_id = hb_mc_device_pod_to_pod_id(device, pod);
-        BSG_CUDA_CALL(hb_mc_device_pod_malloc(device, pod_id, kernel->argc * sizeof(*(kernel->argv)), &argv_addr));
-        tile_group->argv_eva = argv_addr;
-
-        // copy argv over
-        BSG_CUDA_CALL(hb_mc_device_pod_memcpy_to_device(device, pod_id,
-                                                        tile_group->argv_eva,
-                                                        &kernel->argv[0],
-                                                        kernel->argc * sizeof(*(kernel->argv))));
+        // the first tile group of a grid to launch allocates and copies argv
+        // the rest of the grid shares it
+        if (kernel->argv_eva == 0) {
+                hb_mc_eva_t argv_addr;
+                hb_mc_pod_id_t pod_id = hb_mc_device_pod_to_pod_id(device, pod);
+                size_t argv_size = kernel->argc * sizeof(*(kernel->argv));
+
+                if (kernel->data_size == 0) {
+                        BSG_CUDA_CALL(hb_mc_device_pod_malloc(device, pod_id, argv_size, &argv_addr));
+
+                        // copy argv over
+                        BSG_CUDA_CALL(hb_mc_device_pod_memcpy_to_device(device, pod_id,
+                                                                        argv_addr,
+                                                                        &kernel->argv[0],
+                                                                        argv_size));
+                } else {
+                        // arguments passed by reference follow argv in the same buffer
+                        size_t data_offset = (argv_size + HB_MC_KERNEL_ARGS_DATA_ALIGN - 1)
+                                & ~(size_t)(HB_MC_KERNEL_ARGS_DATA_ALIGN - 1);
+                        size_t size = data_offset + kernel->data_size;
+                        BSG_CUDA_CALL(hb_mc_device_pod_malloc(device, pod_id, size, &argv_addr));
+
+                        unsigned char *buf;
+                        XMALLOC_N(buf, size);
+                        memset(buf, 0, data_offset);
+                        memcpy(buf, &kernel->argv[0], argv_size);
+                        memcpy(buf + data_offset, kernel->data, kernel->data_size);
+
+                        // patch references with their device address
+                        uint32_t *words = reinterpret_cast<uint32_t*>(buf);
+                        for (uint32_t i = 0; i < kernel->num_relocs; i++)
+                                words[kernel->relocs[i]] += argv_addr + data_offset;
+
+                        int r = hb_mc_device_pod_memcpy_to_device(device, pod_id, argv_addr, buf, size);
+                        free(buf);
+                        if (r != HB_MC_SUCCESS)
+                                return r;
+                }
+                kernel->argv_eva = argv_addr;
+        }
+        tile_group->argv_eva = kernel->argv_eva;
 
         // initialize hw barrier array
         BSG_CUDA_CALL(hb_mc_device_pod_tile_group_barrier_init(device, pod, tile_group));
@@ -1656,6 +1950,12 @@ int hb_mc_device_pod_tile_group_launch(hb_mc_device_t *device, hb_mc_pod_t *pod,
         hb_mc_eva_t kernel_addr;
         BSG_CUDA_CALL(hb_mc_loader_symbol_to_eva(pod->program->bin, pod->program->bin_size, kernel->name, &kernel_addr));
 
+        // open a trace region before any tile of a traced kernel wakes up
+        BSG_CUDA_CALL(hb_mc_device_trace_regions_enter(device, kernel));
+        BSG_CUDA_CALL(hb_mc_device_stats_stream_tile_group_launch(device, tile_group));
+        BSG_CUDA_CALL(hb_mc_device_hotspots_tile_group_launch(device, tile_group));
+        if (hb_mc_timeline_enabled() || hb_mc_device_watchdog_enabled(device))
+                hb_mc_timeline_stamp(device->mc, &tile_group->launched);
 
         hb_mc_coordinate_t coord;
         foreach_coordinate(coord, tile_group->origin, tile_group->dim)
@@ -1675,22 +1975,24 @@ int hb_mc_device_pod_tile_group_launch(hb_mc_device_t *device, hb_mc_pod_t *pod,
 
 // forward declaration
 static
-int hb_mc_device_podv_wait_for_tile_group_finish_any(hb_mc_device_t *device,
-                                                     hb_mc_pod_id_t *podv,
-                                                     int podc,
-                                                     hb_mc_pod_id_t *pod_done);
+int hb_mc_device_podv_wait_for_tile_group_finish_batch(hb_mc_device_t *device,
+                                                       hb_mc_pod_id_t *podv,
+                                                       int podc,
+                                                       int *podv_done);
 
 /**
- * Wait for a tile group to complete for a pod.
+ * Wait for at least one tile group to complete for a pod.
+ * Every completion already pending is retired in the same call.
  */
 static
-int hb_mc_device_pod_wait_for_tile_group_finish_any(hb_mc_device_t *device, hb_mc_pod_t *pod)
+int hb_mc_device_pod_wait_for_tile_group_finish_batch(hb_mc_device_t *device, hb_mc_pod_t *pod)
 {
-        hb_mc_pod_id_t pid, pid_done;
+        hb_mc_pod_id_t pid;
+        int done = 0;
         pid = hb_mc_device_pod_to_pod_id(device, pod);
-        return hb_mc_device_podv_wait_for_tile_group_finish_any(device,
-                                                                &pid, 1,
-                                                                &pid_done);
+        return hb_mc_device_podv_wait_for_tile_group_finish_batch(device,
+                                                                  &pid, 1,
+                                                                  &done);
 }
 
 /**
@@ -1757,10 +2059,14 @@ int hb_mc_device_pod_kernels_execute(hb_mc_device_t *device,
                 // try launching as many tile groups as possible
                 BSG_CUDA_CALL(hb_mc_device_pod_try_launch_tile_groups(device, pod));
 
-                // wait for any tile group to complete
-                BSG_CUDA_CALL(hb_mc_device_pod_wait_for_tile_group_finish_any(device, pod));
+                // wait for any tile group to complete and retire
+                // every other completion that is already pending
+                BSG_CUDA_CALL(hb_mc_device_pod_wait_for_tile_group_finish_batch(device, pod));
         }
 
+        // all grids have drained
+        BSG_CUDA_CALL(hb_mc_device_pod_barcfgs_exit(device, pod));
+
         return HB_MC_SUCCESS;
 }
 
@@ -1800,84 +2106,158 @@ int hb_mc_device_podv_try_launch_tile_groups(hb_mc_device_t *device,
 }
 
 /**
- * Wait for any tile group to complete. Cleanup and release that tile groups resources.
- * @return pod_done  The pod on which a tile-group just completed
+ * Retire the tile group that sent a finish packet.
+ * Deallocates the tile group's tiles and cleans up the tile group.
+ * @param[in]  device    Pointer to device
+ * @param[in]  rqst      A request packet received from the manycore
+ * @param[out] pod_done  The pod on which the tile group completed
+ * @return HB_MC_SUCCESS if a tile group was retired, HB_MC_NOTFOUND if
+ *         #rqst is not a finish packet of any launched tile group.
+ *         Otherwise an error code is returned.
  */
 static
-int hb_mc_device_podv_wait_for_tile_group_finish_any(hb_mc_device_t *device,
-                                                     hb_mc_pod_id_t *podv,
-                                                     int podc,
-                                                     hb_mc_pod_id_t *pod_done)
+int hb_mc_device_tile_group_retire(hb_mc_device_t *device,
+                                   const hb_mc_request_packet_t *rqst,
+                                   hb_mc_pod_id_t *pod_done)
 {
-        bsg_pr_dbg("%s: calling\n", __func__);
-
-        while (true) {
-                hb_mc_request_packet_t rqst;
-
-                // perform a blocking read from the request fifo
-                BSG_CUDA_CALL(hb_mc_manycore_request_rx(device->mc, &rqst, -1));
-
-                #ifdef DEBUG
+        // called for every finish packet: only format it if it will be printed
+        if (bsg_log_enabled(BSG_LOG_LEVEL_DEBUG, BSG_LOG_SUBSYSTEM)) {
                 char pkt_str[256];
-                hb_mc_request_packet_to_string(&rqst, pkt_str, sizeof(pkt_str));
+                hb_mc_request_packet_to_string(rqst, pkt_str, sizeof(pkt_str));
                 bsg_pr_dbg("%s: received packet %s\n",
                            __func__,
                            pkt_str);
-                #endif
-                // request packet read
-                // is it a finish packet?
-                if (hb_mc_request_packet_get_data(&rqst) != HB_MC_CUDA_FINISH_SIGNAL_VAL) {
-                        bsg_pr_dbg("%s: not a finish packet\n", __func__);
+        }
+        // request packet read
+        // is it a finish packet?
+        if (hb_mc_request_packet_get_data(rqst) != HB_MC_CUDA_FINISH_SIGNAL_VAL) {
+                bsg_pr_dbg("%s: not a finish packet\n", __func__);
+                return HB_MC_NOTFOUND;
+        }
+
+        // identify the pod
+        hb_mc_coordinate_t src =
+                hb_mc_coordinate(hb_mc_request_packet_get_x_src(rqst),
+                                 hb_mc_request_packet_get_y_src(rqst));
+
+        hb_mc_coordinate_t podco = hb_mc_config_pod(&device->mc->config, src);
+        hb_mc_pod_id_t pid = hb_mc_coordinate_to_index(podco, device->mc->config.pods);
+        hb_mc_pod_t *pod = &device->pods[pid];
+
+        // find the tile group with matching origin in pod
+        hb_mc_tile_group_t *tg;
+        pod_foreach_tile_group(pod, tg)
+        {
+                // only look for launched tile groups
+                if (tg->status != HB_MC_TILE_GROUP_STATUS_LAUNCHED) {
                         continue;
                 }
 
-                // identify the pod
-                hb_mc_coordinate_t src =
-                        hb_mc_coordinate(hb_mc_request_packet_get_x_src(&rqst),
-                                         hb_mc_request_packet_get_y_src(&rqst));
+                // origin matches?
+                if (!(tg->origin.x == src.x && tg->origin.y == src.y))
+                        continue;
 
-                hb_mc_coordinate_t podco = hb_mc_config_pod(&device->mc->config, src);
-                hb_mc_pod_id_t pid = hb_mc_coordinate_to_index(podco, device->mc->config.pods);
-                hb_mc_pod_t *pod = &device->pods[pid];
+                // finish signal epa matches?
+                if (hb_mc_request_packet_get_epa(rqst)
+                    != hb_mc_npa_get_epa(&tg->finish_signal_npa))
+                        continue;
 
-                // find the tile group with matching origin in pod
-                hb_mc_tile_group_t *tg;
-                pod_foreach_tile_group(pod, tg)
-                {
-                        // only look for launched tile groups
-                        if (tg->status != HB_MC_TILE_GROUP_STATUS_LAUNCHED) {
-                                continue;
-                        }
+                bsg_pr_dbg("%s: received finish packet from (%d,%d)\n",
+                           __func__, tg->origin.x, tg->origin.y);
+                BSG_CUDA_CALL(hb_mc_device_stats_stream_tile_group_finish(device, pid, tg));
+                BSG_CUDA_CALL(hb_mc_device_hotspots_tile_group_finish(device, tg));
+                if (hb_mc_timeline_enabled()) {
+                        hb_mc_timeline_stamp_t finished;
+                        hb_mc_timeline_stamp(device->mc, &finished);
+                        hb_mc_timeline_record(tg->kernel->name, "tile_group",
+                                              HB_MC_TIMELINE_POD_PID(pid),
+                                              HB_MC_TIMELINE_TILE_GROUP_TID(tg->origin),
+                                              &tg->launched, &finished);
+                }
+                // this is the matching tile group
+                // deallocate tiles
+                BSG_CUDA_CALL(hb_mc_device_pod_tile_group_deallocate_tiles(device, pod, tg));
 
-                        // origin matches?
-                        if (!(tg->origin.x == src.x && tg->origin.y == src.y))
-                                continue;
+                // close the trace region if this was the last traced tile group
+                BSG_CUDA_CALL(hb_mc_device_trace_regions_leave(device, tg->kernel));
 
-                        // finish signal epa matches?
-                        if (hb_mc_request_packet_get_epa(&rqst)
-                            != hb_mc_npa_get_epa(&tg->finish_signal_npa))
-                                continue;
+                // cleanup tile group
+                BSG_CUDA_CALL(hb_mc_device_pod_tile_group_exit(device, pod, tg));
 
-                        #ifdef DEBUG
-                        bsg_pr_dbg("%s: received finish packet from (%d,%d)\n",
-                                   __func__, tg->origin.x, tg->origin.y);
-                        #endif
-                        // this is the matching tile group
-                        // deallocate tiles
-                        BSG_CUDA_CALL(hb_mc_device_pod_tile_group_deallocate_tiles(device, pod, tg));
+                // mark this pod as having completed a tile-group
+                *pod_done = pid;
+                return HB_MC_SUCCESS;
+        }
 
-                        // cleanup tile group
-                        BSG_CUDA_CALL(hb_mc_device_pod_tile_group_exit(device, pod, tg));
+        bsg_pr_dbg("%s: packet received with finished signal "
+                   "value but no matching tile-group",
+                   __func__);
 
-                        // mark this pod as having completed a tile-group
-                        *pod_done = pid;
-                        return HB_MC_SUCCESS;
+        return HB_MC_NOTFOUND;
+}
+
+/**
+ * Wait for at least one tile group to complete, then drain every
+ * finish packet already waiting in the request FIFO without blocking.
+ * Cleanup and release the resources of each tile group that completed.
+ *
+ * Retiring completions together lets the caller refill each pod once
+ * per batch rather than once per tile group.
+ * @param[out] podv_done  Incremented by the number of tile groups that completed on each pod in #podv
+ */
+static
+int hb_mc_device_podv_wait_for_tile_group_finish_batch(hb_mc_device_t *device,
+                                                       hb_mc_pod_id_t *podv,
+                                                       int podc,
+                                                       int *podv_done)
+{
+        HB_MC_API_PROBE(device->mc, HB_MC_API_TILE_GROUP_FINISH);
+        // waits on several pods go on the calling thread's track
+        HB_MC_TIMELINE_PROBE(device->mc, "wait_for_tile_groups", "wait",
+                             podc == 1 ? HB_MC_TIMELINE_POD_PID(podv[0]) : HB_MC_TIMELINE_MANYCORE_PID,
+                             podc == 1 ? HB_MC_TIMELINE_HOST_TID : HB_MC_TIMELINE_THREAD_TID);
+        // without a watchdog, block for the first completion
+        long timeout = hb_mc_device_watchdog_timeout(device);
+        int retired = 0;
+        int r;
+
+        bsg_pr_dbg("%s: calling\n", __func__);
+
+        while (true) {
+                hb_mc_request_packet_t rqst;
+                hb_mc_pod_id_t pid;
+
+                // wait for the first completion, then only poll
+                r = hb_mc_manycore_request_rx(device->mc, &rqst, timeout);
+                if (r == HB_MC_TIMEOUT && retired > 0) {
+                        break;
+                } else if (r == HB_MC_TIMEOUT) {
+                        // nothing finished within a watchdog slice
+                        r = hb_mc_device_watchdog_check(device, podv, podc);
+                        if (r != HB_MC_SUCCESS)
+                                return r;
+                        continue;
+                } else if (r != HB_MC_SUCCESS) {
+                        return r;
                 }
 
-                bsg_pr_dbg("%s: packet received with finished signal "
-                           "value but no matching tile-group",
-                           __func__);
+                r = hb_mc_device_tile_group_retire(device, &rqst, &pid);
+                if (r == HB_MC_NOTFOUND)
+                        continue;
+                else if (r != HB_MC_SUCCESS)
+                        return r;
+
+                for (int podi = 0; podi < podc; podi++)
+                        if (podv[podi] == pid)
+                                podv_done[podi]++;
+
+                retired++;
+                timeout = 0;
         }
+
+        bsg_pr_dbg("%s: retired %d tile groups\n", __func__, retired);
+
+        return HB_MC_SUCCESS;
 }
 
 /**
@@ -1896,21 +2276,45 @@ int hb_mc_device_podv_kernels_execute(hb_mc_device_t *device,
                                       hb_mc_pod_id_t *podv,
                                       int podc)
 {
+        int *podv_done;
+        int r = HB_MC_SUCCESS;
+
         /* launch as many tile groups as possible on all pods */
         BSG_CUDA_CALL(hb_mc_device_podv_try_launch_tile_groups(device, podv, podc));
 
+        XMALLOC_N(podv_done, podc);
+
         /* until all tile groups have completed */
         while (hb_mc_device_podv_all_tile_groups_finished(device, podv, podc) != HB_MC_SUCCESS)
         {
-                /* wait for any tile group to finish on any pod */
-                hb_mc_pod_id_t pod;
-                BSG_CUDA_CALL(hb_mc_device_podv_wait_for_tile_group_finish_any(device, podv, podc,
-                                                                               &pod));
+                /* wait for tile groups to finish on any pod */
+                memset(podv_done, 0, sizeof(*podv_done) * podc);
+                r = hb_mc_device_podv_wait_for_tile_group_finish_batch(device, podv, podc,
+                                                                       podv_done);
+                if (r != HB_MC_SUCCESS)
+                        goto done;
+
+                /* try launching tile groups once on each pod with completions in this batch */
+                for (int podi = 0; podi < podc; podi++) {
+                        if (podv_done[podi] == 0)
+                                continue;
 
-                /* try launching launching tile groups on pod with most recent completion */
-                BSG_CUDA_CALL(hb_mc_device_pod_try_launch_tile_groups(device, &device->pods[pod]));
+                        r = hb_mc_device_pod_try_launch_tile_groups(device, &device->pods[podv[podi]]);
+                        if (r != HB_MC_SUCCESS)
+                                goto done;
+                }
         }
-        return HB_MC_SUCCESS;
+
+        /* all grids have drained */
+        for (int podi = 0; podi < podc; podi++) {
+                r = hb_mc_device_pod_barcfgs_exit(device, &device->pods[podv[podi]]);
+                if (r != HB_MC_SUCCESS)
+                        goto done;
+        }
+
+done:
+        free(podv_done);
+        return r;
 }
 
 /**
@@ -1935,6 +2339,511 @@ int hb_mc_device_pods_kernels_execute(hb_mc_device_t *device)
 }
 
 
+/**
+ * Launches as many kernel invocations enqueued on pod as fit, without
+ * waiting for them to complete.
+ * Use hb_mc_device_pod_kernels_execute() to wait for completion and
+ * launch the remainder.
+ * @param[in]  device        Pointer to device
+ * @param[in]  pod           Pod ID
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_device_pod_kernels_launch(hb_mc_device_t *device,
+                                    hb_mc_pod_id_t pod_id)
+{
+        CHECK_POD_ID(device, pod_id);
+        hb_mc_pod_t *pod = &device->pods[pod_id];
+
+        bsg_pr_dbg("%s: device<%s>: program<%s>: calling\n",
+                   __func__, device->name, pod->program->bin_name);
+
+        return hb_mc_device_pod_try_launch_tile_groups(device, pod);
+}
+
+/************************************/
+/* Pod Interface Persistent Kernels */
+/************************************/
+/**
+ * Get the EVA of the slot holding a work queue item.
+ */
+static hb_mc_eva_t hb_mc_work_queue_slot_eva(const hb_mc_work_queue_t *queue, uint32_t item)
+{
+        uint32_t word = HB_MC_WORK_QUEUE_HEADER_WORDS
+                + (item % queue->capacity) * HB_MC_WORK_QUEUE_SLOT_WORDS;
+
+        return queue->eva + word * sizeof(uint32_t);
+}
+
+/**
+ * Get the NPA of a work queue header word.
+ */
+__attribute__((warn_unused_result))
+static int hb_mc_device_pod_work_queue_header_npa(hb_mc_device_t *device,
+                                                  const hb_mc_work_queue_t *queue,
+                                                  uint32_t word,
+                                                  hb_mc_npa_t *npa)
+{
+        hb_mc_pod_t *pod = &device->pods[queue->pod_id];
+        hb_mc_eva_t eva = queue->eva + word * sizeof(uint32_t);
+        size_t sz;
+
+        BSG_MANYCORE_CALL(device->mc,
+                          hb_mc_eva_to_npa(device->mc, &default_map, &pod->mesh->origin,
+                                           &eva, npa, &sz));
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Read back the slots of a work queue that tiles have claimed, and
+ * advance the index below which the host may write, past every slot
+ * that tiles have emptied.
+ */
+__attribute__((warn_unused_result))
+static int hb_mc_device_pod_work_queue_refresh(hb_mc_device_t *device,
+                                               hb_mc_work_queue_t *queue)
+{
+        hb_mc_npa_t head_npa;
+        uint32_t head;
+
+        BSG_CUDA_CALL(hb_mc_device_pod_work_queue_header_npa(device, queue,
+                                                             HB_MC_WORK_QUEUE_HEAD_IDX,
+                                                             &head_npa));
+        BSG_MANYCORE_CALL(device->mc, hb_mc_manycore_read32(device->mc, &head_npa, &head));
+
+        // tiles claim ahead of the tail while they wait, and only
+        // claimed slots can have been emptied
+        uint32_t claimed = queue->tail;
+        if ((int32_t)(head - queue->tail) < 0)
+                claimed = head;
+
+        // the slot for item 'free' last held item 'free - capacity'
+        uint32_t first = queue->free - queue->capacity;
+        if ((int32_t)(claimed - first) <= 0)
+                return HB_MC_SUCCESS;
+
+        // read the claimed slots, in up to two pieces if they wrap
+        for (uint32_t item = first; item != claimed; ) {
+                uint32_t idx = item % queue->capacity;
+                uint32_t n = std::min(claimed - item, queue->capacity - idx);
+
+                BSG_CUDA_CALL(hb_mc_device_pod_memcpy_to_host(device, queue->pod_id,
+                                                              &queue->slots[idx * HB_MC_WORK_QUEUE_SLOT_WORDS],
+                                                              hb_mc_work_queue_slot_eva(queue, item),
+                                                              n * HB_MC_WORK_QUEUE_SLOT_WORDS * sizeof(uint32_t)));
+                item += n;
+        }
+
+        while (queue->free - queue->capacity != claimed) {
+                uint32_t *slot = &queue->slots[(queue->free % queue->capacity) * HB_MC_WORK_QUEUE_SLOT_WORDS];
+                if (slot[HB_MC_WORK_QUEUE_SLOT_FULL_IDX] != 0)
+                        break;
+
+                queue->free++;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Allocates and initializes a work queue in a pod's DRAM.
+ *
+ * A persistent kernel is launched once with the queue's EVA as an
+ * argument and stays resident: its tiles claim items from the queue,
+ * run them, and count them as done, until they claim an item with op
+ * HB_MC_WORK_QUEUE_OP_EXIT. See examples/cuda/test_persistent_kernel
+ * for the device side of the protocol.
+ * @param[in]  device        Pointer to device
+ * @param[in]  pod           Pod ID with a program initialized
+ * @param[in]  capacity      Number of slots in the queue
+ * @param[out] queue         The work queue
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_device_pod_work_queue_init(hb_mc_device_t *device,
+                                     hb_mc_pod_id_t pod_id,
+                                     uint32_t capacity,
+                                     hb_mc_work_queue_t *queue)
+{
+        CHECK_POD_ID(device, pod_id);
+        CHECK_PTR(queue);
+
+        if (capacity == 0) {
+                bsg_pr_err("%s: work queue capacity must be non-zero\n", __func__);
+                return HB_MC_INVALID;
+        }
+
+        // align the queue to a slot so that no slot straddles a cache line
+        uint32_t align = HB_MC_WORK_QUEUE_SLOT_WORDS * sizeof(uint32_t);
+        uint32_t bytes = (HB_MC_WORK_QUEUE_HEADER_WORDS + capacity * HB_MC_WORK_QUEUE_SLOT_WORDS)
+                * sizeof(uint32_t);
+
+        XMALLOC_N(queue->slots, capacity * HB_MC_WORK_QUEUE_SLOT_WORDS);
+
+        int err = hb_mc_device_pod_malloc(device, pod_id, bytes + align, &queue->alloc_eva);
+        if (err != HB_MC_SUCCESS) {
+                free(queue->slots);
+                queue->slots = NULL;
+                return err;
+        }
+
+        queue->pod_id   = pod_id;
+        queue->eva      = (queue->alloc_eva + align - 1) & ~(align - 1);
+        queue->capacity = capacity;
+        queue->tail     = 0;
+        queue->free     = capacity;
+        queue->done     = 0;
+
+        // zero the header and empty all slots
+        err = hb_mc_device_pod_memset(device, pod_id, queue->eva, 0, bytes);
+        if (err == HB_MC_SUCCESS)
+                err = hb_mc_device_pod_memcpy_to_device(device, pod_id,
+                                                        queue->eva + HB_MC_WORK_QUEUE_CAPACITY_IDX * sizeof(uint32_t),
+                                                        &capacity, sizeof(capacity));
+        if (err != HB_MC_SUCCESS) {
+                if (hb_mc_device_pod_free(device, pod_id, queue->alloc_eva) != HB_MC_SUCCESS)
+                        bsg_pr_err("%s: failed to free work queue after init error\n", __func__);
+                free(queue->slots);
+                queue->slots = NULL;
+                queue->eva = 0;
+                queue->alloc_eva = 0;
+                return err;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Appends items to a work queue.
+ * Items are written with posted stores and published to tiles in
+ * batches with a single amoadd to the queue tail. Blocks while the
+ * queue is full.
+ * @param[in]  device        Pointer to device
+ * @param[in]  queue         A work queue initialized with hb_mc_device_pod_work_queue_init()
+ * @param[in]  items         Items to append
+ * @param[in]  n             Number of items
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_device_pod_work_queue_push(hb_mc_device_t *device,
+                                     hb_mc_work_queue_t *queue,
+                                     const hb_mc_work_item_t *items,
+                                     uint32_t n)
+{
+        CHECK_PTR(queue);
+        CHECK_POD_ID(device, queue->pod_id);
+
+        hb_mc_npa_t tail_npa;
+        BSG_CUDA_CALL(hb_mc_device_pod_work_queue_header_npa(device, queue,
+                                                             HB_MC_WORK_QUEUE_TAIL_IDX,
+                                                             &tail_npa));
+        while (n > 0) {
+                // wait for tiles to empty a slot
+                if (queue->tail == queue->free) {
+                        BSG_CUDA_CALL(hb_mc_device_pod_work_queue_refresh(device, queue));
+                        continue;
+                }
+
+                // write as many free slots as we can without wrapping
+                uint32_t batch = std::min(n, queue->free - queue->tail);
+                batch = std::min(batch, queue->capacity - queue->tail % queue->capacity);
+
+                // stage the batch in the host copy of its slots: refresh
+                // only reads back claimed slots, which these are not
+                uint32_t *slots = &queue->slots[(queue->tail % queue->capacity) * HB_MC_WORK_QUEUE_SLOT_WORDS];
+                for (uint32_t i = 0; i < batch; i++) {
+                        uint32_t *slot = &slots[i * HB_MC_WORK_QUEUE_SLOT_WORDS];
+                        slot[HB_MC_WORK_QUEUE_SLOT_OP_IDX]   = items[i].op;
+                        slot[HB_MC_WORK_QUEUE_SLOT_ARG0_IDX] = items[i].arg0;
+                        slot[HB_MC_WORK_QUEUE_SLOT_ARG1_IDX] = items[i].arg1;
+                        slot[HB_MC_WORK_QUEUE_SLOT_FULL_IDX] = 1;
+                }
+
+                // the write is fenced before returning, so the slots
+                // are visible before the tail is advanced
+                BSG_CUDA_CALL(hb_mc_device_pod_memcpy_to_device(device, queue->pod_id,
+                                                                hb_mc_work_queue_slot_eva(queue, queue->tail),
+                                                                slots,
+                                                                batch * HB_MC_WORK_QUEUE_SLOT_WORDS * sizeof(uint32_t)));
+
+                // publish
+                uint32_t tail;
+                BSG_MANYCORE_CALL(device->mc, hb_mc_manycore_amoadd32(device->mc, &tail_npa, batch, &tail));
+                if (tail != queue->tail) {
+                        bsg_pr_err("%s: work queue tail is %" PRIu32 ", expected %" PRIu32 ": "
+                                   "is another thread appending to this queue?\n",
+                                   __func__, tail, queue->tail);
+                        return HB_MC_FAIL;
+                }
+
+                queue->tail += batch;
+                items += batch;
+                n -= batch;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Waits until at least n items of a work queue have completed.
+ * @param[in]  device        Pointer to device
+ * @param[in]  queue         A work queue initialized with hb_mc_device_pod_work_queue_init()
+ * @param[in]  n             Number of completed items to wait for
+ * @param[in]  timeout       How long to wait in microseconds, 0 to poll once, or -1 to wait forever.
+ * @return HB_MC_SUCCESS if succesful. HB_MC_TIMEOUT if fewer than n items completed in time.
+ * Otherwise an error code is returned.
+ */
+int hb_mc_device_pod_work_queue_wait(hb_mc_device_t *device,
+                                     hb_mc_work_queue_t *queue,
+                                     uint32_t n,
+                                     long timeout)
+{
+        CHECK_PTR(queue);
+        CHECK_POD_ID(device, queue->pod_id);
+
+        hb_mc_npa_t done_npa;
+        BSG_CUDA_CALL(hb_mc_device_pod_work_queue_header_npa(device, queue,
+                                                             HB_MC_WORK_QUEUE_DONE_IDX,
+                                                             &done_npa));
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(timeout);
+
+        // tiles count completions in DRAM - one load observes a whole batch
+        while (true) {
+                BSG_MANYCORE_CALL(device->mc, hb_mc_manycore_read32(device->mc, &done_npa, &queue->done));
+
+                // counts wrap, so compare distances
+                if ((int32_t)(queue->done - n) >= 0)
+                        return HB_MC_SUCCESS;
+
+                if (timeout >= 0 && std::chrono::steady_clock::now() >= deadline)
+                        return HB_MC_TIMEOUT;
+        }
+}
+
+/**
+ * Appends one HB_MC_WORK_QUEUE_OP_EXIT item for each worker tile,
+ * so that the persistent kernel returns.
+ * @param[in]  device        Pointer to device
+ * @param[in]  queue         A work queue initialized with hb_mc_device_pod_work_queue_init()
+ * @param[in]  workers       Number of tiles polling the queue
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_device_pod_work_queue_close(hb_mc_device_t *device,
+                                      hb_mc_work_queue_t *queue,
+                                      uint32_t workers)
+{
+        CHECK_PTR(queue);
+
+        if (workers == 0)
+                return HB_MC_SUCCESS;
+
+        hb_mc_work_item_t *exits;
+        XMALLOC_N(exits, workers);
+        for (uint32_t i = 0; i < workers; i++) {
+                exits[i].op   = HB_MC_WORK_QUEUE_OP_EXIT;
+                exits[i].arg0 = 0;
+                exits[i].arg1 = 0;
+        }
+
+        int err = hb_mc_device_pod_work_queue_push(device, queue, exits, workers);
+        free(exits);
+        return err;
+}
+
+/**
+ * Frees a work queue.
+ * @param[in]  device        Pointer to device
+ * @param[in]  queue         A work queue initialized with hb_mc_device_pod_work_queue_init()
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_device_pod_work_queue_exit(hb_mc_device_t *device,
+                                     hb_mc_work_queue_t *queue)
+{
+        CHECK_PTR(queue);
+        BSG_CUDA_CALL(hb_mc_device_pod_free(device, queue->pod_id, queue->alloc_eva));
+        free(queue->slots);
+        queue->slots = NULL;
+        queue->eva = 0;
+        queue->alloc_eva = 0;
+        return HB_MC_SUCCESS;
+}
+
+
+/*******************************/
+/* Kernel Argument Marshalling */
+/*******************************/
+/**
+ * Initialize an empty kernel argument list.
+ * @param[in]  args  Argument list to initialize
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_kernel_args_init(hb_mc_kernel_args_t *args)
+{
+        CHECK_PTR(args);
+        memset(args, 0, sizeof(*args));
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Cleanup a kernel argument list.
+ * @param[in]  args  Argument list initialized with hb_mc_kernel_args_init()
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_kernel_args_exit(hb_mc_kernel_args_t *args)
+{
+        CHECK_PTR(args);
+        free(args->argv);
+        free(args->data);
+        free(args->relocs);
+        memset(args, 0, sizeof(*args));
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Append one argument word.
+ */
+__attribute__((warn_unused_result))
+static int hb_mc_kernel_args_push_word(hb_mc_kernel_args_t *args, uint32_t word)
+{
+        if (args->argc == args->argv_capacity) {
+                uint32_t cap = args->argv_capacity == 0 ? 8 : 2 * args->argv_capacity;
+                XREALLOC(args->argv, cap);
+                args->argv_capacity = cap;
+        }
+        args->argv[args->argc++] = word;
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Append a 32-bit integer argument.
+ * @param[in]  args  Argument list initialized with hb_mc_kernel_args_init()
+ * @param[in]  val   Argument value
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_kernel_args_push_u32(hb_mc_kernel_args_t *args, uint32_t val)
+{
+        CHECK_PTR(args);
+        return hb_mc_kernel_args_push_word(args, val);
+}
+
+/**
+ * Append a 32-bit signed integer argument.
+ * @param[in]  args  Argument list initialized with hb_mc_kernel_args_init()
+ * @param[in]  val   Argument value
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_kernel_args_push_i32(hb_mc_kernel_args_t *args, int32_t val)
+{
+        CHECK_PTR(args);
+        return hb_mc_kernel_args_push_word(args, static_cast<uint32_t>(val));
+}
+
+/**
+ * Append a 64-bit integer argument. It occupies two argument words.
+ * @param[in]  args  Argument list initialized with hb_mc_kernel_args_init()
+ * @param[in]  val   Argument value
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_kernel_args_push_u64(hb_mc_kernel_args_t *args, uint64_t val)
+{
+        CHECK_PTR(args);
+        // named 2*XLEN scalars take the next two registers, low word first,
+        // with no even-register alignment
+        BSG_CUDA_CALL(hb_mc_kernel_args_push_word(args, static_cast<uint32_t>(val)));
+        BSG_CUDA_CALL(hb_mc_kernel_args_push_word(args, static_cast<uint32_t>(val >> 32)));
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Append a device pointer argument.
+ * @param[in]  args  Argument list initialized with hb_mc_kernel_args_init()
+ * @param[in]  eva   A device address, e.g. from hb_mc_device_pod_malloc()
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_kernel_args_push_eva(hb_mc_kernel_args_t *args, hb_mc_eva_t eva)
+{
+        CHECK_PTR(args);
+        return hb_mc_kernel_args_push_word(args, eva);
+}
+
+/**
+ * Append a pointer argument to a device copy of a host buffer.
+ * @param[in]  args   Argument list initialized with hb_mc_kernel_args_init()
+ * @param[in]  ptr    Host buffer to copy
+ * @param[in]  size   Size of the buffer in bytes
+ * @param[in]  align  Alignment of the copy on the device in bytes - a power of two
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_kernel_args_push_ref(hb_mc_kernel_args_t *args,
+                               const void *ptr, size_t size, size_t align)
+{
+        CHECK_PTR(args);
+        CHECK_PTR(ptr);
+
+        if (align == 0 || (align & (align - 1)) != 0 || align > HB_MC_KERNEL_ARGS_DATA_ALIGN) {
+                bsg_pr_err("%s: alignment %zu is not a power of two up to %zu\n",
+                           __func__, align, HB_MC_KERNEL_ARGS_DATA_ALIGN);
+                return HB_MC_INVALID;
+        }
+
+        // word-align every payload so that the kernel can load it with lw
+        if (align < sizeof(uint32_t))
+                align = sizeof(uint32_t);
+
+        size_t offset = (args->data_size + align - 1) & ~(align - 1);
+        if (offset + size > args->data_capacity) {
+                size_t cap = args->data_capacity == 0 ? 64 : args->data_capacity;
+                while (cap < offset + size)
+                        cap *= 2;
+                XREALLOC(args->data, cap);
+                args->data_capacity = cap;
+        }
+        memset(args->data + args->data_size, 0, offset - args->data_size);
+        memcpy(args->data + offset, ptr, size);
+        args->data_size = offset + size;
+
+        // the word holds the offset until the device address is known at launch
+        if (args->num_relocs == args->relocs_capacity) {
+                uint32_t cap = args->relocs_capacity == 0 ? 4 : 2 * args->relocs_capacity;
+                XREALLOC(args->relocs, cap);
+                args->relocs_capacity = cap;
+        }
+        args->relocs[args->num_relocs++] = args->argc;
+
+        return hb_mc_kernel_args_push_word(args, static_cast<uint32_t>(offset));
+}
+
+/**
+ * Append a struct argument.
+ * Structs of up to 8 bytes are passed by value in argument words.
+ * Larger structs are passed by reference to a device copy shared by
+ * every tile group in the grid.
+ * @param[in]  args   Argument list initialized with hb_mc_kernel_args_init()
+ * @param[in]  ptr    Host copy of the struct
+ * @param[in]  size   Size of the struct in bytes
+ * @param[in]  align  Alignment of the struct on the device in bytes - a power of two
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+int hb_mc_kernel_args_push_struct(hb_mc_kernel_args_t *args,
+                                  const void *ptr, size_t size, size_t align)
+{
+        CHECK_PTR(args);
+        CHECK_PTR(ptr);
+
+        // aggregates larger than 2*XLEN are replaced by a reference
+        if (size > 2 * sizeof(uint32_t))
+                return hb_mc_kernel_args_push_ref(args, ptr, size, align);
+
+        // smaller aggregates are laid out in memory order across
+        // as many registers as they need
+        uint32_t words[2] = {0, 0};
+        memcpy(words, ptr, size);
+        for (size_t i = 0; i < (size + sizeof(uint32_t) - 1) / sizeof(uint32_t); i++)
+                BSG_CUDA_CALL(hb_mc_kernel_args_push_word(args, words[i]));
+
+        return HB_MC_SUCCESS;
+}
+
+
 /********************/
 /* Legacy Interface */
 /********************/
@@ -2096,6 +3005,8 @@ int hb_mc_device_memset (hb_mc_device_t *device,
 
 int hb_mc_device_pod_dma_to_device(hb_mc_device_t *device, hb_mc_pod_id_t pod_id, const hb_mc_dma_htod_t *jobs, size_t count)
 {
+        HB_MC_TIMELINE_PROBE(device->mc, "dma_to_device", "dma",
+                             HB_MC_TIMELINE_POD_PID(pod_id), HB_MC_TIMELINE_HOST_TID);
         int err;
         CHECK_POD_ID(device, pod_id);
 
@@ -2147,6 +3058,8 @@ int hb_mc_device_pod_dma_to_device(hb_mc_device_t *device, hb_mc_pod_id_t pod_id
 
 int hb_mc_device_pod_dma_to_host(hb_mc_device_t *device, hb_mc_pod_id_t pod_id, const hb_mc_dma_dtoh_t *jobs, size_t count)
 {
+        HB_MC_TIMELINE_PROBE(device->mc, "dma_to_host", "dma",
+                             HB_MC_TIMELINE_POD_PID(pod_id), HB_MC_TIMELINE_HOST_TID);
         int err;
         CHECK_POD_ID(device, pod_id);
 
@@ -2314,6 +3227,28 @@ int hb_mc_kernel_enqueue (hb_mc_device_t *device,
                                                name, argc, argv);
 }
 
+/**
+ * Enqueues and schedules a kernel to be run on device with a typed argument list.
+ * @param[in]  device        Pointer to device
+ * @param[in]  grid_dim      X/Y dimensions of the grid to be initialized
+ * @param[in]  tg_dim        X/Y dimensions of tile groups in grid
+ * @param[in]  name          Kernel name to be executed on tile groups in grid
+ * @param[in]  args          Arguments initialized with hb_mc_kernel_args_init()
+ * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+ */
+__attribute__((weak))
+int hb_mc_kernel_enqueue_args (hb_mc_device_t *device,
+                               hb_mc_dimension_t grid_dim,
+                               hb_mc_dimension_t tg_dim,
+                               const char *name,
+                               const hb_mc_kernel_args_t *args)
+{
+        return hb_mc_device_pod_kernel_enqueue_args(device, device->default_pod_id,
+                                                    grid_dim,
+                                                    tg_dim,
+                                                    name, args);
+}
+
 
 
 
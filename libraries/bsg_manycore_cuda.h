@@ -29,6 +29,7 @@
 #define BSG_MANYCORE_CUDA_H
 #include <bsg_manycore_features.h>
 #include <bsg_manycore_eva.h>
+#include <bsg_manycore_timeline.h>
 
 #ifdef __cplusplus
 #include <cstdint>
@@ -48,6 +49,24 @@ extern "C" {
         // The begining of section in host memory intended for tile groups to write finish signals into.
 #define HB_MC_CUDA_HOST_FINISH_SIGNAL_BASE_ADDR 0xF000  
 
+        // Layout of a work queue in device DRAM, shared with persistent kernels.
+        // A header of HB_MC_WORK_QUEUE_HEADER_WORDS words is followed by a ring
+        // of 'capacity' slots, each HB_MC_WORK_QUEUE_SLOT_WORDS words long.
+#define HB_MC_WORK_QUEUE_HEAD_IDX               0 // next item to claim - amoadd by tiles
+#define HB_MC_WORK_QUEUE_TAIL_IDX               1 // items published - amoadd by host
+#define HB_MC_WORK_QUEUE_DONE_IDX               2 // items completed - amoadd by tiles
+#define HB_MC_WORK_QUEUE_CAPACITY_IDX           3 // number of slots in the ring
+#define HB_MC_WORK_QUEUE_HEADER_WORDS           4
+        // Slot words. The host sets FULL when writing a slot, and a tile clears
+        // it once it has read the slot out.
+#define HB_MC_WORK_QUEUE_SLOT_OP_IDX            0
+#define HB_MC_WORK_QUEUE_SLOT_ARG0_IDX          1
+#define HB_MC_WORK_QUEUE_SLOT_ARG1_IDX          2
+#define HB_MC_WORK_QUEUE_SLOT_FULL_IDX          3
+#define HB_MC_WORK_QUEUE_SLOT_WORDS             4
+        // A tile that claims an item with this op leaves its kernel.
+#define HB_MC_WORK_QUEUE_OP_EXIT                0xFFFFFFFF
+
 
 
         typedef uint8_t tile_group_id_t;
@@ -81,8 +100,41 @@ extern "C" {
                 uint32_t        argc;
                 const uint32_t *argv;
                 int             refcount;
+                hb_mc_eva_t     argv_eva; // device copy of argv - shared by all tile groups
+                const unsigned char *data;       // payload of arguments passed by reference
+                size_t               data_size;
+                const uint32_t      *relocs;     // argv words that hold an offset into data
+                uint32_t             num_relocs;
+                uint32_t             launch;     // kernels enqueued on the device before this one
+                int                  traced;     // launched inside a trace region?
         } hb_mc_kernel_t;
 
+        /**
+         * A typed list of kernel arguments.
+         * Build with the hb_mc_kernel_args_push_*() functions and pass to
+         * hb_mc_device_pod_kernel_enqueue_args().
+         *
+         * Arguments are packed into argument words in the order the RV32
+         * integer calling convention assigns them: one word per 32-bit
+         * scalar, two words (low word first) per 64-bit scalar, and
+         * aggregates of up to two words by value. Larger aggregates are
+         * passed by reference, as the ABI requires: their bytes are copied
+         * into a payload that is uploaded in the same buffer as the argument
+         * words, and the argument word is patched with its device address at
+         * launch.
+         */
+        typedef struct {
+                uint32_t      *argv;
+                uint32_t       argc;
+                uint32_t       argv_capacity;
+                unsigned char *data;
+                size_t         data_size;
+                size_t         data_capacity;
+                uint32_t      *relocs;
+                uint32_t       num_relocs;
+                uint32_t       relocs_capacity;
+        } hb_mc_kernel_args_t;
+
         typedef struct {
                 hb_mc_coordinate_t        id;
                 grid_id_t                 grid_id;
@@ -95,8 +147,17 @@ extern "C" {
                 hb_mc_eva_t               argv_eva;
                 hb_mc_eva_t               barcfg_eva;
                 hb_mc_npa_t               finish_signal_npa;
+                uint64_t                  start_cycle;  // counters at launch, see bsg_manycore_stats_stream.h
+                uint64_t                  start_icount[HB_MC_INSTR_TYPES];
+                hb_mc_timeline_stamp_t    launched;     // see bsg_manycore_timeline.h and bsg_manycore_watchdog.h
         } hb_mc_tile_group_t;
 
+        typedef struct {
+                hb_mc_dimension_t dim;    // tile group shape
+                hb_mc_eva_t       eva;    // barrier lock word + one CSR value per tile
+                int               in_use; // held by a launched tile group?
+        } hb_mc_barcfg_t;
+
 
         typedef struct {
                 hb_mc_dimension_t dim;
@@ -132,6 +193,23 @@ extern "C" {
 
         typedef int hb_mc_pod_id_t;
 
+        typedef struct {
+                uint32_t op;
+                uint32_t arg0;
+                uint32_t arg1;
+        } hb_mc_work_item_t;
+
+        typedef struct {
+                hb_mc_pod_id_t pod_id;
+                hb_mc_eva_t    alloc_eva; // as returned by hb_mc_device_pod_malloc()
+                hb_mc_eva_t    eva;       // queue header
+                uint32_t       capacity;
+                uint32_t       tail;      // number of items pushed
+                uint32_t       free;      // items below this index have a free slot
+                uint32_t       done;      // last observed number of completed items
+                uint32_t      *slots;     // host copy of the ring, staged by push and read back by refresh
+        } hb_mc_work_queue_t;
+
         typedef struct {
                 hb_mc_program_t    *program;
                 hb_mc_mesh_t       *mesh;
@@ -141,6 +219,9 @@ extern "C" {
                 uint8_t             num_grids;
                 hb_mc_coordinate_t  pod_coord; // what pod am I in the global manycore?
                 int                 program_loaded;
+                hb_mc_barcfg_t     *barcfgs; // barrier configs, reused by tile groups of the same shape
+                uint32_t            num_barcfgs;
+                uint32_t            barcfg_capacity;
         } hb_mc_pod_t;
 
         typedef struct {
@@ -150,6 +231,10 @@ extern "C" {
                 const char       *name;
                 hb_mc_pod_id_t    default_pod_id;
                 hb_mc_dimension_t default_mesh_dim;
+                void             *trace_regions; // see bsg_manycore_trace_regions.h
+                void             *stats_stream;  // see bsg_manycore_stats_stream.h
+                void             *hotspots;      // see bsg_manycore_hotspots.h
+                void             *watchdog;      // see bsg_manycore_watchdog.h
         } hb_mc_device_t; 
 
 
@@ -374,6 +459,114 @@ extern "C" {
                                             const uint32_t argc,
                                             const uint32_t *argv);
 
+        /**
+         * Enqueues and schedules a kernel to be run on a pod with a typed argument list.
+         * Behaves like hb_mc_device_pod_kernel_enqueue(), but the argument words and the
+         * payload of arguments passed by reference are uploaded together in a single
+         * allocation when the first tile group of the grid launches.
+         * #args is copied and may be reused or cleaned up after this call.
+         * @param[in]  device        Pointer to device
+         * @param[in]  pod           Pod ID
+         * @param[in]  grid_dim      X/Y dimensions of the grid to be initialized
+         * @param[in]  tg_dim        X/Y dimensions of tile groups in grid
+         * @param[in]  name          Kernel name to be executed on tile groups in grid
+         * @param[in]  args          Arguments initialized with hb_mc_kernel_args_init()
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_device_pod_kernel_enqueue_args(hb_mc_device_t *device,
+                                                 hb_mc_pod_id_t  pod,
+                                                 hb_mc_dimension_t grid_dim,
+                                                 hb_mc_dimension_t tg_dim,
+                                                 const char *name,
+                                                 const hb_mc_kernel_args_t *args);
+
+        /**
+         * Initialize an empty kernel argument list.
+         * @param[in]  args  Argument list to initialize
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_kernel_args_init(hb_mc_kernel_args_t *args);
+
+        /**
+         * Cleanup a kernel argument list.
+         * @param[in]  args  Argument list initialized with hb_mc_kernel_args_init()
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_kernel_args_exit(hb_mc_kernel_args_t *args);
+
+        /**
+         * Append a 32-bit integer argument.
+         * @param[in]  args  Argument list initialized with hb_mc_kernel_args_init()
+         * @param[in]  val   Argument value
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_kernel_args_push_u32(hb_mc_kernel_args_t *args, uint32_t val);
+
+        /**
+         * Append a 32-bit signed integer argument.
+         * @param[in]  args  Argument list initialized with hb_mc_kernel_args_init()
+         * @param[in]  val   Argument value
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_kernel_args_push_i32(hb_mc_kernel_args_t *args, int32_t val);
+
+        /**
+         * Append a 64-bit integer argument. It occupies two argument words.
+         * @param[in]  args  Argument list initialized with hb_mc_kernel_args_init()
+         * @param[in]  val   Argument value
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_kernel_args_push_u64(hb_mc_kernel_args_t *args, uint64_t val);
+
+        /**
+         * Append a device pointer argument.
+         * @param[in]  args  Argument list initialized with hb_mc_kernel_args_init()
+         * @param[in]  eva   A device address, e.g. from hb_mc_device_pod_malloc()
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_kernel_args_push_eva(hb_mc_kernel_args_t *args, hb_mc_eva_t eva);
+
+        /**
+         * Append a struct argument.
+         * Structs of up to 8 bytes are passed by value in argument words.
+         * Larger structs are passed by reference to a device copy shared by
+         * every tile group in the grid, which the kernel must not modify.
+         * Kernels are compiled for a hard-float ABI that passes floating-point
+         * members in floating-point registers, so structs with float members
+         * should be declared as pointer (e.g. const T *) parameters and pushed
+         * with hb_mc_kernel_args_push_ref().
+         * @param[in]  args   Argument list initialized with hb_mc_kernel_args_init()
+         * @param[in]  ptr    Host copy of the struct
+         * @param[in]  size   Size of the struct in bytes
+         * @param[in]  align  Alignment of the struct on the device in bytes - a power of two
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_kernel_args_push_struct(hb_mc_kernel_args_t *args,
+                                          const void *ptr, size_t size, size_t align);
+
+        /**
+         * Append a pointer argument to a device copy of a host buffer.
+         * The buffer is uploaded with the argument words; use this for
+         * descriptors instead of a separate hb_mc_device_pod_malloc() and
+         * hb_mc_device_pod_memcpy_to_device() per launch.
+         * @param[in]  args   Argument list initialized with hb_mc_kernel_args_init()
+         * @param[in]  ptr    Host buffer to copy
+         * @param[in]  size   Size of the buffer in bytes
+         * @param[in]  align  Alignment of the copy on the device in bytes - a power of two
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_kernel_args_push_ref(hb_mc_kernel_args_t *args,
+                                       const void *ptr, size_t size, size_t align);
+
         /**
          * Launches all kernel invocations enqueued on pod.
          * These kernel invocations are enqueued by
@@ -383,7 +576,8 @@ extern "C" {
          * and completed.
          * @param[in]  device        Pointer to device
          * @param[in]  pod           Pod ID
-         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         * @return HB_MC_SUCCESS if succesful. HB_MC_WATCHDOG if a tile group ran past
+         * its budget (see bsg_manycore_watchdog.h). Otherwise an error code is returned.
          */
         __attribute__((warn_unused_result))
         int hb_mc_device_pod_kernels_execute(hb_mc_device_t *device,
@@ -399,7 +593,8 @@ extern "C" {
          * @param[in]  device        Pointer to device
          * @param[in]  podv          Vector of Pod IDs
          * @param[in]  podc          Number of Pod IDs
-         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         * @return HB_MC_SUCCESS if succesful. HB_MC_WATCHDOG if a tile group ran past
+         * its budget (see bsg_manycore_watchdog.h). Otherwise an error code is returned.
          */
         __attribute__((warn_unused_result))
         int hb_mc_device_podv_kernels_execute(hb_mc_device_t *device,
@@ -414,11 +609,103 @@ extern "C" {
          * This function blocks until all kernels have been invoked
          * and completed.
          * @param[in]  device        Pointer to device
-         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         * @return HB_MC_SUCCESS if succesful. HB_MC_WATCHDOG if a tile group ran past
+         * its budget (see bsg_manycore_watchdog.h). Otherwise an error code is returned.
          */
         __attribute__((warn_unused_result))
         int hb_mc_device_pods_kernels_execute(hb_mc_device_t *device);
 
+        /**
+         * Launches as many kernel invocations enqueued on pod as fit, without
+         * waiting for them to complete.
+         * Use hb_mc_device_pod_kernels_execute() to wait for completion and
+         * launch the remainder.
+         * @param[in]  device        Pointer to device
+         * @param[in]  pod           Pod ID
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_device_pod_kernels_launch(hb_mc_device_t *device,
+                                            hb_mc_pod_id_t pod);
+
+        /************************************/
+        /* Pod Interface Persistent Kernels */
+        /************************************/
+        /**
+         * Allocates and initializes a work queue in a pod's DRAM.
+         *
+         * A persistent kernel is launched once with the queue's EVA as an
+         * argument and stays resident: its tiles claim items from the queue,
+         * run them, and count them as done, until they claim an item with op
+         * HB_MC_WORK_QUEUE_OP_EXIT. See examples/cuda/test_persistent_kernel
+         * for the device side of the protocol.
+         * @param[in]  device        Pointer to device
+         * @param[in]  pod           Pod ID with a program initialized
+         * @param[in]  capacity      Number of slots in the queue
+         * @param[out] queue         The work queue
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_device_pod_work_queue_init(hb_mc_device_t *device,
+                                             hb_mc_pod_id_t pod,
+                                             uint32_t capacity,
+                                             hb_mc_work_queue_t *queue);
+
+        /**
+         * Appends items to a work queue.
+         * Items are written with posted stores and published to tiles in
+         * batches with a single amoadd to the queue tail. Blocks while the
+         * queue is full.
+         * @param[in]  device        Pointer to device
+         * @param[in]  queue         A work queue initialized with hb_mc_device_pod_work_queue_init()
+         * @param[in]  items         Items to append
+         * @param[in]  n             Number of items
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_device_pod_work_queue_push(hb_mc_device_t *device,
+                                             hb_mc_work_queue_t *queue,
+                                             const hb_mc_work_item_t *items,
+                                             uint32_t n);
+
+        /**
+         * Waits until at least n items of a work queue have completed.
+         * @param[in]  device        Pointer to device
+         * @param[in]  queue         A work queue initialized with hb_mc_device_pod_work_queue_init()
+         * @param[in]  n             Number of completed items to wait for
+         * @param[in]  timeout       How long to wait in microseconds, 0 to poll once, or -1 to wait forever.
+         * @return HB_MC_SUCCESS if succesful. HB_MC_TIMEOUT if fewer than n items completed in time.
+         * Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_device_pod_work_queue_wait(hb_mc_device_t *device,
+                                             hb_mc_work_queue_t *queue,
+                                             uint32_t n,
+                                             long timeout);
+
+        /**
+         * Appends one HB_MC_WORK_QUEUE_OP_EXIT item for each worker tile,
+         * so that the persistent kernel returns.
+         * @param[in]  device        Pointer to device
+         * @param[in]  queue         A work queue initialized with hb_mc_device_pod_work_queue_init()
+         * @param[in]  workers       Number of tiles polling the queue
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_device_pod_work_queue_close(hb_mc_device_t *device,
+                                              hb_mc_work_queue_t *queue,
+                                              uint32_t workers);
+
+        /**
+         * Frees a work queue.
+         * @param[in]  device        Pointer to device
+         * @param[in]  queue         A work queue initialized with hb_mc_device_pod_work_queue_init()
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_device_pod_work_queue_exit(hb_mc_device_t *device,
+                                             hb_mc_work_queue_t *queue);
+
         /*************************/
         /* Pod Interface Cleanup */
         /*************************/
@@ -635,6 +922,22 @@ extern "C" {
                                        const uint32_t argc,
                                        const uint32_t *argv);
 
+        /**
+         * Enqueues and schedules a kernel to be run on device with a typed argument list.
+         * @param[in]  device        Pointer to device
+         * @param[in]  grid_dim      X/Y dimensions of the grid to be initialized
+         * @param[in]  tg_dim        X/Y dimensions of tile groups in grid
+         * @param[in]  name          Kernel name to be executed on tile groups in grid
+         * @param[in]  args          Arguments initialized with hb_mc_kernel_args_init()
+         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_kernel_enqueue_args (hb_mc_device_t *device,
+                                       hb_mc_dimension_t grid_dim,
+                                       hb_mc_dimension_t tg_dim,
+                                       const char *name,
+                                       const hb_mc_kernel_args_t *args);
+
 
 
 
@@ -644,7 +947,8 @@ extern "C" {
          * API remains in this function until all tile groups
          * have successfully finished execution.
          * @param[in]  device        Pointer to device
-         * @return HB_MC_SUCCESS if succesful. Otherwise an error code is returned.
+         * @return HB_MC_SUCCESS if succesful. HB_MC_WATCHDOG if a tile group ran past
+         * its budget (see bsg_manycore_watchdog.h). Otherwise an error code is returned.
          */
         __attribute__((warn_unused_result))
         int hb_mc_device_tile_groups_execute (hb_mc_device_t *device);
@@ -25,6 +25,7 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define DEBUG
+#define BSG_LOG_SUBSYSTEM BSG_LOG_CUDA
 #include <bsg_manycore_cuda.h>
 #include <bsg_manycore_tile.h>
 #include <bsg_manycore_memory_manager.h>
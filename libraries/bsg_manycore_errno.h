@@ -45,6 +45,7 @@ extern "C" {
 #define HB_MC_BUSY          (-8)
 #define HB_MC_UNALIGNED     (-9)
 #define HB_MC_IOVERFLOW    (-10)
+#define HB_MC_WATCHDOG     (-11) // see bsg_manycore_watchdog.h
 
         static inline const char * hb_mc_strerror(int err)
         {
@@ -60,6 +61,7 @@ extern "C" {
                         [-HB_MC_BUSY]              = "Busy",
                         [-HB_MC_UNALIGNED]         = "Unaligned memory request",
                         [-HB_MC_IOVERFLOW]         = "Integer overflow",
+                        [-HB_MC_WATCHDOG]          = "Watchdog expired",
                 };
                 return strtab[-err];
         }
@@ -36,10 +36,12 @@
 // https://github.com:bespoke-silicon-group/bsg_replicant/examples/library/test_manycore_eva/main.c  //
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#define BSG_LOG_SUBSYSTEM BSG_LOG_EVA
 #include <bsg_manycore_eva.h>
 #include <bsg_manycore_tile.h>
 #include <bsg_manycore_vcache.h>
 #include <bsg_manycore_printing.h>
+#include <bsg_manycore_api_stats.h>
 
 
 #ifdef __cplusplus
@@ -1289,6 +1291,7 @@ int hb_mc_manycore_eva_write_internal(hb_mc_manycore_t *mc,
                                       WriteFunction write_function)
 {
         int err;
+        HB_MC_API_PROBE(mc, HB_MC_API_EVA_WRITE);
         size_t dest_sz, xfer_sz;
         hb_mc_npa_t dest_npa;
         char *destp;
@@ -1388,6 +1391,7 @@ int hb_mc_manycore_eva_read_internal(hb_mc_manycore_t *mc,
                                      ReadFunction read_function)
 {
         int err;
+        HB_MC_API_PROBE(mc, HB_MC_API_EVA_READ);
         size_t src_sz, xfer_sz;
         hb_mc_npa_t src_npa;
         char *srcp;
@@ -0,0 +1,212 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#define BSG_LOG_SUBSYSTEM BSG_LOG_CUDA
+#include <bsg_manycore_hotspots.h>
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_loader.h>
+#include <bsg_manycore_printing.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <map>
+#include <utility>
+#include <vector>
+
+typedef std::map<uint32_t, uint64_t> hb_mc_hotspots_pcs_t;
+
+typedef struct hb_mc_hotspots {
+        unsigned                                 top;
+        std::map<uint32_t, hb_mc_hotspots_pcs_t> launches; // samples by kernel launch
+        std::vector<hb_mc_pc_count_t>            counts;   // reused by every read
+} hb_mc_hotspots_t;
+
+static hb_mc_hotspots_t *hb_mc_hotspots(hb_mc_device_t *device)
+{
+        return reinterpret_cast<hb_mc_hotspots_t*>(device->hotspots);
+}
+
+int hb_mc_device_hotspots_enable(hb_mc_device_t *device, unsigned top)
+{
+        int err;
+
+        err = hb_mc_manycore_pc_histogram_enable(device->mc);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        hb_mc_hotspots_t *h = hb_mc_hotspots(device);
+        if (h == NULL) {
+                h = new hb_mc_hotspots_t();
+                device->hotspots = h;
+        }
+
+        h->top = top;
+        return HB_MC_SUCCESS;
+}
+
+void hb_mc_device_hotspots_disable(hb_mc_device_t *device)
+{
+        hb_mc_hotspots_t *h = hb_mc_hotspots(device);
+        if (h == NULL)
+                return;
+
+        hb_mc_manycore_pc_histogram_disable(device->mc);
+        delete h;
+        device->hotspots = NULL;
+}
+
+int hb_mc_device_hotspots_init(hb_mc_device_t *device)
+{
+        device->hotspots = NULL;
+
+        const char *top = getenv("HB_MC_HOTSPOTS");
+        if (top == NULL || *top == '\0')
+                return HB_MC_SUCCESS;
+
+        char *end;
+        unsigned long n = strtoul(top, &end, 0);
+        if (*end != '\0') {
+                bsg_pr_err("%s: HB_MC_HOTSPOTS='%s' is not a number of functions\n",
+                           __func__, top);
+                return HB_MC_INVALID;
+        }
+
+        int err = hb_mc_device_hotspots_enable(device, n ? n : HB_MC_HOTSPOTS_DEFAULT_TOP);
+        if (err == HB_MC_NOIMPL) {
+                bsg_pr_warn("%s: No PC histogram on this platform, hotspots will not be reported\n",
+                            __func__);
+                return HB_MC_SUCCESS;
+        }
+
+        return err;
+}
+
+int hb_mc_device_hotspots_tile_group_launch(hb_mc_device_t *device,
+                                            const hb_mc_tile_group_t *tg)
+{
+        hb_mc_coordinate_t coord;
+        int err;
+
+        if (hb_mc_hotspots(device) == NULL)
+                return HB_MC_SUCCESS;
+
+        // tiles keep their histograms between launches
+        foreach_coordinate(coord, tg->origin, tg->dim) {
+                err = hb_mc_manycore_pc_histogram_reset(device->mc, coord);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+int hb_mc_device_hotspots_tile_group_finish(hb_mc_device_t *device,
+                                            const hb_mc_tile_group_t *tg)
+{
+        hb_mc_hotspots_t *h = hb_mc_hotspots(device);
+        hb_mc_coordinate_t coord;
+        size_t n;
+        int err;
+
+        if (h == NULL)
+                return HB_MC_SUCCESS;
+
+        hb_mc_hotspots_pcs_t &pcs = h->launches[tg->kernel->launch];
+        foreach_coordinate(coord, tg->origin, tg->dim) {
+                err = hb_mc_manycore_pc_histogram_read(device->mc, coord,
+                                                       h->counts.data(), h->counts.size(), &n);
+                if (err == HB_MC_NOMEM) {
+                        h->counts.resize(n);
+                        err = hb_mc_manycore_pc_histogram_read(device->mc, coord,
+                                                               h->counts.data(), h->counts.size(), &n);
+                }
+
+                if (err != HB_MC_SUCCESS)
+                        return err;
+
+                for (size_t i = 0; i < n; i++)
+                        pcs[h->counts[i].pc] += h->counts[i].count;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+int hb_mc_device_hotspots_kernel_finish(hb_mc_device_t *device, const hb_mc_pod_t *pod,
+                                        const hb_mc_kernel_t *kernel)
+{
+        hb_mc_hotspots_t *h = hb_mc_hotspots(device);
+        hb_mc_loader_function_t *funcs;
+        size_t n_funcs;
+        int err;
+
+        if (h == NULL)
+                return HB_MC_SUCCESS;
+
+        auto launch = h->launches.find(kernel->launch);
+        if (launch == h->launches.end())
+                return HB_MC_SUCCESS;
+
+        hb_mc_hotspots_pcs_t pcs;
+        pcs.swap(launch->second);
+        h->launches.erase(launch);
+
+        err = hb_mc_loader_get_functions(pod->program->bin, pod->program->bin_size,
+                                         &funcs, &n_funcs);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        // attribute samples to functions; PCs outside any function are lumped together
+        std::map<const char *, uint64_t> by_func;
+        uint64_t total = 0;
+        for (const auto &pc : pcs) {
+                const hb_mc_loader_function_t *f = hb_mc_loader_function_at(funcs, n_funcs, pc.first);
+                by_func[f ? f->name : "??"] += pc.second;
+                total += pc.second;
+        }
+
+        std::vector<std::pair<uint64_t, const char *>> hot;
+        for (const auto &f : by_func)
+                hot.push_back(std::make_pair(f.second, f.first));
+
+        size_t shown = std::min<size_t>(h->top, hot.size());
+        std::partial_sort(hot.begin(), hot.begin() + shown, hot.end(),
+                          [](const std::pair<uint64_t, const char *> &a,
+                             const std::pair<uint64_t, const char *> &b) {
+                                  return a.first > b.first;
+                          });
+
+        bsg_pr_info("Hotspots of '%s' (launch %" PRIu32 "): %" PRIu64 " samples in %zu functions\n",
+                    kernel->name, kernel->launch, total, hot.size());
+        for (size_t i = 0; i < shown; i++)
+                bsg_pr_info("  %6.2f%% %12" PRIu64 "  %s\n",
+                            total ? 100.0 * hot[i].first / total : 0.0,
+                            hot[i].first, hot[i].second);
+
+        free(funcs);
+        return HB_MC_SUCCESS;
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/* Report the functions each kernel launch spent its PC samples in */
+#ifndef BSG_MANYCORE_HOTSPOTS_H
+#define BSG_MANYCORE_HOTSPOTS_H
+#include <bsg_manycore_features.h>
+#include <bsg_manycore.h>
+#include <bsg_manycore_cuda.h>
+
+/*
+ * While hotspot reports are on, the runtime clears the PC histogram
+ * of each tile a tile group is launched on and reads it back when
+ * the tile group retires (see hb_mc_manycore_pc_histogram_read()).
+ * When the last tile group of a kernel launch retires, the samples
+ * are attributed to functions with the symbol table of the pod's
+ * program and the #top hottest are printed.
+ *
+ * Set HB_MC_HOTSPOTS to a number of functions to turn reports on
+ * without changing the host program. Platforms without a PC
+ * histogram print a warning and no reports.
+ */
+#define HB_MC_HOTSPOTS_DEFAULT_TOP 10
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+        /**
+         * Print the hottest functions of every kernel launch from now on
+         * @param[in]  device  A CUDA device initialized with hb_mc_device_init()
+         * @param[in]  top     How many functions to print per launch
+         * @return HB_MC_SUCCESS on success. HB_MC_NOIMPL if the platform has no PC histogram.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_device_hotspots_enable(hb_mc_device_t *device, unsigned top);
+
+        /**
+         * Stop reporting hotspots. Launches in flight are not reported.
+         * @param[in]  device  A CUDA device initialized with hb_mc_device_init()
+         */
+        void hb_mc_device_hotspots_disable(hb_mc_device_t *device);
+
+        /* runtime hooks, called from bsg_manycore_cuda.cpp */
+        int hb_mc_device_hotspots_init(hb_mc_device_t *device);
+
+        int hb_mc_device_hotspots_tile_group_launch(hb_mc_device_t *device,
+                                                    const hb_mc_tile_group_t *tg);
+
+        int hb_mc_device_hotspots_tile_group_finish(hb_mc_device_t *device,
+                                                    const hb_mc_tile_group_t *tg);
+
+        int hb_mc_device_hotspots_kernel_finish(hb_mc_device_t *device, const hb_mc_pod_t *pod,
+                                                const hb_mc_kernel_t *kernel);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -25,6 +25,7 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#define BSG_LOG_SUBSYSTEM BSG_LOG_LOADER
 #include <bsg_manycore_loader.h>
 #include <bsg_manycore_tile.h>
 #include <bsg_manycore_vcache.h>
@@ -200,46 +201,237 @@ static int hb_mc_loader_eva_write(const Elf32_Phdr *phdr,
         return HB_MC_SUCCESS;
 }
 
+////////////////////////////////////////////
+// Zero-filling uninitialized (.bss) data //
+////////////////////////////////////////////
+
+#define HB_MC_LOADER_ZERO_FILL_DMA_CHUNK 4096
+
+static hb_mc_loader_zero_fill_stats_t zero_fill_stats;
+static const unsigned char zero_fill_zeros[HB_MC_LOADER_ZERO_FILL_DMA_CHUNK] = {0};
+
 /**
- * Writes program data to an EVA.
+ * Get the zero-fill statistics accumulated by the loader since the
+ * last call to hb_mc_loader_zero_fill_stats_reset().
+ * @param[out] stats   Filled with the current counters.
+ */
+void hb_mc_loader_zero_fill_stats_get(hb_mc_loader_zero_fill_stats_t *stats)
+{
+        *stats = zero_fill_stats;
+}
+
+/**
+ * Reset the zero-fill statistics accumulated by the loader.
+ */
+void hb_mc_loader_zero_fill_stats_reset(void)
+{
+        memset(&zero_fill_stats, 0, sizeof(zero_fill_stats));
+}
+
+/**
+ * Get a printable name for a zero-fill strategy.
+ * @param[in]  strategy  A zero-fill strategy.
+ * @return A static string naming #strategy.
+ */
+const char *hb_mc_loader_zero_fill_strategy_to_string(hb_mc_loader_zero_fill_strategy_t strategy)
+{
+        static const char *strs [] = {
+                "skip",   // HB_MC_LOADER_ZERO_FILL_SKIP
+                "dma",    // HB_MC_LOADER_ZERO_FILL_DMA
+                "packet", // HB_MC_LOADER_ZERO_FILL_PACKET
+        };
+
+        if (strategy < 0 || strategy >= HB_MC_LOADER_ZERO_FILL_STRATEGIES)
+                return "unknown";
+
+        return strs[strategy];
+}
+
+/**
+ * Zero an NPA range with remote store packets.
+ * @param[in]  mc      A manycore instance.
+ * @param[in]  npa     The start of the range.
+ * @param[in]  sz      The number of bytes to zero.
+ * @param[out] bytes   Incremented by the number of bytes written, indexed by strategy.
+ * @return HB_MC_SUCCESS if succesful. Otherwise and error code is returned.
+ */
+static int hb_mc_loader_npa_zero_fill_packet(hb_mc_manycore_t *mc,
+                                             const hb_mc_npa_t *npa, size_t sz,
+                                             size_t *bytes)
+{
+        int rc;
+
+        if (sz == 0)
+                return HB_MC_SUCCESS;
+
+        rc = hb_mc_manycore_memset(mc, npa, 0, sz);
+        if (rc != HB_MC_SUCCESS)
+                return rc;
+
+        bytes[HB_MC_LOADER_ZERO_FILL_PACKET] += sz;
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Zero a DRAM NPA range through the DMA backdoor.
+ * The range must cover whole vcache lines. Those lines are invalidated
+ * without being flushed: the range is about to be defined as zero, so
+ * dirty data left there by a previous program is dead. Backdoor memory
+ * that already reads as zero (e.g. after reset, or after a previous load
+ * of the same program) is not rewritten.
+ * @param[in]  mc      A manycore instance.
+ * @param[in]  npa     The start of the range. Must map to DRAM.
+ * @param[in]  sz      The number of bytes to zero.
+ * @param[out] bytes   Incremented by the number of bytes handled, indexed by strategy.
+ * @return HB_MC_SUCCESS if succesful. Otherwise and error code is returned.
+ */
+static int hb_mc_loader_npa_zero_fill_dma(hb_mc_manycore_t *mc,
+                                          const hb_mc_npa_t *npa, size_t sz,
+                                          size_t *bytes)
+{
+        unsigned char buf[HB_MC_LOADER_ZERO_FILL_DMA_CHUNK];
+        hb_mc_npa_t chunk_npa = *npa;
+        int rc;
+
+        rc = hb_mc_manycore_vcache_invalidate_npa_range(mc, npa, sz);
+        if (rc != HB_MC_SUCCESS)
+                return rc;
+
+        for (size_t off = 0; off < sz; ) {
+                size_t xfer_sz = min_size_t(sz - off, sizeof(buf));
+                hb_mc_npa_set_epa(&chunk_npa, hb_mc_npa_get_epa(npa) + off);
+
+                rc = hb_mc_manycore_dma_read_no_cache_afl(mc, &chunk_npa, buf, xfer_sz);
+                if (rc != HB_MC_SUCCESS)
+                        return rc;
+
+                if (memcmp(buf, zero_fill_zeros, xfer_sz) == 0) {
+                        bytes[HB_MC_LOADER_ZERO_FILL_SKIP] += xfer_sz;
+                } else {
+                        rc = hb_mc_manycore_dma_write_no_cache_ainv(mc, &chunk_npa,
+                                                                    zero_fill_zeros, xfer_sz);
+                        if (rc != HB_MC_SUCCESS)
+                                return rc;
+
+                        bytes[HB_MC_LOADER_ZERO_FILL_DMA] += xfer_sz;
+                }
+
+                off += xfer_sz;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Zero the uninitialized tail of a program segment.
+ *
+ * DRAM is zeroed through the DMA backdoor when the platform supports it,
+ * one whole vcache line at a time, and is skipped when the backdoor shows
+ * it is already zero. Partial lines at either end of a DRAM range, tile
+ * memory, and platforms without DMA fall back to remote store packets.
+ *
  * @param[in] phdr       The program header for this data (for debugging).
- * @param[in] val        The value to be written
+ * @param[in] sz         The number of bytes to zero.
  * @param[in] start_eva  The start EVA.
  * @param[in] mc         A manycore instance.
  * @param[in] map        And EVA to NPA map
  * @param[in] tile       A manycore coordinate.
  * @return HB_MC_SUCCESS if succesful. Otherwise and error code is returned.
  */
-static int hb_mc_loader_eva_memset(const Elf32_Phdr *phdr,
-                                   uint8_t val, size_t sz,
-                                   hb_mc_eva_t start_eva,
-                                   hb_mc_manycore_t *mc,
-                                   const hb_mc_eva_map_t *map,
-                                   hb_mc_coordinate_t tile)
+static int hb_mc_loader_eva_zero_fill(const Elf32_Phdr *phdr,
+                                      size_t sz,
+                                      hb_mc_eva_t start_eva,
+                                      hb_mc_manycore_t *mc,
+                                      const hb_mc_eva_map_t *map,
+                                      hb_mc_coordinate_t tile)
 {
+        const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
+        size_t line_sz = hb_mc_config_get_vcache_block_size(cfg);
+        size_t bytes[HB_MC_LOADER_ZERO_FILL_STRATEGIES] = {0};
         hb_mc_eva_t eva = start_eva;
-        size_t off = 0, rem = sz;
+        bool dma = hb_mc_manycore_supports_dma_write(mc)
+                && hb_mc_manycore_supports_dma_read(mc)
+                && hb_mc_manycore_dram_is_enabled(mc);
         int rc;
         char segname[64];
 
+        if (sz == 0)
+                return HB_MC_SUCCESS;
+
         hb_mc_loader_segment_to_string(phdr, segname, sizeof(segname));
 
-        rc = hb_mc_manycore_eva_memset(mc, map, &tile, &start_eva, val, sz);
-        if (rc != HB_MC_SUCCESS) {
-                bsg_pr_err("%s: failed to memset %s @ eva 0x%08x for tile (%d, %d)"
-                           ": %s\n",
-                           __func__,
-                           segname,
-                           eva,
-                           hb_mc_coordinate_get_x(tile),
-                           hb_mc_coordinate_get_y(tile),
-                           hb_mc_strerror(rc));
-                return rc;
+        while (sz > 0) {
+                hb_mc_npa_t npa;
+                size_t npa_sz, head_sz = 0, body_sz = 0, tail_sz;
+
+                rc = hb_mc_eva_to_npa(mc, map, &tile, &eva, &npa, &npa_sz);
+                if (rc != HB_MC_SUCCESS) {
+                        bsg_pr_err("%s: failed to translate eva 0x%08x of %s: %s\n",
+                                   __func__, eva, segname, hb_mc_strerror(rc));
+                        return rc;
+                }
+
+                size_t xfer_sz = min_size_t(sz, npa_sz);
+                hb_mc_epa_t epa = hb_mc_npa_get_epa(&npa);
+
+                /* only whole vcache lines in DRAM go through the backdoor */
+                if (dma && hb_mc_config_is_dram(cfg, hb_mc_npa_get_xy(&npa))) {
+                        head_sz = min_size_t(xfer_sz, (line_sz - (epa % line_sz)) % line_sz);
+                        body_sz = ((xfer_sz - head_sz) / line_sz) * line_sz;
+                }
+                if (body_sz == 0)
+                        head_sz = xfer_sz;
+                tail_sz = xfer_sz - head_sz - body_sz;
+
+                hb_mc_npa_t body_npa = npa, tail_npa = npa;
+                hb_mc_npa_set_epa(&body_npa, epa + head_sz);
+                hb_mc_npa_set_epa(&tail_npa, epa + head_sz + body_sz);
+
+                if ((rc = hb_mc_loader_npa_zero_fill_packet(mc, &npa, head_sz, bytes)) != HB_MC_SUCCESS ||
+                    (body_sz != 0 &&
+                     (rc = hb_mc_loader_npa_zero_fill_dma(mc, &body_npa, body_sz, bytes)) != HB_MC_SUCCESS) ||
+                    (rc = hb_mc_loader_npa_zero_fill_packet(mc, &tail_npa, tail_sz, bytes)) != HB_MC_SUCCESS) {
+                        bsg_pr_err("%s: failed to zero %s @ eva 0x%08x for tile (%d, %d)"
+                                   ": %s\n",
+                                   __func__,
+                                   segname,
+                                   eva,
+                                   hb_mc_coordinate_get_x(tile),
+                                   hb_mc_coordinate_get_y(tile),
+                                   hb_mc_strerror(rc));
+                        return rc;
+                }
+
+                sz  -= xfer_sz;
+                eva += xfer_sz;
+        }
+
+        /* make sure vcache invalidations have landed before tiles run */
+        if (bytes[HB_MC_LOADER_ZERO_FILL_SKIP] != 0 || bytes[HB_MC_LOADER_ZERO_FILL_DMA] != 0) {
+                rc = hb_mc_manycore_host_request_fence(mc, -1);
+                if (rc != HB_MC_SUCCESS)
+                        return rc;
         }
 
+        for (int s = 0; s < HB_MC_LOADER_ZERO_FILL_STRATEGIES; s++) {
+                if (bytes[s] == 0)
+                        continue;
+                zero_fill_stats.fills[s]++;
+                zero_fill_stats.bytes[s] += bytes[s];
+        }
+
+        bsg_pr_dbg("%s: zeroed %s for tile (%d, %d): "
+                   "%zu bytes skipped, %zu bytes by dma, %zu bytes by packet\n",
+                   __func__,
+                   segname,
+                   hb_mc_coordinate_get_x(tile),
+                   hb_mc_coordinate_get_y(tile),
+                   bytes[HB_MC_LOADER_ZERO_FILL_SKIP],
+                   bytes[HB_MC_LOADER_ZERO_FILL_DMA],
+                   bytes[HB_MC_LOADER_ZERO_FILL_PACKET]);
+
         return HB_MC_SUCCESS;
 }
-
 /**
  * Load a program segment.
  * @param[in] mc       A manycore instance.
@@ -295,9 +487,9 @@ static int hb_mc_loader_load_tile_segment(hb_mc_manycore_t *mc,
         size_t zeros_sz  = seg_sz - file_sz;  // zeros are the remainder of the segment
         eva += file_sz; // increment eva by number of initialized bytes written
 
-        rc = hb_mc_loader_eva_memset(phdr, 0, zeros_sz, eva, mc, map, tile);
+        rc = hb_mc_loader_eva_zero_fill(phdr, zeros_sz, eva, mc, map, tile);
         if (rc != HB_MC_SUCCESS) {
-                bsg_pr_dbg("%s: memset: failed to load segment %s: %s\n",
+                bsg_pr_dbg("%s: zero fill: failed to load segment %s: %s\n",
                            __func__,
                            segname,
                            hb_mc_strerror(rc));
@@ -880,6 +1072,14 @@ int hb_mc_loader_load(const void *bin, size_t sz, hb_mc_manycore_t *mc,
                 return rc;
         }
 
+        for (int s = 0; s < HB_MC_LOADER_ZERO_FILL_STRATEGIES; s++) {
+                bsg_pr_dbg("%s: zero fill (%s): %zu regions, %zu bytes\n",
+                           __func__,
+                           hb_mc_loader_zero_fill_strategy_to_string((hb_mc_loader_zero_fill_strategy_t)s),
+                           zero_fill_stats.fills[s],
+                           zero_fill_stats.bytes[s]);
+        }
+
         return HB_MC_SUCCESS;
 }
 
@@ -1040,6 +1240,144 @@ int hb_mc_loader_symbol_to_eva(const void *bin, size_t sz, const char *symbol,
         return HB_MC_SUCCESS;
 }
 
+static int hb_mc_loader_function_cmp(const void *a, const void *b)
+{
+        const hb_mc_loader_function_t *fa = (const hb_mc_loader_function_t *)a;
+        const hb_mc_loader_function_t *fb = (const hb_mc_loader_function_t *)b;
+
+        if (fa->eva != fb->eva)
+                return fa->eva < fb->eva ? -1 : 1;
+
+        /* prefer the symbol that knows its size */
+        return fa->size > fb->size ? -1 : fa->size < fb->size;
+}
+
+/**
+ * List the function symbols of a program, sorted by address.
+ * @param[in]  bin     A memory buffer containing a valid manycore binary.
+ * @param[in]  sz      Size of #bin in bytes.
+ * @param[out] funcs   A newly allocated array of functions. Release it with free().
+ *                     Names point into #bin, which must outlive #funcs.
+ * @param[out] n       Number of entries in #funcs
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_loader_get_functions(const void *bin, size_t sz,
+                               hb_mc_loader_function_t **funcs, size_t *n)
+{
+        const Elf32_Ehdr *ehdr = (const Elf32_Ehdr*) bin;
+        hb_mc_loader_function_t *fs = NULL;
+        size_t fs_n = 0, fs_cap = 0;
+        int rc;
+
+        if (!funcs || !n)
+                return HB_MC_INVALID;
+
+        rc = hb_mc_loader_elf_validate(bin, sz);
+        if (rc != HB_MC_SUCCESS) {
+                bsg_pr_dbg("%s: failed to validate binary\n", __func__);
+                return rc;
+        }
+
+        for (unsigned idx = 0; idx < RV32_Half_to_host(ehdr->e_shnum); idx++) {
+                const Elf32_Shdr *symtab_shdr, *strtab_shdr;
+                const unsigned char *symtab_data, *strtab_data;
+
+                rc = hb_mc_loader_get_section(bin, sz, idx, &symtab_shdr, &symtab_data);
+                if (rc != HB_MC_SUCCESS)
+                        goto fail;
+
+                if (!hb_mc_loader_section_is_symbol_table(symtab_shdr))
+                        continue;
+
+                rc = hb_mc_loader_get_section(bin, sz, RV32_Word_to_host(symtab_shdr->sh_link),
+                                              &strtab_shdr, &strtab_data);
+                if (rc != HB_MC_SUCCESS)
+                        goto fail;
+
+                const Elf32_Sym *symbol_table = (const Elf32_Sym*)symtab_data;
+                Elf32_Word strtab_sz = RV32_Word_to_host(strtab_shdr->sh_size);
+                Elf32_Word sym_n = RV32_Word_to_host(symtab_shdr->sh_size)/RV32_Word_to_host(symtab_shdr->sh_entsize);
+
+                for (Elf32_Word sym_i = 0; sym_i < sym_n; sym_i++) {
+                        const Elf32_Sym *sym = &symbol_table[sym_i];
+                        Elf32_Word sym_name_off = RV32_Word_to_host(sym->st_name);
+
+                        if (ELF32_ST_TYPE(sym->st_info) != STT_FUNC || sym_name_off == 0)
+                                continue;
+
+                        if (sym_name_off >= strtab_sz) {
+                                rc = HB_MC_INVALID;
+                                goto fail;
+                        }
+
+                        if (fs_n == fs_cap) {
+                                size_t cap = fs_cap ? 2 * fs_cap : 64;
+                                hb_mc_loader_function_t *grown =
+                                        (hb_mc_loader_function_t *)realloc(fs, cap * sizeof(*fs));
+                                if (!grown) {
+                                        rc = HB_MC_NOMEM;
+                                        goto fail;
+                                }
+                                fs = grown;
+                                fs_cap = cap;
+                        }
+
+                        fs[fs_n].eva  = RV32_Addr_to_host(sym->st_value);
+                        fs[fs_n].size = RV32_Word_to_host(sym->st_size);
+                        fs[fs_n].name = (const char *)&strtab_data[sym_name_off];
+                        fs_n++;
+                }
+        }
+
+        qsort(fs, fs_n, sizeof(*fs), hb_mc_loader_function_cmp);
+
+        *funcs = fs;
+        *n = fs_n;
+        return HB_MC_SUCCESS;
+
+fail:
+        bsg_pr_dbg("%s: failed to read function symbols: %s\n",
+                   __func__, hb_mc_strerror(rc));
+        free(fs);
+        return rc;
+}
+
+/**
+ * Find the function that contains an address.
+ * @param[in]  funcs   An array returned by hb_mc_loader_get_functions()
+ * @param[in]  n       Number of entries in #funcs
+ * @param[in]  eva     An address in the program's text
+ * @return The function containing #eva, or NULL if there is none.
+ */
+const hb_mc_loader_function_t *hb_mc_loader_function_at(const hb_mc_loader_function_t *funcs,
+                                                        size_t n, hb_mc_eva_t eva)
+{
+        size_t lo = 0, hi = n;
+
+        /* find the last function that starts at or before eva */
+        while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (funcs[mid].eva <= eva)
+                        lo = mid + 1;
+                else
+                        hi = mid;
+        }
+
+        if (lo == 0)
+                return NULL;
+
+        /* aliases sort biggest first, so step back to the one with a size */
+        const hb_mc_loader_function_t *f = &funcs[lo - 1];
+        while (f > funcs && (f - 1)->eva == f->eva)
+                f--;
+
+        /* symbols without a size run up to the next function */
+        if (f->size != 0 && eva - f->eva >= f->size)
+                return NULL;
+
+        return f;
+}
+
 
 
 
@@ -37,6 +37,25 @@
 extern "C" {
 #endif
 
+        /**
+         * Mechanisms used by the loader to zero the uninitialized
+         * tail (.bss) of a program segment.
+         */
+        typedef enum hb_mc_loader_zero_fill_strategy {
+                HB_MC_LOADER_ZERO_FILL_SKIP   = 0, //!< memory was already zero - nothing written
+                HB_MC_LOADER_ZERO_FILL_DMA    = 1, //!< zeroed via the DMA backdoor + vcache invalidate
+                HB_MC_LOADER_ZERO_FILL_PACKET = 2, //!< zeroed with remote store packets
+                HB_MC_LOADER_ZERO_FILL_STRATEGIES,
+        } hb_mc_loader_zero_fill_strategy_t;
+
+        /**
+         * Counters of zero-fill work done by the loader, indexed by strategy.
+         */
+        typedef struct hb_mc_loader_zero_fill_stats {
+                size_t fills[HB_MC_LOADER_ZERO_FILL_STRATEGIES]; //!< number of regions
+                size_t bytes[HB_MC_LOADER_ZERO_FILL_STRATEGIES]; //!< number of bytes
+        } hb_mc_loader_zero_fill_stats_t;
+
         /**
          * Loads a binary object into a list of tiles and DRAM
          * @param[in]  bin    A memory buffer containing a valid manycore binary
@@ -64,6 +83,34 @@ extern "C" {
         int hb_mc_loader_symbol_to_eva(const void *bin, size_t sz, const char *symbol,
                                        hb_mc_eva_t *eva);
 
+        typedef struct {
+                hb_mc_eva_t  eva;  //!< Address of the first instruction
+                uint32_t     size; //!< Size in bytes, or 0 if the symbol table does not say
+                const char  *name; //!< Symbol name. Points into the binary it was read from.
+        } hb_mc_loader_function_t;
+
+        /**
+         * List the function symbols of a program, sorted by address.
+         * @param[in]  bin     A memory buffer containing a valid manycore binary.
+         * @param[in]  sz      Size of #bin in bytes.
+         * @param[out] funcs   A newly allocated array of functions. Release it with free().
+         *                     Names point into #bin, which must outlive #funcs.
+         * @param[out] n       Number of entries in #funcs
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_loader_get_functions(const void *bin, size_t sz,
+                                       hb_mc_loader_function_t **funcs, size_t *n);
+
+        /**
+         * Find the function that contains an address.
+         * @param[in]  funcs   An array returned by hb_mc_loader_get_functions()
+         * @param[in]  n       Number of entries in #funcs
+         * @param[in]  eva     An address in the program's text
+         * @return The function containing #eva, or NULL if there is none.
+         */
+        const hb_mc_loader_function_t *hb_mc_loader_function_at(const hb_mc_loader_function_t *funcs,
+                                                                size_t n, hb_mc_eva_t eva);
+
 
 
         /**
@@ -75,6 +122,25 @@ extern "C" {
          */
         int hb_mc_loader_read_program_file(const char *file_name, unsigned char **file_data, size_t *file_size);
 
+        /**
+         * Get the zero-fill statistics accumulated by the loader since the
+         * last call to hb_mc_loader_zero_fill_stats_reset().
+         * @param[out] stats   Filled with the current counters.
+         */
+        void hb_mc_loader_zero_fill_stats_get(hb_mc_loader_zero_fill_stats_t *stats);
+
+        /**
+         * Reset the zero-fill statistics accumulated by the loader.
+         */
+        void hb_mc_loader_zero_fill_stats_reset(void);
+
+        /**
+         * Get a printable name for a zero-fill strategy.
+         * @param[in]  strategy  A zero-fill strategy.
+         * @return A static string naming #strategy.
+         */
+        const char *hb_mc_loader_zero_fill_strategy_to_string(hb_mc_loader_zero_fill_strategy_t strategy);
+
 
 #ifdef __cplusplus
 }
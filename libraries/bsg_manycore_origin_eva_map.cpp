@@ -25,6 +25,7 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#define BSG_LOG_SUBSYSTEM BSG_LOG_EVA
 #include <bsg_manycore_origin_eva_map.h>
 #include <bsg_manycore_eva.h>
 #include <bsg_manycore_printing.h>
@@ -37,10 +37,17 @@ extern "C" {
 
         /**
          * Transmit a request packet to manycore hardware
+         *
+         * Timeouts throughout this interface are counted in
+         * microseconds on hardware platforms and in simulated cycles
+         * on simulation platforms. A timeout of 0 makes one attempt
+         * and -1 waits forever.
+         *
          * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init()
          * @param[in] request A request packet to transmit to manycore hardware
-         * @param[in] timeout A timeout counter. Unused - set to -1 to wait forever.
-         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         * @param[in] timeout How long to wait for room in the transmit fifo, 0 to poll, or -1 to wait forever.
+         * @return HB_MC_SUCCESS on success. HB_MC_TIMEOUT if the packet was not accepted in time.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
          */
         int hb_mc_platform_transmit(hb_mc_manycore_t *mc,
                                     hb_mc_packet_t *packet,
@@ -51,14 +58,63 @@ extern "C" {
          * Receive a packet from manycore hardware
          * @param[in] mc       A manycore instance initialized with hb_mc_manycore_init()
          * @param[in] response A packet into which data should be read
-         * @param[in] timeout  A timeout counter. Unused - set to -1 to wait forever.
-         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         * @param[in] timeout  How long to wait for a packet, 0 to poll, or -1 to wait forever.
+         * @return HB_MC_SUCCESS on success. HB_MC_TIMEOUT if no packet arrived in time.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
          */
         int hb_mc_platform_receive(hb_mc_manycore_t *mc,
                                    hb_mc_packet_t *packet,
                                    hb_mc_fifo_rx_t type,
                                    long timeout);
 
+        /**
+         * Transmit an array of packets to manycore hardware, in order
+         *
+         * Platforms that do not implement this get a generic version
+         * that calls hb_mc_platform_transmit() once per packet.
+         *
+         * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  packets An array of packets to transmit to manycore hardware
+         * @param[in]  n       The number of packets in #packets
+         * @param[in]  type    Is this packet a request or response packet?
+         * @param[in]  timeout How long to wait for room in the transmit fifo, 0 to poll, or -1 to wait forever.
+         * @param[out] sent    The number of packets accepted, always a prefix of #packets
+         * @return HB_MC_SUCCESS if all #n packets were sent. HB_MC_BUSY if the
+         * hardware cannot accept more packets until responses are read.
+         * HB_MC_TIMEOUT if the rest were not accepted in time.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_platform_transmit_n(hb_mc_manycore_t *mc,
+                                      hb_mc_packet_t *packets,
+                                      size_t n,
+                                      hb_mc_fifo_tx_t type,
+                                      long timeout,
+                                      size_t *sent);
+
+        /**
+         * Receive up to #n packets from manycore hardware
+         *
+         * Waits for the first packet as hb_mc_platform_receive()
+         * does, then returns as many more as are ready. Callers must
+         * not ask for more responses than they have outstanding.
+         * Platforms that do not implement this get a generic version
+         * that calls hb_mc_platform_receive() once per packet.
+         *
+         * @param[in]  mc       A manycore instance initialized with hb_mc_manycore_init()
+         * @param[out] packets  An array of at least #n packets into which data should be read
+         * @param[in]  n        The maximum number of packets to read
+         * @param[in]  type     Is this packet a request or response packet?
+         * @param[in]  timeout  How long to wait for the first packet, 0 to poll, or -1 to wait forever.
+         * @param[out] received The number of packets read into #packets
+         * @return HB_MC_SUCCESS if at least one packet was read. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_platform_receive_n(hb_mc_manycore_t *mc,
+                                     hb_mc_packet_t *packets,
+                                     size_t n,
+                                     hb_mc_fifo_rx_t type,
+                                     long timeout,
+                                     size_t *received);
+
         /**
          * Read the configuration register at an index
          * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
@@ -73,8 +129,9 @@ extern "C" {
         /**
          * Stall until the all requests (and responses) have reached their destination.
          * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
-         * @param[in] timeout A timeout counter. Unused - set to -1 to wait forever.
-         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         * @param[in] timeout How long to wait, 0 to poll, or -1 to wait forever.
+         * @return HB_MC_SUCCESS on success. HB_MC_TIMEOUT if requests are still in flight.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
          */
         int hb_mc_platform_fence(hb_mc_manycore_t *mc, long timeout);
 
@@ -124,6 +181,51 @@ extern "C" {
          */
         int hb_mc_platform_get_icount(hb_mc_manycore_t *mc, bsg_instr_type_e itype, int *count);
 
+        /**
+         * Capture every class of instruction count for every tile in one pass
+         * @param[in]  mc    A manycore instance initialized with hb_mc_manycore_init()
+         * @param[out] snap  A snapshot whose tiles and cap are set by the caller.
+         *                   The platform fills tiles and n_tiles, but not cycle.
+         * @return HB_MC_SUCCESS on success. HB_MC_NOIMPL, quietly, if the platform has no
+         * per-tile profiler. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_platform_get_icount_snapshot(hb_mc_manycore_t *mc, hb_mc_icount_snapshot_t *snap);
+
+        /**
+         * Start accumulating per-tile PC histograms
+         * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_platform_pc_histogram_enable(hb_mc_manycore_t *mc);
+
+        /**
+         * Stop accumulating per-tile PC histograms
+         * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_platform_pc_histogram_disable(hb_mc_manycore_t *mc);
+
+        /**
+         * Discard the PC histogram of one tile
+         * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in] tile  A tile coordinate
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_platform_pc_histogram_reset(hb_mc_manycore_t *mc, hb_mc_coordinate_t tile);
+
+        /**
+         * Read the PC histogram of one tile, in ascending PC order
+         * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+         * @param[in]  tile   A tile coordinate
+         * @param[out] counts An array of #cap entries
+         * @param[in]  cap    Length of #counts
+         * @param[out] n      Number of entries filled in #counts
+         * @return HB_MC_SUCCESS on success. HB_MC_NOMEM if #cap is too small.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_platform_pc_histogram_read(hb_mc_manycore_t *mc, hb_mc_coordinate_t tile,
+                                             hb_mc_pc_count_t *counts, size_t cap, size_t *n);
+
         /**
          * Enable trace file generation (vanilla_operation_trace.csv)
          * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
@@ -29,7 +29,9 @@
 #include <bsg_manycore_request_packet_id.h>
 #include <bsg_manycore_printing.h>
 #include <bsg_manycore_coordinate.h>
+#include <bsg_manycore_responder_output.h>
 #include <stdio.h>
+#include <algorithm>
 
 #define SINT_EPA 0xEAE0
 #define UINT_EPA 0xEAE4
@@ -49,8 +51,12 @@ static hb_mc_request_packet_id_t ids [] = {
 static int init(hb_mc_responder_t *responder,
                 hb_mc_manycore_t *mc)
 {
+        hb_mc_responder_output_t *out;
         bsg_pr_dbg("hello from %s\n", __FILE__);
-        responder->responder_data = stdout;
+        int err = hb_mc_responder_output_get(stdout, &out);
+        if (err != HB_MC_SUCCESS)
+                return err;
+        responder->responder_data = out;
         return 0;
 }
 
@@ -58,6 +64,7 @@ static int quit(hb_mc_responder_t *responder,
                 hb_mc_manycore_t *mc)
 {
         bsg_pr_dbg("goodbye from %s\n", __FILE__);
+        hb_mc_responder_output_put((hb_mc_responder_output_t*)responder->responder_data);
         responder->responder_data = nullptr;
         return 0;
 }
@@ -69,7 +76,9 @@ static int respond(hb_mc_responder_t *responder,
                    const hb_mc_request_packet_t *rqst)
 {
         auto data = hb_mc_request_packet_get_data(rqst);
-        FILE *f = (FILE*)responder->responder_data;
+        hb_mc_responder_output_t *out = (hb_mc_responder_output_t*)responder->responder_data;
+        char line[320];
+        int len = 0;
         char coordstr[256];
         hb_mc_coordinate_to_string(hb_mc_coordinate(hb_mc_request_packet_get_x_src(rqst),
                                                     hb_mc_request_packet_get_y_src(rqst)),
@@ -78,23 +87,26 @@ static int respond(hb_mc_responder_t *responder,
 
         switch (hb_mc_request_packet_get_epa(rqst)) {
         case SINT_EPA:
-                fprintf(f, "int32   from %s: %d\n", coordstr, (int)data);
+                len = snprintf(line, sizeof(line), "int32   from %s: %d\n", coordstr, (int)data);
                 break;
         case UINT_EPA:
-                fprintf(f, "uint32  from %s: %u\n", coordstr, (unsigned)data);
+                len = snprintf(line, sizeof(line), "uint32  from %s: %u\n", coordstr, (unsigned)data);
                 break;
         case XINT_EPA:
-                fprintf(f, "uint32  from %s: 0x%08x\n", coordstr, (unsigned) data);
+                len = snprintf(line, sizeof(line), "uint32  from %s: 0x%08x\n", coordstr, (unsigned) data);
                 break;
         case FP32_EPA:
                 f_data.u = data;
-                fprintf(f, "float32 from %s: %f\n", coordstr, f_data.f);
+                len = snprintf(line, sizeof(line), "float32 from %s: %f\n", coordstr, f_data.f);
                 break;
         case FP32_SCI_EPA:
                 f_data.u = data;
-                fprintf(f, "float32 from %s: %e\n", coordstr, f_data.f);
+                len = snprintf(line, sizeof(line), "float32 from %s: %e\n", coordstr, f_data.f);
                 break;
         }
+
+        if (len > 0)
+                hb_mc_responder_output_write(out, line, std::min<size_t>(len, sizeof(line) - 1));
         return 0;
 }
 
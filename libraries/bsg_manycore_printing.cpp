@@ -26,104 +26,166 @@
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <bsg_manycore_printing.h>
+#include <bsg_manycore_responder_output.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+
+int bsg_log_level = BSG_LOG_LEVEL_DEBUG;
+unsigned bsg_log_mask = BSG_LOG_ALL;
+
+static const struct {
+        const char *name;
+        unsigned value;
+} log_names [] = {
+        {"none",    BSG_LOG_LEVEL_NONE},
+        {"error",   BSG_LOG_LEVEL_ERROR},
+        {"warn",    BSG_LOG_LEVEL_WARN},
+        {"info",    BSG_LOG_LEVEL_INFO},
+        {"debug",   BSG_LOG_LEVEL_DEBUG},
+}, log_subsystems [] = {
+        {"general", BSG_LOG_GENERAL},
+        {"packet",  BSG_LOG_PACKET},
+        {"loader",  BSG_LOG_LOADER},
+        {"cuda",    BSG_LOG_CUDA},
+        {"eva",     BSG_LOG_EVA},
+        {"dma",     BSG_LOG_DMA},
+        {"all",     BSG_LOG_ALL},
+};
 
-#include <map>
-#include <string>
+/* read the runtime log filters from the environment */
+__attribute__((constructor))
+static void bsg_log_init(void)
+{
+        const char *level = getenv("BSG_LOG_LEVEL");
+        if (level != nullptr) {
+                char *end;
+                bsg_log_level = strtol(level, &end, 0);
+                for (auto &n : log_names)
+                        if (strcasecmp(level, n.name) == 0)
+                                bsg_log_level = n.value;
+        }
 
-using std::map;
-using std::string;
+        const char *mask = getenv("BSG_LOG_MASK");
+        if (mask != nullptr) {
+                char *end;
+                bsg_log_mask = strtoul(mask, &end, 0);
+                if (*end == '\0')
+                        return;
+
+                // a list of subsystem names
+                bsg_log_mask = 0;
+                for (const char *name = mask; *name != '\0'; ) {
+                        size_t len = strcspn(name, ",");
+                        for (auto &n : log_subsystems)
+                                if (strlen(n.name) == len && strncasecmp(name, n.name, len) == 0)
+                                        bsg_log_mask |= n.value;
+                        name += len;
+                        if (*name == ',')
+                                name++;
+                }
+        }
+}
 
 typedef struct prefix_info {
+        const char *prefix;
         FILE *file;
         bool newline;
-        void (*newline_hook)(struct prefix_info *info, const char *prefix);
+        void (*newline_hook)(struct prefix_info *info);
 } prefix_info_t;
 
 /* inserts the time into the prefix */
-static void insert_time(prefix_info_t *info, const char *prefix)
+static void insert_time(prefix_info_t *info)
 {
-        fprintf(info->file, "%s @ (%lu): ", prefix, bsg_utc());
+        fprintf(info->file, "%s @ (%lu): ", info->prefix, bsg_utc());
         return;
 }
 
-typedef map<string, prefix_info_t> prefix_map;
-
-static prefix_map fmap = {
-        {BSG_PRINT_PREFIX_DEBUG, {BSG_PRINT_STREAM_DEBUG, true, insert_time}},
-        {BSG_PRINT_PREFIX_ERROR, {BSG_PRINT_STREAM_ERROR, true, 0}},
-        {BSG_PRINT_PREFIX_WARN,  {BSG_PRINT_STREAM_WARN,  true, 0}},
-        {BSG_PRINT_PREFIX_INFO,  {BSG_PRINT_STREAM_INFO,  true, 0}},
+static prefix_info_t prefixes [] = {
+        {BSG_PRINT_PREFIX_DEBUG, BSG_PRINT_STREAM_DEBUG, true, insert_time},
+        {BSG_PRINT_PREFIX_ERROR, BSG_PRINT_STREAM_ERROR, true, 0},
+        {BSG_PRINT_PREFIX_WARN,  BSG_PRINT_STREAM_WARN,  true, 0},
+        {BSG_PRINT_PREFIX_INFO,  BSG_PRINT_STREAM_INFO,  true, 0},
 };
 
+/* messages up to this long are formatted without allocating */
+#define BSG_PRINT_BUFFER_SIZE 1024
+
+static prefix_info_t *find_prefix(const char *prefix)
+{
+        // the bsg_pr_* macros pass the literals above, so the pointers usually match
+        for (auto &info : prefixes)
+                if (info.prefix == prefix)
+                        return &info;
+
+        for (auto &info : prefixes)
+                if (strcmp(info.prefix, prefix) == 0)
+                        return &info;
+
+        return nullptr;
+}
+
 int bsg_pr_prefix(const char *prefix, const char *fmt, ...)
 {
-        string prefix_string(prefix);
-        string fmt_string(fmt);
+        char buf[BSG_PRINT_BUFFER_SIZE];
+        char *msg = buf;
         prefix_info_t *info;
         va_list ap;
-        int r = -1, count = 0;
-        bool newline;
+        int len;
 
-        auto it = fmap.find(prefix_string);
-        if (it != fmap.end()) {
-                info = &it->second;
-        } else {
-                return r;
-        }
+        info = find_prefix(prefix);
+        if (info == nullptr)
+                return -1;
 
-        // lock our file to make our print atomic
-        flockfile(info->file);
+        // format once; only messages that do not fit are formatted again
         va_start(ap, fmt);
-        newline = info->newline;
-
-        string::size_type  cl_start = 0, cl_end;
-        do { // for each line in fmt
-                // find end of line
-                cl_end = fmt_string.find('\n', cl_start);
-                cl_end = (cl_end == string::npos ? fmt_string.size() : cl_end);
-
-                // print prefix if this is the start of a new line
-                if (newline) {
-                        if (info->newline_hook) {
-                                info->newline_hook(info, prefix);
-                        } else {
-                                fprintf(info->file, "%s", prefix);
-                        }
-                }
+        len = vsnprintf(buf, sizeof(buf), fmt, ap);
+        va_end(ap);
+        if (len < 0)
+                return len;
 
-                // print to the end of the line
-                string lfmt = fmt_string.substr(cl_start, cl_end-cl_start);
+        if (static_cast<size_t>(len) >= sizeof(buf)) {
+                msg = static_cast<char*>(malloc(len + 1));
+                if (msg == nullptr)
+                        return -1;
 
-                count += vfprintf(info->file, lfmt.c_str(), ap);
+                va_start(ap, fmt);
+                vsnprintf(msg, len + 1, fmt, ap);
+                va_end(ap);
+        }
 
-                // move cl_start forward
-                cl_start = cl_end;
+        // device output printed before this message comes out first
+        hb_mc_responder_output_flush_all();
 
-                // decide on newline
-                if (cl_end != fmt_string.size()) {
-                        // print the newline character and set 'newline' to true
-                        count += fprintf(info->file, "\n");
-                        cl_start++; // advance one so we don't print the 'newline' twice
-                        newline = true;
-                } else {
-                        // this was the last line printed
-                        // if it was an empty line just set newline to false
-                        newline = lfmt.empty() ? true : false;
+        // lock our file to make our print atomic
+        flockfile(info->file);
+
+        // print the prefix at the start of each line
+        const char *line = msg, *end = msg + len;
+        do {
+                const char *eol = static_cast<const char*>(memchr(line, '\n', end - line));
+                const char *next = eol ? eol + 1 : end;
+
+                if (info->newline) {
+                        if (info->newline_hook)
+                                info->newline_hook(info);
+                        else
+                                fputs_unlocked(info->prefix, info->file);
                 }
 
-                // until we've reached the end of our format string
-        } while (cl_start < fmt_string.size());
+                fwrite_unlocked(line, 1, next - line, info->file);
 
-        // success
-        r = count;
+                // a line that ends here, or is empty, leaves us at the start of a line
+                info->newline = eol != nullptr || next == line;
+                line = next;
+        } while (line < end);
 
- exit_func:
-        // setup for the next call
-        info->newline = newline;
-        va_end(ap);
         funlockfile(info->file);
-        return r;
+
+        if (msg != buf)
+                free(msg);
+
+        return len;
 }
@@ -67,22 +67,85 @@ extern "C" {
         __attribute__((format(printf, 2, 3)))
         int bsg_pr_prefix(const char *prefix, const char *fmt, ...);
 
-
+/*
+ * Log levels. A message is printed if its level is compiled in
+ * (at most BSG_LOG_LEVEL_MAX) and enabled at runtime (at most
+ * bsg_log_level). Both checks happen before any argument is evaluated.
+ */
+#define BSG_LOG_LEVEL_NONE  0
+#define BSG_LOG_LEVEL_ERROR 1
+#define BSG_LOG_LEVEL_WARN  2
+#define BSG_LOG_LEVEL_INFO  3
+#define BSG_LOG_LEVEL_DEBUG 4
+
+/* debug messages are only compiled into objects built with -DDEBUG */
+#ifndef BSG_LOG_LEVEL_MAX
 #if defined(DEBUG)
+#define BSG_LOG_LEVEL_MAX BSG_LOG_LEVEL_DEBUG
+#else
+#define BSG_LOG_LEVEL_MAX BSG_LOG_LEVEL_INFO
+#endif
+#endif
+
+/*
+ * Subsystems. Debug messages are also filtered by bsg_log_mask; a
+ * source file selects its subsystem by defining BSG_LOG_SUBSYSTEM
+ * before including this header.
+ */
+#define BSG_LOG_GENERAL (1u << 0)
+#define BSG_LOG_PACKET  (1u << 1)
+#define BSG_LOG_LOADER  (1u << 2)
+#define BSG_LOG_CUDA    (1u << 3)
+#define BSG_LOG_EVA     (1u << 4)
+#define BSG_LOG_DMA     (1u << 5)
+#define BSG_LOG_ALL     (~0u)
+
+#ifndef BSG_LOG_SUBSYSTEM
+#define BSG_LOG_SUBSYSTEM BSG_LOG_GENERAL
+#endif
+
+        /*
+         * Runtime filters, initialized from the environment variables
+         * BSG_LOG_LEVEL ("error", "warn", "info", "debug" or a number) and
+         * BSG_LOG_MASK (a comma-separated list of "general", "packet",
+         * "loader", "cuda", "eva", "dma", "all", or a number). By default
+         * everything that is compiled in is printed.
+         */
+        extern int bsg_log_level;
+        extern unsigned bsg_log_mask;
+
+        static inline void bsg_log_set_level(int level) { bsg_log_level = level; }
+        static inline void bsg_log_set_mask(unsigned mask) { bsg_log_mask = mask; }
+
+#define bsg_log_enabled(level, subsystem)                               \
+        ((level) <= BSG_LOG_LEVEL_MAX && (level) <= bsg_log_level &&     \
+         ((level) < BSG_LOG_LEVEL_DEBUG || (bsg_log_mask & (subsystem))))
+
+#define bsg_log(level, subsystem, prefix, fmt, ...)                     \
+        do {                                                            \
+                if (bsg_log_enabled(level, subsystem))                  \
+                        bsg_pr_prefix(prefix, fmt, ##__VA_ARGS__);      \
+        } while (0)
+
+#if BSG_LOG_LEVEL_MAX >= BSG_LOG_LEVEL_DEBUG
 #define bsg_pr_dbg(fmt, ...)                                            \
-        bsg_pr_prefix(BSG_PRINT_PREFIX_DEBUG, fmt, ##__VA_ARGS__)
+        bsg_log(BSG_LOG_LEVEL_DEBUG, BSG_LOG_SUBSYSTEM,                 \
+                BSG_PRINT_PREFIX_DEBUG, fmt, ##__VA_ARGS__)
 #else
 #define bsg_pr_dbg(...)
 #endif
 
 #define bsg_pr_err(fmt, ...)                                            \
-        bsg_pr_prefix(BSG_PRINT_PREFIX_ERROR, fmt, ##__VA_ARGS__)
+        bsg_log(BSG_LOG_LEVEL_ERROR, BSG_LOG_SUBSYSTEM,                 \
+                BSG_PRINT_PREFIX_ERROR, fmt, ##__VA_ARGS__)
 
 #define bsg_pr_warn(fmt, ...)                                           \
-        bsg_pr_prefix(BSG_PRINT_PREFIX_WARN, fmt, ##__VA_ARGS__)
+        bsg_log(BSG_LOG_LEVEL_WARN, BSG_LOG_SUBSYSTEM,                  \
+                BSG_PRINT_PREFIX_WARN, fmt, ##__VA_ARGS__)
 
 #define bsg_pr_info(fmt, ...)                                           \
-        bsg_pr_prefix(BSG_PRINT_PREFIX_INFO, fmt, ##__VA_ARGS__)
+        bsg_log(BSG_LOG_LEVEL_INFO, BSG_LOG_SUBSYSTEM,                  \
+                BSG_PRINT_PREFIX_INFO, fmt, ##__VA_ARGS__)
 
 
 #if defined(__cplusplus)
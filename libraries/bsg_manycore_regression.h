@@ -1,7 +1,11 @@
 #pragma once
+#include <bsg_manycore.h>
 #include <bsg_manycore_printing.h>
 #include <bsg_manycore_errno.h>
 #include <argp.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -42,6 +46,18 @@ extern "C" {
 #define bsg_pr_test_pass_fail(success_condition)                        \
         printf("BSG REGRESSION TEST %s\n", ((success_condition) ? BSG_GREEN("PASSED") : BSG_RED("FAILED")))
 
+/**
+ * bsg_pr_test_cycles() prints the device cycles counted up to the last hb_mc_manycore_exit(),
+ * for regression drivers such as examples/regression.py. Set HB_MC_REPORT_CYCLES to enable it.
+ */
+#define bsg_pr_test_cycles()                                            \
+        do {                                                            \
+                uint64_t cycles;                                        \
+                if (getenv("HB_MC_REPORT_CYCLES") != NULL &&            \
+                    hb_mc_manycore_get_exit_cycle(&cycles) == HB_MC_SUCCESS) \
+                        printf("BSG REGRESSION CYCLES %" PRIu64 "\n", cycles); \
+        } while (0)
+
 
 /****************************/
 /* Array comparison helpers */
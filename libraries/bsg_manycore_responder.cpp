@@ -27,13 +27,84 @@
 
 #include <bsg_manycore_responder.h>
 #include <bsg_manycore_errno.h>
+#include <algorithm>
 #include <list>
+#include <unordered_map>
+#include <vector>
 #include <stdint.h>
 
 typedef std::list<hb_mc_responder_t *> responder_list;
 
 static responder_list *responders = nullptr;
 
+/*
+ * Responders are looked up through a dispatch table compiled from their
+ * packet IDs. IDs that match a single EPA are hashed by that EPA; IDs
+ * with a partial address mask are kept aside and tried for every packet.
+ * Each bucket lists its candidates in responder order, with the masked
+ * IDs already merged in, so a packet costs one hash lookup and a scan
+ * of the few IDs that could match it.
+ */
+typedef struct responder_dispatch_entry {
+        size_t order;                          //!< position of the responder in the list
+        hb_mc_responder_t *responder;
+        const hb_mc_request_packet_id_t *id;
+} responder_dispatch_entry_t;
+
+typedef std::vector<responder_dispatch_entry_t> responder_dispatch_bucket;
+
+typedef struct responder_dispatch_table {
+        std::unordered_map<hb_mc_epa_t, responder_dispatch_bucket> by_epa;
+        responder_dispatch_bucket masked;      //!< candidates for EPAs without a bucket
+        bool invalid;                          //!< a responder has no respond function
+        bool stale;                            //!< responders were added or removed
+} responder_dispatch_table_t;
+
+static responder_dispatch_table_t dispatch = { {}, {}, false, true };
+
+static bool responder_dispatch_entry_before(const responder_dispatch_entry_t &a,
+                                            const responder_dispatch_entry_t &b)
+{
+        return a.order < b.order;
+}
+
+static void hb_mc_responders_build_dispatch(void)
+{
+        dispatch.by_epa.clear();
+        dispatch.masked.clear();
+        dispatch.invalid = false;
+        dispatch.stale = false;
+
+        if (responders == nullptr)
+                return;
+
+        size_t order = 0;
+        for (auto responder : *responders) {
+                if (responder->respond == nullptr)
+                        dispatch.invalid = true;
+
+                if (responder->ids == nullptr)
+                        continue; // no ids
+
+                for (const hb_mc_request_packet_id_t *id = responder->ids;
+                     id->init != 0;
+                     id++) {
+                        responder_dispatch_entry_t entry = {order, responder, id};
+                        if (id->id_addr.a_mask == UINT32_MAX)
+                                dispatch.by_epa[id->id_addr.a_value].push_back(entry);
+                        else
+                                dispatch.masked.push_back(entry);
+                }
+                order++;
+        }
+
+        for (auto &it : dispatch.by_epa) {
+                responder_dispatch_bucket &bucket = it.second;
+                bucket.insert(bucket.end(), dispatch.masked.begin(), dispatch.masked.end());
+                std::stable_sort(bucket.begin(), bucket.end(), responder_dispatch_entry_before);
+        }
+}
+
 int hb_mc_responder_init(hb_mc_responder_t *responder, hb_mc_manycore_t *mc)
 {
         int err;
@@ -49,6 +120,8 @@ int hb_mc_responder_init(hb_mc_responder_t *responder, hb_mc_manycore_t *mc)
 
 int hb_mc_responders_init(hb_mc_manycore_t *mc)
 {
+        hb_mc_responders_build_dispatch();
+
         if (responders == nullptr)
                 return HB_MC_SUCCESS; //  no responders
 
@@ -96,42 +169,34 @@ int hb_mc_responders_quit(hb_mc_manycore_t *mc)
         return HB_MC_SUCCESS;
 }
 
-static int hb_mc_responder_respond(hb_mc_responder_t *responder,
-                                   hb_mc_manycore_t *mc,
-                                   const hb_mc_request_packet_t *rqst)
+int hb_mc_responders_respond(hb_mc_manycore_t *mc, const hb_mc_request_packet_t *rqst)
 {
         int err;
 
-        if (responder->respond == nullptr)
-                return HB_MC_INVALID; // no respond
-
-        if (responder->ids == nullptr)
-                return HB_MC_SUCCESS; // no ids
+        if (dispatch.stale)
+                hb_mc_responders_build_dispatch();
 
-        for (hb_mc_request_packet_id_t *id = responder->ids;
-             id->init != 0;
-             id++) {
-                if (hb_mc_request_packet_is_match(rqst, id) == 1)
-                        return responder->respond(responder, mc, rqst);
-        }
+        if (dispatch.invalid)
+                return HB_MC_INVALID; // no respond
 
-        return HB_MC_SUCCESS;
-}
+        auto it = dispatch.by_epa.find(hb_mc_request_packet_get_epa(rqst));
+        const responder_dispatch_bucket &bucket =
+                it != dispatch.by_epa.end() ? it->second : dispatch.masked;
 
-int hb_mc_responders_respond(hb_mc_manycore_t *mc, const hb_mc_request_packet_t *rqst)
-{
-        int err;
+        // each responder responds at most once, to its first matching id
+        const hb_mc_responder_t *responded = nullptr;
+        for (const responder_dispatch_entry_t &entry : bucket) {
+                if (entry.responder == responded)
+                        continue;
 
-        if (responders == nullptr)
-                return HB_MC_SUCCESS; // no responders
+                if (hb_mc_request_packet_is_match(rqst, entry.id) != 1)
+                        continue;
 
-        for (auto it = responders->begin();
-             it != responders->end();
-             it++) {
-                auto responder = *it;
-                err = hb_mc_responder_respond(responder, mc, rqst);
+                err = entry.responder->respond(entry.responder, mc, rqst);
                 if (err != HB_MC_SUCCESS)
                         return err;
+
+                responded = entry.responder;
         }
         return HB_MC_SUCCESS;
 }
@@ -143,6 +208,7 @@ int hb_mc_responder_add(hb_mc_responder_t *responder)
                 responders = new responder_list;
 
         responders->push_front(responder);
+        dispatch.stale = true;
         return HB_MC_SUCCESS;
 }
 
@@ -152,5 +218,6 @@ int hb_mc_responder_del(hb_mc_responder_t *responder)
                 return HB_MC_FAIL;
 
         responders->remove(responder);
+        dispatch.stale = true;
         return HB_MC_SUCCESS;
 }
@@ -77,6 +77,8 @@ extern "C" {
         /**
          * Initialze all registered responders.
          * This function is generally called from within the manycore init interface.
+         * It also compiles the packet IDs of all responders into the table
+         * hb_mc_responders_respond() uses to find the responders for a packet.
          * @param[in] mc  A manycore.
          * @return HB_MC_SUCCESS if succesful. An error code otherwise.
          */
@@ -0,0 +1,232 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_responder_output.h>
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_printing.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <unistd.h>
+
+typedef struct hb_mc_responder_output_line {
+        size_t len;
+        char buf[HB_MC_RESPONDER_OUTPUT_LINE_MAX];
+} hb_mc_responder_output_line_t;
+
+/*
+ * The ring is single-producer, single-consumer: the receiving thread
+ * advances #head and whoever writes to the stream advances #tail. Both
+ * count bytes since creation and are masked to index the ring.
+ */
+struct hb_mc_responder_output {
+        FILE *f;
+        int refs;
+        char *ring;
+        std::atomic<uint64_t> head;
+        std::atomic<uint64_t> tail;
+        std::unordered_map<uint64_t, hb_mc_responder_output_line_t> lines; //!< Unfinished line of each tile
+        std::thread writer;
+        std::atomic<bool> stop;
+        bool threaded;
+};
+
+static std::unordered_map<FILE*, hb_mc_responder_output_t*> *outputs = nullptr;
+
+static const uint64_t ring_mask = HB_MC_RESPONDER_OUTPUT_RING_SIZE - 1;
+
+/* write out everything in the ring; returns the number of bytes written */
+static uint64_t hb_mc_responder_output_drain(hb_mc_responder_output_t *out)
+{
+        uint64_t tail = out->tail.load(std::memory_order_relaxed);
+        uint64_t head = out->head.load(std::memory_order_acquire);
+        uint64_t n = head - tail;
+
+        while (tail != head) {
+                size_t seg = std::min(head - tail, HB_MC_RESPONDER_OUTPUT_RING_SIZE - (tail & ring_mask));
+                fwrite(&out->ring[tail & ring_mask], 1, seg, out->f);
+                tail += seg;
+        }
+
+        if (n > 0)
+                out->tail.store(tail, std::memory_order_release);
+
+        return n;
+}
+
+static void hb_mc_responder_output_writer(hb_mc_responder_output_t *out)
+{
+        while (true) {
+                bool stop = out->stop.load(std::memory_order_acquire);
+                if (hb_mc_responder_output_drain(out) == 0) {
+                        if (stop)
+                                break;
+                        usleep(100);
+                }
+        }
+}
+
+/* copy #len bytes into the ring, waiting for space if it is full */
+static void hb_mc_responder_output_push(hb_mc_responder_output_t *out,
+                                        const char *buf, size_t len)
+{
+        while (len > 0) {
+                uint64_t head = out->head.load(std::memory_order_relaxed);
+                uint64_t space = HB_MC_RESPONDER_OUTPUT_RING_SIZE -
+                        (head - out->tail.load(std::memory_order_acquire));
+
+                if (space == 0) {
+                        if (out->threaded)
+                                std::this_thread::yield();
+                        else
+                                hb_mc_responder_output_drain(out);
+                        continue;
+                }
+
+                size_t n = std::min<uint64_t>(len, space);
+                size_t seg = std::min<uint64_t>(n, HB_MC_RESPONDER_OUTPUT_RING_SIZE - (head & ring_mask));
+                memcpy(&out->ring[head & ring_mask], buf, seg);
+                memcpy(&out->ring[0], buf + seg, n - seg);
+                out->head.store(head + n, std::memory_order_release);
+
+                buf += n;
+                len -= n;
+        }
+
+        if (!out->threaded &&
+            out->head.load(std::memory_order_relaxed) - out->tail.load(std::memory_order_relaxed)
+            >= HB_MC_RESPONDER_OUTPUT_FLUSH_BYTES)
+                hb_mc_responder_output_drain(out);
+}
+
+int hb_mc_responder_output_get(FILE *f, hb_mc_responder_output_t **out)
+{
+        if (outputs == nullptr)
+                outputs = new std::unordered_map<FILE*, hb_mc_responder_output_t*>;
+
+        auto it = outputs->find(f);
+        if (it != outputs->end()) {
+                it->second->refs++;
+                *out = it->second;
+                return HB_MC_SUCCESS;
+        }
+
+        hb_mc_responder_output_t *o = new hb_mc_responder_output_t;
+        o->f = f;
+        o->refs = 1;
+        o->head = 0;
+        o->tail = 0;
+        o->stop = false;
+        o->threaded = false;
+        o->ring = reinterpret_cast<char*>(malloc(HB_MC_RESPONDER_OUTPUT_RING_SIZE));
+        if (o->ring == nullptr) {
+                bsg_pr_err("%s: failed to allocate output buffer: %m\n", __func__);
+                delete o;
+                return HB_MC_NOMEM;
+        }
+
+        const char *env = getenv("HB_MC_RESPONDER_WRITER_THREAD");
+        o->threaded = env != nullptr && atoi(env) != 0;
+        if (o->threaded)
+                o->writer = std::thread(hb_mc_responder_output_writer, o);
+
+        (*outputs)[f] = o;
+        *out = o;
+        return HB_MC_SUCCESS;
+}
+
+void hb_mc_responder_output_put(hb_mc_responder_output_t *out)
+{
+        if (--out->refs > 0)
+                return;
+
+        // emit lines that never ended
+        for (auto &it : out->lines) {
+                if (it.second.len > 0)
+                        hb_mc_responder_output_push(out, it.second.buf, it.second.len);
+        }
+
+        if (out->threaded) {
+                out->stop.store(true, std::memory_order_release);
+                out->writer.join();
+        } else {
+                hb_mc_responder_output_drain(out);
+        }
+        fflush(out->f);
+
+        outputs->erase(out->f);
+        free(out->ring);
+        delete out;
+}
+
+void hb_mc_responder_output_putc(hb_mc_responder_output_t *out,
+                                 hb_mc_coordinate_t src, char c)
+{
+        uint64_t key = (static_cast<uint64_t>(src.x) << 32) | src.y;
+        hb_mc_responder_output_line_t &line = out->lines[key];
+
+        line.buf[line.len++] = c;
+        if (c == '\n' || line.len == sizeof(line.buf)) {
+                hb_mc_responder_output_push(out, line.buf, line.len);
+                line.len = 0;
+        }
+}
+
+void hb_mc_responder_output_write(hb_mc_responder_output_t *out,
+                                  const char *buf, size_t len)
+{
+        hb_mc_responder_output_push(out, buf, len);
+}
+
+void hb_mc_responder_output_flush_all(void)
+{
+        if (outputs == nullptr)
+                return;
+
+        for (auto &it : *outputs) {
+                hb_mc_responder_output_t *out = it.second;
+
+                if (out->threaded) {
+                        // wait for the writer to catch up with what is in the ring now
+                        uint64_t head = out->head.load(std::memory_order_acquire);
+                        if (out->tail.load(std::memory_order_acquire) == head)
+                                continue;
+                        while (out->tail.load(std::memory_order_acquire) < head)
+                                std::this_thread::yield();
+                } else if (hb_mc_responder_output_drain(out) == 0) {
+                        continue;
+                }
+
+                // the host print may go to another stream
+                fflush(out->f);
+        }
+}
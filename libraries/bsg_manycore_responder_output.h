@@ -0,0 +1,115 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/* Buffered output for responders that print on behalf of the manycore */
+#ifndef BSG_MANYCORE_RESPONDER_OUTPUT_H
+#define BSG_MANYCORE_RESPONDER_OUTPUT_H
+#include <bsg_manycore_features.h>
+#include <bsg_manycore_coordinate.h>
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstddef>
+#else
+#include <stdio.h>
+#include <stddef.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* the longest line buffered for a single tile before it is emitted */
+#define HB_MC_RESPONDER_OUTPUT_LINE_MAX  256
+/* bytes held for each stream before they are written */
+#define HB_MC_RESPONDER_OUTPUT_RING_SIZE (1 << 20)
+/* without a writer thread, the ring is written out once it holds this many bytes */
+#define HB_MC_RESPONDER_OUTPUT_FLUSH_BYTES 4096
+
+        /**
+         * Output to a stdio stream from responders.
+         *
+         * Responders run inside the host receive loop, so they only copy
+         * text into a ring buffer, a line per tile at a time. The
+         * receiving thread writes the ring to the stream once it holds
+         * HB_MC_RESPONDER_OUTPUT_FLUSH_BYTES, before each host print
+         * (see hb_mc_responder_output_flush_all()), and when the last
+         * responder quits. With the environment variable
+         * HB_MC_RESPONDER_WRITER_THREAD set to a non-zero value, a
+         * background writer thread does the writing instead. All
+         * responders writing to one stream share its ring, so their output
+         * stays in order.
+         */
+        typedef struct hb_mc_responder_output hb_mc_responder_output_t;
+
+        /**
+         * Get the output for a stream, creating it on first use.
+         * Each call must be paired with hb_mc_responder_output_put().
+         * @param[in]  f    A stdio stream
+         * @param[out] out  Set to the output for #f
+         * @return HB_MC_SUCCESS if succesful. An error code otherwise.
+         */
+        __attribute__((warn_unused_result))
+        int hb_mc_responder_output_get(FILE *f, hb_mc_responder_output_t **out);
+
+        /**
+         * Release an output. The last release writes out everything buffered.
+         * @param[in]  out  An output returned by hb_mc_responder_output_get()
+         */
+        void hb_mc_responder_output_put(hb_mc_responder_output_t *out);
+
+        /**
+         * Append a character to the current line of a tile.
+         * The line is emitted when it ends or reaches HB_MC_RESPONDER_OUTPUT_LINE_MAX.
+         * @param[in]  out  An output returned by hb_mc_responder_output_get()
+         * @param[in]  src  The tile that sent the character
+         * @param[in]  c    The character
+         */
+        void hb_mc_responder_output_putc(hb_mc_responder_output_t *out,
+                                         hb_mc_coordinate_t src, char c);
+
+        /**
+         * Emit complete text, such as a formatted line.
+         * @param[in]  out  An output returned by hb_mc_responder_output_get()
+         * @param[in]  buf  The text
+         * @param[in]  len  The number of bytes in #buf
+         */
+        void hb_mc_responder_output_write(hb_mc_responder_output_t *out,
+                                          const char *buf, size_t len);
+
+        /**
+         * Write out and flush the lines emitted to all outputs so far.
+         * Called by the bsg_pr_* functions, so that a host print comes
+         * after the device output that preceded it. Lines a tile has not
+         * finished stay buffered.
+         */
+        void hb_mc_responder_output_flush_all(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
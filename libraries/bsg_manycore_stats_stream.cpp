@@ -0,0 +1,251 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#define BSG_LOG_SUBSYSTEM BSG_LOG_CUDA
+#include <bsg_manycore_stats_stream.h>
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_printing.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// records are small: buffer many of them per write
+#define HB_MC_STATS_STREAM_BUFFER (1 << 20)
+
+typedef struct hb_mc_stats_stream {
+        FILE                             *f;
+        std::string                       path;
+        std::vector<char>                 buf;
+        std::vector<hb_mc_tile_icount_t>  tiles;  // reused by every snapshot
+        bool                              icount; // does the platform have a profiler?
+} hb_mc_stats_stream_t;
+
+static hb_mc_stats_stream_t *hb_mc_stats_stream(hb_mc_device_t *device)
+{
+        return reinterpret_cast<hb_mc_stats_stream_t*>(device->stats_stream);
+}
+
+static int hb_mc_stats_stream_write(hb_mc_stats_stream_t *s, uint32_t type,
+                                    const void *payload, uint32_t size,
+                                    const void *extra, uint32_t extra_size)
+{
+        hb_mc_stats_record_header_t hdr;
+        hdr.type = type;
+        hdr.size = size + extra_size;
+
+        if (fwrite(&hdr, sizeof(hdr), 1, s->f) != 1 ||
+            fwrite(payload, size, 1, s->f) != 1 ||
+            (extra_size > 0 && fwrite(extra, extra_size, 1, s->f) != 1)) {
+                bsg_pr_err("%s: failed to write '%s': %s\n",
+                           __func__, s->path.c_str(), strerror(errno));
+                return HB_MC_FAIL;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/*
+ * Read the cycle counter and the instructions executed so far by the
+ * tiles of #tg
+ */
+static int hb_mc_stats_stream_sample(hb_mc_device_t *device, hb_mc_stats_stream_t *s,
+                                     const hb_mc_tile_group_t *tg, uint64_t *cycle,
+                                     uint64_t *icount, uint32_t *tiles)
+{
+        hb_mc_icount_snapshot_t snap;
+        int err;
+
+        memset(icount, 0, sizeof(*icount) * HB_MC_INSTR_TYPES);
+        *tiles = 0;
+
+        if (!s->icount) {
+                if (hb_mc_manycore_get_cycle(device->mc, cycle) != HB_MC_SUCCESS)
+                        *cycle = 0;
+                return HB_MC_SUCCESS;
+        }
+
+        snap.tiles = s->tiles.data();
+        snap.cap = s->tiles.size();
+        err = hb_mc_manycore_get_icount_snapshot(device->mc, &snap);
+        if (err == HB_MC_NOMEM) {
+                // first snapshot: size the buffer once
+                s->tiles.resize(snap.n_tiles);
+                snap.tiles = s->tiles.data();
+                snap.cap = s->tiles.size();
+                err = hb_mc_manycore_get_icount_snapshot(device->mc, &snap);
+        }
+
+        if (err == HB_MC_NOIMPL) {
+                bsg_pr_warn("%s: No profiler on this platform, recording cycles only\n",
+                            __func__);
+                s->icount = false;
+                return hb_mc_stats_stream_sample(device, s, tg, cycle, icount, tiles);
+        } else if (err != HB_MC_SUCCESS) {
+                return err;
+        }
+
+        *cycle = snap.cycle;
+        for (size_t i = 0; i < snap.n_tiles; i++) {
+                const hb_mc_tile_icount_t *t = &snap.tiles[i];
+                if (t->coord.x <  tg->origin.x ||
+                    t->coord.x >= tg->origin.x + tg->dim.x ||
+                    t->coord.y <  tg->origin.y ||
+                    t->coord.y >= tg->origin.y + tg->dim.y)
+                        continue;
+
+                for (int itype = 0; itype < HB_MC_INSTR_TYPES; itype++)
+                        icount[itype] += t->icount[itype];
+                (*tiles)++;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+int hb_mc_device_stats_stream_open(hb_mc_device_t *device, const char *path)
+{
+        hb_mc_device_stats_stream_close(device);
+
+        hb_mc_stats_stream_t *s = new hb_mc_stats_stream_t();
+        s->path = path;
+        s->icount = true;
+        s->f = fopen(path, "wb");
+        if (s->f == NULL) {
+                bsg_pr_err("%s: failed to open '%s': %s\n", __func__, path, strerror(errno));
+                delete s;
+                return HB_MC_FAIL;
+        }
+
+        s->buf.resize(HB_MC_STATS_STREAM_BUFFER);
+        setvbuf(s->f, s->buf.data(), _IOFBF, s->buf.size());
+
+        hb_mc_stats_stream_header_t hdr;
+        hdr.magic = HB_MC_STATS_STREAM_MAGIC;
+        hdr.version = HB_MC_STATS_STREAM_VERSION;
+        if (fwrite(&hdr, sizeof(hdr), 1, s->f) != 1) {
+                bsg_pr_err("%s: failed to write '%s': %s\n", __func__, path, strerror(errno));
+                fclose(s->f);
+                delete s;
+                return HB_MC_FAIL;
+        }
+
+        device->stats_stream = s;
+        return HB_MC_SUCCESS;
+}
+
+void hb_mc_device_stats_stream_close(hb_mc_device_t *device)
+{
+        hb_mc_stats_stream_t *s = hb_mc_stats_stream(device);
+        if (s == NULL)
+                return;
+
+        if (fclose(s->f) != 0)
+                bsg_pr_err("%s: failed to write '%s': %s\n",
+                           __func__, s->path.c_str(), strerror(errno));
+
+        delete s;
+        device->stats_stream = NULL;
+}
+
+int hb_mc_device_stats_stream_init(hb_mc_device_t *device)
+{
+        device->stats_stream = NULL;
+
+        const char *path = getenv("HB_MC_STATS_STREAM");
+        if (path == NULL || *path == '\0')
+                return HB_MC_SUCCESS;
+
+        return hb_mc_device_stats_stream_open(device, path);
+}
+
+int hb_mc_device_stats_stream_kernel(hb_mc_device_t *device, hb_mc_pod_id_t pod,
+                                     const hb_mc_kernel_t *kernel,
+                                     hb_mc_dimension_t grid_dim,
+                                     hb_mc_dimension_t tg_dim)
+{
+        hb_mc_stats_stream_t *s = hb_mc_stats_stream(device);
+        if (s == NULL)
+                return HB_MC_SUCCESS;
+
+        hb_mc_stats_kernel_record_t rec;
+        rec.launch = kernel->launch;
+        rec.pod = pod;
+        rec.grid_x = grid_dim.x;
+        rec.grid_y = grid_dim.y;
+        rec.tg_x = tg_dim.x;
+        rec.tg_y = tg_dim.y;
+        rec.name_len = strlen(kernel->name);
+
+        return hb_mc_stats_stream_write(s, HB_MC_STATS_RECORD_KERNEL, &rec, sizeof(rec),
+                                        kernel->name, rec.name_len);
+}
+
+int hb_mc_device_stats_stream_tile_group_launch(hb_mc_device_t *device,
+                                                hb_mc_tile_group_t *tg)
+{
+        hb_mc_stats_stream_t *s = hb_mc_stats_stream(device);
+        uint32_t tiles;
+
+        if (s == NULL)
+                return HB_MC_SUCCESS;
+
+        return hb_mc_stats_stream_sample(device, s, tg, &tg->start_cycle,
+                                         tg->start_icount, &tiles);
+}
+
+int hb_mc_device_stats_stream_tile_group_finish(hb_mc_device_t *device, hb_mc_pod_id_t pod,
+                                                const hb_mc_tile_group_t *tg)
+{
+        hb_mc_stats_stream_t *s = hb_mc_stats_stream(device);
+        hb_mc_stats_tile_group_record_t rec;
+        int err;
+
+        if (s == NULL)
+                return HB_MC_SUCCESS;
+
+        err = hb_mc_stats_stream_sample(device, s, tg, &rec.end_cycle, rec.icount, &rec.tiles);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        rec.launch = tg->kernel->launch;
+        rec.pod = pod;
+        rec.id_x = tg->id.x;
+        rec.id_y = tg->id.y;
+        rec.origin_x = tg->origin.x;
+        rec.origin_y = tg->origin.y;
+        rec.dim_x = tg->dim.x;
+        rec.dim_y = tg->dim.y;
+        rec.start_cycle = tg->start_cycle;
+        for (int itype = 0; itype < HB_MC_INSTR_TYPES; itype++)
+                rec.icount[itype] -= tg->start_icount[itype];
+
+        return hb_mc_stats_stream_write(s, HB_MC_STATS_RECORD_TILE_GROUP, &rec, sizeof(rec),
+                                        NULL, 0);
+}
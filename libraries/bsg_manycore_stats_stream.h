@@ -0,0 +1,161 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/* Stream per-tile-group instruction counts and cycles to a compact binary file */
+#ifndef BSG_MANYCORE_STATS_STREAM_H
+#define BSG_MANYCORE_STATS_STREAM_H
+#include <bsg_manycore_features.h>
+#include <bsg_manycore.h>
+#include <bsg_manycore_cuda.h>
+#ifdef __cplusplus
+#include <cstdint>
+#else
+#include <stdint.h>
+#endif
+
+/*
+ * A stats stream is a header followed by records, each a
+ * hb_mc_stats_record_header_t and #size bytes of payload. Fields are
+ * in host byte order. Readers skip record types they don't know.
+ *
+ * The runtime writes a kernel record when a kernel is enqueued, and
+ * a tile group record when each tile group retires. Tile group
+ * records carry the device cycles between launch and retirement and
+ * the instructions executed by the tile group's tiles over that
+ * interval, read with hb_mc_manycore_get_icount_snapshot().
+ *
+ * Instruction counts come from the simulated vanilla core profilers
+ * of pod 0. Elsewhere (FPGAs, other pods, machines built without vcore
+ * profiling) #tiles and #icount are zero. The counters are sampled by
+ * the host when it launches and retires the tile group, so #icount
+ * and the cycles include whatever the tiles and the host did in
+ * between, such as the host's polling latency, not just the kernel.
+ *
+ * There are no vcache counters: the host has no interface to read
+ * them, as the simulated vcache profiler only writes its own logs.
+ * They would go in a new record type, which older readers skip.
+ *
+ * Set HB_MC_STATS_STREAM to a path to record a stream without
+ * changing the host program, and read it back with
+ * hb_mc_stats_reader (see libraries/tools).
+ */
+#define HB_MC_STATS_STREAM_MAGIC   0x54534248 // "HBST"
+#define HB_MC_STATS_STREAM_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+        typedef struct {
+                uint32_t magic;
+                uint32_t version;
+        } hb_mc_stats_stream_header_t;
+
+        typedef enum {
+                HB_MC_STATS_RECORD_KERNEL     = 1,
+                HB_MC_STATS_RECORD_TILE_GROUP = 2,
+        } hb_mc_stats_record_type_t;
+
+        typedef struct {
+                uint32_t type; //!< A hb_mc_stats_record_type_t
+                uint32_t size; //!< Bytes of payload that follow
+        } hb_mc_stats_record_header_t;
+
+        /* followed by name_len bytes of kernel name, not NUL-terminated */
+        typedef struct {
+                uint32_t launch;  //!< Device-wide launch index
+                uint32_t pod;
+                uint32_t grid_x;
+                uint32_t grid_y;
+                uint32_t tg_x;
+                uint32_t tg_y;
+                uint32_t name_len;
+        } hb_mc_stats_kernel_record_t;
+
+        typedef struct {
+                uint32_t launch;      //!< Launch index of the tile group's kernel
+                uint32_t pod;
+                uint16_t id_x;
+                uint16_t id_y;
+                uint16_t origin_x;
+                uint16_t origin_y;
+                uint16_t dim_x;
+                uint16_t dim_y;
+                uint32_t tiles;       //!< Tiles found in the instruction count snapshots
+                uint64_t start_cycle;
+                uint64_t end_cycle;
+                uint64_t icount[HB_MC_INSTR_TYPES]; //!< Indexed by bsg_instr_type_e
+        } hb_mc_stats_tile_group_record_t;
+
+        /**
+         * Start recording a stats stream for a device
+         * @param[in] device  A device initialized with hb_mc_device_init()
+         * @param[in] path    The file to write. An existing file is truncated.
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_device_stats_stream_open(hb_mc_device_t *device, const char *path);
+
+        /**
+         * Flush and stop recording the stats stream of a device, if any
+         * Called by hb_mc_device_finish().
+         * @param[in] device  A device initialized with hb_mc_device_init()
+         */
+        void hb_mc_device_stats_stream_close(hb_mc_device_t *device);
+
+        /**
+         * Start recording to $HB_MC_STATS_STREAM, if it is set
+         * Called by hb_mc_device_init().
+         */
+        int hb_mc_device_stats_stream_init(hb_mc_device_t *device);
+
+        /**
+         * Record a kernel enqueued on a pod
+         * Called when a kernel is enqueued.
+         */
+        int hb_mc_device_stats_stream_kernel(hb_mc_device_t *device, hb_mc_pod_id_t pod,
+                                             const hb_mc_kernel_t *kernel,
+                                             hb_mc_dimension_t grid_dim,
+                                             hb_mc_dimension_t tg_dim);
+
+        /**
+         * Note the counters at the start of a tile group
+         * Called when a tile group is launched.
+         */
+        int hb_mc_device_stats_stream_tile_group_launch(hb_mc_device_t *device,
+                                                        hb_mc_tile_group_t *tg);
+
+        /**
+         * Record a tile group that finished
+         * Called when a tile group is retired.
+         */
+        int hb_mc_device_stats_stream_tile_group_finish(hb_mc_device_t *device, hb_mc_pod_id_t pod,
+                                                        const hb_mc_tile_group_t *tg);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
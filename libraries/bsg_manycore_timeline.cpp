@@ -0,0 +1,290 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_timeline.h>
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_printing.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+typedef struct {
+        std::string            name;
+        const char            *cat;
+        int                    pid;
+        int                    tid;
+        hb_mc_timeline_stamp_t begin;
+        hb_mc_timeline_stamp_t end;
+} hb_mc_timeline_span_t;
+
+/*
+ * Spans recorded by one host thread. Only the owning thread appends,
+ * so its lock is uncontended except while the timeline is closed.
+ */
+typedef struct {
+        std::mutex                         lock;     // guards spans
+        int                                index;
+        bool                               orphaned; // owner exited; guarded by timeline_lock
+        std::vector<hb_mc_timeline_span_t> spans;
+} hb_mc_timeline_buffer_t;
+
+static std::atomic<int> timeline_on(0);
+static std::mutex timeline_lock; // guards everything below
+static std::vector<hb_mc_timeline_buffer_t*> timeline_buffers;
+static int timeline_threads;
+static std::string timeline_path;
+static uint64_t timeline_origin_ns;
+
+/*
+ * A thread's buffer lives until the thread exits and the next close
+ * has written it out, so a record racing a close never sees it freed.
+ */
+struct hb_mc_timeline_local_t {
+        hb_mc_timeline_buffer_t *buffer = nullptr;
+        ~hb_mc_timeline_local_t() {
+                if (buffer == nullptr)
+                        return;
+                std::lock_guard<std::mutex> guard(timeline_lock);
+                buffer->orphaned = true;
+        }
+};
+
+static thread_local hb_mc_timeline_local_t local;
+
+static uint64_t hb_mc_timeline_now_ns(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static hb_mc_timeline_buffer_t *hb_mc_timeline_local_buffer(void)
+{
+        if (local.buffer != nullptr)
+                return local.buffer;
+
+        // first span from this thread
+        std::lock_guard<std::mutex> guard(timeline_lock);
+        hb_mc_timeline_buffer_t *b = new hb_mc_timeline_buffer_t();
+        b->index = timeline_threads++;
+        b->orphaned = false;
+        b->spans.reserve(1024);
+        timeline_buffers.push_back(b);
+
+        local.buffer = b;
+        return b;
+}
+
+int hb_mc_timeline_enabled(void)
+{
+        return timeline_on.load(std::memory_order_relaxed);
+}
+
+void hb_mc_timeline_stamp(hb_mc_manycore_t *mc, hb_mc_timeline_stamp_t *stamp)
+{
+        stamp->ns = hb_mc_timeline_now_ns();
+        if (mc == nullptr || hb_mc_manycore_get_cycle(mc, &stamp->cycle) != HB_MC_SUCCESS)
+                stamp->cycle = 0;
+}
+
+void hb_mc_timeline_record(const char *name, const char *cat, int pid, int tid,
+                           const hb_mc_timeline_stamp_t *begin,
+                           const hb_mc_timeline_stamp_t *end)
+{
+        if (!hb_mc_timeline_enabled())
+                return;
+
+        hb_mc_timeline_buffer_t *b = hb_mc_timeline_local_buffer();
+        std::lock_guard<std::mutex> guard(b->lock);
+
+        // closed since the check above: the span would outlive its timeline
+        if (!hb_mc_timeline_enabled())
+                return;
+
+        hb_mc_timeline_span_t span;
+        span.name = name;
+        span.cat = cat;
+        span.pid = pid;
+        span.tid = tid == HB_MC_TIMELINE_THREAD_TID ? b->index : tid;
+        span.begin = *begin;
+        span.end = *end;
+        b->spans.push_back(std::move(span));
+}
+
+int hb_mc_timeline_open(const char *path)
+{
+        std::lock_guard<std::mutex> guard(timeline_lock);
+        if (hb_mc_timeline_enabled())
+                return HB_MC_SUCCESS;
+
+        timeline_path = path;
+        timeline_origin_ns = hb_mc_timeline_now_ns();
+        timeline_on.store(1, std::memory_order_release);
+        return HB_MC_SUCCESS;
+}
+
+int hb_mc_timeline_init(void)
+{
+        const char *path = getenv("HB_MC_TIMELINE");
+        if (path == NULL || *path == '\0')
+                return HB_MC_SUCCESS;
+
+        return hb_mc_timeline_open(path);
+}
+
+static void hb_mc_timeline_write_string(FILE *f, const char *s)
+{
+        fputc('"', f);
+        for (; *s; s++) {
+                if (*s == '"' || *s == '\\')
+                        fprintf(f, "\\%c", *s);
+                else if ((unsigned char)*s < 0x20)
+                        fprintf(f, "\\u%04x", *s);
+                else
+                        fputc(*s, f);
+        }
+        fputc('"', f);
+}
+
+static void hb_mc_timeline_write_span(FILE *f, const hb_mc_timeline_span_t *s, bool first)
+{
+        // a span begun before the timeline opened starts at its origin
+        uint64_t begin_ns = std::max(s->begin.ns, timeline_origin_ns);
+
+        fprintf(f, "%s\n{\"name\":", first ? "" : ",");
+        hb_mc_timeline_write_string(f, s->name.c_str());
+        fprintf(f, ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d"
+                ",\"ts\":%.3f,\"dur\":%.3f"
+                ",\"args\":{\"begin_cycle\":%" PRIu64 ",\"end_cycle\":%" PRIu64 "}}",
+                s->cat, s->pid, s->tid,
+                (begin_ns - timeline_origin_ns) / 1000.0,
+                (s->end.ns - begin_ns) / 1000.0,
+                s->begin.cycle, s->end.cycle);
+}
+
+/* name each track that has spans */
+static void hb_mc_timeline_write_tracks(FILE *f, const std::set<std::pair<int, int>> &tracks)
+{
+        std::set<int> pids;
+        char name[64];
+
+        for (const auto &t : tracks) {
+                int pid = t.first, tid = t.second;
+
+                if (pid == HB_MC_TIMELINE_MANYCORE_PID)
+                        snprintf(name, sizeof(name), "host thread %d", tid);
+                else if (tid == HB_MC_TIMELINE_HOST_TID)
+                        snprintf(name, sizeof(name), "host");
+                else
+                        snprintf(name, sizeof(name), "tile group @ (%d,%d)",
+                                 (tid - 1) & 0xffff, (tid - 1) >> 16);
+
+                fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d"
+                        ",\"args\":{\"name\":\"%s\"}}", pid, tid, name);
+                pids.insert(pid);
+        }
+
+        for (int pid : pids) {
+                if (pid == HB_MC_TIMELINE_MANYCORE_PID)
+                        snprintf(name, sizeof(name), "manycore");
+                else
+                        snprintf(name, sizeof(name), "pod %d", pid - HB_MC_TIMELINE_POD_PID(0));
+
+                fprintf(f, ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d"
+                        ",\"args\":{\"name\":\"%s\"}}", pid, name);
+                fprintf(f, ",\n{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":%d"
+                        ",\"args\":{\"sort_index\":%d}}", pid, pid);
+        }
+}
+
+int hb_mc_timeline_close(void)
+{
+        std::lock_guard<std::mutex> guard(timeline_lock);
+        std::set<std::pair<int, int>> tracks;
+        bool first = true;
+        int err = HB_MC_SUCCESS;
+
+        if (!hb_mc_timeline_enabled())
+                return HB_MC_SUCCESS;
+
+        timeline_on.store(0, std::memory_order_release);
+
+        FILE *f = fopen(timeline_path.c_str(), "w");
+        if (f == NULL) {
+                bsg_pr_err("%s: failed to open '%s': %s\n",
+                           __func__, timeline_path.c_str(), strerror(errno));
+                err = HB_MC_FAIL;
+        } else {
+                fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+                for (hb_mc_timeline_buffer_t *b : timeline_buffers) {
+                        std::lock_guard<std::mutex> buffer_guard(b->lock);
+                        for (const hb_mc_timeline_span_t &s : b->spans) {
+                                // ended before the timeline opened
+                                if (s.end.ns < timeline_origin_ns)
+                                        continue;
+                                hb_mc_timeline_write_span(f, &s, first);
+                                tracks.insert(std::make_pair(s.pid, s.tid));
+                                first = false;
+                        }
+                }
+                if (!first)
+                        hb_mc_timeline_write_tracks(f, tracks);
+                fprintf(f, "\n]}\n");
+
+                if (fclose(f) != 0) {
+                        bsg_pr_err("%s: failed to write '%s': %s\n",
+                                   __func__, timeline_path.c_str(), strerror(errno));
+                        err = HB_MC_FAIL;
+                }
+        }
+
+        // keep the buffers of live threads, which may still hold a pointer
+        std::vector<hb_mc_timeline_buffer_t*> live;
+        for (hb_mc_timeline_buffer_t *b : timeline_buffers) {
+                if (b->orphaned) {
+                        delete b;
+                } else {
+                        std::lock_guard<std::mutex> buffer_guard(b->lock);
+                        b->spans.clear();
+                        live.push_back(b);
+                }
+        }
+        timeline_buffers.swap(live);
+
+        return err;
+}
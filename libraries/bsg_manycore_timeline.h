@@ -0,0 +1,162 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/* A timeline of host activity in Chrome trace-event format */
+#ifndef BSG_MANYCORE_TIMELINE_H
+#define BSG_MANYCORE_TIMELINE_H
+#include <bsg_manycore_features.h>
+#include <bsg_manycore.h>
+#ifdef __cplusplus
+#include <cstdint>
+#else
+#include <stdint.h>
+#endif
+
+/*
+ * While a timeline is open, instrumented runtime calls record a
+ * span with their host wall-clock begin and end times and the device
+ * cycle counter (hb_mc_manycore_get_cycle()) at both ends. Spans are
+ * appended to a buffer owned by the calling thread, behind a lock
+ * that only hb_mc_timeline_close() contends for. Close writes every
+ * buffer out as a JSON trace that chrome://tracing and Perfetto can
+ * load. Spans that began before the timeline opened are clipped to
+ * its start.
+ *
+ * Tracks are Chrome (pid, tid) pairs:
+ *   pid 0           manycore calls (memory, DMA, fence, vcache),
+ *                   one tid per host thread
+ *   pid 1 + pod     CUDA calls on a pod, tid 0, and one tid per tile
+ *                   group origin spanning launch to finish
+ *
+ * Set HB_MC_TIMELINE to a path to record a timeline from
+ * hb_mc_device_init() to hb_mc_device_finish() without changing the
+ * host program.
+ */
+#define HB_MC_TIMELINE_MANYCORE_PID 0
+#define HB_MC_TIMELINE_POD_PID(pod) (1 + (pod))
+#define HB_MC_TIMELINE_HOST_TID     0
+#define HB_MC_TIMELINE_THREAD_TID   (-1) //!< The calling thread's track
+#define HB_MC_TIMELINE_TILE_GROUP_TID(origin)                           \
+        (1 + (int)(((origin).y << 16) | (origin).x))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+        typedef struct {
+                uint64_t ns;    //!< Host monotonic time
+                uint64_t cycle; //!< Device cycle counter, or 0 if unavailable
+        } hb_mc_timeline_stamp_t;
+
+        /**
+         * Start recording a timeline. Does nothing if one is already open.
+         * @param[in]  path   Where hb_mc_timeline_close() writes the trace
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_timeline_open(const char *path);
+
+        /**
+         * Stop recording and write the trace. No other thread may be
+         * calling into the runtime.
+         * @return HB_MC_SUCCESS on success, or if no timeline is open.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_timeline_close(void);
+
+        /**
+         * Open a timeline at the path in HB_MC_TIMELINE, if it is set
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_timeline_init(void);
+
+        /**
+         * Is a timeline being recorded?
+         * @return Nonzero if a timeline is open.
+         */
+        int hb_mc_timeline_enabled(void);
+
+        /**
+         * Read the host clock and the device cycle counter
+         * @param[in]  mc     A manycore instance, or NULL to skip the cycle counter
+         * @param[out] stamp  Set to the current times
+         */
+        void hb_mc_timeline_stamp(hb_mc_manycore_t *mc, hb_mc_timeline_stamp_t *stamp);
+
+        /**
+         * Record a span on a track. Does nothing if no timeline is open.
+         * @param[in]  name   Span name; copied
+         * @param[in]  cat    Span category; must be a string literal
+         * @param[in]  pid    Track process, see HB_MC_TIMELINE_*_PID
+         * @param[in]  tid    Track thread, see HB_MC_TIMELINE_*_TID
+         * @param[in]  begin  Stamp taken when the span began
+         * @param[in]  end    Stamp taken when the span ended
+         */
+        void hb_mc_timeline_record(const char *name, const char *cat, int pid, int tid,
+                                   const hb_mc_timeline_stamp_t *begin,
+                                   const hb_mc_timeline_stamp_t *end);
+
+#ifdef __cplusplus
+}
+
+/*
+ * Records the enclosing scope as a span, so that every return path of
+ * an instrumented function is covered.
+ */
+class hb_mc_timeline_probe {
+public:
+        hb_mc_timeline_probe(hb_mc_manycore_t *mc, const char *name, const char *cat,
+                             int pid, int tid) :
+                mc(mc), name(name), cat(cat), pid(pid), tid(tid),
+                on(hb_mc_timeline_enabled()) {
+                if (on)
+                        hb_mc_timeline_stamp(mc, &begin);
+        }
+
+        ~hb_mc_timeline_probe() {
+                if (!on)
+                        return;
+                hb_mc_timeline_stamp_t end;
+                hb_mc_timeline_stamp(mc, &end);
+                hb_mc_timeline_record(name, cat, pid, tid, &begin, &end);
+        }
+
+private:
+        hb_mc_manycore_t *mc;
+        const char *name;
+        const char *cat;
+        int pid;
+        int tid;
+        bool on;
+        hb_mc_timeline_stamp_t begin;
+};
+
+#define HB_MC_TIMELINE_PROBE(mc, name, cat, pid, tid)                   \
+        hb_mc_timeline_probe __hb_mc_timeline_probe((mc), (name), (cat), (pid), (tid))
+
+#endif // #ifdef __cplusplus
+
+#endif
@@ -0,0 +1,282 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#define BSG_LOG_SUBSYSTEM BSG_LOG_CUDA
+#include <bsg_manycore_trace_regions.h>
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_printing.h>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+typedef struct hb_mc_trace_regions {
+        std::vector<std::string> names;    // kernels traced by exact name
+        std::vector<std::string> prefixes; // kernels traced by name prefix
+        std::vector<uint32_t>    launches; // kernels traced by launch index
+        unsigned    pins;
+        uint32_t    num_launches; // kernels enqueued so far
+        uint32_t    active;       // launched, unretired tile groups of traced kernels
+        uint32_t    region;       // regions closed so far
+        std::string opener;       // kernel that opened the current region
+        uint32_t    opener_launch;
+        uint64_t    start_cycle;
+        std::string path;
+        FILE       *markers;
+} hb_mc_trace_regions_t;
+
+static hb_mc_trace_regions_t *hb_mc_trace_regions(hb_mc_device_t *device)
+{
+        return reinterpret_cast<hb_mc_trace_regions_t*>(device->trace_regions);
+}
+
+/* parse a selection into #r; on error #r is left empty */
+static int hb_mc_trace_regions_parse(hb_mc_trace_regions_t *r, const char *kernels)
+{
+        r->names.clear();
+        r->prefixes.clear();
+        r->launches.clear();
+
+        if (kernels == NULL)
+                return HB_MC_SUCCESS;
+
+        std::string spec(kernels);
+        size_t pos = 0;
+        while (pos <= spec.size()) {
+                size_t end = spec.find(',', pos);
+                if (end == std::string::npos)
+                        end = spec.size();
+
+                std::string item = spec.substr(pos, end - pos);
+                size_t first = item.find_first_not_of(" \t");
+                size_t last = item.find_last_not_of(" \t");
+                item = first == std::string::npos ? "" : item.substr(first, last - first + 1);
+                pos = end + 1;
+
+                if (item.empty())
+                        continue;
+
+                if (item[0] == '#') {
+                        char *endp;
+                        unsigned long launch = strtoul(item.c_str() + 1, &endp, 0);
+                        if (item.size() == 1 || *endp != '\0') {
+                                bsg_pr_err("%s: '%s' is not a launch index\n",
+                                           __func__, item.c_str());
+                                hb_mc_trace_regions_parse(r, NULL);
+                                return HB_MC_INVALID;
+                        }
+                        r->launches.push_back(launch);
+                } else if (item.back() == '*') {
+                        r->prefixes.push_back(item.substr(0, item.size() - 1));
+                } else {
+                        r->names.push_back(item);
+                }
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+static bool hb_mc_trace_regions_match(const hb_mc_trace_regions_t *r,
+                                      const char *name, uint32_t launch)
+{
+        for (uint32_t l : r->launches)
+                if (l == launch)
+                        return true;
+
+        for (const std::string &n : r->names)
+                if (n == name)
+                        return true;
+
+        for (const std::string &p : r->prefixes)
+                if (strncmp(name, p.c_str(), p.size()) == 0)
+                        return true;
+
+        return false;
+}
+
+/* raise or lower the selected pins; pins the platform lacks are dropped */
+static int hb_mc_trace_regions_pins(hb_mc_device_t *device, hb_mc_trace_regions_t *r, bool on)
+{
+        int err;
+
+        if (r->pins & HB_MC_TRACE_REGION_TRACE) {
+                err = on ? hb_mc_manycore_trace_enable(device->mc)
+                         : hb_mc_manycore_trace_disable(device->mc);
+                if (err == HB_MC_NOIMPL) {
+                        bsg_pr_warn("%s: Platform has no operation trace, only recording regions\n",
+                                    __func__);
+                        r->pins &= ~HB_MC_TRACE_REGION_TRACE;
+                } else if (err != HB_MC_SUCCESS) {
+                        return err;
+                }
+        }
+
+        if (r->pins & HB_MC_TRACE_REGION_LOG) {
+                err = on ? hb_mc_manycore_log_enable(device->mc)
+                         : hb_mc_manycore_log_disable(device->mc);
+                if (err == HB_MC_NOIMPL) {
+                        bsg_pr_warn("%s: Platform has no log, only recording regions\n",
+                                    __func__);
+                        r->pins &= ~HB_MC_TRACE_REGION_LOG;
+                } else if (err != HB_MC_SUCCESS) {
+                        return err;
+                }
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/* the cycle counter, or 0 on platforms without one */
+static uint64_t hb_mc_trace_regions_cycle(hb_mc_device_t *device)
+{
+        uint64_t cycle;
+
+        if (hb_mc_manycore_get_cycle(device->mc, &cycle) != HB_MC_SUCCESS)
+                return 0;
+
+        return cycle;
+}
+
+static int hb_mc_trace_regions_close(hb_mc_device_t *device, hb_mc_trace_regions_t *r)
+{
+        int err;
+
+        err = hb_mc_trace_regions_pins(device, r, false);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        uint64_t end_cycle = hb_mc_trace_regions_cycle(device);
+
+        if (r->markers == NULL) {
+                r->markers = fopen(r->path.c_str(), "w");
+                if (r->markers == NULL) {
+                        bsg_pr_err("%s: failed to open '%s': %s\n",
+                                   __func__, r->path.c_str(), strerror(errno));
+                        return HB_MC_FAIL;
+                }
+                fprintf(r->markers, "region,kernel,launch,start_cycle,end_cycle\n");
+        }
+
+        fprintf(r->markers, "%" PRIu32 ",%s,%" PRIu32 ",%" PRIu64 ",%" PRIu64 "\n",
+                r->region, r->opener.c_str(), r->opener_launch, r->start_cycle, end_cycle);
+        // keep the markers for regions that completed if the program dies
+        fflush(r->markers);
+
+        bsg_pr_dbg("%s: region %" PRIu32 " ('%s', launch %" PRIu32 ") closed after %" PRIu64 " cycles\n",
+                   __func__, r->region, r->opener.c_str(), r->opener_launch,
+                   end_cycle - r->start_cycle);
+
+        r->region++;
+        return HB_MC_SUCCESS;
+}
+
+int hb_mc_device_trace_regions_set(hb_mc_device_t *device, const char *kernels, unsigned pins)
+{
+        hb_mc_trace_regions_t *r = hb_mc_trace_regions(device);
+        r->pins = pins & (HB_MC_TRACE_REGION_TRACE | HB_MC_TRACE_REGION_LOG);
+        return hb_mc_trace_regions_parse(r, kernels);
+}
+
+int hb_mc_device_trace_regions_init(hb_mc_device_t *device)
+{
+        hb_mc_trace_regions_t *r = new hb_mc_trace_regions_t();
+        r->pins = HB_MC_TRACE_REGION_TRACE;
+        r->num_launches = 0;
+        r->active = 0;
+        r->region = 0;
+        r->opener_launch = 0;
+        r->start_cycle = 0;
+        r->markers = NULL;
+        device->trace_regions = r;
+
+        const char *file = getenv("HB_MC_TRACE_REGIONS_FILE");
+        r->path = file != NULL ? file : HB_MC_TRACE_REGIONS_FILE;
+
+        const char *pins = getenv("HB_MC_TRACE_PINS");
+        if (pins != NULL) {
+                r->pins = 0;
+                if (strstr(pins, "trace") != NULL)
+                        r->pins |= HB_MC_TRACE_REGION_TRACE;
+                if (strstr(pins, "log") != NULL)
+                        r->pins |= HB_MC_TRACE_REGION_LOG;
+        }
+
+        return hb_mc_trace_regions_parse(r, getenv("HB_MC_TRACE_KERNELS"));
+}
+
+void hb_mc_device_trace_regions_cleanup(hb_mc_device_t *device)
+{
+        hb_mc_trace_regions_t *r = hb_mc_trace_regions(device);
+        if (r == NULL)
+                return;
+
+        // a kernel failed while traced: still mark where the region began
+        if (r->active > 0)
+                hb_mc_trace_regions_close(device, r);
+
+        if (r->markers != NULL)
+                fclose(r->markers);
+
+        delete r;
+        device->trace_regions = NULL;
+}
+
+void hb_mc_device_trace_regions_kernel_enqueue(hb_mc_device_t *device, hb_mc_kernel_t *kernel)
+{
+        hb_mc_trace_regions_t *r = hb_mc_trace_regions(device);
+
+        kernel->launch = r->num_launches++;
+        kernel->traced = hb_mc_trace_regions_match(r, kernel->name, kernel->launch);
+}
+
+int hb_mc_device_trace_regions_enter(hb_mc_device_t *device, const hb_mc_kernel_t *kernel)
+{
+        hb_mc_trace_regions_t *r = hb_mc_trace_regions(device);
+
+        if (!kernel->traced || r->active++ > 0)
+                return HB_MC_SUCCESS;
+
+        r->opener = kernel->name;
+        r->opener_launch = kernel->launch;
+        r->start_cycle = hb_mc_trace_regions_cycle(device);
+
+        return hb_mc_trace_regions_pins(device, r, true);
+}
+
+int hb_mc_device_trace_regions_leave(hb_mc_device_t *device, const hb_mc_kernel_t *kernel)
+{
+        hb_mc_trace_regions_t *r = hb_mc_trace_regions(device);
+
+        if (!kernel->traced || --r->active > 0)
+                return HB_MC_SUCCESS;
+
+        return hb_mc_trace_regions_close(device, r);
+}
@@ -0,0 +1,122 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/* Toggle trace and log generation around selected kernel launches */
+#ifndef BSG_MANYCORE_TRACE_REGIONS_H
+#define BSG_MANYCORE_TRACE_REGIONS_H
+#include <bsg_manycore_features.h>
+#include <bsg_manycore.h>
+#include <bsg_manycore_cuda.h>
+#ifdef __cplusplus
+#include <cstdint>
+#else
+#include <stdint.h>
+#endif
+
+/*
+ * A trace region starts when the first tile group of a selected
+ * kernel launches, and ends when no tile group of a selected kernel
+ * is running. The trace (vanilla_operation_trace.csv) and log
+ * (vanilla.log) pins are only held high inside a region, so their
+ * size follows the kernels of interest rather than the whole run.
+ *
+ * Each region is recorded as one line of a CSV file (by default
+ * vanilla_trace_regions.csv):
+ *
+ *     region,kernel,launch,start_cycle,end_cycle
+ *
+ * where kernel and launch name the kernel that opened the region.
+ * Trace rows are stamped with the cycle they executed in, so a
+ * parser can split them by region on the cycle ranges.
+ *
+ * Regions can also be selected without changing the host program
+ * with these environment variables, read by hb_mc_device_init():
+ *
+ *   HB_MC_TRACE_KERNELS       a selection, as for hb_mc_device_trace_regions_set()
+ *   HB_MC_TRACE_PINS          "trace", "log" or "trace,log" (default "trace")
+ *   HB_MC_TRACE_REGIONS_FILE  where to write the region markers
+ */
+#define HB_MC_TRACE_REGION_TRACE 0x1 //!< Operation trace (vanilla_operation_trace.csv)
+#define HB_MC_TRACE_REGION_LOG   0x2 //!< Log (vanilla.log)
+
+#define HB_MC_TRACE_REGIONS_FILE "vanilla_trace_regions.csv"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+        /**
+         * Select the kernel launches to trace
+         *
+         * #kernels is a comma separated list. Each entry is either a
+         * kernel name, a name prefix ending in '*', or '#' followed by
+         * a launch index: the number of kernels enqueued on the device
+         * before it, counting from 0. A launch is traced if any entry
+         * matches it. Only kernels enqueued after this call are
+         * affected.
+         *
+         * @param[in] device   A device initialized with hb_mc_device_init()
+         * @param[in] kernels  Kernels to trace, or NULL or "" to trace none
+         * @param[in] pins     HB_MC_TRACE_REGION_TRACE and/or HB_MC_TRACE_REGION_LOG
+         * @return HB_MC_SUCCESS on success. HB_MC_INVALID if #kernels can't be parsed.
+         */
+        int hb_mc_device_trace_regions_set(hb_mc_device_t *device, const char *kernels, unsigned pins);
+
+        /**
+         * Set up trace regions for a device from the environment
+         * Called by hb_mc_device_init().
+         */
+        int hb_mc_device_trace_regions_init(hb_mc_device_t *device);
+
+        /**
+         * Close any open region and free the trace region state
+         * Called by hb_mc_device_finish().
+         */
+        void hb_mc_device_trace_regions_cleanup(hb_mc_device_t *device);
+
+        /**
+         * Assign a kernel its launch index and decide if it is traced
+         * Called when a kernel is enqueued.
+         */
+        void hb_mc_device_trace_regions_kernel_enqueue(hb_mc_device_t *device, hb_mc_kernel_t *kernel);
+
+        /**
+         * Note that a tile group of #kernel is about to start, opening a region if needed
+         * Called when a tile group is launched.
+         */
+        int hb_mc_device_trace_regions_enter(hb_mc_device_t *device, const hb_mc_kernel_t *kernel);
+
+        /**
+         * Note that a tile group of #kernel has finished, closing the region if it was the last
+         * Called when a tile group is retired.
+         */
+        int hb_mc_device_trace_regions_leave(hb_mc_device_t *device, const hb_mc_kernel_t *kernel);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
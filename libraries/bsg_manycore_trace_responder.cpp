@@ -28,7 +28,9 @@
 #include <bsg_manycore_responder.h>
 #include <bsg_manycore_request_packet_id.h>
 #include <bsg_manycore_printing.h>
+#include <bsg_manycore_responder_output.h>
 #include <stdio.h>
+#include <algorithm>
 
 enum hb_mc_trace_epa_indx {
         BRANCH_TRACE_EPA_INDX, 
@@ -39,6 +41,7 @@ enum hb_mc_trace_epa_indx {
 typedef struct {
         FILE* f;
         const char* type;
+        hb_mc_responder_output_t* out;
 } trace_config_t;
 
 static hb_mc_request_packet_id_t ids [] = {
@@ -53,7 +56,17 @@ static trace_config_t trace_config [] = {
 static int init(hb_mc_responder_t *responder,
                 hb_mc_manycore_t *mc)
 {
+        int err;
         bsg_pr_dbg("hello from %s\n", __FILE__);
+        for(int i=0; i<HB_MC_NUM_TRACE_EPAS; i++) {
+                err = hb_mc_responder_output_get(trace_config[i].f, &trace_config[i].out);
+                if (err != HB_MC_SUCCESS) {
+                        // release the streams already acquired
+                        while (--i >= 0)
+                                hb_mc_responder_output_put(trace_config[i].out);
+                        return err;
+                }
+        }
         responder->responder_data = trace_config;
         return 0;
 }
@@ -62,6 +75,8 @@ static int quit(hb_mc_responder_t *responder,
                 hb_mc_manycore_t *mc)
 {
         bsg_pr_dbg("goodbye from %s\n", __FILE__);
+        for(int i=0; i<HB_MC_NUM_TRACE_EPAS; i++)
+                hb_mc_responder_output_put(trace_config[i].out);
         responder->responder_data = nullptr;
         return 0;
 }
@@ -77,9 +92,13 @@ static int respond(hb_mc_responder_t *responder,
         for(int i=0; i<HB_MC_NUM_TRACE_EPAS; i++) {
                 if(hb_mc_request_packet_is_match(rqst, &responder->ids[i])) {
                         trace_config_t config = ((trace_config_t*) responder->responder_data)[i];
-                        fprintf(config.f, 
-                                "hbmc_%s_trace x=%d y=%d data=%x\n", 
-                                config.type, src_x, src_y, (int)data);
+                        char line[128];
+                        int len = snprintf(line, sizeof(line),
+                                           "hbmc_%s_trace x=%d y=%d data=%x\n",
+                                           config.type, src_x, src_y, (int)data);
+                        if (len > 0)
+                                hb_mc_responder_output_write(config.out, line,
+                                                             std::min<size_t>(len, sizeof(line) - 1));
                         break;
                 }
         }
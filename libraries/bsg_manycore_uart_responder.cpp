@@ -28,6 +28,7 @@
 #include <bsg_manycore_responder.h>
 #include <bsg_manycore_request_packet_id.h>
 #include <bsg_manycore_printing.h>
+#include <bsg_manycore_responder_output.h>
 #include <stdio.h>
 
 enum hb_mc_uart_epa_indx {
@@ -48,11 +49,23 @@ static FILE* uart_streams [] = {
         [STDERR_EPA_INDX] = stderr,
 };
 
+static hb_mc_responder_output_t* uart_outputs [HB_MC_NUM_UART_EPAS];
+
 static int init(hb_mc_responder_t *responder,
                 hb_mc_manycore_t *mc)
 {
+        int err;
         bsg_pr_dbg("hello from %s\n", __FILE__);
-        responder->responder_data = uart_streams;
+        for(int i=STDOUT_EPA_INDX; i<HB_MC_NUM_UART_EPAS; i++) {
+                err = hb_mc_responder_output_get(uart_streams[i], &uart_outputs[i]);
+                if (err != HB_MC_SUCCESS) {
+                        // release the streams already acquired
+                        while (--i >= STDOUT_EPA_INDX)
+                                hb_mc_responder_output_put(uart_outputs[i]);
+                        return err;
+                }
+        }
+        responder->responder_data = uart_outputs;
         return 0;
 }
 
@@ -60,6 +73,8 @@ static int quit(hb_mc_responder_t *responder,
                 hb_mc_manycore_t *mc)
 {
         bsg_pr_dbg("goodbye from %s\n", __FILE__);
+        for(int i=STDOUT_EPA_INDX; i<HB_MC_NUM_UART_EPAS; i++)
+                hb_mc_responder_output_put(uart_outputs[i]);
         responder->responder_data = nullptr;
         return 0;
 }
@@ -72,8 +87,12 @@ static int respond(hb_mc_responder_t *responder,
 
         for(int i=STDOUT_EPA_INDX; i<HB_MC_NUM_UART_EPAS; i++) {
                 if(hb_mc_request_packet_is_match(rqst, &responder->ids[i])) {
-                        FILE *f = ((FILE**)responder->responder_data)[i];
-                        fputc((int)data, f);
+                        hb_mc_responder_output_t *out =
+                                ((hb_mc_responder_output_t**)responder->responder_data)[i];
+                        hb_mc_responder_output_putc(out,
+                                                    hb_mc_coordinate(hb_mc_request_packet_get_x_src(rqst),
+                                                                     hb_mc_request_packet_get_y_src(rqst)),
+                                                    (char)data);
                         break;
                 }
         }
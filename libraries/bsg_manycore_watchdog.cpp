@@ -0,0 +1,257 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#define BSG_LOG_SUBSYSTEM BSG_LOG_CUDA
+#include <bsg_manycore_watchdog.h>
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_loader.h>
+#include <bsg_manycore_printing.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <vector>
+
+typedef struct hb_mc_watchdog {
+        uint64_t ns;     // 0 for no wall-clock budget
+        uint64_t cycles; // 0 for no cycle budget
+        long     poll;   // receive timeout between checks
+} hb_mc_watchdog_t;
+
+static hb_mc_watchdog_t *hb_mc_watchdog(const hb_mc_device_t *device)
+{
+        return reinterpret_cast<hb_mc_watchdog_t*>(device->watchdog);
+}
+
+int hb_mc_device_watchdog_enable(hb_mc_device_t *device, double seconds, uint64_t cycles)
+{
+        if (seconds < 0 || (seconds == 0 && cycles == 0)) {
+                bsg_pr_err("%s: A watchdog needs a time or cycle budget\n", __func__);
+                return HB_MC_INVALID;
+        }
+
+        hb_mc_watchdog_t *w = hb_mc_watchdog(device);
+        if (w == NULL) {
+                w = new hb_mc_watchdog_t();
+                device->watchdog = w;
+        }
+
+        w->ns = static_cast<uint64_t>(seconds * 1e9);
+        w->cycles = cycles;
+
+        // check ten times per budget; the timeout is in microseconds or cycles
+        uint64_t budget = UINT64_MAX;
+        if (w->ns != 0)
+                budget = std::min(budget, w->ns / 1000);
+        if (w->cycles != 0)
+                budget = std::min(budget, w->cycles);
+        w->poll = static_cast<long>(std::max<uint64_t>(HB_MC_WATCHDOG_POLL_MIN,
+                                                       std::min<uint64_t>(HB_MC_WATCHDOG_POLL_MAX,
+                                                                          budget / 10)));
+        return HB_MC_SUCCESS;
+}
+
+void hb_mc_device_watchdog_disable(hb_mc_device_t *device)
+{
+        delete hb_mc_watchdog(device);
+        device->watchdog = NULL;
+}
+
+int hb_mc_device_watchdog_init(hb_mc_device_t *device)
+{
+        double seconds = 0;
+        uint64_t cycles = 0;
+        char *end;
+
+        device->watchdog = NULL;
+
+        const char *s = getenv("HB_MC_WATCHDOG_SECONDS");
+        if (s != NULL && *s != '\0') {
+                seconds = strtod(s, &end);
+                if (*end != '\0' || seconds < 0) {
+                        bsg_pr_err("%s: HB_MC_WATCHDOG_SECONDS='%s' is not a number of seconds\n",
+                                   __func__, s);
+                        return HB_MC_INVALID;
+                }
+        }
+
+        const char *c = getenv("HB_MC_WATCHDOG_CYCLES");
+        if (c != NULL && *c != '\0') {
+                cycles = strtoull(c, &end, 0);
+                if (*end != '\0') {
+                        bsg_pr_err("%s: HB_MC_WATCHDOG_CYCLES='%s' is not a number of cycles\n",
+                                   __func__, c);
+                        return HB_MC_INVALID;
+                }
+        }
+
+        if (seconds == 0 && cycles == 0)
+                return HB_MC_SUCCESS;
+
+        return hb_mc_device_watchdog_enable(device, seconds, cycles);
+}
+
+int hb_mc_device_watchdog_enabled(const hb_mc_device_t *device)
+{
+        return hb_mc_watchdog(device) != NULL;
+}
+
+long hb_mc_device_watchdog_timeout(const hb_mc_device_t *device)
+{
+        hb_mc_watchdog_t *w = hb_mc_watchdog(device);
+        return w != NULL ? w->poll : -1;
+}
+
+static bool hb_mc_watchdog_expired(const hb_mc_watchdog_t *w, const hb_mc_tile_group_t *tg,
+                                   const hb_mc_timeline_stamp_t *now)
+{
+        // launched before the watchdog was set: its age is unknown
+        if (tg->launched.ns == 0)
+                return false;
+
+        if (w->ns != 0 && now->ns - tg->launched.ns > w->ns)
+                return true;
+
+        // a cycle of 0 means the platform has no cycle counter
+        if (w->cycles != 0 && now->cycle != 0 &&
+            now->cycle - tg->launched.cycle > w->cycles)
+                return true;
+
+        return false;
+}
+
+/* print the most sampled PC of each tile, if the PC histogram is on */
+static void hb_mc_watchdog_report_pcs(hb_mc_device_t *device, const hb_mc_tile_group_t *tg,
+                                      const hb_mc_loader_function_t *funcs, size_t n_funcs)
+{
+        std::vector<hb_mc_pc_count_t> counts;
+        hb_mc_coordinate_t coord;
+        size_t n = 0;
+        int err;
+
+        foreach_coordinate(coord, tg->origin, tg->dim) {
+                err = hb_mc_manycore_pc_histogram_read(device->mc, coord,
+                                                       counts.data(), counts.size(), &n);
+                if (err == HB_MC_NOMEM) {
+                        counts.resize(n);
+                        err = hb_mc_manycore_pc_histogram_read(device->mc, coord,
+                                                               counts.data(), counts.size(), &n);
+                }
+
+                // no histogram on this platform: no tile will have one
+                if (err == HB_MC_NOIMPL)
+                        return;
+                if (err != HB_MC_SUCCESS || n == 0)
+                        continue;
+
+                const hb_mc_pc_count_t *top = &counts[0];
+                for (size_t i = 1; i < n; i++)
+                        if (counts[i].count > top->count)
+                                top = &counts[i];
+
+                const hb_mc_loader_function_t *f = hb_mc_loader_function_at(funcs, n_funcs, top->pc);
+                bsg_pr_err("    tile (%d,%d): pc 0x%08" PRIx32 " in %s (%" PRIu64 " samples)\n",
+                           coord.x, coord.y, top->pc, f ? f->name : "??", top->count);
+        }
+}
+
+int hb_mc_device_watchdog_check(hb_mc_device_t *device,
+                                const hb_mc_pod_id_t *podv, int podc)
+{
+        hb_mc_watchdog_t *w = hb_mc_watchdog(device);
+        hb_mc_timeline_stamp_t now;
+        hb_mc_tile_group_t *tg;
+        bool expired = false;
+
+        if (w == NULL)
+                return HB_MC_SUCCESS;
+
+        hb_mc_timeline_stamp(device->mc, &now);
+        for (int podi = 0; podi < podc && !expired; podi++) {
+                hb_mc_pod_t *pod = &device->pods[podv[podi]];
+                for (tg = pod->tile_groups; tg != pod->tile_groups + pod->num_tile_groups; tg++) {
+                        if (tg->status == HB_MC_TILE_GROUP_STATUS_LAUNCHED &&
+                            hb_mc_watchdog_expired(w, tg, &now)) {
+                                expired = true;
+                                break;
+                        }
+                }
+        }
+
+        if (!expired)
+                return HB_MC_SUCCESS;
+
+        bsg_pr_err("%s: Watchdog expired (budget: %.3f s, %" PRIu64 " cycles; 0 is none)\n",
+                   __func__, w->ns / 1e9, w->cycles);
+
+        for (int podi = 0; podi < podc; podi++) {
+                hb_mc_pod_t *pod = &device->pods[podv[podi]];
+                hb_mc_loader_function_t *funcs = NULL;
+                size_t n_funcs = 0;
+                int waiting = 0;
+
+                // the report is best effort; PCs just go unnamed without symbols
+                if (pod->program != NULL)
+                        hb_mc_loader_get_functions(pod->program->bin, pod->program->bin_size,
+                                                   &funcs, &n_funcs);
+
+                for (tg = pod->tile_groups; tg != pod->tile_groups + pod->num_tile_groups; tg++) {
+                        if (tg->status == HB_MC_TILE_GROUP_STATUS_INITIALIZED) {
+                                waiting++;
+                                continue;
+                        }
+
+                        if (tg->status != HB_MC_TILE_GROUP_STATUS_LAUNCHED)
+                                continue;
+
+                        if (tg->launched.ns == 0) {
+                                bsg_pr_err("  pod %d: '%s' (launch %" PRIu32 ") tile group at (%d,%d), %dx%d:"
+                                           " launched before the watchdog was set\n",
+                                           podv[podi], tg->kernel->name, tg->kernel->launch,
+                                           tg->origin.x, tg->origin.y, tg->dim.x, tg->dim.y);
+                                hb_mc_watchdog_report_pcs(device, tg, funcs, n_funcs);
+                                continue;
+                        }
+
+                        bsg_pr_err("  pod %d: '%s' (launch %" PRIu32 ") tile group at (%d,%d), %dx%d:"
+                                   " running for %.3f s, %" PRIu64 " cycles%s\n",
+                                   podv[podi], tg->kernel->name, tg->kernel->launch,
+                                   tg->origin.x, tg->origin.y, tg->dim.x, tg->dim.y,
+                                   (now.ns - tg->launched.ns) / 1e9,
+                                   now.cycle ? now.cycle - tg->launched.cycle : 0,
+                                   hb_mc_watchdog_expired(w, tg, &now) ? " (expired)" : "");
+                        hb_mc_watchdog_report_pcs(device, tg, funcs, n_funcs);
+                }
+
+                if (waiting)
+                        bsg_pr_err("  pod %d: %d tile groups not yet launched\n",
+                                   podv[podi], waiting);
+                free(funcs);
+        }
+
+        return HB_MC_WATCHDOG;
+}
@@ -0,0 +1,98 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/* Report kernel launches that run past a wall-clock or cycle budget */
+#ifndef BSG_MANYCORE_WATCHDOG_H
+#define BSG_MANYCORE_WATCHDOG_H
+#include <bsg_manycore_features.h>
+#include <bsg_manycore.h>
+#include <bsg_manycore_cuda.h>
+#ifdef __cplusplus
+#include <cstdint>
+#else
+#include <stdint.h>
+#endif
+
+/*
+ * While a watchdog is set, the runtime waits for finish packets in
+ * slices rather than forever. A slice is a tenth of the tighter budget,
+ * clamped to [HB_MC_WATCHDOG_POLL_MIN, HB_MC_WATCHDOG_POLL_MAX] in the
+ * receive timeout's units (microseconds on hardware, cycles in
+ * simulation). After each idle slice it measures every launched tile
+ * group from its launch. If one has run for longer than either budget,
+ * the watchdog reports every outstanding tile group of the pods being
+ * waited on and the wait returns HB_MC_WATCHDOG. The report gives each
+ * tile group's kernel, origin, shape and age. When the PC histogram is
+ * on (see bsg_manycore_hotspots.h), it also gives each tile's most
+ * sampled PC. Tile groups launched before the watchdog was set have no
+ * launch time and are not measured.
+ *
+ * The watchdog only reports the overrun and stops the wait; it does not
+ * stop, reset or cancel the tiles. They are still running afterwards,
+ * so the program should give up on the device and exit.
+ *
+ * Set HB_MC_WATCHDOG_SECONDS and/or HB_MC_WATCHDOG_CYCLES to arm the
+ * watchdog without changing the host program.
+ */
+#define HB_MC_WATCHDOG_POLL_MIN 100
+#define HB_MC_WATCHDOG_POLL_MAX 10000
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+        /**
+         * Stop waiting on, and report, tile groups that run longer than a budget
+         * @param[in]  device   A CUDA device initialized with hb_mc_device_init()
+         * @param[in]  seconds  Wall-clock budget per tile group, or 0 for none
+         * @param[in]  cycles   Device cycle budget per tile group, or 0 for none
+         * @return HB_MC_SUCCESS on success. HB_MC_INVALID if both budgets are 0.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_device_watchdog_enable(hb_mc_device_t *device, double seconds, uint64_t cycles);
+
+        /**
+         * Wait for tile groups without a budget again
+         * @param[in]  device  A CUDA device initialized with hb_mc_device_init()
+         */
+        void hb_mc_device_watchdog_disable(hb_mc_device_t *device);
+
+        /* runtime hooks, called from bsg_manycore_cuda.cpp */
+        int hb_mc_device_watchdog_init(hb_mc_device_t *device);
+
+        int hb_mc_device_watchdog_enabled(const hb_mc_device_t *device);
+
+        /* how long to wait for a finish packet before checking budgets */
+        long hb_mc_device_watchdog_timeout(const hb_mc_device_t *device);
+
+        int hb_mc_device_watchdog_check(hb_mc_device_t *device,
+                                        const hb_mc_pod_id_t *podv, int podc);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -1,3 +1,4 @@
+#define BSG_LOG_SUBSYSTEM BSG_LOG_DMA
 #include <bsg_manycore_dma.h>
 #include <bsg_manycore.h>
 #include <bsg_manycore_printing.h>
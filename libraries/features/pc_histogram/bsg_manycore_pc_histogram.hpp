@@ -0,0 +1,74 @@
+#ifndef __BSG_MANYCORE_PC_HISTOGRAM_HPP
+#define __BSG_MANYCORE_PC_HISTOGRAM_HPP
+#include <bsg_manycore.h>
+#include <string>
+
+// Since the definition of hb_mc_pc_histogram_t is implementation
+// dependent, we use void *
+typedef void* hb_mc_pc_histogram_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+        /**
+         * Initialize an hb_mc_pc_histogram_t instance
+         * @param[in] p    A pointer to the hb_mc_pc_histogram_t instance to initialize
+         * @param[in] hier An implementation-dependent string. See the implementation for more details.
+         * @return HB_MC_SUCCESS on success. HB_MC_BUSY if another instance exists.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
+         *
+         * Samples arrive through a process-wide DPI export that carries no
+         * instance, so only one histogram, and so one manycore, can be
+         * attached per process. This matches the simulation platforms, which
+         * run one manycore per simulator process. Only machines built with
+         * BSG_MACHINE_ENABLE_PC_SAMPLER (the pc-histogram simulators)
+         * produce samples; elsewhere every tile reads back empty.
+         */
+        int hb_mc_pc_histogram_init(hb_mc_pc_histogram_t *p, std::string &hier);
+
+        /**
+         * Clean up an hb_mc_pc_histogram_t instance
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_pc_histogram_cleanup(hb_mc_pc_histogram_t *p);
+
+        /**
+         * Start accumulating PC samples
+         * @param[in] p    A histogram instance initialized with hb_mc_pc_histogram_init()
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_pc_histogram_enable(hb_mc_pc_histogram_t p);
+
+        /**
+         * Stop accumulating PC samples. Counts already taken are kept.
+         * @param[in] p    A histogram instance initialized with hb_mc_pc_histogram_init()
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_pc_histogram_disable(hb_mc_pc_histogram_t p);
+
+        /**
+         * Discard the PC samples of one tile
+         * @param[in] p    A histogram instance initialized with hb_mc_pc_histogram_init()
+         * @param[in] t    A tile coordinate
+         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         */
+        int hb_mc_pc_histogram_reset(hb_mc_pc_histogram_t p, hb_mc_coordinate_t t);
+
+        /**
+         * Read the PC samples of one tile, in ascending PC order
+         * @param[in]  p      A histogram instance initialized with hb_mc_pc_histogram_init()
+         * @param[in]  t      A tile coordinate
+         * @param[out] counts An array of #cap entries
+         * @param[in]  cap    Length of #counts
+         * @param[out] n      Number of entries filled in #counts
+         * @return HB_MC_SUCCESS on success. HB_MC_NOMEM if #cap is too small, in which
+         * case #n is set to the number of entries required.
+         */
+        int hb_mc_pc_histogram_read(hb_mc_pc_histogram_t p, hb_mc_coordinate_t t,
+                                    hb_mc_pc_count_t *counts, size_t cap, size_t *n);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
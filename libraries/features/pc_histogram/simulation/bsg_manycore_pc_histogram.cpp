@@ -0,0 +1,177 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include <bsg_manycore_pc_histogram.hpp>
+#include <bsg_manycore_printing.h>
+#include <bsg_manycore_coordinate.h>
+#include <map>
+#include <string>
+#include <utility>
+using namespace std;
+
+// PC samples are produced by vanilla_core_pc_sampler, which the
+// testbench binds to each vanilla_core when BSG_MACHINE_ENABLE_PC_SAMPLER
+// is defined. It calls hb_mc_pc_histogram_sample() (below) through DPI
+// once per sampled instruction. The samples are kept
+// here, in host memory, so that they can be read and reset while the
+// simulation is running.
+typedef map<uint32_t, uint64_t> pc_counts_t;
+
+typedef struct {
+        bool enabled;
+        string hier;
+        map<pair<hb_mc_idx_t, hb_mc_idx_t>, pc_counts_t> tiles;
+} pc_histogram_t;
+
+// The DPI export below has no instance argument, so samples go to the
+// one histogram attached in this process.
+static pc_histogram_t *active = nullptr;
+
+/**
+ * Record one PC sample. Called every few cycles for each tile by
+ * vanilla_core_pc_sampler (platforms/common/dpi/hardware) through DPI.
+ * @param[in] x    Global X coordinate of the tile that executed #pc
+ * @param[in] y    Global Y coordinate of the tile that executed #pc
+ * @param[in] pc   The program counter that was sampled
+ */
+extern "C" void hb_mc_pc_histogram_sample(int x, int y, int pc){
+        if (active == nullptr || !active->enabled)
+                return;
+
+        active->tiles[make_pair(x, y)][static_cast<uint32_t>(pc)]++;
+}
+
+/**
+ * Initialize an hb_mc_pc_histogram_t instance
+ * @param[in] p    A pointer to the hb_mc_pc_histogram_t instance to initialize
+ * @param[in] hier An implementation-dependent string. See the implementation for more details.
+ * @return HB_MC_SUCCESS on success. HB_MC_BUSY if another instance exists.
+ * Otherwise an error code defined in bsg_manycore_errno.h.
+ *
+ * NOTE: In this implementation, the argument hier indicates the path
+ * to the top level module in simulation.
+ */
+int hb_mc_pc_histogram_init(hb_mc_pc_histogram_t *p, string &hier){
+        if (active != nullptr) {
+                bsg_pr_err("%s: A PC histogram is already attached to %s\n",
+                           __func__, active->hier.c_str());
+                return HB_MC_BUSY;
+        }
+
+        pc_histogram_t *h = new pc_histogram_t;
+        h->enabled = false;
+        h->hier = hier;
+
+        active = h;
+        *p = reinterpret_cast<hb_mc_pc_histogram_t>(h);
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Clean up an hb_mc_pc_histogram_t instance
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_pc_histogram_cleanup(hb_mc_pc_histogram_t *p){
+        pc_histogram_t *h = reinterpret_cast<pc_histogram_t *>(*p);
+
+        if (active == h)
+                active = nullptr;
+
+        delete h;
+        *p = nullptr;
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Start accumulating PC samples
+ * @param[in] p    A histogram instance initialized with hb_mc_pc_histogram_init()
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_pc_histogram_enable(hb_mc_pc_histogram_t p){
+        pc_histogram_t *h = reinterpret_cast<pc_histogram_t *>(p);
+
+        h->enabled = true;
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Stop accumulating PC samples. Counts already taken are kept.
+ * @param[in] p    A histogram instance initialized with hb_mc_pc_histogram_init()
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_pc_histogram_disable(hb_mc_pc_histogram_t p){
+        pc_histogram_t *h = reinterpret_cast<pc_histogram_t *>(p);
+
+        h->enabled = false;
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Discard the PC samples of one tile
+ * @param[in] p    A histogram instance initialized with hb_mc_pc_histogram_init()
+ * @param[in] t    A tile coordinate
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_pc_histogram_reset(hb_mc_pc_histogram_t p, hb_mc_coordinate_t t){
+        pc_histogram_t *h = reinterpret_cast<pc_histogram_t *>(p);
+
+        h->tiles.erase(make_pair(t.x, t.y));
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Read the PC samples of one tile, in ascending PC order
+ * @param[in]  p      A histogram instance initialized with hb_mc_pc_histogram_init()
+ * @param[in]  t      A tile coordinate
+ * @param[out] counts An array of #cap entries
+ * @param[in]  cap    Length of #counts
+ * @param[out] n      Number of entries filled in #counts
+ * @return HB_MC_SUCCESS on success. HB_MC_NOMEM if #cap is too small, in which
+ * case #n is set to the number of entries required.
+ */
+int hb_mc_pc_histogram_read(hb_mc_pc_histogram_t p, hb_mc_coordinate_t t,
+                            hb_mc_pc_count_t *counts, size_t cap, size_t *n){
+        pc_histogram_t *h = reinterpret_cast<pc_histogram_t *>(p);
+
+        auto it = h->tiles.find(make_pair(t.x, t.y));
+        if (it == h->tiles.end()) {
+                *n = 0;
+                return HB_MC_SUCCESS;
+        }
+
+        *n = it->second.size();
+        if (cap < *n)
+                return HB_MC_NOMEM;
+
+        size_t i = 0;
+        for (const auto &pc : it->second) {
+                counts[i].pc = pc.first;
+                counts[i].count = pc.second;
+                i++;
+        }
+
+        return HB_MC_SUCCESS;
+}
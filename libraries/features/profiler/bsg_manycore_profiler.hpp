@@ -17,7 +17,9 @@ extern "C" {
          * @param[in] x    X dimension of the Manycore Device
          * @param[in] y    Y dimension of the Manycore Device
          * @param[in] hier An implementation-dependent string. See the implementation for more details.
-         * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+         * @return HB_MC_SUCCESS on success. HB_MC_NOIMPL if there is nothing to profile, in which
+         * case the other functions return HB_MC_NOIMPL and cleanup is still safe to call.
+         * Otherwise an error code defined in bsg_manycore_errno.h.
          */
         int hb_mc_profiler_init(hb_mc_profiler_t *p, hb_mc_idx_t x, hb_mc_idx_t y, std::string &hier);
 
@@ -36,6 +38,15 @@ extern "C" {
          */
         int hb_mc_profiler_get_icount(hb_mc_profiler_t p, bsg_instr_type_e itype, int *count);
 
+        /**
+         * Get every class of instruction count for every profiled tile
+         * @param[in]  p     A hb_mc_profiler_t instance initialized with hb_mc_profiler_init()
+         * @param[out] snap  A snapshot whose tiles and cap are set by the caller
+         * @return HB_MC_SUCCESS on success. HB_MC_NOMEM if snap->cap is too small, in which
+         * case snap->n_tiles is set to the number of entries required.
+         */
+        int hb_mc_profiler_get_icount_snapshot(hb_mc_profiler_t p, hb_mc_icount_snapshot_t *snap);
+
 #ifdef __cplusplus
 }
 #endif
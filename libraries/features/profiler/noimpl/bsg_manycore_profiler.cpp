@@ -51,6 +51,16 @@ int hb_mc_profiler_get_icount(hb_mc_profiler_t p, bsg_instr_type_e itype, int *c
         return HB_MC_NOIMPL;
 }
 
+/**
+ * Get every class of instruction count for every profiled tile
+ * @param[in]  p     A hb_mc_profiler_t instance initialized with hb_mc_profiler_init()
+ * @param[out] snap  A snapshot whose tiles and cap are set by the caller
+ * @return HB_MC_NOIMPL. Callers poll this, so it does not warn.
+ */
+int hb_mc_profiler_get_icount_snapshot(hb_mc_profiler_t p, hb_mc_icount_snapshot_t *snap){
+        return HB_MC_NOIMPL;
+}
+
 /**
  * Enable trace file generation
  * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
@@ -36,63 +36,106 @@
 using namespace bsg_nonsynth_dpi;
 using namespace std;
 
+// A profiler bound to a tile, and where that tile is. Construction
+// skips tiles without a profiler, so the coordinate can't be derived
+// from the position in the vector.
+typedef struct {
+        hb_mc_coordinate_t coord;
+        dpi_vanilla_core_profiler *prof;
+} tile_profiler_t;
+
+// Where the vanilla_core_profiler bound to a tile sits below that
+// tile, for the crossbar and the mesh tile respectively. If instance
+// names in the RTL hierarchy change, these need to change too.
+static const char *tile_tails[] = {
+        ".proc.vcore.vcore_prof",
+        ".tile.proc.h.z.vcore.vcore_prof",
+};
+
+// There is no way to query the DPI interface for the scopes that
+// exist, so we ask for a scope by name and treat 0/NULL as absent.
+static bool scope_exists(const string &name){
+        return svGetScopeFromName(name.c_str()) != NULL;
+}
+
+// Number of subarrays along one axis of a pod, found by probing the
+// (0,0) tile of each subarray in turn. Returns 0 if the pod is not
+// split into subarrays.
+static int count_subarrays(const string &hier, const string &tail, bool along_y){
+        int n = 0;
+        for (;; ++n){
+                ostringstream stream;
+                stream << hier << ".mc_y[" << (along_y ? n : 0) << "]"
+                       << ".mc_x[" << (along_y ? 0 : n) << "]"
+                       << ".mc.y[0].x[0]" << tail;
+                if (!scope_exists(stream.str()))
+                        return n;
+        }
+}
+
 /**
  * Initialize an hb_mc_profiler_t instance
  * @param[in] p    A pointer to the hb_mc_profiler_t instance to initialize
+ * @param[in] x    X dimension of the pod, in tiles
+ * @param[in] y    Y dimension of the pod, in tiles
  * @param[in] hier An implementation-dependent string. See the implementation for more details.
- * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ * @return HB_MC_SUCCESS on success. HB_MC_NOIMPL if no tile profiler was found.
+ * Otherwise an error code defined in bsg_manycore_errno.h.
  *
  * NOTE: In this implementation, the argument hier indicates the path
- * to the top level module in simulation.
+ * to a pod in simulation. The pod is either split into mc_y/mc_x
+ * subarrays of tiles, or is itself a single y/x array of tiles.
+ * Tiles are recorded with their x/y index across the pod, which is
+ * not necessarily their network coordinate.
  */
 int hb_mc_profiler_init(hb_mc_profiler_t *p, hb_mc_idx_t x, hb_mc_idx_t y, string &hier){
+        // We construct a dpi_vanilla_core_profiler instance for each
+        // profiler in the HDL, and track it with its tile coordinate
+        // using a vector.
+        vector<tile_profiler_t> *profilers = new vector<tile_profiler_t>();
 
-        // The crossbar and the Mesh hierarchy differ, so we need to
-        // figure out which one exists. There is no way to query the
-        // DPI interface to see what scopes are available, so instead
-        // we attempt to get the scope for the (1,0) tile profiler
-        // using getScopeFromName and if that returns 0/NULL then the
-        // scope does not exist.
-
-        // We check for the crossbar hierarchy first, and then assume
-        // mesh if that scope does not exist.
-
-        // If instance names in the RTL hierarchy change for either
-        // network topology, then the definition of the strings tail
-        // and tile01 (below) will need to change to reflect the new
-        // naming.
-        string tile01 = ".y[1].x[0].proc.vcore.vcore_prof";
-        string xbar = hier + tile01;
-        string tail;
-        svScope scope;
-        scope = svGetScopeFromName(xbar.c_str());
-        if(scope)
-                tail = ".proc.vcore.vcore_prof";
-        else
-                tail = ".tile.proc.h.z.vcore.vcore_prof";
-
-        // Each profiler is located in the RTL hierarchy at: hier +
-        // y[y-index].x[x-index] + tail. We need to construct that
-        // string in the for-loop below.
+        *p = NULL;
 
-        // We construct a dpi_vanilla_core_profiler instance for each
-        // profiler in the HDL, and track it using a vector.
-        vector<dpi_vanilla_core_profiler* > *profilers = new vector<dpi_vanilla_core_profiler* >();
-        
-        // Construct the objects, and strings.
-        for(int iy = HB_MC_CONFIG_VCORE_BASE_Y-1; iy <= y; ++iy){
-                for(int ix = 0; ix < x; ++ix){
-                        ostringstream stream;
-                        stream << hier << ".y[" << iy << "]" << ".x[" << ix << "]" << tail;
-                        // If the scope does not exist, then there is
-                        // not a profiler module bound to a tile at
-                        // that location. Do not instantiate an object
-                        if(svGetScopeFromName(stream.str().c_str()))
-                                profilers->push_back(new dpi_vanilla_core_profiler(stream.str()));
+        // Try each tile hierarchy until one has profilers
+        for (size_t i = 0; i < sizeof(tile_tails)/sizeof(tile_tails[0]) && profilers->empty(); ++i){
+                string tail = tile_tails[i];
+                int sub_y = count_subarrays(hier, tail, true);
+                int sub_x = count_subarrays(hier, tail, false);
+                bool split = sub_y && sub_x;
+
+                for(hb_mc_idx_t iy = 0; iy < y; ++iy){
+                        for(hb_mc_idx_t ix = 0; ix < x; ++ix){
+                                ostringstream stream;
+                                if (split){
+                                        hb_mc_idx_t ty = y / sub_y, tx = x / sub_x;
+                                        stream << hier << ".mc_y[" << iy / ty << "]" << ".mc_x[" << ix / tx << "]"
+                                               << ".mc.y[" << iy % ty << "]" << ".x[" << ix % tx << "]" << tail;
+                                } else {
+                                        stream << hier << ".y[" << iy << "]" << ".x[" << ix << "]" << tail;
+                                }
+                                // If the scope does not exist, then there is
+                                // not a profiler module bound to a tile at
+                                // that location. Do not instantiate an object
+                                if(scope_exists(stream.str())){
+                                        tile_profiler_t tp;
+                                        tp.coord = hb_mc_coordinate(ix, iy);
+                                        tp.prof = new dpi_vanilla_core_profiler(stream.str());
+                                        profilers->push_back(tp);
+                                }
+                        }
                 }
         }
-        
-        // Save the 2D vector
+
+        if (profilers->empty()){
+                // expected in the exec simulators, which are built
+                // with BSG_MACHINE_DISABLE_VCORE_PROFILING
+                bsg_pr_dbg("%s: No vanilla core profiler found under %s. "
+                           "Is vcore profiling enabled in the machine?\n",
+                           __func__, hier.c_str());
+                delete profilers;
+                return HB_MC_NOIMPL;
+        }
+
         *p = reinterpret_cast<hb_mc_profiler_t>(profilers);
         return HB_MC_SUCCESS;
 }
@@ -102,18 +145,21 @@ int hb_mc_profiler_init(hb_mc_profiler_t *p, hb_mc_idx_t x, hb_mc_idx_t y, strin
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_profiler_cleanup(hb_mc_profiler_t *p){
-        vector<dpi_vanilla_core_profiler *> *profilers =
-                reinterpret_cast<vector<dpi_vanilla_core_profiler *> *>(*p);
-        dpi_vanilla_core_profiler * prof;
+        vector<tile_profiler_t> *profilers =
+                reinterpret_cast<vector<tile_profiler_t> *>(*p);
+
+        // hb_mc_profiler_init() found no profilers
+        if (!profilers)
+                return HB_MC_SUCCESS;
         // From last to first (reverse order) remove elements from the
         // vectors, and delete the associated bojects.
         while (!profilers->empty()){
-                prof = profilers->back();
-                delete prof;
+                delete profilers->back().prof;
                 profilers->pop_back();
         }
 
         delete profilers;
+        *p = NULL;
 
         return HB_MC_SUCCESS;
 }
@@ -128,11 +174,14 @@ int hb_mc_profiler_cleanup(hb_mc_profiler_t *p){
 int hb_mc_profiler_get_icount(hb_mc_profiler_t p, bsg_instr_type_e itype, int *count){
         int err;
         int sum = 0, cur;
-        vector<dpi_vanilla_core_profiler *> *profilers =
-                reinterpret_cast<vector<dpi_vanilla_core_profiler *> *>(p);
+        vector<tile_profiler_t> *profilers =
+                reinterpret_cast<vector<tile_profiler_t> *>(p);
+
+        if (!profilers)
+                return HB_MC_NOIMPL;
 
         for (auto it = profilers->begin() ; it != profilers->end(); ++it){
-                err = (*it)->get_instr_count(itype, &cur);
+                err = it->prof->get_instr_count(itype, &cur);
                 sum += cur;
                 if(err != BSG_NONSYNTH_DPI_SUCCESS){
                         if(err == BSG_NONSYNTH_DPI_NOT_WINDOW)
@@ -145,3 +194,48 @@ int hb_mc_profiler_get_icount(hb_mc_profiler_t p, bsg_instr_type_e itype, int *c
         return HB_MC_SUCCESS;
 }
 
+
+/**
+ * Get every class of instruction count for every profiled tile
+ * @param[in]  p     A hb_mc_profiler_t instance initialized with hb_mc_profiler_init()
+ * @param[out] snap  A snapshot whose tiles and cap are set by the caller
+ * @return HB_MC_SUCCESS on success. HB_MC_NOMEM if snap->cap is too small, in which
+ * case snap->n_tiles is set to the number of entries required. HB_MC_NOIMPL if
+ * hb_mc_profiler_init() found no profilers. Tile coordinates are relative to the pod.
+ */
+int hb_mc_profiler_get_icount_snapshot(hb_mc_profiler_t p, hb_mc_icount_snapshot_t *snap){
+        int err;
+        int cur;
+        vector<tile_profiler_t> *profilers =
+                reinterpret_cast<vector<tile_profiler_t> *>(p);
+
+        if (!profilers)
+                return HB_MC_NOIMPL;
+
+        if (snap->cap < profilers->size()){
+                snap->n_tiles = profilers->size();
+                return HB_MC_NOMEM;
+        }
+
+        // One pass over the tiles reads every class, rather than
+        // one pass per class as with hb_mc_profiler_get_icount().
+        for (size_t i = 0; i < profilers->size(); ++i){
+                const tile_profiler_t &tp = (*profilers)[i];
+                hb_mc_tile_icount_t *t = &snap->tiles[i];
+
+                t->coord = tp.coord;
+                for (int itype = 0; itype < HB_MC_INSTR_TYPES; ++itype){
+                        err = tp.prof->get_instr_count(static_cast<bsg_instr_type_e>(itype), &cur);
+                        if(err != BSG_NONSYNTH_DPI_SUCCESS){
+                                if(err == BSG_NONSYNTH_DPI_NOT_WINDOW)
+                                        bsg_pr_err("%s: Called while not in valid clock window. (is reset still high?)\n", __func__);
+                                return HB_MC_FAIL;
+                        }
+                        // The DPI counter is a 32-bit int
+                        t->icount[itype] = static_cast<uint32_t>(cur);
+                }
+        }
+
+        snap->n_tiles = profilers->size();
+        return HB_MC_SUCCESS;
+}
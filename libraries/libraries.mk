@@ -32,12 +32,15 @@ LIB_CSOURCES   +=
 LIB_CSOURCES   += $(LIBRARIES_PATH)/bsg_manycore_config_id_to_string.c
 LIB_CSOURCES   += $(LIBRARIES_PATH)/bsg_manycore_memsys.c
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore.cpp
+LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_api_stats.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_epa.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_bits.cpp
+LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_cmdlist.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_config.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_cuda.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_elf.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_eva.cpp
+LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_hotspots.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_loader.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_memory_manager.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_origin_eva_map.cpp
@@ -45,26 +48,39 @@ LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_print_int_responder.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_printing.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_request_packet_id.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_responder.cpp
+LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_responder_output.cpp
+LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_stats_stream.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_tile.cpp
+LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_timeline.cpp
+LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_trace_regions.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_uart_responder.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_trace_responder.cpp
 LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_vcache.cpp
+LIB_CXXSOURCES += $(LIBRARIES_PATH)/bsg_manycore_watchdog.cpp
 
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore.h
+LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_api_stats.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_bits.h
+LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_cmdlist.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_config.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_cuda.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_elf.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_eva.h
+LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_hotspots.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_loader.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_memory_manager.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_origin_eva_map.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_printing.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_request_packet_id.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_responder.h
+LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_responder_output.h
+LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_stats_stream.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_tile.h
+LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_timeline.h
+LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_trace_regions.h
 
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_vcache.h
+LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_watchdog.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_errno.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_features.h
 LIB_HEADERS += $(LIBRARIES_PATH)/bsg_manycore_coordinate.h
@@ -114,6 +130,14 @@ $(LIB_OBJECTS) $(LIB_OBJECTS_CUDA_POD_REPL) $(LIB_OBJECTS_REGRESSION): INCLUDES
 # contain flags that are unwanted for the library building flow
 $(LIB_OBJECTS) $(LIB_OBJECTS_CUDA_POD_REPL) $(LIB_OBJECTS_REGRESSION): CFLAGS    := -std=c11 -fPIC -D_GNU_SOURCE -D_BSD_SOURCE -D_DEFAULT_SOURCE
 $(LIB_OBJECTS) $(LIB_OBJECTS_CUDA_POD_REPL) $(LIB_OBJECTS_REGRESSION): CXXFLAGS  := -std=c++11 -fPIC -D_GNU_SOURCE -D_BSD_SOURCE -D_DEFAULT_SOURCE
+
+# Host API call statistics, summarized by hb_mc_device_finish():
+#   0 - off, 1 - call counts and wall-clock latency histograms,
+#   2 - also device-cycle latency (two cycle-counter reads per call)
+LIB_API_STATS ?= 0
+$(LIB_OBJECTS) $(LIB_OBJECTS_CUDA_POD_REPL) $(LIB_OBJECTS_REGRESSION): CFLAGS    += -DHB_MC_API_STATS=$(LIB_API_STATS)
+$(LIB_OBJECTS) $(LIB_OBJECTS_CUDA_POD_REPL) $(LIB_OBJECTS_REGRESSION): CXXFLAGS  += -DHB_MC_API_STATS=$(LIB_API_STATS)
+
 # Uncomment to enable Verilator profiling with operf
 # $(LIB_OBJECTS) $(LIB_OBJECTS_CUDA_POD_REPL) $(LIB_OBJECTS_REGRESSION): CFLAGS    += -g -pg
 # $(LIB_OBJECTS) $(LIB_OBJECTS_CUDA_POD_REPL) $(LIB_OBJECTS_REGRESSION): CXXFLAGS  += -g -pg
@@ -131,6 +155,8 @@ $(LIB_STRICT_OBJECTS): CXXFLAGS += -Wno-unused-but-set-variable
 
 # I don't like these, but they'll have to do for now.
 $(BSG_PLATFORM_PATH)/libbsg_manycore_runtime.so.1.0: LDFLAGS :=
+# responder output may use a background writer thread
+$(BSG_PLATFORM_PATH)/libbsg_manycore_runtime.so.1.0: LDFLAGS += -lpthread
 $(BSG_PLATFORM_PATH)/libbsg_manycore_runtime.so.1.0: INCLUDES :=
 
 # Some per-target library includes are overloaded
@@ -170,9 +196,14 @@ $(BSG_PLATFORM_PATH)/libbsg_manycore_regression.so.1.0: LD = $(CXX)
 $(BSG_PLATFORM_PATH)/libbsg_manycore_regression.so.1.0: $(LIB_OBJECTS_REGRESSION)
 	$(LD) -shared -Wl,-soname,$(basename $(notdir $@)) -o $@ $^ $(LDFLAGS)
 
+# Reader for the stream written with HB_MC_STATS_STREAM (see bsg_manycore_stats_stream.h)
+$(BSG_PLATFORM_PATH)/hb_mc_stats_reader: $(LIBRARIES_PATH)/tools/hb_mc_stats_reader.cpp $(LIBRARIES_PATH)/bsg_manycore_bits.cpp
+	$(CXX) -std=c++11 -O2 -D_GNU_SOURCE -D_BSD_SOURCE -D_DEFAULT_SOURCE -I$(LIBRARIES_PATH) -o $@ $^
+
 .PHONY: libraries.clean
 libraries.clean:
 	rm -f $(LIB_OBJECTS) $(LIB_OBJECTS_CUDA_POD_REPL) $(LIB_OBJECTS_REGRESSION)
+	rm -f $(BSG_PLATFORM_PATH)/hb_mc_stats_reader
 	rm -f $(BSG_PLATFORM_PATH)/libbsg_manycore_runtime.so.1.0
 	rm -f $(BSG_PLATFORM_PATH)/libbsgmc_cuda_legacy_pod_repl.so.1.0
 	rm -f $(BSG_PLATFORM_PATH)/libbsg_manycore_regression.so.1.0
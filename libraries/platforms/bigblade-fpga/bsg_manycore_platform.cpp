@@ -1,3 +1,4 @@
+#define BSG_LOG_SUBSYSTEM BSG_LOG_PACKET
 #include <bsg_manycore_platform.h>
 #include <bsg_manycore_mmio.h>
 #include <bsg_manycore_config.h>
@@ -6,8 +7,10 @@
 #include <bsg_manycore_profiler.hpp>
 #include <bsg_manycore_tracer.hpp>
 
+#include <algorithm>
 #include <cstring>
 #include <set>
+#include <time.h>
 
 /* these are convenience macros that are only good for one line prints */
 #define platform_pr_dbg(m, fmt, ...)                    \
@@ -36,6 +39,30 @@ typedef struct hb_mc_platform_t {
 } hb_mc_platform_t;
 
 
+// ****************************************************************************
+// TIMEOUTS
+// ****************************************************************************
+
+/* read the monotonic clock in microseconds */
+static uint64_t hb_mc_platform_now_us()
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+/*
+ * Have #timeout microseconds passed since #start? A timeout of -1 never
+ * expires, and a timeout of 0 expires after the first attempt.
+ */
+static bool hb_mc_platform_expired(uint64_t start, long timeout)
+{
+        if (timeout == -1)
+                return false;
+
+        return hb_mc_platform_now_us() - start >= static_cast<uint64_t>(timeout);
+}
+
 // ****************************************************************************
 // FIFO INTERFACE
 // ****************************************************************************
@@ -208,8 +235,9 @@ static void hb_mc_platform_fifos_cleanup(hb_mc_manycore_t *mc,
  * Transmit a request packet to manycore hardware
  * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init()
  * @param[in] request A request packet to transmit to manycore hardware
- * @param[in] timeout A timeout counter. Unused - set to -1 to wait forever.
- * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ * @param[in] timeout Microseconds to wait, 0 to poll, or -1 to wait forever.
+ * @return HB_MC_SUCCESS on success, HB_MC_TIMEOUT if the fifo stayed full.
+ * Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_transmit(hb_mc_manycore_t *mc,
                             hb_mc_packet_t *packet,
@@ -220,11 +248,11 @@ int hb_mc_platform_transmit(hb_mc_manycore_t *mc,
 
         const char *typestr = hb_mc_fifo_tx_to_string(type);
         uintptr_t data_addr;
+        uint64_t start = hb_mc_platform_now_us();
         int err;
 
-        if (timeout != -1) {
-                platform_pr_err(pl, "%s: Only a timeout value of -1 is supported\n",
-                                __func__);
+        if (timeout < -1) {
+                platform_pr_err(pl, "%s: Invalid timeout %ld\n", __func__, timeout);
                 return HB_MC_INVALID;
         }
 
@@ -234,6 +262,8 @@ int hb_mc_platform_transmit(hb_mc_manycore_t *mc,
 
         while(pl->transmit_vacancy == 0){
                 hb_mc_platform_get_transmit_vacancy(mc, HB_MC_FIFO_TX_REQ, &pl->transmit_vacancy);
+                if (pl->transmit_vacancy == 0 && hb_mc_platform_expired(start, timeout))
+                        return HB_MC_TIMEOUT;
         }
 
         pl->transmit_vacancy--;
@@ -253,7 +283,8 @@ int hb_mc_platform_transmit(hb_mc_manycore_t *mc,
  * Receive a packet from manycore hardware
  * @param[in] mc       A manycore instance initialized with hb_mc_manycore_init()
  * @param[in] response A packet into which data should be read
- * @param[in] timeout  A timeout counter. Unused - set to -1 to wait forever.
+ * @param[in] timeout  Microseconds to wait, 0 to poll, or -1 to wait forever.
+ *                     Responses cannot time out: the response fifo blocks in hardware.
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_receive(hb_mc_manycore_t *mc,
@@ -265,11 +296,11 @@ int hb_mc_platform_receive(hb_mc_manycore_t *mc,
         const char *typestr = hb_mc_fifo_rx_to_string(type);
         uintptr_t data_addr;
         uint32_t occupancy;
+        uint64_t start = hb_mc_platform_now_us();
         int err;
 
-        if (timeout != -1) {
-                platform_pr_err(pl, "%s: Only a timeout value of -1 is supported\n",
-                                __func__);
+        if (timeout < -1) {
+                platform_pr_err(pl, "%s: Invalid timeout %ld\n", __func__, timeout);
                 return HB_MC_INVALID;
         }
 
@@ -285,7 +316,11 @@ int hb_mc_platform_receive(hb_mc_manycore_t *mc,
                                 return err;
                         }
 
-                } while (occupancy < 1);  // this is packet occupancy, not word occupancy!
+                } while (occupancy < 1 && !hb_mc_platform_expired(start, timeout));  // this is packet occupancy, not word occupancy!
+
+                // report that nothing arrived in time
+                if (occupancy < 1)
+                        return HB_MC_TIMEOUT;
         }
 
         /* read in the packet one word at a time */
@@ -300,6 +335,142 @@ int hb_mc_platform_receive(hb_mc_manycore_t *mc,
         return HB_MC_SUCCESS;
 }
 
+/**
+ * Transmit an array of packets to manycore hardware, in order
+ * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  packets An array of packets to transmit to manycore hardware
+ * @param[in]  n       The number of packets in #packets
+ * @param[in]  type    Is this packet a request or response packet?
+ * @param[in]  timeout Microseconds to wait, 0 to poll, or -1 to wait forever.
+ * @param[out] sent    The number of packets accepted
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_transmit_n(hb_mc_manycore_t *mc,
+                              hb_mc_packet_t *packets,
+                              size_t n,
+                              hb_mc_fifo_tx_t type,
+                              long timeout,
+                              size_t *sent)
+{
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        uintptr_t data_addr;
+        size_t i = 0;
+        uint64_t start = hb_mc_platform_now_us();
+        int err;
+
+        *sent = 0;
+
+        if (timeout < -1) {
+                platform_pr_err(pl, "%s: Invalid timeout %ld\n", __func__, timeout);
+                return HB_MC_INVALID;
+        }
+
+        // get the address of the transmit data register TDR
+        data_addr = hb_mc_mmio_fifo_get_addr(type, HB_MC_MMIO_FIFO_TX_DATA_OFFSET);
+
+        while (i < n) {
+                // only read the vacancy register when the software copy runs out
+                while (pl->transmit_vacancy == 0) {
+                        err = hb_mc_platform_get_transmit_vacancy(mc, HB_MC_FIFO_TX_REQ,
+                                                                  &pl->transmit_vacancy);
+                        if (err != HB_MC_SUCCESS) {
+                                *sent = i;
+                                return err;
+                        }
+                        if (pl->transmit_vacancy == 0 && hb_mc_platform_expired(start, timeout)) {
+                                *sent = i;
+                                return HB_MC_TIMEOUT;
+                        }
+                }
+
+                // write as many packets as there is room for
+                for (; i < n && pl->transmit_vacancy > 0; i++) {
+                        pl->transmit_vacancy--;
+                        for (unsigned w = 0; w < array_size(packets[i].words); w++) {
+                                err = hb_mc_mmio_write32(pl->mmio, data_addr, packets[i].words[w]);
+                                if (err != HB_MC_SUCCESS) {
+                                        *sent = i;
+                                        return err;
+                                }
+                        }
+                }
+        }
+
+        *sent = i;
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Receive up to #n packets from manycore hardware
+ * @param[in]  mc       A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] packets  An array of packets into which data should be read
+ * @param[in]  n        The maximum number of packets to read
+ * @param[in]  type     Is this packet a request or response packet?
+ * @param[in]  timeout  Microseconds to wait, 0 to poll, or -1 to wait forever.
+ *                      Responses cannot time out: the response fifo blocks in hardware.
+ * @param[out] received The number of packets read
+ * @return HB_MC_SUCCESS if at least one packet was read. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_receive_n(hb_mc_manycore_t *mc,
+                             hb_mc_packet_t *packets,
+                             size_t n,
+                             hb_mc_fifo_rx_t type,
+                             long timeout,
+                             size_t *received)
+{
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        const char *typestr = hb_mc_fifo_rx_to_string(type);
+        uintptr_t data_addr;
+        uint32_t occupancy;
+        size_t count = n;
+        uint64_t start = hb_mc_platform_now_us();
+        int err;
+
+        *received = 0;
+
+        if (timeout < -1) {
+                platform_pr_err(pl, "%s: Invalid timeout %ld\n", __func__, timeout);
+                return HB_MC_INVALID;
+        }
+
+        data_addr = hb_mc_mmio_fifo_get_addr(type, HB_MC_MMIO_FIFO_RX_DATA_OFFSET);
+
+        // The response fifo has no occupancy register; reads of it
+        // block in hardware. Callers only ask for responses they are
+        // owed, so all #n will arrive. Requests are unsolicited:
+        // read only what the occupancy register says is there.
+        if (type == HB_MC_FIFO_RX_REQ) {
+                do {
+                        err = hb_mc_platform_rx_fifo_get_occupancy(pl, type, &occupancy);
+                        if (err != HB_MC_SUCCESS) {
+                                platform_pr_err(pl, "%s: Failed to get %s FIFO occupancy while waiting for packet: %s\n",
+                                                __func__, typestr, hb_mc_strerror(err));
+                                return err;
+                        }
+                } while (occupancy < 1 && !hb_mc_platform_expired(start, timeout));
+
+                if (occupancy < 1)
+                        return HB_MC_TIMEOUT;
+
+                count = std::min<size_t>(n, occupancy);
+        }
+
+        for (size_t i = 0; i < count; i++) {
+                for (unsigned w = 0; w < array_size(packets[i].words); w++) {
+                        err = hb_mc_mmio_read32(pl->mmio, data_addr, &packets[i].words[w]);
+                        if (err != HB_MC_SUCCESS) {
+                                platform_pr_err(pl, "%s: Failed read data from %s FIFO: %s\n",
+                                                __func__, typestr, hb_mc_strerror(err));
+                                *received = i;
+                                return err;
+                        }
+                }
+        }
+
+        *received = count;
+        return HB_MC_SUCCESS;
+}
+
 /**
  * Read the configuration register at an index
  * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
@@ -492,8 +663,9 @@ int hb_mc_platform_init(hb_mc_manycore_t *mc,
 /**
  * Stall until the all requests (and responses) have reached their destination.
  * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
- * @param[in] timeout A timeout counter. Unused - set to -1 to wait forever.
- * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ * @param[in] timeout Microseconds to wait, 0 to poll, or -1 to wait forever.
+ * @return HB_MC_SUCCESS on success, HB_MC_TIMEOUT if requests are still in flight.
+ * Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_fence(hb_mc_manycore_t *mc,
                          long timeout)
@@ -507,27 +679,29 @@ int hb_mc_platform_fence(hb_mc_manycore_t *mc,
 
         const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
         const hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform); 
+        uint64_t start = hb_mc_platform_now_us();
 
-        if (timeout != -1) {
-                platform_pr_err(pl, "%s: Only a timeout value of -1 is supported\n",
-                                __func__);
-                return HB_MC_NOIMPL;
+        if (timeout < -1) {
+                platform_pr_err(pl, "%s: Invalid timeout %ld\n", __func__, timeout);
+                return HB_MC_INVALID;
         }
 
         max_vacancy = hb_mc_config_get_transmit_vacancy_max(cfg);
         max_credits = hb_mc_config_get_io_endpoint_max_out_credits(cfg);
 
         // wait until out credts are fully resumed, and the tx fifo vacancy equals to host credits
-        while ((vacancy != max_vacancy) | (credits != 0)) {
+        do {
                 err = hb_mc_platform_get_transmit_vacancy(mc, HB_MC_FIFO_TX_REQ, &vacancy);
                 if (err != HB_MC_SUCCESS)
                         return err;
                 err = hb_mc_platform_get_credits(mc, &credits, -1);
                 if (err != HB_MC_SUCCESS)
                         return err;
-        }
+                if ((vacancy == max_vacancy) && (credits == 0))
+                        return HB_MC_SUCCESS;
+        } while (!hb_mc_platform_expired(start, timeout));
 
-        return HB_MC_SUCCESS;
+        return HB_MC_TIMEOUT;
 }
 
 
@@ -585,6 +759,18 @@ int hb_mc_platform_get_icount(hb_mc_manycore_t *mc, bsg_instr_type_e itype, int
         return hb_mc_profiler_get_icount(pl->prof, itype, count);
 }
 
+/**
+ * Capture every class of instruction count for every tile in one pass
+ * @param[in]  mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] snap  A snapshot whose tiles and cap are set by the caller.
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_get_icount_snapshot(hb_mc_manycore_t *mc, hb_mc_icount_snapshot_t *snap){
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+
+        return hb_mc_profiler_get_icount_snapshot(pl->prof, snap);
+}
+
 /**
  * Enable trace file generation (vanilla_operation_trace.csv)
  * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
@@ -18,6 +18,7 @@ extern "C" {
     int main(int argc, char *argv[]) {                         \
         bsg_pr_test_info("Regression Test: %s\n", test_name);  \
         int rc = name(argc, argv);                             \
+        bsg_pr_test_cycles();                                  \
         bsg_pr_test_pass_fail(rc == HB_MC_SUCCESS);            \
         return rc;                                             \
     }
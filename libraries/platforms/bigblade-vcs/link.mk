@@ -89,6 +89,7 @@ $(BSG_MACHINExPLATFORM_PATH)/repl/simv $(BSG_MACHINExPLATFORM_PATH)/pc-histogram
 $(BSG_MACHINExPLATFORM_PATH)/repl/simv $(BSG_MACHINExPLATFORM_PATH)/saifgen/simv $(BSG_MACHINExPLATFORM_PATH)/exec/simv: VDEFINES += BSG_MACHINE_DISABLE_REMOTE_OP_PROFILING
 $(BSG_MACHINExPLATFORM_PATH)/repl/simv $(BSG_MACHINExPLATFORM_PATH)/profile/simv $(BSG_MACHINExPLATFORM_PATH)/saifgen/simv $(BSG_MACHINExPLATFORM_PATH)/exec/simv: VDEFINES += BSG_MACHINE_DISABLE_VCORE_PC_HISTOGRAM
 $(BSG_MACHINExPLATFORM_PATH)/saifgen/simv: VDEFINES += BSG_MACHINE_ENABLE_SAIF
+$(BSG_MACHINExPLATFORM_PATH)/pc-histogram/simv: VDEFINES += BSG_MACHINE_ENABLE_PC_SAMPLER
 $(BSG_MACHINExPLATFORM_PATH)/saifgen/simv: VCS_VFLAGS += -debug_pp
 
 # The repl library must be linked before the other libraries to ensure
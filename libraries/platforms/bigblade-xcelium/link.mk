@@ -83,6 +83,7 @@ $(BSG_MACHINExPLATFORM_PATH)/repl/simx $(BSG_MACHINExPLATFORM_PATH)/pc-histogram
 $(BSG_MACHINExPLATFORM_PATH)/repl/simx $(BSG_MACHINExPLATFORM_PATH)/saifgen/simx $(BSG_MACHINExPLATFORM_PATH)/exec/simx: VDEFINES += BSG_MACHINE_DISABLE_REMOTE_OP_PROFILING
 $(BSG_MACHINExPLATFORM_PATH)/repl/simx $(BSG_MACHINExPLATFORM_PATH)/profile/simx $(BSG_MACHINExPLATFORM_PATH)/saifgen/simx $(BSG_MACHINExPLATFORM_PATH)/exec/simx: VDEFINES += BSG_MACHINE_DISABLE_VCORE_PC_HISTOGRAM
 $(BSG_MACHINExPLATFORM_PATH)/saifgen/simx: VDEFINES += BSG_MACHINE_ENABLE_SAIF
+$(BSG_MACHINExPLATFORM_PATH)/pc-histogram/simx: VDEFINES += BSG_MACHINE_ENABLE_PC_SAMPLER
 
 # The repl library must be linked before the other libraries to ensure
 # that it "intercepts" the non replicated versions
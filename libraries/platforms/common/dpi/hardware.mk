@@ -137,6 +137,7 @@ VSOURCES += $(BASEJUMP_STL_DIR)/bsg_test/bsg_nonsynth_dpi_cycle_counter.sv
 # Top-level module name
 BSG_DESIGN_TOP := replicant_tb_top
 
+VSOURCES += $(LIBRARIES_PATH)/platforms/common/dpi/hardware/vanilla_core_pc_sampler.sv
 VSOURCES += $(LIBRARIES_PATH)/platforms/common/dpi/hardware/dpi_top.sv
 
 VINCLUDES += $(BSG_PLATFORM_PATH)/hardware
@@ -395,6 +395,21 @@ module replicant_tb_top
    end
 `endif
 
+`ifdef BSG_MACHINE_ENABLE_PC_SAMPLER
+   // Feed the host's PC histogram (see bsg_manycore_pc_histogram.hpp)
+ `ifndef BSG_MACHINE_PC_SAMPLE_PERIOD
+  `define BSG_MACHINE_PC_SAMPLE_PERIOD 64
+ `endif
+   bind vanilla_core vanilla_core_pc_sampler
+     #(// Reminder: parameters are scoped to the bind target, not in the scope of the declaration!
+       .x_cord_width_p(x_cord_width_p)
+       ,.y_cord_width_p(y_cord_width_p)
+       ,.sample_period_p(`BSG_MACHINE_PC_SAMPLE_PERIOD)
+       )
+   pc_sampler
+     (.*);
+`endif
+
 `ifdef BSG_MACHINE_ENABLE_SAIF
    wor saif_en = 0;
 
@@ -0,0 +1,43 @@
+// Samples the PC of the instruction in a vanilla core's execute stage
+// every sample_period_p cycles and hands it to the host runtime's PC
+// histogram (features/pc_histogram/simulation) through DPI. The host
+// decides whether samples are kept; this module only produces them.
+//
+// dpi_top.sv binds it to vanilla_core when BSG_MACHINE_ENABLE_PC_SAMPLER
+// is defined; the ports match the core's signal names.
+module vanilla_core_pc_sampler
+  import bsg_vanilla_pkg::*;
+  #(parameter x_cord_width_p="inv"
+    , parameter y_cord_width_p="inv"
+    , parameter sample_period_p=64
+  )
+  (
+   input clk_i
+   , input reset_i
+
+   , input exe_signals_s exe_r
+
+   , input [x_cord_width_p-1:0] global_x_i
+   , input [y_cord_width_p-1:0] global_y_i
+  );
+
+  import "DPI-C" function void hb_mc_pc_histogram_sample(input int x, input int y, input int pc);
+
+  integer ctr_r;
+
+  always_ff @(posedge clk_i) begin
+    if (reset_i) begin
+      ctr_r <= 0;
+    end
+    else if (ctr_r == sample_period_p-1) begin
+      ctr_r <= 0;
+      // a stalled instruction is sampled too: it is what the cycle went to
+      if (exe_r.pc_plus4 != '0)
+        hb_mc_pc_histogram_sample(global_x_i, global_y_i, exe_r.pc_plus4 - 4);
+    end
+    else begin
+      ctr_r <= ctr_r + 1;
+    end
+  end
+
+endmodule
@@ -24,11 +24,14 @@
 // ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#define BSG_LOG_SUBSYSTEM BSG_LOG_PACKET
 #include <bsg_manycore_platform.h>
 #include <bsg_manycore.h>
 #include <bsg_manycore_config.h>
 #include <bsg_manycore_printing.h>
 #include <bsg_manycore_tracer.hpp>
+#include <bsg_manycore_pc_histogram.hpp>
+#include <bsg_manycore_profiler.hpp>
 
 #include <bsg_manycore_simulator.hpp>
 
@@ -40,6 +43,7 @@
 #include <cstring>
 #include <set>
 #include <map>
+#include <vector>
 #include <xmmintrin.h>
 
 /* these are convenience macros that are only good for one line prints */
@@ -61,8 +65,18 @@ typedef struct hb_mc_platform_t {
         hb_mc_manycore_id_t id;
         bsg_nonsynth_dpi::dpi_cycle_counter<uint64_t> *ctr;
         hb_mc_tracer_t tracer;
+        hb_mc_pc_histogram_t pc_hist;
+        hb_mc_profiler_t prof;
+        std::vector<hb_mc_packet_t> bulk_queue; //!< requests held host-side during a bulk transfer
+        unsigned bulk_depth;                    //!< nesting depth of start/finish_bulk_transfer
+        uint64_t bulk_start;                    //!< cycle at which the outermost bulk transfer started
+        size_t bulk_packets;                    //!< requests queued since the bulk transfer started
 } hb_mc_platform_t;
 
+// The bulk queue is pushed into the DPI fifo once it holds this many
+// requests, so that host memory stays bounded for very large transfers
+static const size_t HB_MC_PLATFORM_BULK_QUEUE_MAX = 4096;
+
 /* read all unread packets from a fifo (rx only) */
 int hb_mc_platform_drain(hb_mc_manycore_t *mc, hb_mc_fifo_rx_t type)
 {
@@ -140,6 +154,141 @@ static void hb_mc_platform_dpi_cleanup(hb_mc_platform_t *platform)
         return;
 }
 
+/*
+ * Has #timeout simulated cycles passed since cycle #start? A timeout of
+ * -1 never expires, and a timeout of 0 expires after the first attempt.
+ */
+static bool hb_mc_platform_expired(hb_mc_platform_t *platform, uint64_t start, long timeout)
+{
+        uint64_t now;
+
+        if (timeout == -1)
+                return false;
+
+        platform->ctr->read(now);
+        return now - start >= static_cast<uint64_t>(timeout);
+}
+
+/* does this request produce a response from its endpoint? */
+static bool hb_mc_platform_expect_response(const hb_mc_packet_t *packet)
+{
+        // The DPI interface doesn't understand packets, but it does
+        // track response fifo occupancy. However, only some requests
+        // produce responses because we use the endpoint standard
+        // (which filters write responses). We use expect_response to
+        // indicate that this request will produce a response, so that
+        // the DPI interface can track the response fifo capacity.
+        return (packet->request.op_v2 != HB_MC_PACKET_OP_REMOTE_STORE) &&
+                (packet->request.op_v2 != HB_MC_PACKET_OP_REMOTE_SW) &&
+                (packet->request.op_v2 != HB_MC_PACKET_OP_CACHE_OP);
+}
+
+/*
+ * Offer the next request on every evaluation until the whole array has
+ * been accepted, without returning in between. A full response fifo is
+ * handed back to the caller as HB_MC_BUSY, since only the caller can
+ * read the responses that make room for the rest, and running out of
+ * #timeout cycles as HB_MC_TIMEOUT.
+ */
+static int hb_mc_platform_dpi_tx_n(hb_mc_manycore_t *mc,
+                                   hb_mc_packet_t *packets,
+                                   size_t n,
+                                   long timeout,
+                                   size_t *sent)
+{
+        hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        SimulationWrapper *top = platform->top;
+        size_t i = 0;
+        uint64_t start;
+        int err;
+
+        platform->ctr->read(start);
+
+        while (i < n) {
+                __m128i *pkt = reinterpret_cast<__m128i*>(&packets[i]);
+
+                err = platform->dpi->tx_req(*pkt, hb_mc_platform_expect_response(&packets[i]));
+                if (err == BSG_NONSYNTH_DPI_SUCCESS) {
+                        i++;
+                        continue;
+                }
+
+                if (err == BSG_NONSYNTH_DPI_NO_CAPACITY) {
+                        *sent = i;
+                        return HB_MC_BUSY;
+                }
+
+                if (err != BSG_NONSYNTH_DPI_NO_CREDITS &&
+                    err != BSG_NONSYNTH_DPI_NOT_WINDOW &&
+                    err != BSG_NONSYNTH_DPI_BUSY &&
+                    err != BSG_NONSYNTH_DPI_NOT_READY) {
+                        manycore_pr_err(mc, "%s: Failed to transmit packet: %s\n",
+                                        __func__, bsg_nonsynth_dpi_strerror(err));
+                        *sent = i;
+                        return HB_MC_INVALID;
+                }
+
+                if (hb_mc_platform_expired(platform, start, timeout)) {
+                        *sent = i;
+                        return HB_MC_TIMEOUT;
+                }
+
+                top->eval();
+        }
+
+        *sent = i;
+        return HB_MC_SUCCESS;
+}
+
+/*
+ * Push requests queued during a bulk transfer into the DPI fifo.
+ * Returns HB_MC_BUSY or HB_MC_TIMEOUT, with the remainder still queued,
+ * if the response fifo fills up or #timeout cycles pass before the
+ * queue is empty.
+ */
+static int hb_mc_platform_bulk_flush(hb_mc_manycore_t *mc, long timeout)
+{
+        hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        std::vector<hb_mc_packet_t> &queue = platform->bulk_queue;
+        size_t sent = 0;
+        int err;
+
+        if (queue.empty())
+                return HB_MC_SUCCESS;
+
+        err = hb_mc_platform_dpi_tx_n(mc, queue.data(), queue.size(), timeout, &sent);
+        queue.erase(queue.begin(), queue.begin() + sent);
+
+        return err;
+}
+
+/*
+ * Append requests to the bulk queue, pushing it out once it is full.
+ * The requests are accepted once queued: if pushing fails they stay
+ * queued, and the fence that finishes the transfer retries them and
+ * reports the error. Failing here would make callers send them twice.
+ */
+static void hb_mc_platform_bulk_enqueue(hb_mc_manycore_t *mc,
+                                        const hb_mc_packet_t *packets,
+                                        size_t n)
+{
+        hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        int err;
+
+        platform->bulk_queue.insert(platform->bulk_queue.end(), packets, packets + n);
+        platform->bulk_packets += n;
+
+        if (platform->bulk_queue.size() < HB_MC_PLATFORM_BULK_QUEUE_MAX)
+                return;
+
+        // A full response fifo is expected here: the requests stay
+        // queued until the caller reads responses
+        err = hb_mc_platform_bulk_flush(mc, -1);
+        if (err != HB_MC_SUCCESS && err != HB_MC_BUSY)
+                manycore_pr_dbg(mc, "%s: %zu requests left queued: %s\n", __func__,
+                                platform->bulk_queue.size(), hb_mc_strerror(err));
+}
+
 // These track active manycore machine IDs, and top-level
 // instantiations.
 static std::set<hb_mc_manycore_id_t> active_ids;
@@ -153,6 +302,8 @@ void hb_mc_platform_cleanup(hb_mc_manycore_t *mc)
 {
         hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
 
+        hb_mc_profiler_cleanup(&(platform->prof));
+        hb_mc_pc_histogram_cleanup(&(platform->pc_hist));
         hb_mc_tracer_cleanup(&(platform->tracer));
 
 
@@ -214,6 +365,9 @@ int hb_mc_platform_init(hb_mc_manycore_t *mc, hb_mc_manycore_id_t id)
 
         active_ids.insert(id);
         platform->id = id;
+        platform->bulk_depth = 0;
+        platform->bulk_start = 0;
+        platform->bulk_packets = 0;
 
         // Instantiate the top-level platform simulation and put it in
         // the map. If it has already been instantiated, don't
@@ -241,8 +395,35 @@ int hb_mc_platform_init(hb_mc_manycore_t *mc, hb_mc_manycore_id_t id)
                 return err;
         }
 
+        err = hb_mc_pc_histogram_init(&(platform->pc_hist), hierarchy);
+        if (err != HB_MC_SUCCESS && err != HB_MC_NOIMPL){
+                hb_mc_tracer_cleanup(&(platform->tracer));
+                hb_mc_platform_dpi_cleanup(platform);
+                delete platform;
+                return err;
+        }
+
+        // Only pod 0 is profiled. Without vcore profiling in the
+        // machine there is nothing to find, and snapshots return
+        // HB_MC_NOIMPL.
+        std::string profiler = hierarchy + ".testbench.DUT.py[0].px[0].pod";
+        hb_mc_platform_get_config_at(mc, HB_MC_CONFIG_POD_DIM_X, &rd);
+        x = rd;
+        hb_mc_platform_get_config_at(mc, HB_MC_CONFIG_POD_DIM_Y, &rd);
+        y = rd;
+        err = hb_mc_profiler_init(&(platform->prof), x, y, profiler);
+        if (err != HB_MC_SUCCESS && err != HB_MC_NOIMPL){
+                hb_mc_pc_histogram_cleanup(&(platform->pc_hist));
+                hb_mc_tracer_cleanup(&(platform->tracer));
+                hb_mc_platform_dpi_cleanup(platform);
+                delete platform;
+                return err;
+        }
+
         err = hb_mc_platform_drain(mc, HB_MC_FIFO_RX_REQ);
         if (err != HB_MC_SUCCESS){
+                hb_mc_profiler_cleanup(&(platform->prof));
+                hb_mc_pc_histogram_cleanup(&(platform->pc_hist));
                 hb_mc_tracer_cleanup(&(platform->tracer));
                 hb_mc_platform_dpi_cleanup(platform);
                 delete platform;
@@ -251,6 +432,8 @@ int hb_mc_platform_init(hb_mc_manycore_t *mc, hb_mc_manycore_id_t id)
 
         hb_mc_platform_drain(mc, HB_MC_FIFO_RX_RSP);
         if (err != HB_MC_SUCCESS){
+                hb_mc_profiler_cleanup(&(platform->prof));
+                hb_mc_pc_histogram_cleanup(&(platform->pc_hist));
                 hb_mc_tracer_cleanup(&(platform->tracer));
                 hb_mc_platform_dpi_cleanup(platform);
                 delete platform;
@@ -266,8 +449,9 @@ int hb_mc_platform_init(hb_mc_manycore_t *mc, hb_mc_manycore_id_t id)
  * Transmit a packet to manycore hardware
  * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init()
  * @param[in] request A request packet to transmit to manycore hardware
- * @param[in] timeout A timeout counter. Unused - set to -1 to wait forever.
- * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ * @param[in] timeout Simulated cycles to wait, 0 to poll, or -1 to wait forever.
+ * @return HB_MC_SUCCESS on success, HB_MC_TIMEOUT if the packet was not accepted in time.
+ * Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_transmit(hb_mc_manycore_t *mc,
                             hb_mc_packet_t *packet,
@@ -278,11 +462,11 @@ int hb_mc_platform_transmit(hb_mc_manycore_t *mc,
         SimulationWrapper *top = platform->top;
         __m128i *pkt = reinterpret_cast<__m128i*>(packet);
         const char *typestr = hb_mc_fifo_tx_to_string(type);
+        uint64_t start;
 
         int err;
-        if (timeout != -1) {
-                manycore_pr_err(mc, "%s: Only a timeout value of -1 is supported\n",
-                                __func__);
+        if (timeout < -1) {
+                manycore_pr_err(mc, "%s: Invalid timeout %ld\n", __func__, timeout);
                 return HB_MC_INVALID;
         }
 
@@ -291,27 +475,36 @@ int hb_mc_platform_transmit(hb_mc_manycore_t *mc,
                 return HB_MC_NOIMPL;
         }
 
-        // The DPI interface doesn't understand packets, but it does
-        // track response fifo occupancy. However, only some requests
-        // produce responses because we use the endpoint standard
-        // (which filters write responses). We use expect_response to
-        // indicate that this request will produce a response, so that
-        // the DPI interface can track the response fifo capacity.
-        bool expect_response =
-                (packet->request.op_v2 != HB_MC_PACKET_OP_REMOTE_STORE) &&
-                (packet->request.op_v2 != HB_MC_PACKET_OP_REMOTE_SW) &&
-                (packet->request.op_v2 != HB_MC_PACKET_OP_CACHE_OP);
+        // Inside a bulk transfer the request is held host-side and
+        // injected along with the rest of the transfer
+        if (platform->bulk_depth > 0) {
+                hb_mc_platform_bulk_enqueue(mc, packet, 1);
+                return HB_MC_SUCCESS;
+        }
+
+        // Requests left queued by a failed bulk transfer go out first,
+        // so that this one cannot overtake them
+        err = hb_mc_platform_bulk_flush(mc, timeout);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        bool expect_response = hb_mc_platform_expect_response(packet);
+        bool retry;
 
+        platform->ctr->read(start);
         do {
                 top->eval();
                 err = platform->dpi->tx_req(*pkt, expect_response);
 
-        } while (err != BSG_NONSYNTH_DPI_SUCCESS &&
-                 (err == BSG_NONSYNTH_DPI_NO_CREDITS ||
-                  err == BSG_NONSYNTH_DPI_NO_CAPACITY ||
-                  err == BSG_NONSYNTH_DPI_NOT_WINDOW ||
-                  err == BSG_NONSYNTH_DPI_BUSY ||
-                  err == BSG_NONSYNTH_DPI_NOT_READY ));
+                retry = (err == BSG_NONSYNTH_DPI_NO_CREDITS ||
+                         err == BSG_NONSYNTH_DPI_NO_CAPACITY ||
+                         err == BSG_NONSYNTH_DPI_NOT_WINDOW ||
+                         err == BSG_NONSYNTH_DPI_BUSY ||
+                         err == BSG_NONSYNTH_DPI_NOT_READY);
+        } while (retry && !hb_mc_platform_expired(platform, start, timeout));
+
+        if (retry)
+                return HB_MC_TIMEOUT;
 
         if(err != BSG_NONSYNTH_DPI_SUCCESS){
                 manycore_pr_err(mc, "%s: Failed to transmit packet: %s\n",
@@ -326,7 +519,7 @@ int hb_mc_platform_transmit(hb_mc_manycore_t *mc,
  * Receive a packet from manycore hardware
  * @param[in] mc       A manycore instance initialized with hb_mc_manycore_init()
  * @param[in] response A packet into which data should be read
- * @param[in] timeout  A timeout counter. Unused - set to -1 to wait forever.
+ * @param[in] timeout  Simulated cycles to wait, 0 to poll, or -1 to wait forever.
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_receive(hb_mc_manycore_t *mc,
@@ -339,13 +532,23 @@ int hb_mc_platform_receive(hb_mc_manycore_t *mc,
         hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
         SimulationWrapper *top = platform->top;
         __m128i *pkt = reinterpret_cast<__m128i*>(packet);
+        uint64_t start;
 
-        if (timeout != -1) {
-                manycore_pr_err(mc, "%s: Only a timeout value of -1 is supported\n",
-                                __func__);
+        if (timeout < -1) {
+                manycore_pr_err(mc, "%s: Invalid timeout %ld\n", __func__, timeout);
                 return HB_MC_INVALID;
         }
 
+        // A response may be waiting on a request that is still in the
+        // bulk queue. Push out as much of the queue as will fit; if the
+        // response fifo is full, or the flush ran out of time, there may
+        // still be a response to read below. The fifo is checked at
+        // least once either way.
+        platform->ctr->read(start);
+        err = hb_mc_platform_bulk_flush(mc, timeout);
+        if (err != HB_MC_SUCCESS && err != HB_MC_BUSY && err != HB_MC_TIMEOUT)
+                return err;
+
         do {
                 top->eval();
 
@@ -361,10 +564,16 @@ int hb_mc_platform_receive(hb_mc_manycore_t *mc,
                         return HB_MC_NOIMPL;
                 }
 
-        } while (err != BSG_NONSYNTH_DPI_SUCCESS &&
-                 (err == BSG_NONSYNTH_DPI_NOT_WINDOW ||
+        } while ((err == BSG_NONSYNTH_DPI_NOT_WINDOW ||
                   err == BSG_NONSYNTH_DPI_BUSY ||
-                  err == BSG_NONSYNTH_DPI_NOT_VALID));
+                  err == BSG_NONSYNTH_DPI_NOT_VALID) &&
+                 !hb_mc_platform_expired(platform, start, timeout));
+
+        // report that nothing arrived in time
+        if (err == BSG_NONSYNTH_DPI_NOT_WINDOW ||
+            err == BSG_NONSYNTH_DPI_BUSY ||
+            err == BSG_NONSYNTH_DPI_NOT_VALID)
+                return HB_MC_TIMEOUT;
 
         if(err != BSG_NONSYNTH_DPI_SUCCESS){
                 manycore_pr_err(mc, "%s: Failed to receive packet: %s\n",
@@ -375,6 +584,109 @@ int hb_mc_platform_receive(hb_mc_manycore_t *mc,
         return HB_MC_SUCCESS;
 }
 
+/**
+ * Transmit an array of packets to manycore hardware, in order
+ * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  packets An array of packets to transmit to manycore hardware
+ * @param[in]  n       The number of packets in #packets
+ * @param[in]  type    Is this packet a request or response packet?
+ * @param[in]  timeout Simulated cycles to wait, 0 to poll, or -1 to wait forever.
+ * @param[out] sent    The number of packets accepted
+ * @return HB_MC_SUCCESS if all packets were sent, HB_MC_BUSY if the response fifo is full,
+ * HB_MC_TIMEOUT if the rest were not accepted in time.
+ * Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_transmit_n(hb_mc_manycore_t *mc,
+                              hb_mc_packet_t *packets,
+                              size_t n,
+                              hb_mc_fifo_tx_t type,
+                              long timeout,
+                              size_t *sent)
+{
+        hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        int err;
+
+        *sent = 0;
+
+        if (timeout < -1) {
+                manycore_pr_err(mc, "%s: Invalid timeout %ld\n", __func__, timeout);
+                return HB_MC_INVALID;
+        }
+
+        if (type == HB_MC_FIFO_TX_RSP) {
+                manycore_pr_err(mc, "TX Response Not Supported!\n");
+                return HB_MC_NOIMPL;
+        }
+
+        if (platform->bulk_depth > 0) {
+                hb_mc_platform_bulk_enqueue(mc, packets, n);
+                *sent = n;
+                return HB_MC_SUCCESS;
+        }
+
+        // Requests left queued by a failed bulk transfer go out first
+        err = hb_mc_platform_bulk_flush(mc, timeout);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        return hb_mc_platform_dpi_tx_n(mc, packets, n, timeout, sent);
+}
+
+/**
+ * Receive up to #n packets from manycore hardware
+ * @param[in]  mc       A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] packets  An array of packets into which data should be read
+ * @param[in]  n        The maximum number of packets to read
+ * @param[in]  type     Is this packet a request or response packet?
+ * @param[in]  timeout  Simulated cycles to wait, 0 to poll, or -1 to wait forever.
+ * @param[out] received The number of packets read
+ * @return HB_MC_SUCCESS if at least one packet was read. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_receive_n(hb_mc_manycore_t *mc,
+                             hb_mc_packet_t *packets,
+                             size_t n,
+                             hb_mc_fifo_rx_t type,
+                             long timeout,
+                             size_t *received)
+{
+        hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        SimulationWrapper *top = platform->top;
+        size_t i = 0;
+        int err;
+
+        *received = 0;
+        if (n == 0)
+                return HB_MC_SUCCESS;
+
+        // wait for the first packet as hb_mc_platform_receive() does
+        err = hb_mc_platform_receive(mc, &packets[0], type, timeout);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        // then keep popping for as long as the fifo stays valid,
+        // stepping the simulation only between windows
+        for (i = 1; i < n; ) {
+                __m128i *pkt = reinterpret_cast<__m128i*>(&packets[i]);
+
+                if (type == HB_MC_FIFO_RX_REQ)
+                        err = platform->dpi->rx_req(*pkt);
+                else
+                        err = platform->dpi->rx_rsp(*pkt);
+
+                if (err == BSG_NONSYNTH_DPI_SUCCESS) {
+                        i++;
+                } else if (err == BSG_NONSYNTH_DPI_NOT_WINDOW ||
+                           err == BSG_NONSYNTH_DPI_BUSY) {
+                        top->eval();
+                } else {
+                        break;
+                }
+        }
+
+        *received = i;
+        return HB_MC_SUCCESS;
+}
+
 /**
  * Read the configuration register at an index
  * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
@@ -475,8 +787,9 @@ int hb_mc_platform_get_credits_max(hb_mc_manycore_t *mc, int *credits, long time
 /**
  * Stall until the all requests (and responses) have reached their destination.
  * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init()
- * @param[in] timeout A timeout counter. Unused - set to -1 to wait forever.
- * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ * @param[in] timeout Simulated cycles to wait, 0 to poll, or -1 to wait forever.
+ * @return HB_MC_SUCCESS on success, HB_MC_TIMEOUT if requests are still in flight.
+ * Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_fence(hb_mc_manycore_t *mc, long timeout)
 {
@@ -484,38 +797,98 @@ int hb_mc_platform_fence(hb_mc_manycore_t *mc, long timeout)
         bool isvacant;
         const hb_mc_config_t *cfg = hb_mc_manycore_get_config(mc);
         hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        uint64_t start;
 
-        if (timeout != -1) {
-                manycore_pr_err(mc, "%s: Only a timeout value of -1 is supported\n",
-                                __func__);
-                return HB_MC_NOIMPL;
+        if (timeout < -1) {
+                manycore_pr_err(mc, "%s: Invalid timeout %ld\n", __func__, timeout);
+                return HB_MC_INVALID;
+        }
+
+        platform->ctr->read(start);
+
+        // Credits only drain once every queued request is in flight
+        err = hb_mc_platform_bulk_flush(mc, timeout);
+        if (err == HB_MC_BUSY) {
+                manycore_pr_err(mc, "%s: Response fifo is full with %zu requests "
+                                "still queued. Read responses before fencing\n",
+                                __func__, platform->bulk_queue.size());
+                return HB_MC_BUSY;
+        } else if (err != HB_MC_SUCCESS) {
+                return err;
         }
 
         do {
-                err = hb_mc_platform_get_credits_used(mc, &credits_used, timeout);
+                err = hb_mc_platform_get_credits_used(mc, &credits_used, -1);
+                if (err != HB_MC_SUCCESS)
+                        return err;
                 platform->dpi->tx_is_vacant(isvacant);
-        } while(err == HB_MC_SUCCESS && !((credits_used == 0) && isvacant));
+                if ((credits_used == 0) && isvacant)
+                        return HB_MC_SUCCESS;
+        } while (!hb_mc_platform_expired(platform, start, timeout));
 
-        return err;
+        return HB_MC_TIMEOUT;
 }
 
 /**
- * Signal the hardware to start a bulk transfer over the network
+ * Signal the hardware to start a bulk transfer over the network.
+ * Until the matching hb_mc_platform_finish_bulk_transfer(), requests
+ * are queued host-side and injected one per cycle in which the DPI
+ * fifo is ready.
  * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_start_bulk_transfer(hb_mc_manycore_t *mc)
 {
+        hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+
+        // Bulk transfers nest; only the outermost one is timed
+        if (platform->bulk_depth++ == 0) {
+                platform->ctr->read(platform->bulk_start);
+                platform->bulk_packets = 0;
+        }
+
         return HB_MC_SUCCESS;
 }
 
 /**
- * Signal the hardware to end a bulk transfer over the network
+ * Signal the hardware to end a bulk transfer over the network. The
+ * outermost call drains the host-side queue and fences.
  * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_finish_bulk_transfer(hb_mc_manycore_t *mc)
 {
+        hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        uint64_t end;
+        int err;
+
+        if (platform->bulk_depth == 0) {
+                manycore_pr_err(mc, "%s: No bulk transfer in progress\n", __func__);
+                return HB_MC_INVALID;
+        }
+
+        if (platform->bulk_depth > 1) {
+                platform->bulk_depth--;
+                return HB_MC_SUCCESS;
+        }
+
+        // Drain the queue and wait for it to land, once for the
+        // whole transfer
+        err = hb_mc_platform_fence(mc, -1);
+
+        // The transfer is over either way. Anything a failed drain
+        // left queued is sent ahead of later requests, see
+        // hb_mc_platform_transmit()
+        platform->bulk_depth = 0;
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        platform->ctr->read(end);
+        manycore_pr_dbg(mc, "%s: %zu requests in %" PRIu64 " cycles (%.2f cycles/request)\n",
+                        __func__, platform->bulk_packets, end - platform->bulk_start,
+                        platform->bulk_packets ?
+                        (double)(end - platform->bulk_start) / platform->bulk_packets : 0.0);
+
         return HB_MC_SUCCESS;
 }
 
@@ -544,9 +917,29 @@ int hb_mc_platform_get_cycle(hb_mc_manycore_t *mc, uint64_t *time)
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_get_icount(hb_mc_manycore_t *mc, bsg_instr_type_e itype, int *count){
-         hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        return hb_mc_profiler_get_icount(pl->prof, itype, count);
+}
 
-         return HB_MC_NOIMPL;
+/**
+ * Get every class of instruction count for every profiled tile
+ * @param[in]  mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] snap  A snapshot whose tiles and cap are set by the caller
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_get_icount_snapshot(hb_mc_manycore_t *mc, hb_mc_icount_snapshot_t *snap){
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        int err = hb_mc_profiler_get_icount_snapshot(pl->prof, snap);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        // The profiler reports coordinates within pod 0
+        hb_mc_coordinate_t origin = hb_mc_config_get_origin_vcore(hb_mc_manycore_get_config(mc));
+        for (size_t i = 0; i < snap->n_tiles; ++i){
+                snap->tiles[i].coord.x += origin.x;
+                snap->tiles[i].coord.y += origin.y;
+        }
+        return HB_MC_SUCCESS;
 }
 
 /**
@@ -589,6 +982,53 @@ int hb_mc_platform_log_disable(hb_mc_manycore_t *mc){
         return hb_mc_tracer_log_disable(pl->tracer);
 }
 
+/**
+ * Start accumulating per-tile PC histograms
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_pc_histogram_enable(hb_mc_manycore_t *mc){
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        return hb_mc_pc_histogram_enable(pl->pc_hist);
+}
+
+/**
+ * Stop accumulating per-tile PC histograms
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_pc_histogram_disable(hb_mc_manycore_t *mc){
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        return hb_mc_pc_histogram_disable(pl->pc_hist);
+}
+
+/**
+ * Discard the PC histogram of one tile
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in] tile  A tile coordinate
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_pc_histogram_reset(hb_mc_manycore_t *mc, hb_mc_coordinate_t tile){
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        return hb_mc_pc_histogram_reset(pl->pc_hist, tile);
+}
+
+/**
+ * Read the PC histogram of one tile, in ascending PC order
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  tile   A tile coordinate
+ * @param[out] counts An array of #cap entries
+ * @param[in]  cap    Length of #counts
+ * @param[out] n      Number of entries filled in #counts
+ * @return HB_MC_SUCCESS on success. HB_MC_NOMEM if #cap is too small.
+ * Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_pc_histogram_read(hb_mc_manycore_t *mc, hb_mc_coordinate_t tile,
+                                     hb_mc_pc_count_t *counts, size_t cap, size_t *n){
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        return hb_mc_pc_histogram_read(pl->pc_hist, tile, counts, cap, n);
+}
+
 /**
  * Check if chip reset has completed.
  * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
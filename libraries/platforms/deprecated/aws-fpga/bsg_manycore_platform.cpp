@@ -253,7 +253,7 @@ int hb_mc_platform_transmit(hb_mc_manycore_t *mc,
  * Receive a packet from manycore hardware
  * @param[in] mc       A manycore instance initialized with hb_mc_manycore_init()
  * @param[in] response A packet into which data should be read
- * @param[in] timeout  A timeout counter. Unused - set to -1 to wait forever.
+ * @param[in] timeout  Set to -1 to wait forever, or 0 to return HB_MC_TIMEOUT if no packet is ready.
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_receive(hb_mc_manycore_t *mc,
@@ -267,8 +267,8 @@ int hb_mc_platform_receive(hb_mc_manycore_t *mc,
         uint32_t occupancy;
         int err;
 
-        if (timeout != -1) {
-                platform_pr_err(pl, "%s: Only a timeout value of -1 is supported\n",
+        if (timeout != -1 && timeout != 0) {
+                platform_pr_err(pl, "%s: Only timeout values of -1 and 0 are supported\n",
                                 __func__);
                 return HB_MC_INVALID;
         }
@@ -285,7 +285,11 @@ int hb_mc_platform_receive(hb_mc_manycore_t *mc,
                                 return err;
                         }
 
-                } while (occupancy < 1);  // this is packet occupancy, not word occupancy!
+                } while (occupancy < 1 && timeout == -1);  // this is packet occupancy, not word occupancy!
+
+                // a timeout of 0 polls: report that nothing was available
+                if (occupancy < 1)
+                        return HB_MC_TIMEOUT;
         }
 
         /* read in the packet one word at a time */
@@ -585,6 +589,18 @@ int hb_mc_platform_get_icount(hb_mc_manycore_t *mc, bsg_instr_type_e itype, int
         return hb_mc_profiler_get_icount(pl->prof, itype, count);
 }
 
+/**
+ * Capture every class of instruction count for every tile in one pass
+ * @param[in]  mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] snap  A snapshot whose tiles and cap are set by the caller.
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_get_icount_snapshot(hb_mc_manycore_t *mc, hb_mc_icount_snapshot_t *snap){
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+
+        return hb_mc_profiler_get_icount_snapshot(pl->prof, snap);
+}
+
 /**
  * Enable trace file generation (vanilla_operation_trace.csv)
  * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
@@ -29,6 +29,7 @@
 #include <bsg_manycore_config.h>
 #include <bsg_manycore_printing.h>
 #include <bsg_manycore_tracer.hpp>
+#include <bsg_manycore_profiler.hpp>
 
 #include <bsg_manycore_simulator.hpp>
 
@@ -61,6 +62,7 @@ typedef struct hb_mc_platform_t {
         hb_mc_manycore_id_t id;
         bsg_nonsynth_dpi::dpi_cycle_counter<uint64_t> *ctr;
         hb_mc_tracer_t tracer;
+        hb_mc_profiler_t prof;
 } hb_mc_platform_t;
 
 /* read all unread packets from a fifo (rx only) */
@@ -153,6 +155,7 @@ void hb_mc_platform_cleanup(hb_mc_manycore_t *mc)
 {
         hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
 
+        hb_mc_profiler_cleanup(&(platform->prof));
         hb_mc_tracer_cleanup(&(platform->tracer));
 
 
@@ -232,8 +235,29 @@ int hb_mc_platform_init(hb_mc_manycore_t *mc, hb_mc_manycore_id_t id)
                 return err;
         }
 
+        // The tile array here is indexed by network coordinate, so
+        // cover everything up to the far corner of the pod and let
+        // the profiler skip the rows and columns without a core.
+        std::string profiler = hierarchy + ".network.manycore";
+        hb_mc_platform_get_config_at(mc, HB_MC_CONFIG_ORIGIN_COORD_X, &rd);
+        x = rd;
+        hb_mc_platform_get_config_at(mc, HB_MC_CONFIG_POD_DIM_X, &rd);
+        x += rd;
+        hb_mc_platform_get_config_at(mc, HB_MC_CONFIG_ORIGIN_COORD_Y, &rd);
+        y = rd;
+        hb_mc_platform_get_config_at(mc, HB_MC_CONFIG_POD_DIM_Y, &rd);
+        y += rd;
+        err = hb_mc_profiler_init(&(platform->prof), x, y, profiler);
+        if (err != HB_MC_SUCCESS && err != HB_MC_NOIMPL){
+                hb_mc_tracer_cleanup(&(platform->tracer));
+                hb_mc_platform_dpi_cleanup(platform);
+                delete platform;
+                return err;
+        }
+
         err = hb_mc_platform_drain(mc, HB_MC_FIFO_RX_REQ);
         if (err != HB_MC_SUCCESS){
+                hb_mc_profiler_cleanup(&(platform->prof));
                 hb_mc_tracer_cleanup(&(platform->tracer));
                 hb_mc_platform_dpi_cleanup(platform);
                 delete platform;
@@ -242,6 +266,7 @@ int hb_mc_platform_init(hb_mc_manycore_t *mc, hb_mc_manycore_id_t id)
 
         hb_mc_platform_drain(mc, HB_MC_FIFO_RX_RSP);
         if (err != HB_MC_SUCCESS){
+                hb_mc_profiler_cleanup(&(platform->prof));
                 hb_mc_tracer_cleanup(&(platform->tracer));
                 hb_mc_platform_dpi_cleanup(platform);
                 delete platform;
@@ -317,7 +342,7 @@ int hb_mc_platform_transmit(hb_mc_manycore_t *mc,
  * Receive a packet from manycore hardware
  * @param[in] mc       A manycore instance initialized with hb_mc_manycore_init()
  * @param[in] response A packet into which data should be read
- * @param[in] timeout  A timeout counter. Unused - set to -1 to wait forever.
+ * @param[in] timeout  Set to -1 to wait forever, or 0 to return HB_MC_TIMEOUT if no packet is ready.
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_receive(hb_mc_manycore_t *mc,
@@ -331,8 +356,8 @@ int hb_mc_platform_receive(hb_mc_manycore_t *mc,
         SimulationWrapper *top = platform->top;
         __m128i *pkt = reinterpret_cast<__m128i*>(packet);
 
-        if (timeout != -1) {
-                manycore_pr_err(mc, "%s: Only a timeout value of -1 is supported\n",
+        if (timeout != -1 && timeout != 0) {
+                manycore_pr_err(mc, "%s: Only timeout values of -1 and 0 are supported\n",
                                 __func__);
                 return HB_MC_INVALID;
         }
@@ -352,11 +377,18 @@ int hb_mc_platform_receive(hb_mc_manycore_t *mc,
                         return HB_MC_NOIMPL;
                 }
 
-        } while (err != BSG_NONSYNTH_DPI_SUCCESS &&
+        } while (timeout == -1 &&
+                 err != BSG_NONSYNTH_DPI_SUCCESS &&
                  (err == BSG_NONSYNTH_DPI_NOT_WINDOW ||
                   err == BSG_NONSYNTH_DPI_BUSY ||
                   err == BSG_NONSYNTH_DPI_NOT_VALID));
 
+        // a timeout of 0 polls: report that nothing was available
+        if (err == BSG_NONSYNTH_DPI_NOT_WINDOW ||
+            err == BSG_NONSYNTH_DPI_BUSY ||
+            err == BSG_NONSYNTH_DPI_NOT_VALID)
+                return HB_MC_TIMEOUT;
+
         if(err != BSG_NONSYNTH_DPI_SUCCESS){
                 manycore_pr_err(mc, "%s: Failed to receive packet: %s\n",
                                 __func__, bsg_nonsynth_dpi_strerror(err));
@@ -535,9 +567,19 @@ int hb_mc_platform_get_cycle(hb_mc_manycore_t *mc, uint64_t *time)
  * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
  */
 int hb_mc_platform_get_icount(hb_mc_manycore_t *mc, bsg_instr_type_e itype, int *count){
-         hb_mc_platform_t *platform = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        return hb_mc_profiler_get_icount(pl->prof, itype, count);
+}
 
-         return HB_MC_NOIMPL;
+/**
+ * Get every class of instruction count for every profiled tile
+ * @param[in]  mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] snap  A snapshot whose tiles and cap are set by the caller
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_get_icount_snapshot(hb_mc_manycore_t *mc, hb_mc_icount_snapshot_t *snap){
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        return hb_mc_profiler_get_icount_snapshot(pl->prof, snap);
 }
 
 /**
@@ -51,6 +51,7 @@ $(PLATFORM_OBJECTS): INCLUDES += -I$(BSG_PLATFORM_PATH)
 $(PLATFORM_OBJECTS): INCLUDES += -I$(VERILATOR_ROOT)/include/vltstd
 $(PLATFORM_OBJECTS): INCLUDES += -I$(VERILATOR_ROOT)/include/
 $(PLATFORM_OBJECTS): INCLUDES += -I$(BSG_MANYCORE_DIR)/testbenches/dpi/
+$(PLATFORM_OBJECTS): INCLUDES += -I$(BSG_MANYCORE_DIR)/testbenches/common/v/
 $(PLATFORM_OBJECTS): INCLUDES += -I$(BASEJUMP_STL_DIR)/bsg_test/
 
 $(PLATFORM_OBJECTS): CFLAGS    = -std=c11 -fPIC -DVERILATOR $(INCLUDES) -D_GNU_SOURCE -D_BSD_SOURCE -D_DEFAULT_SOURCE
@@ -0,0 +1,528 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <bsg_manycore_functional_model.hpp>
+#include <bsg_manycore_config_pod.h>
+#include <bsg_manycore_errno.h>
+#include <bsg_manycore_printing.h>
+#include <bsg_manycore_vcache.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using namespace bsg_functional_model;
+
+/* Each endpoint owns a 4GB slice of a sparse_memory */
+static inline uint64_t endpoint_address(hb_mc_coordinate_t co, hb_mc_epa_t epa)
+{
+        return (static_cast<uint64_t>(co.x) << 48)
+                | (static_cast<uint64_t>(co.y) << 32)
+                | epa;
+}
+
+static inline unsigned log2_of(uint32_t v)
+{
+        return __builtin_popcount(v - 1);
+}
+
+/////////////////////
+// Sparse Memory   //
+/////////////////////
+
+void sparse_memory::read(uint64_t addr, void *data, size_t sz) const
+{
+        uint8_t *dst = reinterpret_cast<uint8_t *>(data);
+        while (sz > 0) {
+                uint64_t offset = addr % page_size;
+                size_t n = std::min<size_t>(sz, page_size - offset);
+                auto it = pages.find(addr / page_size);
+                if (it == pages.end())
+                        memset(dst, 0, n);
+                else
+                        memcpy(dst, &it->second[offset], n);
+                addr += n;
+                dst  += n;
+                sz   -= n;
+        }
+}
+
+void sparse_memory::write(uint64_t addr, const void *data, size_t sz)
+{
+        const uint8_t *src = reinterpret_cast<const uint8_t *>(data);
+        while (sz > 0) {
+                uint64_t offset = addr % page_size;
+                size_t n = std::min<size_t>(sz, page_size - offset);
+                std::vector<uint8_t> &page = pages[addr / page_size];
+                if (page.empty())
+                        page.resize(page_size, 0);
+                memcpy(&page[offset], src, n);
+                addr += n;
+                src  += n;
+                sz   -= n;
+        }
+}
+
+/////////////////////
+// Victim Cache    //
+/////////////////////
+
+vcache::vcache(sparse_memory *dram, uint64_t base,
+               uint32_t sets, uint32_t ways, uint32_t block_size) :
+        dram(dram), base(base), sets(sets), ways(ways), block_size(block_size),
+        set_shift(log2_of(block_size)), way_shift(log2_of(block_size) + log2_of(sets)),
+        lru_clock(0), lines(sets * ways)
+{
+        for (line &l : lines) {
+                l.valid = false;
+                l.dirty = false;
+                l.tag = 0;
+                l.lru = 0;
+                l.data.resize(block_size, 0);
+        }
+}
+
+void vcache::write_back(uint32_t set, line &l)
+{
+        if (l.valid && l.dirty) {
+                hb_mc_epa_t addr = (l.tag << way_shift) | (set << set_shift);
+                dram->write(base + addr, l.data.data(), block_size);
+        }
+        l.dirty = false;
+}
+
+vcache::line *vcache::find(hb_mc_epa_t epa)
+{
+        uint32_t set = set_of(epa);
+        for (uint32_t way = 0; way < ways; way++) {
+                line &l = lines[set * ways + way];
+                if (l.valid && l.tag == tag_of(epa))
+                        return &l;
+        }
+        return nullptr;
+}
+
+vcache::line *vcache::fill(hb_mc_epa_t epa)
+{
+        uint32_t set = set_of(epa);
+        line *victim = &lines[set * ways];
+
+        // prefer an invalid way, then the least recently used
+        for (uint32_t way = 0; way < ways; way++) {
+                line &l = lines[set * ways + way];
+                if (!l.valid) {
+                        victim = &l;
+                        break;
+                }
+                if (l.lru < victim->lru)
+                        victim = &l;
+        }
+
+        write_back(set, *victim);
+
+        hb_mc_epa_t addr = epa & ~(block_size - 1);
+        dram->read(base + addr, victim->data.data(), block_size);
+        victim->valid = true;
+        victim->tag = tag_of(epa);
+        return victim;
+}
+
+bool vcache::read(hb_mc_epa_t epa, void *data, size_t sz)
+{
+        line *l = find(epa);
+        bool hit = l != nullptr;
+        if (!hit)
+                l = fill(epa);
+
+        l->lru = ++lru_clock;
+        memcpy(data, &l->data[epa & (block_size - 1)], sz);
+        return hit;
+}
+
+bool vcache::write(hb_mc_epa_t epa, const void *data, size_t sz)
+{
+        line *l = find(epa);
+        bool hit = l != nullptr;
+        if (!hit)
+                l = fill(epa);
+
+        l->lru = ++lru_clock;
+        l->dirty = true;
+        memcpy(&l->data[epa & (block_size - 1)], data, sz);
+        return hit;
+}
+
+vcache::line &vcache::way_line(hb_mc_epa_t tag_epa)
+{
+        uint32_t way = (tag_epa >> way_shift) & (ways - 1);
+        return lines[set_of(tag_epa) * ways + way];
+}
+
+const vcache::line &vcache::way_line(hb_mc_epa_t tag_epa) const
+{
+        uint32_t way = (tag_epa >> way_shift) & (ways - 1);
+        return lines[set_of(tag_epa) * ways + way];
+}
+
+uint32_t vcache::read_tag(hb_mc_epa_t epa) const
+{
+        const line &l = way_line(epa);
+        return (l.valid ? HB_MC_VCACHE_VALID : 0) | l.tag;
+}
+
+void vcache::write_tag(hb_mc_epa_t epa, uint32_t tag)
+{
+        line &l = way_line(epa);
+        l.valid = (tag & HB_MC_VCACHE_VALID) != 0;
+        l.dirty = false;
+        l.tag = tag & ~HB_MC_VCACHE_VALID;
+}
+
+int vcache::apply(hb_mc_epa_t epa, uint8_t cache_op)
+{
+        line *l;
+        switch (cache_op) {
+        case HB_MC_PACKET_CACHE_OP_AFL:
+                if ((l = find(epa)))
+                        write_back(set_of(epa), *l);
+                return HB_MC_SUCCESS;
+        case HB_MC_PACKET_CACHE_OP_AINV:
+                if ((l = find(epa)))
+                        l->valid = l->dirty = false;
+                return HB_MC_SUCCESS;
+        case HB_MC_PACKET_CACHE_OP_AFLINV:
+                if ((l = find(epa))) {
+                        write_back(set_of(epa), *l);
+                        l->valid = false;
+                }
+                return HB_MC_SUCCESS;
+        case HB_MC_PACKET_CACHE_OP_TAGFL:
+                write_back(set_of(epa), way_line(epa));
+                return HB_MC_SUCCESS;
+        default:
+                return HB_MC_INVALID;
+        }
+}
+
+/////////////////////
+// Host Endpoint   //
+/////////////////////
+
+endpoint::endpoint(const hb_mc_config_t *cfg) :
+        cfg(cfg), now(0)
+{
+}
+
+endpoint::~endpoint()
+{
+        for (auto &c : caches)
+                delete c.second;
+}
+
+uint64_t endpoint::latency(hb_mc_coordinate_t dst) const
+{
+        hb_mc_coordinate_t host = hb_mc_config_get_host_interface(cfg);
+        uint64_t dx = dst.x > host.x ? dst.x - host.x : host.x - dst.x;
+        uint64_t dy = dst.y > host.y ? dst.y - host.y : host.y - dst.y;
+        return 1 + dx + dy;
+}
+
+void endpoint::retire_credits()
+{
+        while (!credits.empty() && credits.top() <= now)
+                credits.pop();
+}
+
+int endpoint::credits_used()
+{
+        retire_credits();
+        return static_cast<int>(credits.size());
+}
+
+vcache *endpoint::cache_at(hb_mc_coordinate_t dst)
+{
+        if (!hb_mc_config_is_dram(cfg, dst))
+                return nullptr;
+
+        // with no cache in the memory system requests go straight to DRAM
+        if (!hb_mc_config_memsys_feature_cache(cfg))
+                return nullptr;
+
+        uint64_t key = endpoint_address(dst, 0);
+        auto it = caches.find(key);
+        if (it != caches.end())
+                return it->second;
+
+        vcache *vc = new vcache(&dram, key,
+                                hb_mc_config_get_vcache_sets(cfg),
+                                hb_mc_config_get_vcache_ways(cfg),
+                                hb_mc_config_get_vcache_block_size(cfg));
+        caches[key] = vc;
+        return vc;
+}
+
+/* apply an AMO to #old and return the value to be written back */
+static uint32_t amo_apply(uint8_t op, uint32_t old, uint32_t operand)
+{
+        int32_t sold = static_cast<int32_t>(old), sop = static_cast<int32_t>(operand);
+        switch (op) {
+        case HB_MC_PACKET_OP_REMOTE_AMOSWAP: return operand;
+        case HB_MC_PACKET_OP_REMOTE_AMOADD:  return old + operand;
+        case HB_MC_PACKET_OP_REMOTE_AMOXOR:  return old ^ operand;
+        case HB_MC_PACKET_OP_REMOTE_AMOAND:  return old & operand;
+        case HB_MC_PACKET_OP_REMOTE_AMOOR:   return old | operand;
+        case HB_MC_PACKET_OP_REMOTE_AMOMIN:  return static_cast<uint32_t>(std::min(sold, sop));
+        case HB_MC_PACKET_OP_REMOTE_AMOMAX:  return static_cast<uint32_t>(std::max(sold, sop));
+        case HB_MC_PACKET_OP_REMOTE_AMOMINU: return std::min(old, operand);
+        default:                             return std::max(old, operand);
+        }
+}
+
+/* shift and extend a loaded word as the endpoint does before responding */
+static uint32_t load_format(const hb_mc_request_packet_t *rqst, uint32_t word)
+{
+        hb_mc_request_packet_load_info_t info = hb_mc_request_packet_get_load_info(rqst);
+        uint32_t data = word >> (8 * info.part_sel);
+
+        if (info.is_byte_op)
+                return info.is_unsigned_op ? (data & 0xFF)
+                        : static_cast<uint32_t>(static_cast<int8_t>(data));
+        if (info.is_hex_op)
+                return info.is_unsigned_op ? (data & 0xFFFF)
+                        : static_cast<uint32_t>(static_cast<int16_t>(data));
+        return data;
+}
+
+/* bytes written by a store: a remote store carries a byte mask */
+static int store_bytes(const hb_mc_request_packet_t *rqst, int *first, int *count)
+{
+        uint8_t mask = HB_MC_PACKET_REQUEST_MASK_WORD;
+        if (hb_mc_request_packet_get_op(rqst) == HB_MC_PACKET_OP_REMOTE_STORE)
+                mask = hb_mc_request_packet_get_mask(rqst);
+
+        if (mask == 0 || mask > HB_MC_PACKET_REQUEST_MASK_WORD)
+                return HB_MC_INVALID;
+
+        *first = __builtin_ctz(mask);
+        *count = __builtin_popcount(mask);
+
+        // masks must be contiguous
+        if ((mask >> *first) != ((1 << *count) - 1))
+                return HB_MC_INVALID;
+
+        return HB_MC_SUCCESS;
+}
+
+int endpoint::execute_vcache(vcache *vc, const hb_mc_request_packet_t *rqst,
+                             uint32_t *data, bool *hit)
+{
+        hb_mc_epa_t epa = hb_mc_request_packet_get_epa(rqst);
+        uint8_t op = hb_mc_request_packet_get_op(rqst);
+        uint32_t payload = hb_mc_request_packet_get_data(rqst);
+        uint32_t word;
+        int first, count, err;
+
+        *hit = true;
+        if (op == HB_MC_PACKET_OP_CACHE_OP)
+                return vc->apply(epa, hb_mc_request_packet_get_cache_op(rqst));
+
+        if (epa >= HB_MC_VCACHE_EPA_OFFSET_WH_DST) {
+                // wormhole routing is not modeled; accept and ignore stores
+                *data = 0;
+                return HB_MC_SUCCESS;
+        }
+
+        if (epa >= HB_MC_VCACHE_EPA_OFFSET_TAG) {
+                if (op == HB_MC_PACKET_OP_REMOTE_LOAD)
+                        *data = vc->read_tag(epa);
+                else if (op == HB_MC_PACKET_OP_REMOTE_SW)
+                        vc->write_tag(epa, payload);
+                else
+                        return HB_MC_INVALID;
+                return HB_MC_SUCCESS;
+        }
+
+        switch (op) {
+        case HB_MC_PACKET_OP_REMOTE_LOAD:
+                *hit = vc->read(epa, &word, sizeof(word));
+                *data = load_format(rqst, word);
+                return HB_MC_SUCCESS;
+        case HB_MC_PACKET_OP_REMOTE_STORE:
+        case HB_MC_PACKET_OP_REMOTE_SW:
+                err = store_bytes(rqst, &first, &count);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+                *hit = vc->write(epa + first,
+                                 reinterpret_cast<uint8_t *>(&payload) + first, count);
+                return HB_MC_SUCCESS;
+        default:
+                *hit = vc->read(epa, &word, sizeof(word));
+                *data = word;
+                word = amo_apply(op, word, payload);
+                vc->write(epa, &word, sizeof(word));
+                return HB_MC_SUCCESS;
+        }
+}
+
+int endpoint::execute(const hb_mc_request_packet_t *rqst, uint32_t *data, bool *hit)
+{
+        hb_mc_coordinate_t dst = hb_mc_coordinate(hb_mc_request_packet_get_x_dst(rqst),
+                                                  hb_mc_request_packet_get_y_dst(rqst));
+        hb_mc_epa_t epa = hb_mc_request_packet_get_epa(rqst);
+        uint8_t op = hb_mc_request_packet_get_op(rqst);
+        uint32_t payload = hb_mc_request_packet_get_data(rqst);
+        int first, count, err;
+
+        vcache *vc = cache_at(dst);
+        if (vc != nullptr)
+                return execute_vcache(vc, rqst, data, hit);
+
+        // tiles, and DRAM when there is no cache, are plain memory
+        sparse_memory &mem = hb_mc_config_is_dram(cfg, dst) ? dram : tiles;
+        uint64_t addr = endpoint_address(dst, epa);
+        uint32_t word;
+
+        *hit = true;
+        switch (op) {
+        case HB_MC_PACKET_OP_REMOTE_LOAD:
+                mem.read(addr, &word, sizeof(word));
+                *data = load_format(rqst, word);
+                return HB_MC_SUCCESS;
+        case HB_MC_PACKET_OP_REMOTE_STORE:
+        case HB_MC_PACKET_OP_REMOTE_SW:
+                err = store_bytes(rqst, &first, &count);
+                if (err != HB_MC_SUCCESS)
+                        return err;
+                mem.write(addr + first, reinterpret_cast<uint8_t *>(&payload) + first, count);
+                return HB_MC_SUCCESS;
+        case HB_MC_PACKET_OP_CACHE_OP:
+                // nothing is cached
+                return HB_MC_SUCCESS;
+        default:
+                mem.read(addr, &word, sizeof(word));
+                *data = word;
+                word = amo_apply(op, word, payload);
+                mem.write(addr, &word, sizeof(word));
+                return HB_MC_SUCCESS;
+        }
+}
+
+int endpoint::transmit(const hb_mc_request_packet_t *rqst)
+{
+        uint8_t op = hb_mc_request_packet_get_op(rqst);
+        bool expect_response =
+                (op != HB_MC_PACKET_OP_REMOTE_STORE) &&
+                (op != HB_MC_PACKET_OP_REMOTE_SW) &&
+                (op != HB_MC_PACKET_OP_CACHE_OP);
+
+        if (op > HB_MC_PACKET_OP_REMOTE_AMOMAXU)
+                return HB_MC_INVALID;
+
+        // the host must drain responses before it may request more
+        if (expect_response &&
+            responses.size() >= hb_mc_config_get_io_remote_load_cap(cfg))
+                return HB_MC_BUSY;
+
+        // stall until a credit is available
+        uint32_t max_credits = hb_mc_config_get_io_endpoint_max_out_credits(cfg);
+        retire_credits();
+        while (max_credits > 0 && credits.size() >= max_credits) {
+                now = credits.top();
+                retire_credits();
+        }
+
+        uint32_t data = 0;
+        bool hit;
+        int err = execute(rqst, &data, &hit);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        // one cycle to inject, then the round trip
+        now++;
+        hb_mc_coordinate_t dst = hb_mc_coordinate(hb_mc_request_packet_get_x_dst(rqst),
+                                                  hb_mc_request_packet_get_y_dst(rqst));
+        uint64_t done = now + 2 * latency(dst) + (hit ? 0 : miss_penalty);
+        credits.push(done);
+
+        if (expect_response) {
+                hb_mc_response_packet_t rsp = {};
+                hb_mc_response_packet_set_x_dst(&rsp, hb_mc_request_packet_get_x_src(rqst));
+                hb_mc_response_packet_set_y_dst(&rsp, hb_mc_request_packet_get_y_src(rqst));
+                hb_mc_response_packet_set_load_id(&rsp, hb_mc_request_packet_get_load_id(rqst));
+                hb_mc_response_packet_set_data(&rsp, data);
+                hb_mc_response_packet_set_op(&rsp, op);
+                responses.insert(std::make_pair(done, rsp));
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+int endpoint::receive(hb_mc_response_packet_t *rsp, long timeout)
+{
+        if (responses.empty())
+                return HB_MC_TIMEOUT;
+
+        auto it = responses.begin();
+        if (it->first > now) {
+                if (timeout != -1 && it->first - now > static_cast<uint64_t>(timeout)) {
+                        // waiting still lets time pass, even a poll
+                        now += std::max(timeout, 1L);
+                        return HB_MC_TIMEOUT;
+                }
+                now = it->first;
+        }
+
+        *rsp = it->second;
+        responses.erase(it);
+        return HB_MC_SUCCESS;
+}
+
+int endpoint::fence(long timeout)
+{
+        uint64_t deadline = now + timeout;
+
+        while (!credits.empty()) {
+                if (timeout != -1 && credits.top() > deadline) {
+                        now = deadline;
+                        return HB_MC_TIMEOUT;
+                }
+                now = std::max(now, credits.top());
+                credits.pop();
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+void endpoint::dram_read(hb_mc_coordinate_t cache, hb_mc_epa_t epa, void *data, size_t sz)
+{
+        dram.read(endpoint_address(cache, epa), data, sz);
+}
+
+void endpoint::dram_write(hb_mc_coordinate_t cache, hb_mc_epa_t epa, const void *data, size_t sz)
+{
+        dram.write(endpoint_address(cache, epa), data, sz);
+}
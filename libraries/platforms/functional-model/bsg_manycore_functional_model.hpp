@@ -0,0 +1,156 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef BSG_MANYCORE_FUNCTIONAL_MODEL_HPP
+#define BSG_MANYCORE_FUNCTIONAL_MODEL_HPP
+
+#include <bsg_manycore_config.h>
+#include <bsg_manycore_packet.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+// A pure C++ model of everything the host can see through its
+// endpoint: tile DMEM and CSRs, the victim caches and the DRAM behind
+// them. Requests take effect as soon as they are transmitted; only
+// the time at which responses and credits return to the host is
+// modeled, using the manhattan distance from the host and a fixed
+// penalty for victim cache misses.
+//
+// Tiles do not execute code. Nothing in the model ever sends a
+// request to the host.
+namespace bsg_functional_model {
+
+        // Byte-addressed backing store that is allocated a page at a
+        // time as it is written. Unwritten memory reads as zero.
+        class sparse_memory {
+        public:
+                void read(uint64_t addr, void *data, size_t sz) const;
+                void write(uint64_t addr, const void *data, size_t sz);
+        private:
+                static const uint64_t page_size = 4096;
+                std::unordered_map<uint64_t, std::vector<uint8_t> > pages;
+        };
+
+        // A write-back, write-allocate, LRU victim cache in front of
+        // one slice of a sparse_memory.
+        class vcache {
+        public:
+                vcache(sparse_memory *dram, uint64_t base,
+                       uint32_t sets, uint32_t ways, uint32_t block_size);
+
+                // Access the DRAM address space. Returns true on a hit.
+                bool read(hb_mc_epa_t epa, void *data, size_t sz);
+                bool write(hb_mc_epa_t epa, const void *data, size_t sz);
+
+                // Access the tag address space.
+                uint32_t read_tag(hb_mc_epa_t epa) const;
+                void write_tag(hb_mc_epa_t epa, uint32_t tag);
+
+                // Apply a cache operation (hb_mc_packet_cache_op_t).
+                int apply(hb_mc_epa_t epa, uint8_t cache_op);
+
+        private:
+                struct line {
+                        bool valid;
+                        bool dirty;
+                        uint32_t tag;
+                        uint64_t lru;
+                        std::vector<uint8_t> data;
+                };
+
+                line *find(hb_mc_epa_t epa);
+                line *fill(hb_mc_epa_t epa);
+                line &way_line(hb_mc_epa_t tag_epa);
+                const line &way_line(hb_mc_epa_t tag_epa) const;
+                void write_back(uint32_t set, line &l);
+
+                uint32_t set_of(hb_mc_epa_t epa) const { return (epa >> set_shift) & (sets - 1); }
+                uint32_t tag_of(hb_mc_epa_t epa) const { return epa >> way_shift; }
+
+                sparse_memory *dram;
+                uint64_t base;
+                uint32_t sets, ways, block_size;
+                unsigned set_shift, way_shift;
+                uint64_t lru_clock;
+                std::vector<line> lines;
+        };
+
+        // The network as seen from the host endpoint.
+        class endpoint {
+        public:
+                // Cycles added to a round trip by a victim cache miss.
+                static const uint64_t miss_penalty = 64;
+
+                // #cfg is read lazily; it does not need to be
+                // initialized until the first request.
+                endpoint(const hb_mc_config_t *cfg);
+                ~endpoint();
+
+                // Returns HB_MC_BUSY if #rqst expects a response and
+                // io_remote_load_cap responses are already outstanding.
+                int transmit(const hb_mc_request_packet_t *rqst);
+
+                // Returns HB_MC_TIMEOUT if no response is ready
+                // within #timeout cycles, or if no response is
+                // outstanding. A #timeout of -1 waits forever.
+                int receive(hb_mc_response_packet_t *rsp, long timeout);
+
+                // Stall until every credit has been returned. Returns
+                // HB_MC_TIMEOUT if that takes longer than #timeout
+                // cycles. A #timeout of -1 waits forever.
+                int fence(long timeout);
+
+                int credits_used();
+                uint64_t cycle() const { return now; }
+
+                // Backdoor access to DRAM that bypasses the victim caches.
+                void dram_read(hb_mc_coordinate_t cache, hb_mc_epa_t epa, void *data, size_t sz);
+                void dram_write(hb_mc_coordinate_t cache, hb_mc_epa_t epa, const void *data, size_t sz);
+
+        private:
+                uint64_t latency(hb_mc_coordinate_t dst) const;
+                void retire_credits();
+                vcache *cache_at(hb_mc_coordinate_t dst);
+                int execute(const hb_mc_request_packet_t *rqst, uint32_t *data, bool *hit);
+                int execute_vcache(vcache *vc, const hb_mc_request_packet_t *rqst, uint32_t *data, bool *hit);
+
+                const hb_mc_config_t *cfg;
+                uint64_t now;
+                sparse_memory tiles;
+                sparse_memory dram;
+                std::map<uint64_t, vcache *> caches;
+                std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t> > credits;
+                std::multimap<uint64_t, hb_mc_response_packet_t> responses;
+        };
+}
+
+#endif
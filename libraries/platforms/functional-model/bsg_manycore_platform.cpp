@@ -0,0 +1,541 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+//
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#define BSG_LOG_SUBSYSTEM BSG_LOG_PACKET
+#include <bsg_manycore_platform.h>
+#include <bsg_manycore.h>
+#include <bsg_manycore_config.h>
+#include <bsg_manycore_config_pod.h>
+#include <bsg_manycore_coordinate.h>
+#include <bsg_manycore_printing.h>
+#include <bsg_manycore_dma.h>
+
+#include <bsg_manycore_functional_model.hpp>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+
+/* these are convenience macros that are only good for one line prints */
+#define platform_pr_dbg(m, fmt, ...)                    \
+        bsg_pr_dbg("%s: " fmt, m->name, ##__VA_ARGS__)
+
+#define platform_pr_err(m, fmt, ...)                    \
+        bsg_pr_err("%s: " fmt, m->name, ##__VA_ARGS__)
+
+#define platform_pr_warn(m, fmt, ...)                   \
+        bsg_pr_warn("%s: " fmt, m->name, ##__VA_ARGS__)
+
+#define platform_pr_info(m, fmt, ...)                   \
+        bsg_pr_info("%s: " fmt, m->name, ##__VA_ARGS__)
+
+// The configuration ROM of the machine being modeled. The path is set
+// at compile time by library.mk and can be overridden at run time
+// with the environment variable of the same name.
+#ifndef HB_MC_FUNCTIONAL_MODEL_ROM
+#define HB_MC_FUNCTIONAL_MODEL_ROM "bsg_bladerunner_configuration.rom"
+#endif
+
+typedef struct hb_mc_platform_t {
+        const char *name;
+        hb_mc_manycore_id_t id;  //!< which manycore instance is this
+        hb_mc_config_raw_t config[HB_MC_CONFIG_MAX]; //!< contents of the configuration ROM
+        bsg_functional_model::endpoint *model; //!< the network, tiles, and memory system
+} hb_mc_platform_t;
+
+// This track active manycore machine IDs
+static std::set<hb_mc_manycore_id_t> active_ids;
+
+/* read the ASCII-binary configuration ROM generated by hardware.mk */
+static int hb_mc_platform_rom_load(hb_mc_platform_t *pl, const char *path)
+{
+        char line[128];
+        unsigned int idx = 0;
+        FILE *f = fopen(path, "r");
+
+        if (!f) {
+                platform_pr_err(pl, "Failed to open configuration ROM '%s': %s\n",
+                                path, strerror(errno));
+                return HB_MC_NOTFOUND;
+        }
+
+        while (idx < HB_MC_CONFIG_MAX && fgets(line, sizeof(line), f)) {
+                char *end;
+                unsigned long v = strtoul(line, &end, 2);
+                if (end == line) {
+                        platform_pr_err(pl, "Malformed line %u in configuration ROM '%s'\n",
+                                        idx, path);
+                        fclose(f);
+                        return HB_MC_INVALID;
+                }
+                pl->config[idx++] = static_cast<hb_mc_config_raw_t>(v);
+        }
+
+        fclose(f);
+
+        if (idx < HB_MC_CONFIG_MAX) {
+                platform_pr_err(pl, "Configuration ROM '%s' has %u entries, expected %u\n",
+                                path, idx, HB_MC_CONFIG_MAX);
+                return HB_MC_INVALID;
+        }
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Clean up the runtime platform
+ * @param[in] mc    A manycore to clean up
+ */
+void hb_mc_platform_cleanup(hb_mc_manycore_t *mc)
+{
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+
+        delete pl->model;
+
+        // Remove the key
+        auto key = active_ids.find(pl->id);
+        active_ids.erase(key);
+
+        delete pl;
+
+        mc->platform = nullptr;
+
+        return;
+}
+
+/**
+ * Initialize the runtime platform
+ * @param[in] mc    A manycore to initialize
+ * @param[in] id    ID which selects the physical hardware from which this manycore is configured
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int hb_mc_platform_init(hb_mc_manycore_t *mc, hb_mc_manycore_id_t id)
+{
+        // check if platform is already initialized
+        if (mc->platform)
+                return HB_MC_INITIALIZED_TWICE;
+
+        hb_mc_platform_t *pl = new hb_mc_platform_t();
+        const char *rom;
+        int err;
+
+        pl->name = mc->name;
+
+        // Check if the ID has already been initialized
+        if (active_ids.find(id) != active_ids.end()) {
+                platform_pr_err(pl, "Already initialized ID\n");
+                delete pl;
+                return HB_MC_INVALID;
+        }
+
+        rom = getenv("HB_MC_FUNCTIONAL_MODEL_ROM");
+        if (!rom)
+                rom = HB_MC_FUNCTIONAL_MODEL_ROM;
+
+        err = hb_mc_platform_rom_load(pl, rom);
+        if (err != HB_MC_SUCCESS) {
+                delete pl;
+                return err;
+        }
+
+        // The model reads the configuration when the first packet
+        // is sent, after hb_mc_manycore_init() has parsed the ROM.
+        pl->model = new bsg_functional_model::endpoint(&mc->config);
+        pl->id = id;
+        active_ids.insert(id);
+
+        mc->platform = reinterpret_cast<void *>(pl);
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Transmit a packet to manycore hardware
+ * @param[in] mc      A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in] packet  A packet to transmit to manycore hardware
+ * @param[in] type    Is this packet a request or response packet?
+ * @param[in] timeout Model cycles to wait, 0 to poll, or -1 to wait forever.
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_transmit(hb_mc_manycore_t *mc,
+                            hb_mc_packet_t *packet,
+                            hb_mc_fifo_tx_t type,
+                            long timeout)
+{
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        int err;
+
+        // Transmit only stalls for model time, which the host never
+        // waits on, so any timeout is satisfied
+        if (timeout < -1) {
+                platform_pr_err(pl, "%s: Invalid timeout %ld\n", __func__, timeout);
+                return HB_MC_INVALID;
+        }
+
+        if (type == HB_MC_FIFO_TX_RSP) {
+                platform_pr_err(pl, "TX Response Not Supported!\n");
+                return HB_MC_NOIMPL;
+        }
+
+        err = pl->model->transmit(&packet->request);
+        if (err == HB_MC_INVALID) {
+                char pkt_str[256];
+                platform_pr_err(pl, "%s: Malformed request: %s\n", __func__,
+                                hb_mc_request_packet_to_string(&packet->request,
+                                                               pkt_str, sizeof(pkt_str)));
+        }
+
+        return err;
+}
+
+/**
+ * Receive a packet from manycore hardware
+ * @param[in] mc       A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in] packet   A packet into which data should be read
+ * @param[in] type     Is this packet a request or response packet?
+ * @param[in] timeout  Model cycles to wait, 0 to poll, or -1 to wait forever.
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_receive(hb_mc_manycore_t *mc,
+                           hb_mc_packet_t *packet,
+                           hb_mc_fifo_rx_t type,
+                           long timeout)
+{
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        int err;
+
+        if (timeout < -1) {
+                platform_pr_err(pl, "%s: Invalid timeout %ld\n", __func__, timeout);
+                return HB_MC_INVALID;
+        }
+
+        switch (type) {
+        case HB_MC_FIFO_RX_REQ:
+                // Tiles do not execute, so no requests ever arrive.
+                // Waiting forever would hang the host.
+                if (timeout == -1)
+                        platform_pr_err(pl, "%s: Tiles do not execute code in the functional model; "
+                                        "no request will ever arrive\n", __func__);
+                return HB_MC_TIMEOUT;
+        case HB_MC_FIFO_RX_RSP:
+                err = pl->model->receive(&packet->response, timeout);
+                if (err == HB_MC_TIMEOUT && timeout == -1)
+                        platform_pr_err(pl, "%s: No response is outstanding\n", __func__);
+                return err;
+        default:
+                platform_pr_err(pl, "%s: Unknown packet type\n", __func__);
+                return HB_MC_NOIMPL;
+        }
+}
+
+/**
+ * Transmit an array of packets to manycore hardware, in order
+ * @param[in]  mc      A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  packets An array of packets to transmit to manycore hardware
+ * @param[in]  n       The number of packets in #packets
+ * @param[in]  type    Is this packet a request or response packet?
+ * @param[in]  timeout Model cycles to wait, 0 to poll, or -1 to wait forever.
+ * @param[out] sent    The number of packets accepted
+ * @return HB_MC_SUCCESS if all packets were sent, HB_MC_BUSY if responses must be read first.
+ * Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_transmit_n(hb_mc_manycore_t *mc,
+                              hb_mc_packet_t *packets,
+                              size_t n,
+                              hb_mc_fifo_tx_t type,
+                              long timeout,
+                              size_t *sent)
+{
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        int err = HB_MC_SUCCESS;
+        size_t i;
+
+        *sent = 0;
+
+        if (timeout < -1) {
+                platform_pr_err(pl, "%s: Invalid timeout %ld\n", __func__, timeout);
+                return HB_MC_INVALID;
+        }
+
+        if (type == HB_MC_FIFO_TX_RSP) {
+                platform_pr_err(pl, "TX Response Not Supported!\n");
+                return HB_MC_NOIMPL;
+        }
+
+        for (i = 0; i < n; i++) {
+                err = pl->model->transmit(&packets[i].request);
+                if (err != HB_MC_SUCCESS)
+                        break;
+        }
+
+        *sent = i;
+        return err;
+}
+
+/**
+ * Receive up to #n packets from manycore hardware
+ * @param[in]  mc       A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] packets  An array of packets into which data should be read
+ * @param[in]  n        The maximum number of packets to read
+ * @param[in]  type     Is this packet a request or response packet?
+ * @param[in]  timeout  Model cycles to wait, 0 to poll, or -1 to wait forever.
+ * @param[out] received The number of packets read
+ * @return HB_MC_SUCCESS if at least one packet was read. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_receive_n(hb_mc_manycore_t *mc,
+                             hb_mc_packet_t *packets,
+                             size_t n,
+                             hb_mc_fifo_rx_t type,
+                             long timeout,
+                             size_t *received)
+{
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        size_t i;
+        int err;
+
+        *received = 0;
+        if (n == 0)
+                return HB_MC_SUCCESS;
+
+        // requests never arrive; let hb_mc_platform_receive() report it
+        err = hb_mc_platform_receive(mc, &packets[0], type, timeout);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        for (i = 1; i < n; i++) {
+                if (pl->model->receive(&packets[i].response, 0) != HB_MC_SUCCESS)
+                        break;
+        }
+
+        *received = i;
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Read the configuration register at an index
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  idx    Configuration register index to access
+ * @param[out] config Configuration value at index
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_get_config_at(hb_mc_manycore_t *mc,
+                                 unsigned int idx,
+                                 hb_mc_config_raw_t *config)
+{
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+
+        if (idx < HB_MC_CONFIG_MAX) {
+                *config = pl->config[idx];
+                return HB_MC_SUCCESS;
+        }
+
+        return HB_MC_INVALID;
+}
+
+/**
+ * Stall until the all requests (and responses) have reached their destination.
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in] timeout Model cycles to wait, 0 to poll, or -1 to wait forever.
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_fence(hb_mc_manycore_t *mc, long timeout)
+{
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+
+        if (timeout < -1) {
+                platform_pr_err(pl, "%s: Invalid timeout %ld\n", __func__, timeout);
+                return HB_MC_INVALID;
+        }
+
+        return pl->model->fence(timeout);
+}
+
+/**
+ * Signal the hardware to start a bulk transfer over the network
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_start_bulk_transfer(hb_mc_manycore_t *mc)
+{
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Signal the hardware to end a bulk transfer over the network
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_finish_bulk_transfer(hb_mc_manycore_t *mc)
+{
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Get the current cycle counter of the Manycore Platform
+ *
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[out] time   The current counter value.
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_get_cycle(hb_mc_manycore_t *mc, uint64_t *time)
+{
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+
+        *time = pl->model->cycle();
+
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Get the number of instructions executed for a certain class of instructions
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in] itype An enum defining the class of instructions to query.
+ * @param[out] count The number of instructions executed in the queried class.
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_get_icount(hb_mc_manycore_t *mc, bsg_instr_type_e itype, int *count)
+{
+        return HB_MC_NOIMPL;
+}
+
+/**
+ * Enable trace file generation (vanilla_operation_trace.csv)
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_trace_enable(hb_mc_manycore_t *mc)
+{
+        return HB_MC_NOIMPL;
+}
+
+/**
+ * Disable trace file generation (vanilla_operation_trace.csv)
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_trace_disable(hb_mc_manycore_t *mc)
+{
+        return HB_MC_NOIMPL;
+}
+
+/**
+ * Enable log file generation (vanilla.log)
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_log_enable(hb_mc_manycore_t *mc)
+{
+        return HB_MC_NOIMPL;
+}
+
+/**
+ * Disable log file generation (vanilla.log)
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_log_disable(hb_mc_manycore_t *mc)
+{
+        return HB_MC_NOIMPL;
+}
+
+/**
+ * Check if chip reset has completed.
+ * @param[in] mc    A manycore instance initialized with hb_mc_manycore_init()
+ * @return HB_MC_SUCCESS on success. Otherwise an error code defined in bsg_manycore_errno.h.
+ */
+int hb_mc_platform_wait_reset_done(hb_mc_manycore_t *mc)
+{
+        // The model comes out of reset when it is constructed
+        return HB_MC_SUCCESS;
+}
+
+/* check that a DMA targets a victim cache and return the model */
+static int hb_mc_platform_dma_check(hb_mc_manycore_t *mc, const hb_mc_npa_t *npa,
+                                    bsg_functional_model::endpoint **model)
+{
+        hb_mc_platform_t *pl = reinterpret_cast<hb_mc_platform_t *>(mc->platform);
+        hb_mc_coordinate_t co = hb_mc_npa_get_xy(npa);
+
+        if (!hb_mc_config_is_dram(hb_mc_manycore_get_config(mc), co)) {
+                char npa_str[256];
+                platform_pr_err(pl, "%s: %s is not a DRAM address\n", __func__,
+                                hb_mc_npa_to_string(npa, npa_str, sizeof(npa_str)));
+                return HB_MC_INVALID;
+        }
+
+        *model = pl->model;
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Write memory out to manycore DRAM, bypassing the victim caches
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  npa    A valid hb_mc_npa_t - must be an L2 cache coordinate
+ * @param[in]  data   A buffer to be written out manycore hardware
+ * @param[in]  sz     The number of bytes to write to manycore hardware
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int hb_mc_dma_write(hb_mc_manycore_t *mc,
+                    const hb_mc_npa_t *npa,
+                    const void *data, size_t sz)
+{
+        bsg_functional_model::endpoint *model;
+        int err = hb_mc_platform_dma_check(mc, npa, &model);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        model->dram_write(hb_mc_npa_get_xy(npa), hb_mc_npa_get_epa(npa), data, sz);
+        return HB_MC_SUCCESS;
+}
+
+/**
+ * Read memory from manycore DRAM, bypassing the victim caches
+ * @param[in]  mc     A manycore instance initialized with hb_mc_manycore_init()
+ * @param[in]  npa    A valid hb_mc_npa_t - must be an L2 cache coordinate
+ * @param[in]  data   A host buffer to be read into from manycore hardware
+ * @param[in]  sz     The number of bytes to read from manycore hardware
+ * @return HB_MC_FAIL if an error occured. HB_MC_SUCCESS otherwise.
+ */
+int hb_mc_dma_read(hb_mc_manycore_t *mc,
+                   const hb_mc_npa_t *npa,
+                   void *data, size_t sz)
+{
+        bsg_functional_model::endpoint *model;
+        int err = hb_mc_platform_dma_check(mc, npa, &model);
+        if (err != HB_MC_SUCCESS)
+                return err;
+
+        model->dram_read(hb_mc_npa_get_xy(npa), hb_mc_npa_get_epa(npa), data, sz);
+        return HB_MC_SUCCESS;
+}
+
+int hb_mc_dma_init(hb_mc_manycore_t *mc)
+{
+        return HB_MC_SUCCESS;
+}
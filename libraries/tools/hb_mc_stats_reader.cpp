@@ -0,0 +1,241 @@
+// Copyright (c) 2021, University of Washington All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// 
+// Redistributions of source code must retain the above copyright notice, this list
+// of conditions and the following disclaimer.
+// 
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// 
+// Neither the name of the copyright holder nor the names of its contributors may
+// be used to endorse or promote products derived from this software without
+// specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/*
+ * Read a stats stream written by the runtime (see
+ * bsg_manycore_stats_stream.h) and print per-kernel statistics.
+ *
+ * usage: hb_mc_stats_reader [-g] [-n] <stream>
+ *   -g  also print every tile group
+ *   -n  aggregate launches of the same kernel by name
+ */
+#include <bsg_manycore_stats_stream.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+typedef struct {
+        std::string name;
+        uint32_t    pod;
+        uint32_t    launches;
+        uint64_t    tile_groups;
+        uint64_t    first_cycle;
+        uint64_t    last_cycle;
+        uint64_t    tg_cycles;   // sum of tile group lifetimes
+        uint64_t    tile_cycles; // sum of tile group lifetimes times their tiles
+        uint64_t    icount[HB_MC_INSTR_TYPES];
+} kernel_stats_t;
+
+static void kernel_stats_init(kernel_stats_t *k, const std::string &name, uint32_t pod)
+{
+        k->name = name;
+        k->pod = pod;
+        k->launches = 1;
+        k->tile_groups = 0;
+        k->first_cycle = UINT64_MAX;
+        k->last_cycle = 0;
+        k->tg_cycles = 0;
+        k->tile_cycles = 0;
+        memset(k->icount, 0, sizeof(k->icount));
+}
+
+static void kernel_stats_add(kernel_stats_t *k, const hb_mc_stats_tile_group_record_t *tg)
+{
+        uint64_t cycles = tg->end_cycle - tg->start_cycle;
+
+        k->tile_groups++;
+        k->first_cycle = std::min(k->first_cycle, tg->start_cycle);
+        k->last_cycle = std::max(k->last_cycle, tg->end_cycle);
+        k->tg_cycles += cycles;
+        k->tile_cycles += cycles * tg->tiles;
+        for (int itype = 0; itype < HB_MC_INSTR_TYPES; itype++)
+                k->icount[itype] += tg->icount[itype];
+}
+
+static void kernel_stats_merge(kernel_stats_t *k, const kernel_stats_t *from)
+{
+        k->launches += from->launches;
+        k->tile_groups += from->tile_groups;
+        k->first_cycle = std::min(k->first_cycle, from->first_cycle);
+        k->last_cycle = std::max(k->last_cycle, from->last_cycle);
+        k->tg_cycles += from->tg_cycles;
+        k->tile_cycles += from->tile_cycles;
+        for (int itype = 0; itype < HB_MC_INSTR_TYPES; itype++)
+                k->icount[itype] += from->icount[itype];
+}
+
+static void kernel_stats_print_header(void)
+{
+        printf("%-32s %6s %4s %8s %14s %14s %14s %14s %14s %6s\n",
+               "kernel", "launch", "pod", "tgs", "span", "tg_cycles",
+               "instr", "instr_int", "instr_fp", "ipc");
+}
+
+static void kernel_stats_print(const kernel_stats_t *k, const char *launch)
+{
+        uint64_t span = k->tile_groups > 0 ? k->last_cycle - k->first_cycle : 0;
+        double ipc = k->tile_cycles > 0 ? (double)k->icount[e_instr_all] / k->tile_cycles : 0.0;
+
+        printf("%-32s %6s %4" PRIu32 " %8" PRIu64 " %14" PRIu64 " %14" PRIu64
+               " %14" PRIu64 " %14" PRIu64 " %14" PRIu64 " %6.3f\n",
+               k->name.c_str(), launch, k->pod, k->tile_groups, span, k->tg_cycles,
+               k->icount[e_instr_all], k->icount[e_instr_int], k->icount[e_instr_float], ipc);
+}
+
+static void tile_group_print(const std::string &name, const hb_mc_stats_tile_group_record_t *tg)
+{
+        printf("  %-30s launch %-6" PRIu32 " pod %-3" PRIu32 " tg (%u,%u) %ux%u at (%u,%u):"
+               " %" PRIu64 " cycles, %" PRIu64 " instr\n",
+               name.c_str(), tg->launch, tg->pod, tg->id_x, tg->id_y, tg->dim_x, tg->dim_y,
+               tg->origin_x, tg->origin_y, tg->end_cycle - tg->start_cycle,
+               tg->icount[e_instr_all]);
+}
+
+static void usage(const char *prog)
+{
+        fprintf(stderr, "usage: %s [-g] [-n] <stream>\n", prog);
+        fprintf(stderr, "  -g  also print every tile group\n");
+        fprintf(stderr, "  -n  aggregate launches of the same kernel by name\n");
+}
+
+int main(int argc, char *argv[])
+{
+        bool tile_groups = false, by_name = false;
+        int opt;
+
+        while ((opt = getopt(argc, argv, "gnh")) != -1) {
+                switch (opt) {
+                case 'g': tile_groups = true; break;
+                case 'n': by_name = true; break;
+                default:
+                        usage(argv[0]);
+                        return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+                }
+        }
+
+        if (optind != argc - 1) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+
+        const char *path = argv[optind];
+        FILE *f = fopen(path, "rb");
+        if (f == NULL) {
+                fprintf(stderr, "%s: failed to open '%s': %s\n", argv[0], path, strerror(errno));
+                return EXIT_FAILURE;
+        }
+
+        hb_mc_stats_stream_header_t hdr;
+        if (fread(&hdr, sizeof(hdr), 1, f) != 1 ||
+            hdr.magic != HB_MC_STATS_STREAM_MAGIC) {
+                fprintf(stderr, "%s: '%s' is not a stats stream\n", argv[0], path);
+                fclose(f);
+                return EXIT_FAILURE;
+        }
+
+        if (hdr.version != HB_MC_STATS_STREAM_VERSION) {
+                fprintf(stderr, "%s: '%s' has version %" PRIu32 ", expected %d\n",
+                        argv[0], path, hdr.version, HB_MC_STATS_STREAM_VERSION);
+                fclose(f);
+                return EXIT_FAILURE;
+        }
+
+        std::map<uint32_t, kernel_stats_t> launches;
+        std::vector<char> payload;
+        hb_mc_stats_record_header_t rec;
+        int rc = EXIT_SUCCESS;
+
+        while (fread(&rec, sizeof(rec), 1, f) == 1) {
+                payload.resize(rec.size);
+                if (rec.size > 0 && fread(payload.data(), rec.size, 1, f) != 1) {
+                        fprintf(stderr, "%s: '%s' is truncated\n", argv[0], path);
+                        rc = EXIT_FAILURE;
+                        break;
+                }
+
+                if (rec.type == HB_MC_STATS_RECORD_KERNEL &&
+                    rec.size >= sizeof(hb_mc_stats_kernel_record_t)) {
+                        hb_mc_stats_kernel_record_t k;
+                        memcpy(&k, payload.data(), sizeof(k));
+                        size_t len = std::min<size_t>(k.name_len, rec.size - sizeof(k));
+                        std::string name(payload.data() + sizeof(k), len);
+                        kernel_stats_init(&launches[k.launch], name, k.pod);
+                } else if (rec.type == HB_MC_STATS_RECORD_TILE_GROUP &&
+                           rec.size >= sizeof(hb_mc_stats_tile_group_record_t)) {
+                        hb_mc_stats_tile_group_record_t tg;
+                        memcpy(&tg, payload.data(), sizeof(tg));
+                        auto it = launches.find(tg.launch);
+                        if (it == launches.end()) {
+                                // a stream opened after the kernel was enqueued
+                                kernel_stats_init(&launches[tg.launch], "(unknown)", tg.pod);
+                                it = launches.find(tg.launch);
+                        }
+                        kernel_stats_add(&it->second, &tg);
+                        if (tile_groups)
+                                tile_group_print(it->second.name, &tg);
+                }
+                // skip records from newer writers
+        }
+
+        fclose(f);
+
+        if (tile_groups)
+                printf("\n");
+
+        kernel_stats_print_header();
+        if (by_name) {
+                std::map<std::string, kernel_stats_t> names;
+                for (auto &l : launches) {
+                        auto it = names.find(l.second.name);
+                        if (it == names.end())
+                                names[l.second.name] = l.second;
+                        else
+                                kernel_stats_merge(&it->second, &l.second);
+                }
+                for (auto &n : names) {
+                        char launches_str[16];
+                        snprintf(launches_str, sizeof(launches_str), "x%" PRIu32, n.second.launches);
+                        kernel_stats_print(&n.second, launches_str);
+                }
+        } else {
+                for (auto &l : launches) {
+                        char launch_str[16];
+                        snprintf(launch_str, sizeof(launch_str), "%" PRIu32, l.first);
+                        kernel_stats_print(&l.second, launch_str);
+                }
+        }
+
+        return rc;
+}